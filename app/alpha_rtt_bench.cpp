@@ -0,0 +1,64 @@
+// benchmark for the strategy perceived round trip (AlphaServer send -> ack, send -> own add on the market data feed).
+// AlphaServer's 10k test orders go through a gateway, the engine and the market data publisher (local fan out only) back to
+// the AlphaServer. the pipeline runs cooperatively on this thread : after every order each stage gets a turn, so the
+// numbers are the sum of the stage costs on the path (no cross core hops), the floor of the threaded loop.
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/alpha_tester.cpp"
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/market_data_publisher.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t RING = 1 << 16;
+
+int main() {
+
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> idle_oq(1);
+	LFQueue<UserAcknowledgement> saq(RING);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING);
+	LFQueue<BroadcastElement> bq(RING);
+	LFQueue<BroadcastElement> alpha_bq(RING);
+
+	MatchingEngine engine(10000, 400, &loq, &laq, &bq);
+	OrderGateway ogw(&laq, &soq, &idle_oq, &loq);
+	ogw.setThrottleCycles(0);
+	ogw.setAckRoute(1, &saq);
+
+	MarketDataPublisher publisher(&bq);
+	publisher.setLocalFanout(&alpha_bq);
+
+	AlphaServer alpha(&soq, &saq, &alpha_bq);
+	alpha.prepare();
+
+	auto turn = [&]() {
+		ogw.pollOrders();
+		while(loq.getNextRead() != nullptr) engine.readOrder();
+		for(int k = 0; k < 8 && laq.getNextRead() != nullptr; k++) ogw.pollAcknowledgement();
+		publisher.poll();
+		alpha.pollFeedback();
+	};
+
+	for(int i = 0; i < static_cast<int>(alpha.orderCount()); i++) {
+		alpha.run(i);
+		turn();
+	}
+	while(!alpha.allAcked() || laq.getNextRead() != nullptr || bq.getNextRead() != nullptr) turn();
+
+	double cpns = get_cycles_per_ns();
+	std::cout << "[ALPHA RTT BENCH] orders : " << alpha.orderCount() << " , acks : " << alpha.getSendToAck().size()
+			  << " , own adds seen on the feed : " << alpha.getSendToMarketData().size() << "\n\n";
+
+	std::string sta = "send -> ack";
+	showBench(sta, alpha.getSendToAck(), cpns);
+	std::string stmd = "send -> market data (own add observed)";
+	showBench(stmd, alpha.getSendToMarketData(), cpns);
+	return 0;
+}
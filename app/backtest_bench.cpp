@@ -0,0 +1,93 @@
+// benchmark for the deterministic backtest (core/src/backtest.cpp).
+// the mean reversion strategy (mean_reversion.cpp : own book from the feed through the book builder, trades against a
+// drifting mid every 100 us of virtual time) runs against the simulated market makers (99 traders, one generator) : the same run twice, the feed hash and the
+// strategy's fills / position / pnl must come out identical. reports simulated vs wall time.
+// backtest_bench [simulated seconds] [market maker events/s] [recording.bin] : with a recording (replay_convert) it also runs
+// the strategy against it at recorded timing.
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "book_builder.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/market_maker.cpp"
+#include "../core/src/replay_driver.cpp"
+#include "../core/src/strategy.cpp"
+#include "../core/src/backtest.cpp"
+#include "../core/src/mean_reversion.cpp"
+
+using namespace internal_lib;
+
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+
+struct RunSummary {
+	BacktestResult result;
+	uint64_t fills;
+	int position;
+	double pnl;
+};
+
+static void print(const std::string& name, const RunSummary& s) {
+	std::cout << " " << name << " : " << s.result.simulated_ns * 1e-9 << " s simulated in " << s.result.wall_ns * 1e-9 << " s wall ("
+			  << static_cast<double>(s.result.simulated_ns) / static_cast<double>(s.result.wall_ns) << "x) , " << s.result.feed_events
+			  << " feed events , " << s.result.trades << " trades , feed hash " << std::hex << s.result.feed_hash << std::dec
+			  << " | strategy fills " << s.fills << " position " << s.position << " pnl " << s.pnl << "\n";
+}
+
+static RunSummary simulated(double seconds, double rate) {
+	Backtest bt;
+	bt.routeFlowAcks(FIRST_MM, MM_TRADERS);
+
+	MarketMakerConfig config;
+	config.arrival_rate = rate;
+	MarketMaker flow(config, FIRST_MM, MM_TRADERS, bt.flowOrders(), bt.flowCancels(), BACKTEST_CYCLES_PER_NS);
+	flow.setAckQueue(bt.flowAcks());
+
+	BookBuilder book(10000);
+	MeanReversion strategy(bt, book);
+	BacktestResult r = bt.run(flow, strategy, static_cast<uint64_t>(seconds * 1e9));
+	return RunSummary{r, strategy.getFills(), strategy.getPosition(), strategy.pnl()};
+}
+
+static bool replayed(const char* path, RunSummary& out) {
+	Backtest bt;
+	ReplayDriver flow(BACKTEST_CYCLES_PER_NS);
+	if(!flow.open(path)) return false;
+	flow.setSpeed(1.0);
+	for(int t = 0; t < OE_MAX_TRADERS; t++) {
+		if(t != bt.strategyTrader()) flow.setRoute(static_cast<short>(t), bt.flowOrders(), bt.flowCancels());
+	}
+
+	BookBuilder book(10000);
+	MeanReversion strategy(bt, book);
+	BacktestResult r = bt.run(flow, strategy, flow.getRecordedSpanNs() + 1000);
+	out = RunSummary{r, strategy.getFills(), strategy.getPosition(), strategy.pnl()};
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	double seconds = (argc > 1) ? std::stod(argv[1]) : 10.0;
+	double rate = (argc > 2) ? std::stod(argv[2]) : 200000.0;
+
+	std::cout << "[BACKTEST BENCH] mean reversion vs " << MM_TRADERS << " simulated market makers (" << rate << " events/s)\n\n";
+	RunSummary first = simulated(seconds, rate);
+	print("run 1", first);
+	RunSummary second = simulated(seconds, rate);
+	print("run 2", second);
+
+	bool same = first.result.feed_hash == second.result.feed_hash && first.fills == second.fills && first.position == second.position &&
+				first.pnl == second.pnl;
+	std::cout << " deterministic : " << (same ? "yes" : "NO") << "\n";
+
+	if(argc > 3) {
+		RunSummary rec;
+		if(replayed(argv[3], rec)) print("recording", rec);
+		else std::cout << " can not map " << argv[3] << "\n";
+	}
+	return same ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+// benchmark for the client side book builder (book_builder.h).
+// a synthetic flow (market maker creates / replaces / cancels, sniper orders crossing the spread) goes through one gateway
+// into the engine, the engine's feed is captured and also applied to a builder as it comes. at every checkpoint the builder's
+// top 10 on both sides is compared with the engine's own top of book (same levels, same quantities, same order counts).
+// then the captured feed is applied again to fresh builders back to back : events per second, the apply cost alone.
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "top_of_book.h"
+#include "book_builder.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr short SNIPER = 1;
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+static constexpr size_t RING = 1 << 16;
+static constexpr size_t TICKS = 10000;
+
+struct Quote {
+	int order_id;
+	char side;
+	float price;
+};
+
+// the builder's page against the engine's, false on the first difference
+static bool samePage(const BookBuilder& builder, const TopOfBook& top) {
+	DepthView engine_page;
+	top.readDepth(engine_page);
+	for(int s = 0; s < 2; s++) {
+		DepthLevel page[TOB_DEPTH];
+		int n = builder.topN(s == 0, page, TOB_DEPTH);
+		int engine_n = (s == 0) ? engine_page.bid_levels : engine_page.ask_levels;
+		const DepthLevel* engine_levels = (s == 0) ? engine_page.bids : engine_page.asks;
+		if(n != engine_n) return false;
+		for(int i = 0; i < n; i++) {
+			if(page[i].price != engine_levels[i].price || page[i].quantity != engine_levels[i].quantity || page[i].orders != engine_levels[i].orders) return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	size_t count = (argc > 1) ? std::stoul(argv[1]) : 2000000;
+	int rounds = (argc > 2) ? std::stoi(argv[2]) : 5;
+	double cpns = get_cycles_per_ns();
+
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> mmoq(RING);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING * 4);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	TopOfBook top(TICKS);
+	MatchingEngine engine(TICKS, 400, &loq, &laq, &bq);
+	engine.attachTopOfBook(&top);
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setThrottleCycles(0);
+
+	BookBuilder live_builder(TICKS);
+	std::vector<BroadcastElement> feed;
+	feed.reserve(count * 3);
+
+	std::mt19937_64 rng(17);
+	std::vector<std::vector<Quote>> quotes(FIRST_MM + MM_TRADERS);
+	std::vector<int> next_id(FIRST_MM + MM_TRADERS, 0);
+	int checkpoints = 0, mismatches = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		short trader = (rng() % 20 == 0) ? SNIPER : static_cast<short>(FIRST_MM + rng() % MM_TRADERS);
+		LFQueue<UserOrder>& lane = (trader == SNIPER) ? soq : mmoq;
+		UserOrder* o = lane.getNextWrite();
+		o->trader_id = trader;
+		o->arrived_cycle_count = now_cycles();
+
+		std::vector<Quote>& mine = quotes[trader];
+		uint64_t dice = rng() % 10;
+		if(trader == SNIPER || mine.size() < 8 || dice < 4) {
+			bool buy = rng() & 1;
+			float offset = 0.1f * static_cast<float>(1 + rng() % 40);
+			if(trader == SNIPER) offset = -offset;
+			o->order_id = next_id[trader]++;
+			o->order_type = buy ? 'b' : 's';
+			o->req_type = 'c';
+			o->price = buy ? 130.0f - offset : 130.0f + offset;
+			o->quantity = 1 + static_cast<int>(rng() % 100);
+			if(trader != SNIPER) mine.push_back(Quote{o->order_id, o->order_type, o->price});
+		} else {
+			size_t pick = rng() % mine.size();
+			Quote& q = mine[pick];
+			o->order_id = q.order_id;
+			o->order_type = q.side;
+			if(dice < 7) {
+				o->req_type = 'd';
+				o->price = q.price;
+				o->quantity = 0;
+				q = mine.back();
+				mine.pop_back();
+			} else {
+				// replace : re-size, sometimes re-price (delete + add on the feed)
+				o->req_type = 'u';
+				if(dice == 9) q.price = (q.side == 'b') ? 130.0f - 0.1f * static_cast<float>(1 + rng() % 40) : 130.0f + 0.1f * static_cast<float>(1 + rng() % 40);
+				o->price = q.price;
+				o->quantity = 1 + static_cast<int>(rng() % 100);
+			}
+		}
+		o->out_cycle_count = o->arrived_cycle_count;
+		lane.updateWrite();
+
+		ogw.pollOrders();
+		while(loq.getNextRead() != nullptr) engine.readOrder();
+		while(laq.getNextRead() != nullptr) ogw.pollAcknowledgement();
+
+		BroadcastElement* be;
+		while((be = bq.getNextRead()) != nullptr) {
+			feed.push_back(*be);
+			live_builder.apply(*be);
+			bq.updateRead();
+		}
+
+		if((i + 1) % 100000 == 0) {
+			checkpoints++;
+			if(!samePage(live_builder, top)) mismatches++;
+		}
+	}
+
+	std::cout << "[BOOK BUILDER BENCH] " << count << " orders -> " << feed.size() << " feed events , top 10 vs engine : "
+			  << checkpoints - mismatches << "/" << checkpoints << " checkpoints match , ignored events " << live_builder.getIgnored() << "\n\n";
+
+	// apply only
+	std::vector<uint64_t> per_event;
+	for(int r = 0; r < rounds; r++) {
+		BookBuilder builder(TICKS);
+		uint64_t start = now_cycles();
+		for(const BroadcastElement& be : feed) builder.apply(be);
+		uint64_t cycles = now_cycles() - start;
+		per_event.push_back(cycles / feed.size());
+		std::cout << " round " << r << " : " << static_cast<double>(feed.size()) / (static_cast<double>(cycles) / cpns * 1e-9) * 1e-6
+				  << " M events/s\n";
+	}
+
+	// queue position of random live orders
+	std::vector<uint64_t> queue_position;
+	DepthLevel best;
+	if(live_builder.bestLevel(true, best)) {
+		for(size_t k = 0; k < 10000; k++) {
+			const BroadcastElement& be = feed[rng() % feed.size()];
+			if(be.type != 'N' || live_builder.orderQuantity(be.system_id) == 0) continue;
+			uint64_t start = now_cycles();
+			QueuePosition qp = live_builder.queuePosition(be.system_id);
+			queue_position.push_back(now_cycles() - start);
+			if(qp.level_orders < 0) mismatches++;
+		}
+	}
+	std::cout << "\n";
+
+	std::string apply_name = "apply (cycles per event, per round)";
+	showBench(apply_name, per_event, cpns);
+	std::string qp_name = "queue position query";
+	showBench(qp_name, queue_position, cpns);
+	return 0;
+}
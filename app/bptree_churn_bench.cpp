@@ -0,0 +1,110 @@
+// long session churn for the gateway's translation tree (simd_bplus_tree.h) : ids are recycled for ever, so the tree must
+// stay bounded by its live keys whatever order the keys leave in.
+// fills the tree to LIVE keys (order keys of 100 traders, each with increasing order ids, like the gateway makes them), then :
+//   churn  : erase a random live key, insert the next order of a random trader (a cancel / fill + a new order), N times
+//   thin   : erase all but every 64th key (a leaf ends up with a handful of keys, what lazy deletion left behind), refill
+// the pool is sized like the gateway's (worstCaseNodes(LIVE)), a node count above it would have been a terminate() in
+// MemPool. checks every live key still maps to its value after each phase and prints the node count against the bound.
+// bptree_churn_bench [churn operations] [rounds of thin + refill]
+
+#include <random>
+
+#include "simd_bplus_tree.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+using namespace internal_lib;
+
+using Tree = SIMDBPlusTree<long long, int, 256>;
+
+static constexpr size_t LIVE = 1 << 20;
+static constexpr int TRADERS = 100;
+
+struct Churn {
+	Tree tree{Tree::worstCaseNodes(LIVE)};
+	std::vector<long long> live;	// keys in the tree, value = position in this vector at insert time
+	std::vector<int> next_order;	// per trader
+	std::mt19937_64 rng{41};
+	size_t peak_nodes = 0;
+
+	Churn() : next_order(TRADERS, 0) { live.reserve(LIVE); }
+
+	void insertNext() {
+		short trader = static_cast<short>(rng() % TRADERS);
+		long long key = makeOrderKey(trader, next_order[trader]++);
+		tree.insert(key, static_cast<int>(key & 0x7fffffff));
+		live.push_back(key);
+		peak_nodes = std::max(peak_nodes, tree.nodeCount());
+	}
+
+	void eraseAt(size_t pick) {
+		tree.erase(live[pick]);
+		live[pick] = live.back();
+		live.pop_back();
+	}
+
+	// every live key found with its value, and nothing the tree should have forgotten
+	bool verify(const std::vector<long long>& gone) {
+		for(long long key : live) {
+			if(tree.find(key) != static_cast<int>(key & 0x7fffffff)) return false;
+		}
+		for(long long key : gone) {
+			if(tree.find(key) != -1) return false;
+		}
+		return true;
+	}
+};
+
+static bool report(const char* phase, Churn& c, double seconds, uint64_t ops, const std::vector<long long>& gone) {
+	bool ok = c.verify(gone) && c.tree.nodeCount() <= Tree::worstCaseNodes(c.live.size()) && c.peak_nodes <= Tree::worstCaseNodes(LIVE);
+	std::cout << " " << phase << " : " << c.live.size() << " live keys , " << c.tree.nodeCount() << " nodes (bound "
+			  << Tree::worstCaseNodes(c.live.size()) << ") , peak " << c.peak_nodes << " / pool " << Tree::worstCaseNodes(LIVE);
+	if(ops > 0) std::cout << " , " << seconds * 1e9 / static_cast<double>(ops) << " ns per erase + insert";
+	std::cout << " : " << (ok ? "ok" : "FAILED") << "\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	uint64_t churn_ops = (argc > 1) ? std::stoull(argv[1]) : 20000000;
+	int rounds = (argc > 2) ? std::stoi(argv[2]) : 8;
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[B+ TREE CHURN] " << LIVE << " live keys , " << churn_ops << " churn operations , " << rounds
+			  << " thin / refill rounds , pool of " << Tree::worstCaseNodes(LIVE) << " nodes\n";
+
+	Churn c;
+	bool ok = true;
+	std::vector<long long> gone;
+
+	for(size_t i = 0; i < LIVE; i++) c.insertNext();
+	ok &= report("filled", c, 0, 0, gone);
+
+	uint64_t start = now_cycles();
+	for(uint64_t op = 0; op < churn_ops; op++) {
+		c.eraseAt(c.rng() % c.live.size());
+		c.insertNext();
+	}
+	double seconds = static_cast<double>(now_cycles() - start) / cpns * 1e-9;
+	ok &= report("churn", c, seconds, churn_ops, gone);
+
+	for(int r = 0; r < rounds && ok; r++) {
+		gone.clear();
+		std::vector<long long> keep;
+		keep.reserve(c.live.size() / 64 + 1);
+		for(size_t i = 0; i < c.live.size(); i++) {
+			if(i % 64 == 0) keep.push_back(c.live[i]);
+			else {
+				c.tree.erase(c.live[i]);
+				if(gone.size() < 4096) gone.push_back(c.live[i]);
+			}
+		}
+		c.live.swap(keep);
+		ok &= report("thinned", c, 0, 0, gone);
+
+		while(c.live.size() < LIVE) c.insertNext();
+		ok &= report("refilled", c, 0, 0, gone);
+	}
+
+	return ok ? 0 : 1;
+}
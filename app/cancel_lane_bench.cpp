@@ -0,0 +1,188 @@
+// benchmark for the gateway cancel lanes.
+// a market maker sends bursts of new quotes with a cancel (of a quote from the previous burst) after every CANCEL_EVERY of them.
+// every order is stamped when it is queued, the gateway then drains the burst ---> stamp to LOB latency, reported separately for
+// new orders and cancels. once with one shared queue (cancels wait behind the new orders in front of them) and once with the
+// cancel lane attached.
+// then a steady flow where the gateway keeps pace with a standing backlog of BACKLOG orders (the order lane never runs dry
+// inside a round) and one cancel in GONE_EVERY names an order that is already gone (filled / cancelled before) : such a cancel
+// waits for the orders ahead of it, not for the order lane to run dry. stamp -> 'R' latency of those, and every one of them
+// must be rejected (non zero exit otherwise).
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+
+using namespace internal_lib;
+
+static constexpr int CANCEL_EVERY = 16;
+static constexpr short MM_TRADER = 2;
+static constexpr int BACKLOG = 2 * CANCEL_EVERY;
+static constexpr int GONE_EVERY = 8; // steady flow : one cancel in GONE_EVERY names an order that is already gone
+
+static void runLanes(bool cancel_lane, int burst, int rounds, int streak_limit, double cpns) {
+	size_t ring = static_cast<size_t>(burst) * 2;
+
+	LFQueue<UserOrder> soq(100);
+	LFQueue<UserOrder> mmoq(ring);
+	LFQueue<UserOrder> mmcq(ring);
+	LFQueue<LOBOrder> loq(ring * 2);
+	LFQueue<LOBAcknowledgement> laq(100);
+
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setThrottleCycles(0);
+	if(cancel_lane) {
+		ogw.attachCancelLanes(nullptr, &mmcq);
+		ogw.setCancelStreakLimit(streak_limit);
+	}
+
+	LFQueue<UserOrder>& cancels = cancel_lane ? mmcq : mmoq;
+
+	int next_id = 0;
+	for(int r = 0; r < rounds; r++) {
+		int first_of_previous = next_id - burst;
+
+		for(int i = 0; i < burst; i++) {
+			UserOrder* o = mmoq.getNextWrite();
+			o->arrived_cycle_count = now_cycles();
+			o->order_id = next_id++;
+			o->trader_id = MM_TRADER;
+			o->order_type = (i & 1) ? 's' : 'b';
+			o->req_type = 'c';
+			o->price = 100.0f + 0.1f * static_cast<float>(i & 63);
+			o->quantity = 10;
+			mmoq.updateWrite();
+
+			if(r > 0 && (i % CANCEL_EVERY) == CANCEL_EVERY - 1) {
+				UserOrder* c = cancels.getNextWrite();
+				c->arrived_cycle_count = now_cycles();
+				c->order_id = first_of_previous + i;
+				c->trader_id = MM_TRADER;
+				c->order_type = (i & 1) ? 's' : 'b';
+				c->req_type = 'd';
+				c->price = 0;
+				c->quantity = 0;
+				cancels.updateWrite();
+			}
+		}
+
+		while(mmoq.getNextRead() != nullptr || mmcq.getNextRead() != nullptr) {
+			ogw.pollOrders();
+			while(loq.getNextRead() != nullptr) loq.updateRead(); // stand-in for the engine
+		}
+	}
+
+	std::string mode = cancel_lane ? "cancel lane, streak " + std::to_string(streak_limit) : "shared queue";
+	std::string new_name = "new orders (" + mode + ")";
+	std::string cancel_name = "cancels (" + mode + ")";
+	showBench(new_name, ogw.getNewOrderLatencies(), cpns);
+	showBench(cancel_name, ogw.getCancelLatencies(), cpns);
+}
+
+// returns false if an unknown id cancel was not rejected
+static bool runUnknownCancels(int burst, int rounds, double cpns) {
+	size_t ring = static_cast<size_t>(burst) * 2;
+
+	LFQueue<UserOrder> soq(100);
+	LFQueue<UserOrder> mmoq(ring);
+	LFQueue<UserOrder> mmcq(ring);
+	LFQueue<LOBOrder> loq(ring * 2);
+	LFQueue<LOBAcknowledgement> laq(100);
+	LFQueue<UserAcknowledgement> maq(ring);
+
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setThrottleCycles(0);
+	ogw.attachCancelLanes(nullptr, &mmcq);
+	ogw.setAckRoute(MM_TRADER, &maq);
+
+	std::vector<uint64_t> stamps;		// per unknown cancel, its order id is -(index + 1)
+	std::vector<uint64_t> reject_times;
+	size_t unknown = 0;
+	size_t backlog_sum = 0;
+
+	auto drain = [&]() {
+		while(loq.getNextRead() != nullptr) loq.updateRead(); // stand-in for the engine
+		UserAcknowledgement* ack;
+		while((ack = maq.getNextRead()) != nullptr) {
+			if(ack->status == 'R' && ack->order_id < 0) reject_times.push_back(now_cycles() - stamps[-(ack->order_id + 1)]);
+			maq.updateRead();
+		}
+	};
+
+	int next_id = 0;
+	for(int r = 0; r < rounds; r++) {
+		int first_of_previous = next_id - burst;
+
+		for(int i = 0; i < burst; i++) {
+			UserOrder* o = mmoq.getNextWrite();
+			o->arrived_cycle_count = now_cycles();
+			o->order_id = next_id++;
+			o->trader_id = MM_TRADER;
+			o->order_type = (i & 1) ? 's' : 'b';
+			o->req_type = 'c';
+			o->price = 100.0f + 0.1f * static_cast<float>(i & 63);
+			o->quantity = 10;
+			mmoq.updateWrite();
+
+			if(i < BACKLOG) continue; // the standing backlog, no cancels yet
+			if((i % CANCEL_EVERY) == CANCEL_EVERY - 1) {
+				bool gone = ((i / CANCEL_EVERY) % GONE_EVERY) == 0;
+				if(!gone && r == 0) continue; // no previous burst to cancel from yet
+				UserOrder* c = mmcq.getNextWrite();
+				c->arrived_cycle_count = now_cycles();
+				if(gone) {
+					stamps.push_back(c->arrived_cycle_count);
+					c->order_id = -static_cast<int>(stamps.size());
+					unknown++;
+					backlog_sum += mmoq.entriesBetween(mmoq.readIndex(), mmoq.writeIndex());
+				} else {
+					c->order_id = first_of_previous + i;
+				}
+				c->trader_id = MM_TRADER;
+				c->order_type = (i & 1) ? 's' : 'b';
+				c->req_type = 'd';
+				c->price = 0;
+				c->quantity = 0;
+				mmcq.updateWrite();
+
+				// the gateway keeps pace : one poll per order / cancel written
+				for(int k = 0; k < CANCEL_EVERY + 1; k++) ogw.pollOrders();
+				drain();
+			}
+		}
+
+		while(mmoq.getNextRead() != nullptr || mmcq.getNextRead() != nullptr) {
+			ogw.pollOrders();
+			drain();
+		}
+	}
+
+	std::string known_name = "cancels of live orders (steady flow)";
+	std::string unknown_name = "cancels of orders already gone, stamp -> reject (steady flow)";
+	showBench(known_name, ogw.getCancelLatencies(), cpns);
+	showBench(unknown_name, reject_times, cpns);
+
+	bool ok = (reject_times.size() == unknown);
+	std::cout << " unknown id cancels : " << unknown << " , rejected : " << reject_times.size() << (ok ? "" : " MISMATCH")
+			  << " , order lane backlog when one was sent : " << static_cast<double>(backlog_sum) / static_cast<double>(unknown) << " orders\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	int burst = (argc > 1) ? std::stoi(argv[1]) : 512;
+	int rounds = (argc > 2) ? std::stoi(argv[2]) : 1000;
+	int streak_limit = (argc > 3) ? std::stoi(argv[3]) : 8;
+	if(static_cast<long long>(burst) * rounds > SYSTEM_ID_CAPACITY) rounds = SYSTEM_ID_CAPACITY / burst;
+
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[CANCEL LANE BENCH] burst : " << burst << " new orders , one cancel every " << CANCEL_EVERY << " , rounds : " << rounds << "\n\n";
+
+	runLanes(false, burst, rounds, streak_limit, cpns);
+	runLanes(true, burst, rounds, streak_limit, cpns);
+	bool ok = runUnknownCancels(burst, rounds, cpns);
+
+	return ok ? 0 : 1;
+}
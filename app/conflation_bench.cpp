@@ -0,0 +1,118 @@
+// benchmark for the conflated level feed.
+// the engine runs a create/cancel/modify workload (some of it crossing) with no conflated book, with a reader that never
+// collects (the slowest possible subscriber) and with a reader that collects after every chunk. engine cost must not depend on
+// how far behind the reader is.
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "conflated_book.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t CHUNK = 256;          // orders per round, the active reader collects after each round
+static constexpr size_t MAX_TICKS = 10000;
+
+int main(int argc, char** argv) {
+
+	size_t ops = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+
+	// workload : creates around 150.0 (about 1 in 10 crosses), cancels / quantity modifies of live orders
+	std::mt19937_64 rng(3);
+	std::vector<LOBOrder> workload;
+	workload.reserve(ops);
+	std::vector<LOBOrder> live;
+	int next_id = 0;
+
+	for(size_t i = 0; i < ops; i++) {
+		LOBOrder o{};
+		uint64_t dice = rng() % 10;
+		if(live.size() < 1000 || dice < 5) {
+			bool buy = rng() & 1;
+			o.system_id = next_id++;
+			o.order_type = buy ? 'b' : 's';
+			float offset = 0.1f * static_cast<float>(1 + rng() % 200);
+			if(rng() % 10 == 0) offset = -offset * 0.05f; // through the spread
+			o.price = buy ? 150.0f - offset : 150.0f + offset;
+			o.quantity = 1 + static_cast<int>(rng() % 100);
+			o.trader_id = 2 + static_cast<short>(rng() % 98);
+			o.req_type = 'c';
+			live.push_back(o);
+		} else {
+			size_t pick = rng() % live.size();
+			o = live[pick];
+			if(dice < 8) {
+				o.req_type = 'd';
+				o.quantity = 0;
+				live[pick] = live.back();
+				live.pop_back();
+			} else {
+				o.req_type = 'u';
+				o.quantity = 1 + static_cast<int>(rng() % 100);
+				live[pick].quantity = o.quantity;
+			}
+		}
+		workload.push_back(o);
+	}
+
+	std::cout << "[CONFLATION BENCH] ops : " << ops << "\n\n";
+	double cpns = get_cycles_per_ns();
+
+	const char* names[3] = {"no conflated book", "reader never collects", "reader collects every chunk"};
+	for(int mode = 0; mode < 3; mode++) {
+		LFQueue<LOBOrder> loq(CHUNK);
+		LFQueue<LOBAcknowledgement> laq(CHUNK * 16);
+		LFQueue<BroadcastElement> bq(CHUNK * 16);
+
+		MatchingEngine engine(MAX_TICKS, 400, &loq, &laq, &bq);
+		ConflatedBook book(MAX_TICKS);
+		int reader = -1;
+		if(mode > 0) {
+			engine.attachConflatedBook(&book);
+			reader = book.registerReader();
+			book.collect(reader, [](bool, size_t, int64_t, int32_t) {}); // initial snapshot
+		}
+
+		uint64_t engine_cycles = 0;
+		uint64_t collect_cycles = 0;
+		size_t levels_seen = 0;
+
+		for(size_t base = 0; base < workload.size(); base += CHUNK) {
+			size_t end = std::min(workload.size(), base + CHUNK);
+			for(size_t i = base; i < end; i++) {
+				LOBOrder* w = loq.getNextWrite();
+				*w = workload[i];
+				w->arrived_cycle_count = now_cycles();
+				w->out_cycle_count = w->arrived_cycle_count;
+				loq.updateWrite();
+			}
+
+			uint64_t start = now_cycles();
+			while(loq.getNextRead() != nullptr) engine.readOrder();
+			engine_cycles += now_cycles() - start;
+
+			while(laq.getNextRead() != nullptr) laq.updateRead();
+			while(bq.getNextRead() != nullptr) bq.updateRead();
+
+			if(mode == 2) {
+				uint64_t c = now_cycles();
+				levels_seen += book.collect(reader, [](bool, size_t, int64_t, int32_t) {});
+				collect_cycles += now_cycles() - c;
+			}
+		}
+
+		std::cout << " " << names[mode] << " : engine " << (double)engine_cycles / ops / cpns << " ns/order";
+		if(mode == 2) {
+			std::cout << " , " << levels_seen << " level updates collected (" << (double)levels_seen / ops << " per order) , "
+					  << (double)collect_cycles / (double)(ops / CHUNK) / cpns << " ns per collect";
+		}
+		std::cout << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+// benchmark for the fused pipeline (core/src/fused_pipeline.cpp) against the split one.
+// the same synthetic flow (market maker creates / cancels, sniper orders crossing the spread) is sent one order at a time, the
+// next one only after the ack of the previous came back (no replaces : the engine does not ack a replace that changes
+// nothing, or one for an order that is already gone), through :
+//   fused                 : FusedOrderGateway, the engine is called from the gateway (one thread, no LOB queue)
+//   split, one thread     : OrderGateway + LOB queue + engine stepped on this thread (the queue without the cross core hop)
+//   split, engine on core : OrderGateway on this thread, engine spinning on its own core (the production layout, needs 2 cores)
+// reports the engine's tick-to-trade (gateway pickup -> engine done) and producer stamp -> ack back to the producer.
+
+#include <random>
+#include <thread>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "thread_utils.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/fused_pipeline.cpp"
+
+using namespace internal_lib;
+
+static constexpr short SNIPER = 1;
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+static constexpr size_t RING = 1 << 16;
+static constexpr size_t TICKS = 10000;
+
+enum class Topology { FUSED, SPLIT_STEPPED, SPLIT_THREADED };
+
+struct Quote {
+	int order_id;
+	short trader_id;
+	char side;
+	float price;
+};
+
+struct PipelineRun {
+	std::vector<uint64_t> tick_to_trade;
+	std::vector<uint64_t> round_trip;
+	uint64_t broadcast_dropped = 0;
+};
+
+// one order of the synthetic flow into its lane. market maker ids are unique over all market makers (and sniper ids over
+// the sniper), so an ack is matched to its order by id and lane alone
+static void writeOrder(std::mt19937_64& rng, std::vector<Quote>& quotes, int& next_id, bool sniper, LFQueue<UserOrder>& lane) {
+	UserOrder* o = lane.getNextWrite();
+	o->trader_id = sniper ? SNIPER : static_cast<short>(FIRST_MM + rng() % MM_TRADERS);
+
+	uint64_t dice = rng() % 10;
+	if(sniper || quotes.size() < 64 || dice < 6) {
+		bool buy = rng() & 1;
+		float offset = 0.1f * static_cast<float>(1 + rng() % 40);
+		if(sniper) offset = -offset;
+		o->order_id = next_id++;
+		o->order_type = buy ? 'b' : 's';
+		o->req_type = 'c';
+		o->price = buy ? 130.0f - offset : 130.0f + offset;
+		o->quantity = 1 + static_cast<int>(rng() % 100);
+		if(!sniper) quotes.push_back(Quote{o->order_id, o->trader_id, o->order_type, o->price});
+	} else {
+		size_t pick = rng() % quotes.size();
+		Quote& q = quotes[pick];
+		o->order_id = q.order_id;
+		o->trader_id = q.trader_id;
+		o->order_type = q.side;
+		o->price = q.price;
+		o->req_type = 'd';
+		o->quantity = 0;
+		q = quotes.back();
+		quotes.pop_back();
+	}
+	o->arrived_cycle_count = now_cycles();
+	o->out_cycle_count = o->arrived_cycle_count;
+	lane.updateWrite();
+}
+
+// drains the ack ring, true once the ack of order_id was in it
+static bool sawAck(LFQueue<UserAcknowledgement>& aq, int order_id) {
+	bool seen = false;
+	UserAcknowledgement* ack;
+	while((ack = aq.getNextRead()) != nullptr) {
+		if(ack->order_id == order_id) seen = true;
+		aq.updateRead();
+	}
+	return seen;
+}
+
+template<Topology T>
+static PipelineRun run(size_t count) {
+	constexpr bool FUSED = (T == Topology::FUSED);
+
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> mmoq(RING);
+	LFQueue<UserAcknowledgement> saq(RING * 4);
+	LFQueue<UserAcknowledgement> mmaq(RING * 4);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING * 4);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	MatchingEngine engine(TICKS, 400, &loq, &laq, &bq);
+	auto downstream = [&]() {
+		if constexpr (FUSED) return &engine;
+		else return &loq;
+	}();
+	PipelineGateway<FUSED> ogw(&laq, &soq, &mmoq, downstream);
+	ogw.setThrottleCycles(0);
+	ogw.setAckRoute(SNIPER, &saq);
+	for(int t = 0; t < MM_TRADERS; t++) ogw.setAckRoute(static_cast<short>(FIRST_MM + t), &mmaq);
+
+	std::atomic<bool> stop{false};
+	std::thread* engine_thread = nullptr;
+	if constexpr (T == Topology::SPLIT_THREADED) {
+		engine_thread = createAndStartThread(1, "Matching Engine", [&]() {
+			while(!stop.load(std::memory_order_acquire)) engine.readOrder();
+		});
+	}
+
+	PipelineRun out;
+	out.round_trip.reserve(count);
+	std::mt19937_64 rng(29);
+	std::vector<Quote> quotes;
+	int next_sniper_id = 0, next_mm_id = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		bool sniper = (rng() % 20 == 0);
+		LFQueue<UserOrder>& lane = sniper ? soq : mmoq;
+		LFQueue<UserAcknowledgement>& acks = sniper ? saq : mmaq;
+		writeOrder(rng, quotes, sniper ? next_sniper_id : next_mm_id, sniper, lane);
+		int order_id = lane.getNextRead()->order_id;
+		uint64_t stamp = lane.getNextRead()->arrived_cycle_count;
+
+		while(true) {
+			ogw.poll();
+			if constexpr (T == Topology::SPLIT_STEPPED) {
+				while(loq.getNextRead() != nullptr) engine.readOrder();
+			}
+			if(sawAck(acks, order_id)) break;
+		}
+		out.round_trip.push_back(now_cycles() - stamp);
+		while(bq.getNextRead() != nullptr) bq.updateRead(); // stands in for the publisher, off the clock
+	}
+
+	if constexpr (T == Topology::SPLIT_THREADED) {
+		stop.store(true, std::memory_order_release);
+		engine_thread->join();
+		delete engine_thread;
+	}
+	out.tick_to_trade = engine.getTickToTradeTimes();
+	out.broadcast_dropped = engine.getBroadcastDropped();
+	return out;
+}
+
+// one sniper order sweeps more resting orders than the ack ring has room for acks (fill + fill + release per passive order).
+// fused, the engine has to drain the ring through the gateway mid order, waiting for it would never end
+static bool sweepCheck() {
+	static constexpr int RESTING = 200;
+
+	LFQueue<UserOrder> soq(16);
+	LFQueue<UserOrder> mmoq(RESTING);
+	LFQueue<UserAcknowledgement> saq(RESTING * 2);
+	LFQueue<UserAcknowledgement> mmaq(RESTING * 4);
+	LFQueue<LOBOrder> loq(16); // unused, fused
+	LFQueue<LOBAcknowledgement> laq(32); // 256 slots, the sweep makes 3 x RESTING acks
+	LFQueue<BroadcastElement> bq(RESTING * 4);
+
+	MatchingEngine engine(TICKS, 400, &loq, &laq, &bq);
+	FusedOrderGateway ogw(&laq, &soq, &mmoq, &engine);
+	ogw.setThrottleCycles(0);
+	ogw.setAckRoute(SNIPER, &saq);
+	for(int t = 0; t < MM_TRADERS; t++) ogw.setAckRoute(static_cast<short>(FIRST_MM + t), &mmaq);
+
+	auto send = [&](LFQueue<UserOrder>& lane, short trader, int id, char side, float price, int qty) {
+		UserOrder* o = lane.getNextWrite();
+		*o = UserOrder{now_cycles(), id, trader, side, 'c', price, qty, 0};
+		lane.updateWrite();
+		while(lane.getNextRead() != nullptr) ogw.poll();
+	};
+	for(int i = 0; i < RESTING; i++) send(mmoq, static_cast<short>(FIRST_MM + i % MM_TRADERS), i, 's', 130.0f, 5);
+	send(soq, SNIPER, 0, 'b', 131.0f, RESTING * 5);
+	ogw.poll();
+
+	int fills = 0;
+	while(UserAcknowledgement* ack = saq.getNextRead()) { fills += (ack->status == 'T'); saq.updateRead(); }
+	bool ok = (fills == RESTING && ogw.liveSystemIds() == 0);
+	std::cout << " sweep of " << RESTING << " resting orders through a 256 slot ack ring : " << fills << " sniper fills , "
+			  << ogw.liveSystemIds() << " ids still live " << (ok ? "ok" : "FAILED") << "\n\n";
+	return ok;
+}
+
+static void report(const std::string& name, PipelineRun& r, double cpns) {
+	std::string ttt = name + " : tick-to-trade (gateway pickup -> engine done)";
+	showBench(ttt, r.tick_to_trade, cpns);
+	std::string rtt = name + " : producer stamp -> ack";
+	showBench(rtt, r.round_trip, cpns);
+	std::cout << " " << name << " : " << r.broadcast_dropped << " market data changes dropped (broadcast queue full)\n\n";
+}
+
+int main(int argc, char** argv) {
+
+	size_t count = (argc > 1) ? std::stoul(argv[1]) : 200000;
+	double cpns = get_cycles_per_ns();
+	unsigned cores = std::thread::hardware_concurrency();
+
+	std::cout << "[FUSED PIPELINE BENCH] " << count << " orders, one in flight , " << cores << " hardware threads\n\n";
+
+	bool ok = sweepCheck();
+
+	PipelineRun fused = run<Topology::FUSED>(count);
+	PipelineRun stepped = run<Topology::SPLIT_STEPPED>(count);
+	report("fused", fused, cpns);
+	report("split, one thread", stepped, cpns);
+	ok &= (fused.broadcast_dropped == 0 && stepped.broadcast_dropped == 0);
+
+	if(cores >= 2) {
+		PipelineRun threaded = run<Topology::SPLIT_THREADED>(count);
+		report("split, engine on its own core", threaded, cpns);
+		ok &= (threaded.broadcast_dropped == 0);
+	} else {
+		std::cout << " split with the engine on its own core needs 2 cores, skipped\n";
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// benchmark for N partitioned order gateways in front of one matching engine (gateway g owns id slot range g, its own
+// tree / LUT / allocator, the engine fans their LOB queues in round robin and routes acks back by id).
+// every gateway gets the same share of one flow (new orders resting away from the spread, each cancelled 1000 orders later,
+// so ids are released and recycled all along) and N = 1, 2, 4 are run :
+//   stepped  : every gateway and the engine on this thread, a gateway drains a block of its lane then the engine drains
+//              what it forwarded. the cycles of each gateway and of the engine are counted apart ---> what one gateway
+//              does per second on its own core, and what the engine can absorb. projected = min(N x gateway, engine)
+//   threaded : gateway g on core g + 1, engine on core 0, wall clock orders/s (needs N + 1 cores, skipped otherwise)
+// gateway_scaling_bench [orders in total] [max gateways]
+
+#include <thread>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "thread_utils.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t TICKS = 10000;
+static constexpr int CANCEL_AFTER = 1000; // an order is cancelled this many new orders later
+static constexpr size_t BLOCK = 256;      // stepped run : orders a gateway forwards before the engine takes over
+
+struct Rig {
+	int n;
+	std::vector<LFQueue<UserOrder>*> lanes;
+	std::vector<LFQueue<LOBOrder>*> loqs;
+	std::vector<LFQueue<LOBAcknowledgement>*> laqs;
+	LFQueue<UserOrder> idle{1};
+	LFQueue<BroadcastElement> bq;
+	MatchingEngine* engine;
+	std::vector<OrderGateway*> gateways;
+	size_t per_gateway = 0;
+
+	Rig(int gateways_n, size_t orders) : n(gateways_n), bq(orders * 2) {
+		size_t creates = orders / n / 2 + CANCEL_AFTER / 2;
+		for(int g = 0; g < n; g++) {
+			lanes.push_back(new LFQueue<UserOrder>(creates * 2));
+			loqs.push_back(new LFQueue<LOBOrder>(BLOCK * 64));
+			laqs.push_back(new LFQueue<LOBAcknowledgement>(BLOCK * 256));
+		}
+		engine = new MatchingEngine(TICKS, 400, loqs, laqs, &bq);
+		for(int g = 0; g < n; g++) {
+			gateways.push_back(new OrderGateway(laqs[g], lanes[g], &idle, loqs[g], g, n));
+			gateways[g]->setThrottleCycles(0);
+		}
+
+		// trader g + 1 on gateway g, resting orders on 400 price levels a side, away from the spread (no trades)
+		for(int g = 0; g < n; g++) {
+			LFQueue<UserOrder>& lane = *lanes[g];
+			size_t written = 0;
+			for(int i = 0; written < orders / n; i++) {
+				auto put = [&](int id, char req) {
+					UserOrder* o = lane.getNextWrite();
+					bool buy = (id & 1) == 0;
+					o->order_id = id;
+					o->trader_id = static_cast<short>(g + 1);
+					o->order_type = buy ? 'b' : 's';
+					o->req_type = req;
+					o->price = buy ? 100.0f - 0.1f * static_cast<float>(id % 400) : 130.0f + 0.1f * static_cast<float>(id % 400);
+					o->quantity = (req == 'c') ? 10 : 0;
+					o->arrived_cycle_count = 0;
+					lane.updateWrite();
+					written++;
+				};
+				put(i, 'c');
+				if(i >= CANCEL_AFTER && written < orders / n) put(i - CANCEL_AFTER, 'd');
+			}
+			per_gateway = written;
+		}
+	}
+
+	~Rig() {
+		for(OrderGateway* g : gateways) delete g;
+		delete engine;
+		for(int g = 0; g < n; g++) {
+			delete lanes[g];
+			delete loqs[g];
+			delete laqs[g];
+		}
+	}
+
+	bool drained(int g) { return lanes[g]->getNextRead() == nullptr && loqs[g]->getNextRead() == nullptr && laqs[g]->getNextRead() == nullptr; }
+};
+
+struct Stepped {
+	std::vector<uint64_t> gateway_cycles;
+	uint64_t engine_cycles = 0;
+	uint64_t orders = 0;
+	uint64_t rejects = 0;
+};
+
+static Stepped runStepped(int n, size_t orders) {
+	Rig rig(n, orders);
+	Stepped out;
+	out.gateway_cycles.assign(n, 0);
+	out.orders = rig.per_gateway * n;
+
+	bool busy = true;
+	while(busy) {
+		busy = false;
+		for(int g = 0; g < n; g++) {
+			if(rig.drained(g)) continue;
+			busy = true;
+
+			uint64_t start = now_cycles();
+			for(size_t k = 0; k < BLOCK && rig.lanes[g]->getNextRead() != nullptr; k++) rig.gateways[g]->poll();
+			while(rig.laqs[g]->getNextRead() != nullptr) rig.gateways[g]->poll(); // acks of the previous block
+			out.gateway_cycles[g] += now_cycles() - start;
+
+			start = now_cycles();
+			while(rig.loqs[g]->getNextRead() != nullptr) rig.engine->readOrder();
+			out.engine_cycles += now_cycles() - start;
+		}
+	}
+	for(int g = 0; g < n; g++) out.rejects += rig.gateways[g]->getRiskRejects();
+	return out;
+}
+
+static double runThreaded(int n, size_t orders) {
+	Rig rig(n, orders);
+	std::atomic<bool> go{false};
+	std::atomic<bool> stop{false};
+	std::atomic<int> done{0};
+
+	std::thread* engine_thread = createAndStartThread(0, "Matching Engine", [&]() {
+		while(!stop.load(std::memory_order_acquire)) rig.engine->readOrder();
+	});
+	std::vector<std::thread*> threads;
+	for(int g = 0; g < n; g++) {
+		threads.push_back(createAndStartThread(g + 1, "Order Gateway", [&, g]() {
+			while(!go.load(std::memory_order_acquire)) {}
+			while(!rig.drained(g)) rig.gateways[g]->poll();
+			done.fetch_add(1, std::memory_order_acq_rel);
+		}));
+	}
+
+	uint64_t start = now_cycles();
+	go.store(true, std::memory_order_release);
+	while(done.load(std::memory_order_acquire) < n) std::this_thread::yield();
+	uint64_t cycles = now_cycles() - start;
+
+	stop.store(true, std::memory_order_release);
+	engine_thread->join();
+	delete engine_thread;
+	for(std::thread* t : threads) {
+		t->join();
+		delete t;
+	}
+	return static_cast<double>(rig.per_gateway * n) / (static_cast<double>(cycles) / get_cycles_per_ns() * 1e-9);
+}
+
+int main(int argc, char** argv) {
+
+	size_t orders = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+	int max_gateways = (argc > 2) ? std::stoi(argv[2]) : 4;
+	double cpns = get_cycles_per_ns();
+	unsigned cores = std::thread::hardware_concurrency();
+
+	std::cout << "[GATEWAY SCALING BENCH] " << orders << " orders (creates + cancels) split over N gateways , " << cores
+			  << " hardware threads\n\n";
+
+	auto rate = [&](uint64_t count, uint64_t cycles) { return static_cast<double>(count) / (static_cast<double>(cycles) / cpns * 1e-9) * 1e-6; };
+
+	for(int n = 1; n <= max_gateways; n *= 2) {
+		Stepped s = runStepped(n, orders);
+		uint64_t per_gateway = s.orders / n;
+
+		double slowest = 1e30;
+		std::cout << " N = " << n << " stepped : per gateway";
+		for(int g = 0; g < n; g++) {
+			double r = rate(per_gateway, s.gateway_cycles[g]);
+			slowest = std::min(slowest, r);
+			std::cout << " " << r;
+		}
+		double engine = rate(s.orders, s.engine_cycles);
+		std::cout << " M orders/s , engine " << engine << " M orders/s , projected " << std::min(slowest * n, engine)
+				  << " M orders/s , risk rejects " << s.rejects << "\n";
+
+		if(cores >= static_cast<unsigned>(n + 1)) {
+			std::cout << " N = " << n << " threaded : " << runThreaded(n, orders) * 1e-6 << " M orders/s\n";
+		} else {
+			std::cout << " N = " << n << " threaded : needs " << n + 1 << " cores, skipped\n";
+		}
+	}
+	return 0;
+}
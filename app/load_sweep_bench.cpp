@@ -0,0 +1,82 @@
+// latency vs throughput of the gateway -> engine pipeline under open loop load (load_generator.cpp).
+// for every target rate a fresh gateway + engine get `duration` seconds worth of requests on a fixed TSC timeline, latency is
+// measured from the intended send time to the ack. the pipeline runs cooperatively on this thread (generator, gateway,
+// engine, ack path each get a turn per round), so the saturation point is that of the whole pipeline on one core.
+// saturation = the last rate that still achieved 95% of its target with a corrected p50 within 10x the lowest rate's p50
+// (past that point a backlog builds and the median itself climbs, the tail is already noisy below it). refused requests are
+// counted on their own and keep a rate from qualifying.
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/load_generator.cpp"
+
+using namespace internal_lib;
+
+static constexpr short TRADER = 1;
+static constexpr size_t RING = 1 << 14;
+
+static LoadResult runRate(double rate, double duration, bool poisson, double cpns) {
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> idle_oq(1);
+	LFQueue<UserAcknowledgement> saq(RING);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	MatchingEngine engine(10000, 400, &loq, &laq, &bq);
+	OrderGateway ogw(&laq, &soq, &idle_oq, &loq);
+	ogw.setThrottleCycles(0);
+	ogw.setAckRoute(TRADER, &saq);
+
+	LoadGenerator gen(&soq, &saq, TRADER, cpns);
+	gen.setPoisson(poisson);
+
+	uint64_t count = static_cast<uint64_t>(rate * duration);
+	uint64_t deadline = now_cycles() + static_cast<uint64_t>((duration * 4 + 1) * 1e9 * cpns); // give up on a hopeless backlog
+	gen.begin(rate, count, now_cycles());
+
+	while(!gen.done()) {
+		uint64_t now = now_cycles();
+		if(now > deadline) break;
+		gen.poll(now);
+		ogw.pollOrders();
+		engine.readOrder();
+		for(int k = 0; k < 4 && laq.getNextRead() != nullptr; k++) ogw.pollAcknowledgement(); // an order makes up to 3 acks, the engine spins on a full ack queue
+		while(bq.getNextRead() != nullptr) bq.updateRead();
+	}
+	return gen.result(rate);
+}
+
+int main(int argc, char** argv) {
+
+	double duration = (argc > 1) ? std::stod(argv[1]) : 0.25; // seconds per rate
+	bool poisson = (argc > 2) && std::string(argv[2]) == "poisson";
+
+	double cpns = get_cycles_per_ns();
+	const double rates[] = {50e3, 100e3, 200e3, 400e3, 600e3, 800e3, 1000e3, 1200e3, 1500e3, 2000e3};
+
+	std::cout << "[LOAD SWEEP BENCH] " << duration << " s per rate , " << (poisson ? "poisson" : "fixed interval") << " arrivals\n\n";
+	std::cout << "   target/s   achieved/s    p50 ns      p99 ns    p99.9 ns      max ns   raw p99 ns   rejected\n";
+
+	double base_p50 = 0;
+	double saturation = 0;
+	bool saturated = false;
+	for(double rate : rates) {
+		LoadResult r = runRate(rate, duration, poisson, cpns);
+		printf(" %10.0f %12.0f %9.0f %11.0f %11.0f %11.0f %12.0f %10llu\n", r.target_rate, r.achieved_rate, r.p50_ns, r.p99_ns, r.p999_ns, r.max_ns, r.raw_p99_ns,
+			   static_cast<unsigned long long>(r.rejected));
+
+		if(base_p50 == 0) base_p50 = r.p50_ns;
+		bool ok = r.acked == r.requests && r.requests > 0 && r.achieved_rate >= 0.95 * rate && r.p50_ns <= 10 * base_p50;
+		if(ok && !saturated) saturation = rate;
+		else saturated = true;
+	}
+
+	std::cout << "\n saturation : ~" << saturation << " requests/s (next rate misses its target or builds a backlog)\n";
+	return 0;
+}
@@ -0,0 +1,57 @@
+// binary log (log_format.h) ---> text, one line per record :
+//
+//   log_decode <in.log> [out.txt]        (stdout without out.txt)
+//
+// <time stamp> <component> core <core id> <payload through the token's format string from the file's registry>
+// a record of a token the registry does not know is printed with its token number and the raw payload.
+
+#include <cstdio>
+#include <iostream>
+
+#include "log_format.h"
+
+using namespace internal_lib;
+
+static const char* componentName(uint8_t component) {
+	static const char* names[] = {"MKT_DATA", "LOB_ENGINE", "ORDER_GATEWAY", "SYSTEM_CORE"};
+	return (component < 4) ? names[component] : "UNKNOWN";
+}
+
+int main(int argc, char** argv) {
+
+	if(argc < 2) {
+		std::cerr << "usage : log_decode <in.log> [out.txt]\n";
+		return 2;
+	}
+
+	LogReader reader;
+	if(!reader.open(argv[1])) {
+		std::cerr << "log_decode : " << argv[1] << " is not a readable v" << LOG_VERSION << " log\n";
+		return 1;
+	}
+
+	FILE* out = (argc > 2) ? std::fopen(argv[2], "w") : stdout;
+	if(out == nullptr) {
+		std::cerr << "log_decode : can not create " << argv[2] << "\n";
+		return 1;
+	}
+
+	static char io_buffer[1 << 20];
+	std::setvbuf(out, io_buffer, _IOFBF, sizeof(io_buffer));
+
+	LogRecord r;
+	char text[512];
+	uint64_t records = 0;
+	uint64_t unknown = 0;
+	while(reader.next(r)) {
+		formatPayload(reader.getRegistry(), r, text, sizeof(text));
+		if(reader.getRegistry().format(r.string_token) == nullptr) unknown++;
+		std::fprintf(out, "%llu %s core %d %s\n", static_cast<unsigned long long>(r.time_stamp), componentName(r.component), r.core_id, text);
+		records++;
+	}
+
+	bool ok = (std::fflush(out) == 0);
+	if(out != stdout) ok = (std::fclose(out) == 0) && ok;
+	std::cerr << "log_decode : " << records << " records , " << reader.getRegistry().count() << " tokens , " << unknown << " unregistered\n";
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+// benchmark for logging on the order path (LogProducer in logger.h, wired into the engine and the gateway).
+// the split pipeline on one thread (OrderGateway + LOB queue + engine stepped here, as in fused_pipeline_bench) runs the same
+// synthetic flow one order at a time :
+//   no logger        : nothing attached, every log call is a null check
+//   logger attached  : engine and gateway write their records, an Async_Logger stepped on this thread (poll() between
+//                      orders, outside the measured window) packs them into a file
+// reports the engine's tick-to-trade and the gateway's processing time for both, then reads the log back : one engine record
+// per ack, one gateway record per forwarded order / reject. the log rings are small (128 KB) : a record is a store into a
+// line that is still in cache, a ring sized like the order rings puts a cold line under every record. built twice : log_overhead_bench (default level, info) and
+// log_overhead_bench_off (CAPITOL_LOG_LEVEL=4, every call compiled out, the file holds no records).
+// log_overhead_bench [orders] [log path]
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "logger.h"
+#include "log_format.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr short SNIPER = 1;
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+static constexpr size_t RING = 1 << 16;
+static constexpr size_t TICKS = 10000;
+static constexpr int ROUNDS = 5;
+static constexpr size_t LOG_RING = 256; // 2048 slots , 128 KB per producer : stays in cache, the logger drains it between orders
+
+struct Quote {
+	int order_id;
+	short trader_id;
+	char side;
+	float price;
+};
+
+struct LogRun {
+	std::vector<uint64_t> tick_to_trade;
+	std::vector<uint64_t> gateway;
+	uint64_t engine_acks = 0;	// user acks that came from the engine (C U D T K)
+	uint64_t rejects = 0;		// gateway rejects ('R')
+	uint64_t dropped = 0;		// records the producers could not queue
+};
+
+// one order of the synthetic flow into its lane (creates and cancels, sniper orders cross the spread)
+static void writeOrder(std::mt19937_64& rng, std::vector<Quote>& quotes, int& next_id, bool sniper, LFQueue<UserOrder>& lane) {
+	UserOrder* o = lane.getNextWrite();
+	o->trader_id = sniper ? SNIPER : static_cast<short>(FIRST_MM + rng() % MM_TRADERS);
+
+	uint64_t dice = rng() % 10;
+	if(sniper || quotes.size() < 64 || dice < 6) {
+		bool buy = rng() & 1;
+		float offset = 0.1f * static_cast<float>(1 + rng() % 40);
+		if(sniper) offset = -offset;
+		o->order_id = next_id++;
+		o->order_type = buy ? 'b' : 's';
+		o->req_type = 'c';
+		o->price = buy ? 130.0f - offset : 130.0f + offset;
+		o->quantity = 1 + static_cast<int>(rng() % 100);
+		if(!sniper) quotes.push_back(Quote{o->order_id, o->trader_id, o->order_type, o->price});
+	} else {
+		size_t pick = rng() % quotes.size();
+		Quote& q = quotes[pick];
+		o->order_id = q.order_id;
+		o->trader_id = q.trader_id;
+		o->order_type = q.side;
+		o->price = q.price;
+		o->req_type = 'd';
+		o->quantity = 0;
+		q = quotes.back();
+		quotes.pop_back();
+	}
+	o->arrived_cycle_count = now_cycles();
+	o->out_cycle_count = o->arrived_cycle_count;
+	lane.updateWrite();
+}
+
+// drains the ack ring, true once the ack of order_id was in it
+static bool sawAck(LFQueue<UserAcknowledgement>& aq, int order_id, LogRun& out) {
+	bool seen = false;
+	UserAcknowledgement* ack;
+	while((ack = aq.getNextRead()) != nullptr) {
+		if(ack->order_id == order_id) seen = true;
+		if(ack->status == 'R') out.rejects++;
+		else out.engine_acks++;
+		aq.updateRead();
+	}
+	return seen;
+}
+
+static LogRun run(size_t count, Async_Logger* logger, LFQueue<LogElement>* lob_log, LFQueue<LogElement>* ogw_log) {
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> mmoq(RING);
+	LFQueue<UserAcknowledgement> saq(RING * 4);
+	LFQueue<UserAcknowledgement> mmaq(RING * 4);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING * 4);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	MatchingEngine engine(TICKS, 400, &loq, &laq, &bq);
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setThrottleCycles(0);
+	ogw.setAckRoute(SNIPER, &saq);
+	for(int t = 0; t < MM_TRADERS; t++) ogw.setAckRoute(static_cast<short>(FIRST_MM + t), &mmaq);
+
+	engine.attachLogger(lob_log, 1);
+	ogw.attachLogger(ogw_log, 2);
+
+	LogRun out;
+	std::mt19937_64 rng(29);
+	std::vector<Quote> quotes;
+	int next_sniper_id = 0, next_mm_id = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		bool sniper = (rng() % 20 == 0);
+		LFQueue<UserOrder>& lane = sniper ? soq : mmoq;
+		LFQueue<UserAcknowledgement>& acks = sniper ? saq : mmaq;
+		writeOrder(rng, quotes, sniper ? next_sniper_id : next_mm_id, sniper, lane);
+		int order_id = lane.getNextRead()->order_id;
+
+		while(true) {
+			ogw.poll();
+			while(loq.getNextRead() != nullptr) engine.readOrder();
+			if(sawAck(acks, order_id, out)) break;
+		}
+		while(bq.getNextRead() != nullptr) bq.updateRead(); // stands in for the publisher
+		if(logger != nullptr) logger->poll();
+	}
+	// acks of the other lane still waiting in their rings
+	while(laq.getNextRead() != nullptr) ogw.poll();
+	sawAck(saq, -1, out);
+	sawAck(mmaq, -1, out);
+
+	out.tick_to_trade = engine.getTickToTradeTimes();
+	out.gateway = ogw.getProcessingTimes();
+	out.dropped = engine.getLogDropped() + ogw.getLogDropped();
+	return out;
+}
+
+int main(int argc, char** argv) {
+
+	size_t count = (argc > 1) ? std::stoul(argv[1]) : 200000;
+	std::string path = (argc > 2) ? argv[2] : "/tmp/capitol_log_overhead_bench.log";
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[LOG OVERHEAD BENCH] " << count << " orders, one in flight , compiled log level " << CAPITOL_LOG_LEVEL
+			  << " (0 debug .. 4 off)\n\n";
+
+	LogRegistry tokens;
+	registerCoreLogTokens(tokens);
+	LFQueue<LogElement> lob_log(LOG_RING);
+	LFQueue<LogElement> ogw_log(LOG_RING);
+	Async_Logger logger(path, nullptr, &lob_log, &ogw_log, &tokens);
+	if(!logger.open()) {
+		std::cout << " can not create " << path << "\n";
+		return 1;
+	}
+
+	// the two setups take turns (ROUNDS runs each, samples pooled) so a noisy stretch of the box hits both alike
+	LogRun off, on;
+	for(int round = 0; round < ROUNDS; round++) {
+		LogRun a = run(count / ROUNDS, nullptr, nullptr, nullptr);
+		LogRun b = run(count / ROUNDS, &logger, &lob_log, &ogw_log);
+		off.tick_to_trade.insert(off.tick_to_trade.end(), a.tick_to_trade.begin(), a.tick_to_trade.end());
+		off.gateway.insert(off.gateway.end(), a.gateway.begin(), a.gateway.end());
+		on.tick_to_trade.insert(on.tick_to_trade.end(), b.tick_to_trade.begin(), b.tick_to_trade.end());
+		on.gateway.insert(on.gateway.end(), b.gateway.begin(), b.gateway.end());
+		on.engine_acks += b.engine_acks;
+		on.rejects += b.rejects;
+		on.dropped += b.dropped;
+	}
+	logger.close();
+
+	std::string a = "no logger : tick-to-trade (gateway pickup -> engine done)";
+	showBench(a, off.tick_to_trade, cpns);
+	std::string b = "logger attached : tick-to-trade (gateway pickup -> engine done)";
+	showBench(b, on.tick_to_trade, cpns);
+	std::string c = "no logger : gateway processing";
+	showBench(c, off.gateway, cpns);
+	std::string d = "logger attached : gateway processing";
+	showBench(d, on.gateway, cpns);
+
+	// read back : per token record counts against what the run saw
+	LogReader reader;
+	if(!reader.open(path.c_str())) {
+		std::cout << " can not read " << path << " back\n";
+		return 1;
+	}
+	LogRecord r;
+	uint64_t engine_records = 0, orders = 0, rejects = 0, risk = 0, other = 0;
+	while(reader.next(r)) {
+		switch(r.string_token) {
+			case LOG_ENGINE_ACCEPT : case LOG_ENGINE_FILL : case LOG_ENGINE_CANCEL : case LOG_ENGINE_REJECT : engine_records++; break;
+			case LOG_GATEWAY_ORDER : orders++; break;
+			case LOG_GATEWAY_REJECT : rejects++; break;
+			case LOG_GATEWAY_RISK : risk++; break;
+			default : other++; break;
+		}
+	}
+
+	bool info = logEnabled<LogLevel::INFO>();
+	bool warn = logEnabled<LogLevel::WARN>();
+	uint64_t expect_engine = info ? on.engine_acks : 0;
+	uint64_t expect_orders = info ? count / ROUNDS * ROUNDS - on.rejects : 0;
+	uint64_t expect_rejects = warn ? on.rejects : 0;
+	bool ok = (engine_records == expect_engine && orders == expect_orders && rejects == expect_rejects && other == 0 &&
+			   on.dropped == 0 && !logger.writeFailed());
+
+	std::cout << " log : " << logger.getRecordsWritten() << " records , " << engine_records << " engine (" << on.engine_acks
+			  << " acks) , " << orders << " forwarded orders , " << rejects << " rejects (" << on.rejects << " seen) , " << risk
+			  << " risk rejects , " << on.dropped << " dropped : " << (ok ? "ok" : "MISMATCH") << "\n";
+
+	if(argc <= 2) std::remove(path.c_str());
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// benchmark for the binary async logger (logger.h, log_format.h).
+// this thread writes N log elements round robin into the three producer queues (market data, engine, gateway) as fast as
+// the logger drains them, the logger thread packs them into the file. reports records/s and MB/s from the first write to
+// the last byte on disk, then reads the file back : every record there, each producer's sequence numbers in order, and
+// how long turning the records into text takes (the work the logger thread no longer does).
+// logger_bench [records] [log path]
+
+#include <thread>
+#include <cstdio>
+
+#include "lf_queue.h"
+#include "logger.h"
+#include "log_format.h"
+#include "thread_utils.h"
+#include "benchmark_utility.h"
+
+using namespace internal_lib;
+
+static constexpr size_t RING = 1 << 16;
+
+enum : int32_t { TOKEN_MKT = 1, TOKEN_LOB = 2, TOKEN_OGW = 3 };
+
+int main(int argc, char** argv) {
+
+	uint64_t count = (argc > 1) ? std::stoull(argv[1]) : 10000000;
+	std::string path = (argc > 2) ? argv[2] : "/tmp/capitol_logger_bench.log";
+	double cpns = get_cycles_per_ns();
+
+	LogRegistry tokens;
+	tokens.add(TOKEN_MKT, "market data seq {i32}");
+	tokens.add(TOKEN_LOB, "engine seq {i32}");
+	tokens.add(TOKEN_OGW, "gateway seq {i64}");
+
+	LFQueue<LogElement> mkt_q(RING);
+	LFQueue<LogElement> lob_q(RING);
+	LFQueue<LogElement> ogw_q(RING);
+	LFQueue<LogElement>* queues[3] = {&mkt_q, &lob_q, &ogw_q};
+
+	Async_Logger logger(path, &mkt_q, &lob_q, &ogw_q, &tokens);
+
+	uint64_t start = now_cycles();
+	std::thread* logger_thread = createAndStartThread(-1, "Logger", [&]() { logger.run(); });
+
+	uint64_t full_spins = 0;
+	int32_t seq[3] = {0, 0, 0};
+	for(uint64_t i = 0; i < count; i++) {
+		int q = static_cast<int>(i % 3);
+		LogElement* e;
+		while((e = queues[q]->getNextWrite()) == nullptr) {
+			full_spins++;
+			std::this_thread::yield();
+		}
+		e->time_stamp = i;
+		e->component = static_cast<ComponentId>(q);
+		e->core_id = q;
+		e->string_token = TOKEN_MKT + q;
+		switch(q) {
+			case 0 : e->data_object.mkt.x = seq[0]++; break;
+			case 1 : e->data_object.lob.system_id = seq[1]++; break;
+			default : e->data_object.ogw.order_id = seq[2]++; break;
+		}
+		queues[q]->updateWrite();
+	}
+
+	logger.stop();
+	logger_thread->join();
+	delete logger_thread;
+	double seconds = static_cast<double>(now_cycles() - start) / cpns * 1e-9;
+
+	std::cout << "[LOGGER BENCH] " << count << " records -> " << logger.getRecordsWritten() << " written , "
+			  << logger.getBytesWritten() / (1 << 20) << " MB (" << sizeof(LogRecord) << " byte records) in " << seconds << " s\n"
+			  << " " << static_cast<double>(count) / seconds * 1e-6 << " M records/s , "
+			  << static_cast<double>(logger.getBytesWritten()) / seconds / (1 << 20) << " MB/s , producer found a queue full "
+			  << full_spins << " times\n";
+
+	// read back
+	LogReader reader;
+	if(!reader.open(path.c_str())) {
+		std::cout << " can not read " << path << " back\n";
+		return 1;
+	}
+	LogRecord r;
+	uint64_t read = 0, out_of_order = 0;
+	int32_t expect[3] = {0, 0, 0};
+	char text[256];
+	uint64_t text_bytes = 0;
+	uint64_t format_start = now_cycles();
+	while(reader.next(r)) {
+		int32_t value;
+		std::memcpy(&value, r.payload, sizeof(value));
+		int q = r.component;
+		if(q > 2 || value != expect[q]++) out_of_order++;
+		text_bytes += formatPayload(reader.getRegistry(), r, text, sizeof(text));
+		read++;
+	}
+	double format_seconds = static_cast<double>(now_cycles() - format_start) / cpns * 1e-9;
+
+	bool ok = (read == count && out_of_order == 0 && !logger.writeFailed());
+	std::cout << " read back " << read << " records , " << out_of_order << " out of sequence : " << (ok ? "ok" : "MISMATCH") << "\n"
+			  << " offline decode : " << static_cast<double>(read) / format_seconds * 1e-6 << " M records/s (" << text_bytes / (1 << 20)
+			  << " MB of payload text)\n";
+
+	if(argc <= 2) std::remove(path.c_str());
+	return ok ? 0 : 1;
+}
@@ -9,32 +9,102 @@
 #include "../core/src/alpha_tester.cpp"
 #include "../core/src/order_gateway.cpp"
 #include "../core/src/matching_engine.cpp"
+#include "../core/src/market_data_publisher.cpp"
+#include "../core/src/market_maker.cpp"
 
 int main() {
 
 	// each lfqueue defined with 5M size 
 
+	// number of order gateways (power of 2), each one runs on its own core and owns a disjoint slice of the system id space
+	// gateway 0 serves the sniper, every other gateway serves one market maker generator (a block of the 99 market makers)
+	constexpr int NUM_GATEWAYS = 2;
+	constexpr int NUM_MM_GENERATORS = NUM_GATEWAYS - 1;
+
 	internal_lib::LFQueue<internal_lib::UserOrder> soq(1000000); // Sniper Order Queue
 	internal_lib::LFQueue<internal_lib::UserAcknowledgement> saq(1000000); // Sniper Acknoweldgement Queue
-	internal_lib::LFQueue<internal_lib::LOBOrder> loq(1000000); // LOB Order queue
-	internal_lib::LFQueue<internal_lib::LOBAcknowledgement> laq(1000000); // LOB Acknowledgement Queue
-	internal_lib::LFQueue<internal_lib::BroadcastElement> bq(1000000); // broadcast queue
-
-	// a lf queue to denote one strem from market maker but since we have not written market maker right now we won't fill anything yet.
-	internal_lib::LFQueue<internal_lib::UserOrder> mmoq(100); // market maker order queue
-
-
-
+	internal_lib::LFQueue<internal_lib::BroadcastElement> bq(1000000); // broadcast queue ---> market data publisher
+	internal_lib::LFQueue<internal_lib::BroadcastElement> alpha_bq(1000000); // publisher's local copy for the alpha server
+
+	// market maker lanes, one set per generator : orders, cancels / replaces, acks (fills) back
+	std::vector<internal_lib::LFQueue<internal_lib::UserOrder>*> mmoqs;
+	std::vector<internal_lib::LFQueue<internal_lib::UserOrder>*> mmcqs;
+	std::vector<internal_lib::LFQueue<internal_lib::UserAcknowledgement>*> mmaqs;
+	for(int m = 0; m < NUM_MM_GENERATORS; m++) {
+		mmoqs.push_back(new internal_lib::LFQueue<internal_lib::UserOrder>(1000000)); // market maker order queue
+		mmcqs.push_back(new internal_lib::LFQueue<internal_lib::UserOrder>(1000000)); // market maker cancel lane
+		mmaqs.push_back(new internal_lib::LFQueue<internal_lib::UserAcknowledgement>(1000000)); // market maker acks
+	}
+
+	// sniper lane of the market maker gateway, nobody writes to it but the gateway expects one
+	internal_lib::LFQueue<internal_lib::UserOrder> idle_oq(1);
+
+	// one LOB order queue + one LOB acknowledgement queue per gateway
+	std::vector<internal_lib::LFQueue<internal_lib::LOBOrder>*> loqs;
+	std::vector<internal_lib::LFQueue<internal_lib::LOBAcknowledgement>*> laqs;
+	for(int g = 0; g < NUM_GATEWAYS; g++) {
+		loqs.push_back(new internal_lib::LFQueue<internal_lib::LOBOrder>(1000000)); // LOB Order queue
+		laqs.push_back(new internal_lib::LFQueue<internal_lib::LOBAcknowledgement>(1000000)); // LOB Acknowledgement Queue
+	}
 
 
 	// define ME
-	internal_lib::MatchingEngine matchingEngine(10000,400,&loq,&laq,&bq);
-
-	// define OG
-	internal_lib::OrderGateway orderGateway(&laq, &soq, &saq, &mmoq, &loq);
+	internal_lib::MatchingEngine matchingEngine(10000,400,loqs,laqs,&bq);
+	internal_lib::TopOfBook topOfBook(10000);
+	matchingEngine.attachTopOfBook(&topOfBook);
+
+	// audit log : one SPSC log queue per producer thread, [0] is the engine, [1 + g] gateway g. one logger thread drains them all
+	std::vector<internal_lib::LFQueue<internal_lib::LogElement>*> log_queues;
+	for(int p = 0; p < 1 + NUM_GATEWAYS; p++) log_queues.push_back(new internal_lib::LFQueue<internal_lib::LogElement>(100000));
+	internal_lib::LogRegistry log_tokens;
+	internal_lib::registerCoreLogTokens(log_tokens);
+	std::string log_path = "/tmp/capitol.log"; // log_decode /tmp/capitol.log
+	internal_lib::Async_Logger logger(log_path, log_queues, &log_tokens);
+	matchingEngine.attachLogger(log_queues[0], 1);
+
+	// define OGs
+	std::vector<internal_lib::OrderGateway*> orderGateways;
+	orderGateways.push_back(new internal_lib::OrderGateway(laqs[0], &soq, &idle_oq, loqs[0], 0, NUM_GATEWAYS));
+	orderGateways[0]->setAckRoute(1, &saq); // sniper is trader 1
+	for(int g = 1; g < NUM_GATEWAYS; g++) {
+		orderGateways.push_back(new internal_lib::OrderGateway(laqs[g], &idle_oq, mmoqs[g - 1], loqs[g], g, NUM_GATEWAYS));
+		orderGateways[g]->attachCancelLanes(nullptr, mmcqs[g - 1]);
+	}
+	for(int g = 0; g < NUM_GATEWAYS; g++) orderGateways[g]->attachLogger(log_queues[1 + g], 2 + g);
 
 	// define alpha
-	internal_lib::AlphaServer alphaServer(&soq,&saq,&bq);
+	internal_lib::AlphaServer alphaServer(&soq,&saq,&alpha_bq);
+	alphaServer.setTopOfBook(&topOfBook);
+
+	// define market data publisher : multicast on loopback + shm ring, local fan out to alpha
+	internal_lib::MarketDataPublisher marketDataPublisher(&bq);
+	if(!marketDataPublisher.openMulticast("239.255.0.1", 30001)) std::cout << "market data : multicast not available\n";
+	if(!marketDataPublisher.openShmRing("/capitol_md", 4096)) std::cout << "market data : shm ring not available\n";
+	marketDataPublisher.setLocalFanout(&alpha_bq);
+	double cpns = internal_lib::get_cycles_per_ns();
+	marketDataPublisher.setHeartbeatCycles(cpns * 1e6); // 1 ms
+
+	// trade bars : 1 ms and 1 s OHLCV/VWAP, built by the publisher from the trade stream, readable from any thread
+	internal_lib::TradeBars bars_1ms(static_cast<uint64_t>(cpns * 1e6), 1024);
+	internal_lib::TradeBars bars_1s(static_cast<uint64_t>(cpns * 1e9), 256);
+	marketDataPublisher.addTradeBars(&bars_1ms);
+	marketDataPublisher.addTradeBars(&bars_1s);
+
+
+	// market makers : traders 2 .. 100 split in blocks over the generators, quoting around a drifting mid near the sniper's prices
+	constexpr short FIRST_MM = 2;
+	constexpr int MM_TRADERS = 99;
+	internal_lib::MarketMakerConfig mm_config;
+	mm_config.arrival_rate = 100000.0 / NUM_MM_GENERATORS; // events per second per generator
+	std::vector<internal_lib::MarketMaker*> marketMakers;
+	int mm_block = (MM_TRADERS + NUM_MM_GENERATORS - 1) / NUM_MM_GENERATORS;
+	for(int m = 0; m < NUM_MM_GENERATORS; m++) {
+		short first = static_cast<short>(FIRST_MM + m * mm_block);
+		int traders = std::min(mm_block, FIRST_MM + MM_TRADERS - first);
+		marketMakers.push_back(new internal_lib::MarketMaker(mm_config, first, traders, mmoqs[m], mmcqs[m], cpns));
+		marketMakers[m]->setAckQueue(mmaqs[m]);
+		for(int t = 0; t < traders; t++) orderGateways[m + 1]->setAckRoute(static_cast<short>(first + t), mmaqs[m]);
+	}
 
 
 	// create atomic variables for these components to run and terminate on 
@@ -49,6 +119,12 @@ int main() {
 	std::atomic<bool> start_alpha_server = {false};
 	std::atomic<bool> terminate_alpha_server = {false};
 
+	std::atomic<bool> start_market_data = {false};
+	std::atomic<bool> terminate_market_data = {false};
+
+	std::atomic<bool> start_market_makers = {false};
+	std::atomic<bool> terminate_market_makers = {false};
+
 
 
 	// create threads for each 
@@ -57,12 +133,33 @@ int main() {
         matchingEngine.matchingEngineLoop(start_matching_engine, terminate_matching_engine); 
     });
     
-    auto order_gateway_thread = internal_lib::createAndStartThread(2, "Order Gateway", [&](){ 
-        orderGateway.run(start_ordergate_way, terminate_ordergate_way); 
+    std::vector<std::thread*> order_gateway_threads;
+    for(int g = 0; g < NUM_GATEWAYS; g++) {
+        internal_lib::OrderGateway* ogw = orderGateways[g];
+        order_gateway_threads.push_back(internal_lib::createAndStartThread(2 + g, "Order Gateway " + std::to_string(g), [&, ogw](){ 
+            ogw->run(start_ordergate_way, terminate_ordergate_way); 
+        }));
+    }
+
+    auto alpha_server_thread = internal_lib::createAndStartThread(2 + NUM_GATEWAYS, "Alpha Server", [&](){ 
+        alphaServer.AlphaRun(start_alpha_server, terminate_alpha_server); 
     });
 
-    auto alpha_server_thread = internal_lib::createAndStartThread(3, "Alpha Server", [&](){ 
-        alphaServer.AlphaRun(start_alpha_server, terminate_alpha_server); 
+    auto market_data_thread = internal_lib::createAndStartThread(3 + NUM_GATEWAYS, "Market Data Publisher", [&](){ 
+        marketDataPublisher.run(start_market_data, terminate_market_data); 
+    });
+
+    std::vector<std::thread*> market_maker_threads;
+    for(int m = 0; m < NUM_MM_GENERATORS; m++) {
+        internal_lib::MarketMaker* mm = marketMakers[m];
+        market_maker_threads.push_back(internal_lib::createAndStartThread(4 + NUM_GATEWAYS + m, "Market Maker " + std::to_string(m), [&, mm](){ 
+            mm->run(start_market_makers, terminate_market_makers); 
+        }));
+    }
+
+    // the logger is off the hot path, it yields when idle and is stopped only after every producer has been joined
+    auto logger_thread = internal_lib::createAndStartThread(4 + NUM_GATEWAYS + NUM_MM_GENERATORS, "Logger", [&](){ 
+        logger.run(); 
     });
 
 	//  prewarm: burn all cores for 100 seconds to force max turbo frequency
@@ -73,8 +170,12 @@ int main() {
 
 	// start ME, start OG then start AlphaServer
 	std::cout<<"~~~~~~~~~~~~~~~~~~~~~ CAPITOL STARTED ~~~~~~~~~~~~~~~~~~~~~~~~~~~~` "<<"\n";
+	start_market_data.store(true);
 	start_matching_engine.store(true);
 	start_ordergate_way.store(true);
+	uint64_t mm_epoch = internal_lib::now_cycles(); // one mid walk for all generators
+	for(auto* mm : marketMakers) mm->setEpoch(mm_epoch);
+	start_market_makers.store(true);
 	start_alpha_server.store(true);
 
 
@@ -84,9 +185,11 @@ int main() {
 
 	// stop Alpha 
 
+	terminate_market_makers.store(true);
 	terminate_matching_engine.store(true);
 	terminate_ordergate_way.store(true);
 	terminate_alpha_server.store(true);
+	terminate_market_data.store(true);
 
 	
 
@@ -97,13 +200,41 @@ int main() {
 
 	// join threads now
 	matching_engine_thread->join();
-	order_gateway_thread->join();
+	for(auto* t : order_gateway_threads) t->join();
 	alpha_server_thread->join();
+	market_data_thread->join();
+	for(auto* t : market_maker_threads) t->join();
+
+	// producers are gone : the logger drains what is left and closes the file
+	logger.stop();
+	logger_thread->join();
+	uint64_t log_dropped = matchingEngine.getLogDropped();
+	for(auto* ogw : orderGateways) log_dropped += ogw->getLogDropped();
+	std::cout << "[LOGGER] " << logger.getRecordsWritten() << " records -> " << log_path << " , " << log_dropped << " dropped (queue full)"
+			  << (logger.writeFailed() ? " , WRITE FAILED" : "") << "\n";
 
 
 	delete matching_engine_thread;
-	delete order_gateway_thread;
+	for(auto* t : order_gateway_threads) delete t;
 	delete alpha_server_thread;
+	delete market_data_thread;
+	for(auto* t : market_maker_threads) delete t;
+	delete logger_thread;
+
+	for(auto* ogw : orderGateways) delete ogw;
+	for(auto* q : loqs) delete q;
+	for(auto* q : laqs) delete q;
+	for(auto* mm : marketMakers) delete mm;
+	for(auto* q : mmoqs) delete q;
+	for(auto* q : mmcqs) delete q;
+	for(auto* q : mmaqs) delete q;
+	for(auto* q : log_queues) delete q;
+
+	internal_lib::BarView session_bar;
+	if(bars_1s.window(256, session_bar)) {
+		std::cout << "[TRADE BARS] O " << session_bar.open << " H " << session_bar.high << " L " << session_bar.low << " C " << session_bar.close
+				  << " V " << session_bar.volume << " VWAP " << session_bar.vwap << " trades " << session_bar.trades << "\n";
+	}
 
 	std::cout<<"~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ CLOSING CAPITOL ~~~~~~~~~~~~~~~~~~ \n";
 
@@ -0,0 +1,78 @@
+// benchmark for the market data publisher.
+// stands in for the engine : bursts of book changes (stamped like sendIncrementalChange does) go into the broadcast queue,
+// the publisher packs and sends them, a subscriber on the same transport checks the sequence. publish latency = engine
+// event -> packet handed to the transport (queueing behind the rest of the burst included).
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/market_data_publisher.cpp"
+#include "../core/src/market_data_subscriber.cpp"
+
+using namespace internal_lib;
+
+static constexpr const char* MD_GROUP = "239.255.42.1";
+static constexpr uint16_t MD_PORT = 30042;
+static constexpr const char* MD_SHM = "/capitol_md_bench";
+
+static void runFeed(bool shm, int burst, int rounds, double cpns) {
+	LFQueue<BroadcastElement> bq(static_cast<size_t>(burst));
+
+	MarketDataPublisher publisher(&bq);
+	MarketDataSubscriber subscriber;
+
+	bool ok = shm ? publisher.openShmRing(MD_SHM, 4096) && subscriber.attachShmRing(MD_SHM)
+				  : subscriber.joinMulticast(MD_GROUP, MD_PORT) && publisher.openMulticast(MD_GROUP, MD_PORT);
+	if(!ok) {
+		std::cout << (shm ? " shm ring" : " udp multicast") << " not available here, skipped\n\n";
+		return;
+	}
+
+	std::mt19937 rng(5);
+	const char types[4] = {'N', 'U', 'D', 'T'};
+	uint64_t received = 0;
+
+	for(int r = 0; r < rounds; r++) {
+		for(int i = 0; i < burst; i++) {
+			BroadcastElement* be = bq.getNextWrite();
+			be->event_cycle = now_cycles();
+			be->system_id = static_cast<int>(rng() % 100000);
+			be->price = 100.0f + 0.1f * static_cast<float>(rng() % 400);
+			be->quantity = 1 + static_cast<int>(rng() % 100);
+			be->side = (rng() & 1) ? 'B' : 'S';
+			be->type = types[rng() & 3];
+			bq.updateWrite();
+		}
+
+		while(bq.getNextRead() != nullptr) publisher.poll();
+		while(subscriber.poll([&](const char*, uint64_t) { received++; }) != 0) {}
+	}
+
+	// stragglers still in the socket
+	for(int spin = 0; spin < 1000 && received < publisher.getMessages(); spin++) subscriber.poll([&](const char*, uint64_t) { received++; });
+
+	std::string name = std::string("publish latency (") + (shm ? "shm ring" : "udp multicast") + ", burst " + std::to_string(burst) + ")";
+	showBench(name, publisher.getPublishLatencies(), cpns);
+	std::cout << " messages : " << publisher.getMessages() << " in " << publisher.getPackets() << " packets , received : " << received
+			  << " , gaps : " << subscriber.getGapMessages() << " , send errors : " << publisher.getSendErrors()
+			  << " , ring overruns : " << subscriber.getOverruns() << "\n\n";
+}
+
+int main(int argc, char** argv) {
+
+	int rounds = (argc > 1) ? std::stoi(argv[1]) : 20000;
+
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[MD PUBLISHER BENCH] rounds : " << rounds << "\n\n";
+
+	for(int burst : {1, 16}) {
+		runFeed(true, burst, rounds, cpns);
+		runFeed(false, burst, rounds, cpns);
+	}
+
+	return 0;
+}
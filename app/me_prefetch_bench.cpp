@@ -0,0 +1,109 @@
+// benchmark for the matching engine lookahead prefetch.
+// builds a large resting book (default 2M orders spread over 2000 price levels per side, nothing crosses),
+// then runs a cancel/modify heavy workload against random resting orders with the lookahead disabled and enabled.
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/matching_engine.cpp"
+
+static constexpr size_t CHUNK = 50000; // orders pushed per round
+
+struct BenchQueues {
+	internal_lib::LFQueue<internal_lib::LOBOrder> loq{CHUNK};
+	internal_lib::LFQueue<internal_lib::LOBAcknowledgement> laq{CHUNK * 4};
+	internal_lib::LFQueue<internal_lib::BroadcastElement> bq{CHUNK * 4};
+};
+
+// pushes the orders through the engine in chunks and returns the cycles spent inside readOrder()
+uint64_t pump(internal_lib::MatchingEngine& engine, BenchQueues& q, const std::vector<internal_lib::LOBOrder>& orders) {
+	uint64_t total = 0;
+
+	for(size_t base = 0; base < orders.size(); base += CHUNK) {
+		size_t end = std::min(orders.size(), base + CHUNK);
+
+		for(size_t i = base; i < end; i++) {
+			internal_lib::LOBOrder* w = q.loq.getNextWrite();
+			*w = orders[i];
+			w->arrived_cycle_count = internal_lib::now_cycles();
+			w->out_cycle_count = w->arrived_cycle_count;
+			q.loq.updateWrite();
+		}
+
+		uint64_t start = internal_lib::now_cycles();
+		while(q.loq.getNextRead() != nullptr) engine.readOrder();
+		total += internal_lib::now_cycles() - start;
+
+		// act as gateway + market data consumers
+		while(q.laq.getNextRead() != nullptr) q.laq.updateRead();
+		while(q.bq.getNextRead() != nullptr) q.bq.updateRead();
+	}
+	return total;
+}
+
+int main(int argc, char** argv) {
+
+	size_t resting = (argc > 1) ? std::stoul(argv[1]) : 2000000;
+	size_t ops = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+	size_t lookahead = (argc > 3) ? std::stoul(argv[3]) : 8;
+
+	std::mt19937_64 rng(7);
+
+	// resting book : buys at 100.0 - 199.9 , sells at 300.0 - 399.9 --> spread never crossed
+	std::vector<internal_lib::LOBOrder> book(resting);
+	for(size_t i = 0; i < resting; i++) {
+		internal_lib::LOBOrder& o = book[i];
+		bool buy = (i & 1) == 0;
+		o.system_id = static_cast<int>(i);
+		o.order_type = buy ? 'b' : 's';
+		o.price = (buy ? 100.0f : 300.0f) + static_cast<float>(rng() % 1000) * 0.1f;
+		o.quantity = 50 + static_cast<int>(rng() % 50);
+		o.trader_id = 2 + static_cast<short>(rng() % 98); // market makers, no acks generated
+		o.req_type = 'c';
+	}
+
+	// workload : 70% cancels, 30% quantity modifies (down), random resting targets, each order touched once
+	std::vector<size_t> targets(resting);
+	for(size_t i = 0; i < resting; i++) targets[i] = i;
+	std::shuffle(targets.begin(), targets.end(), rng);
+	if(ops > resting) ops = resting;
+
+	std::vector<internal_lib::LOBOrder> workload(ops);
+	for(size_t i = 0; i < ops; i++) {
+		workload[i] = book[targets[i]];
+		if(rng() % 10 < 7) {
+			workload[i].req_type = 'd';
+		} else {
+			workload[i].req_type = 'u';
+			workload[i].quantity -= 1;
+		}
+	}
+
+	std::cout << "[ME PREFETCH BENCH] resting : " << resting << " , cancel/modify ops : " << ops << " , lookahead : " << lookahead << "\n\n";
+
+	double cpns = internal_lib::get_cycles_per_ns();
+	uint64_t run_cycles[2];
+
+	for(int mode = 0; mode < 2; mode++) {
+		BenchQueues q;
+		internal_lib::MatchingEngine engine(10000, 400, &q.loq, &q.laq, &q.bq);
+
+		engine.setPrefetchLookahead(mode == 0 ? 0 : lookahead);
+		pump(engine, q, book);
+		engine.getProcessingTimes().clear();
+
+		run_cycles[mode] = pump(engine, q, workload);
+
+		std::string name = (mode == 0) ? "ME Processing Time (cancel/modify, no lookahead)" : "ME Processing Time (cancel/modify, lookahead)";
+		internal_lib::showBench(name, engine.getProcessingTimes(), cpns);
+	}
+
+	std::cout << " no lookahead : " << (double)run_cycles[0] / ops / cpns << " ns/order (readOrder loop)\n";
+	std::cout << " lookahead    : " << (double)run_cycles[1] / ops / cpns << " ns/order (readOrder loop)\n";
+
+	return 0;
+}
@@ -0,0 +1,214 @@
+// benchmark for the market maker traffic simulator.
+// the 99 market makers (traders 2 .. 100) are split over GENERATORS generators, each on its own gateway (order lane + cancel
+// lane + ack route), all into one engine. everything is driven from this thread on a virtual clock : every slice the
+// generators emit the events due by then, the gateways and the engine drain them. so the numbers are the gateway / engine cost
+// under the simulated flow, not a live thread race (main runs the generators as threads).
+// run once replace heavy (market makers mostly re-price their quotes) and once cancel heavy (they mostly pull and re-post).
+// ackCheck feeds one maker hand made acks : a refused replace must keep its rung, a refused create must free it.
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/market_maker.cpp"
+
+using namespace internal_lib;
+
+static constexpr int GENERATORS = 2;        // = gateways (power of 2)
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+static constexpr size_t RING = 1 << 16;
+
+static void runProfile(const std::string& name, double cancel_ratio, double rate, double seconds, double cpns) {
+	MarketMakerConfig config;
+	config.arrival_rate = rate;
+	config.cancel_ratio = cancel_ratio;
+
+	std::vector<LFQueue<LOBOrder>*> loqs;
+	std::vector<LFQueue<LOBAcknowledgement>*> laqs;
+	std::vector<LFQueue<UserOrder>*> orders, cancels;
+	std::vector<LFQueue<UserAcknowledgement>*> acks;
+	LFQueue<UserOrder> idle_oq(1);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	for(int g = 0; g < GENERATORS; g++) {
+		loqs.push_back(new LFQueue<LOBOrder>(RING));
+		laqs.push_back(new LFQueue<LOBAcknowledgement>(RING * 4));
+		orders.push_back(new LFQueue<UserOrder>(RING));
+		cancels.push_back(new LFQueue<UserOrder>(RING));
+		acks.push_back(new LFQueue<UserAcknowledgement>(RING * 4));
+	}
+
+	MatchingEngine engine(10000, 400, loqs, laqs, &bq);
+
+	std::vector<OrderGateway*> gateways;
+	std::vector<MarketMaker*> makers;
+	uint64_t epoch = now_cycles();
+	int per_generator = (MM_TRADERS + GENERATORS - 1) / GENERATORS;
+
+	for(int g = 0; g < GENERATORS; g++) {
+		short first = static_cast<short>(FIRST_MM + g * per_generator);
+		int traders = std::min(per_generator, FIRST_MM + MM_TRADERS - first);
+
+		OrderGateway* ogw = new OrderGateway(laqs[g], &idle_oq, orders[g], loqs[g], g, GENERATORS);
+		ogw->setThrottleCycles(0);
+		ogw->attachCancelLanes(nullptr, cancels[g]);
+		for(int t = 0; t < traders; t++) ogw->setAckRoute(static_cast<short>(first + t), acks[g]);
+		gateways.push_back(ogw);
+
+		MarketMaker* mm = new MarketMaker(config, first, traders, orders[g], cancels[g], cpns);
+		mm->setAckQueue(acks[g]);
+		mm->setEpoch(epoch);
+		mm->begin(epoch);
+		makers.push_back(mm);
+	}
+
+	// virtual clock : 10 us slices
+	uint64_t slice = static_cast<uint64_t>(10000 * cpns);
+	uint64_t end = epoch + static_cast<uint64_t>(seconds * 1e9 * cpns);
+	uint64_t trades = 0;
+
+	uint64_t wall_start = now_cycles();
+	for(uint64_t now = epoch; now < end; now += slice) {
+		for(auto* mm : makers) mm->poll(now, 1 << 20);
+
+		bool busy = true;
+		while(busy) {
+			busy = false;
+			for(int g = 0; g < GENERATORS; g++) {
+				if(orders[g]->getNextRead() != nullptr || cancels[g]->getNextRead() != nullptr) {
+					gateways[g]->pollOrders();
+					busy = true;
+				}
+			}
+			for(int g = 0; g < GENERATORS; g++) {
+				if(loqs[g]->getNextRead() != nullptr) {
+					engine.readOrder();
+					busy = true;
+				}
+			}
+			for(int g = 0; g < GENERATORS; g++) {
+				while(laqs[g]->getNextRead() != nullptr) gateways[g]->pollAcknowledgement();
+			}
+			BroadcastElement* be;
+			while((be = bq.getNextRead()) != nullptr) {
+				if(be->type == 'T') trades++;
+				bq.updateRead();
+			}
+		}
+		for(auto* mm : makers) mm->poll(now, 0); // fills back to the makers
+	}
+	double wall_ns = static_cast<double>(now_cycles() - wall_start) / cpns;
+
+	uint64_t events = 0, creates = 0, cancelled = 0, replaced = 0, dropped = 0;
+	int live = 0;
+	for(auto* mm : makers) {
+		events += mm->getEvents();
+		creates += mm->getCreates();
+		cancelled += mm->getCancels();
+		replaced += mm->getReplaces();
+		dropped += mm->getDropped();
+		live += mm->getLiveQuotes();
+	}
+	double n = (events > 0) ? static_cast<double>(events) : 1.0;
+
+	std::cout << "---------------- " << name << " ----------------\n";
+	std::cout << " configured : " << cancel_ratio * 100 << "% of the events on live quotes cancel , " << rate * GENERATORS << " events/s total\n";
+	std::cout << " realized   : " << events << " events , creates " << creates / n * 100 << "% , cancels " << cancelled / n * 100
+			  << "% , replaces " << replaced / n * 100 << "% , dropped " << dropped << " , trades " << trades << " , live quotes " << live
+			  << " , mid " << makers[0]->getMid() << "\n";
+	std::cout << " simulated " << seconds << " s in " << wall_ns * 1e-9 << " s wall\n\n";
+
+	std::string engine_name = name + " : engine processing";
+	showBench(engine_name, engine.getProcessingTimes(), cpns);
+	std::vector<uint64_t> new_lat, cancel_lat;
+	for(auto* ogw : gateways) {
+		new_lat.insert(new_lat.end(), ogw->getNewOrderLatencies().begin(), ogw->getNewOrderLatencies().end());
+		cancel_lat.insert(cancel_lat.end(), ogw->getCancelLatencies().begin(), ogw->getCancelLatencies().end());
+	}
+	std::string new_name = name + " : gateway new orders (stamp -> LOB)";
+	std::string cancel_name = name + " : gateway cancels/replaces (stamp -> LOB)";
+	showBench(new_name, new_lat, cpns);
+	showBench(cancel_name, cancel_lat, cpns);
+
+	for(auto* mm : makers) delete mm;
+	for(auto* ogw : gateways) delete ogw;
+	for(int g = 0; g < GENERATORS; g++) {
+		delete loqs[g];
+		delete laqs[g];
+		delete orders[g];
+		delete cancels[g];
+		delete acks[g];
+	}
+}
+
+// one trader, one rung per side, no cancels : two creates, then a replace on one rung that gets refused
+static bool ackCheck(double cpns) {
+	MarketMakerConfig config;
+	config.ladder_levels = 1;
+	config.cancel_ratio = 0.0;
+
+	LFQueue<UserOrder> oq(64);
+	LFQueue<UserAcknowledgement> aq(64);
+	MarketMaker mm(config, FIRST_MM, 1, &oq, nullptr, cpns);
+	mm.setAckQueue(&aq);
+	mm.begin(now_cycles());
+
+	int ids[2] = {-1, -1}, sizes[2] = {0, 0};
+	int replaced = -1;
+	for(int i = 0; i < 64 && replaced == -1; i++) {
+		mm.poll(mm.nextDue(), 1);
+		UserOrder* o;
+		while((o = oq.getNextRead()) != nullptr) {
+			int slot = (o->order_type == 'b') ? 0 : 1;
+			if(o->req_type == 'c') {
+				ids[slot] = o->order_id;
+				sizes[slot] = o->quantity;
+			} else if(o->req_type == 'u') {
+				replaced = slot;
+			}
+			oq.updateRead();
+		}
+	}
+	if(replaced == -1 || ids[0] == -1 || ids[1] == -1) return false;
+
+	auto ack = [&](int slot, char status, char req_type, int quantity) {
+		UserAcknowledgement* a = aq.getNextWrite();
+		a->order_id = ids[slot];
+		a->status = status;
+		a->req_type = req_type;
+		a->quantity = quantity;
+		aq.updateWrite();
+		mm.poll(0, 0);
+	};
+
+	ack(replaced, 'R', 'u', 0);
+	bool ok = (mm.getLiveQuotes() == 2);
+	ack(1 - replaced, 'R', 'c', 0);
+	ok = ok && (mm.getLiveQuotes() == 1);
+	ack(replaced, 'T', 0, sizes[replaced]); // the size before the refused replace fills it
+	ok = ok && (mm.getLiveQuotes() == 0) && (mm.getRejects() == 2);
+
+	std::cout << " acks : refused replace keeps the quote , refused create frees it , live quotes " << mm.getLiveQuotes()
+			  << (ok ? " : ok" : " : FAILED") << "\n\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	double rate = (argc > 1) ? std::stod(argv[1]) : 200000.0; // per generator
+	double seconds = (argc > 2) ? std::stod(argv[2]) : 2.0;    // simulated
+
+	double cpns = get_cycles_per_ns();
+	std::cout << "[MM SIM BENCH] " << MM_TRADERS << " market makers on " << GENERATORS << " generators / gateways\n\n";
+
+	bool ok = ackCheck(cpns);
+
+	runProfile("replace heavy", 0.2, rate, seconds, cpns);
+	runProfile("cancel heavy", 0.9, rate, seconds, cpns);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+// benchmark for the binary order entry path of the order gateway.
+// encodes a stream of new / replace / cancel messages back to back in one receive buffer (the way they come off a socket), then :
+//   codec   : the wire format on its own (order_entry_protocol.h) : oeFrame + oeValidFields + field loads, and
+//             oeEncodeExecutionReport. timed per block of BLOCK messages (a now_cycles() costs about as much as the codec),
+//             a sample is the block average
+//   gateway : decodeOrderEntry (codec + id translation + write into the LOB queue) and encodeExecutionReport (codec + LUT
+//             lookup) per message
+// one new order reuses the client order id of a live order ---> must come back DUPLICATE_ORDER_ID (non zero exit otherwise).
+
+#include <random>
+#include <cstring>
+#include <limits>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "order_entry_protocol.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t CHUNK = 50000; // messages decoded per round (fits comfortably in the queues)
+static constexpr size_t BLOCK = 64;    // codec only : messages per timed block
+
+static uint32_t out_seq = 1;
+
+static void header(OEHeader& h, char type, uint16_t length) {
+	h.length = length;
+	h.msg_type = type;
+	h.version = OE_PROTOCOL_VERSION;
+	h.seq_num = out_seq++;
+}
+
+// appends one message of 'type' for client order 'id' to the buffer
+static void appendMessage(std::vector<char>& buf, char type, int32_t id, float price, int32_t qty) {
+	size_t at = buf.size();
+	switch(type) {
+		case 'N' : {
+			buf.resize(at + sizeof(OENewOrder));
+			OENewOrder* m = reinterpret_cast<OENewOrder*>(buf.data() + at);
+			header(m->header, 'N', sizeof(OENewOrder));
+			m->client_order_id = id; m->price = price; m->quantity = qty; m->side = 'b';
+			break;
+		}
+		case 'R' : {
+			buf.resize(at + sizeof(OEReplaceOrder));
+			OEReplaceOrder* m = reinterpret_cast<OEReplaceOrder*>(buf.data() + at);
+			header(m->header, 'R', sizeof(OEReplaceOrder));
+			m->client_order_id = id; m->price = price; m->quantity = qty; m->side = 'b';
+			break;
+		}
+		default : {
+			buf.resize(at + sizeof(OECancelOrder));
+			OECancelOrder* m = reinterpret_cast<OECancelOrder*>(buf.data() + at);
+			header(m->header, 'C', sizeof(OECancelOrder));
+			m->client_order_id = id; m->side = 'b';
+			break;
+		}
+	}
+}
+
+// inf / nan never pass the codec, and a finite price past the book's last tick is refused by the engine without touching
+// the book : a create is killed ('K' + 'X', its id is free again), a refused replace ('R') leaves the resting order alone
+static bool priceRangeCheck() {
+	std::vector<char> msg;
+	appendMessage(msg, 'N', 1, std::numeric_limits<float>::infinity(), 10);
+	appendMessage(msg, 'R', 1, std::numeric_limits<float>::quiet_NaN(), 10);
+	appendMessage(msg, 'N', 1, 120.0f, 10);
+	bool codec_ok = !oeValidFields(msg.data()) && !oeValidFields(msg.data() + sizeof(OENewOrder))
+				 && oeValidFields(msg.data() + sizeof(OENewOrder) + sizeof(OEReplaceOrder));
+
+	static constexpr size_t SMALL_TICKS = 1000; // last row is 100.0
+	LFQueue<LOBOrder> loq(16);
+	LFQueue<LOBAcknowledgement> laq(64);
+	LFQueue<BroadcastElement> bq(64);
+	MatchingEngine engine(SMALL_TICKS, 16, &loq, &laq, &bq);
+
+	auto send = [&](int sys_id, char req, float price) {
+		LOBOrder order{};
+		order.system_id = sys_id; order.price = price; order.quantity = 10; order.trader_id = 1; order.order_type = 'b'; order.req_type = req;
+		engine.processOrder(order);
+	};
+	std::string statuses;
+	auto drain = [&]() {
+		while(LOBAcknowledgement* ack = laq.getNextRead()) { statuses += ack->status; laq.updateRead(); }
+		while(bq.getNextRead() != nullptr) bq.updateRead();
+	};
+
+	send(0, 'c', 5000.0f); drain();  // tick 50000 of 1000
+	send(1, 'c', 100.0f);  drain();  // last row, rests
+	send(1, 'u', 100.1f);  drain();  // one tick past
+	send(1, 'u', 99.0f);   drain();  // the order is still there to move
+
+	bool engine_ok = (statuses == "KXCRDC");
+	std::cout << " price range : codec " << (codec_ok ? "ok" : "FAILED") << " , engine acks " << statuses << " (expect KXCRDC) "
+			  << (engine_ok ? "ok" : "FAILED") << "\n";
+	return codec_ok && engine_ok;
+}
+
+int main(int argc, char** argv) {
+
+	size_t orders = (argc > 1) ? std::stoul(argv[1]) : 500000;
+	size_t replaces = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+	if(orders > static_cast<size_t>(SYSTEM_ID_CAPACITY)) orders = SYSTEM_ID_CAPACITY;
+
+	LFQueue<UserOrder> soq(100);
+	LFQueue<LOBOrder> loq(CHUNK);
+	LFQueue<LOBAcknowledgement> laq(100);
+	LFQueue<UserOrder> mmoq(100);
+
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	OrderEntrySession session{1};
+
+	// the wire stream : every order is created, replaced a few times at random and finally cancelled
+	std::mt19937_64 rng(7);
+	std::uniform_int_distribution<size_t> pick(0, orders - 1);
+	std::vector<char> stream;
+	stream.reserve((orders * 40) + (replaces * sizeof(OEReplaceOrder)));
+
+	for(size_t i = 0; i < orders; i++) appendMessage(stream, 'N', static_cast<int32_t>(i), 120.0f, 10);
+	for(size_t i = 0; i < replaces; i++) appendMessage(stream, 'R', static_cast<int32_t>(pick(rng)), 120.0f, 5 + static_cast<int32_t>(i & 7));
+	appendMessage(stream, 'N', 0, 120.0f, 10); // order 0 is still live
+	for(size_t i = 0; i < orders; i++) appendMessage(stream, 'C', static_cast<int32_t>(i), 0.0f, 0);
+
+	size_t messages = orders * 2 + replaces + 1;
+	std::cout << "[OE CODEC BENCH] orders : " << orders << " , replaces : " << replaces << " , messages : " << messages
+			  << " , stream bytes : " << stream.size() << "\n\n";
+
+	double cpns = get_cycles_per_ns();
+
+	// ---- codec only : framing, sequencing, field checks and the loads the mapping does, nothing translated
+	std::vector<uint64_t> codec_decode_times;
+	codec_decode_times.reserve(messages / BLOCK + 1);
+	uint64_t codec_decode_total = 0;
+	uint64_t checksum = 0;
+	{
+		size_t at = 0;
+		uint32_t next_in_seq = 1;
+		while(at < stream.size()) {
+			uint64_t start = now_cycles();
+			for(size_t k = 0; k < BLOCK && at < stream.size(); k++) {
+				const char* msg = stream.data() + at;
+				DecodeResult result = oeFrame(msg, stream.size() - at, next_in_seq);
+				if(UNLIKELY(result.status != DecodeStatus::OK)) { std::cout << " framing error at byte " << at << "\n"; return 1; }
+				if(LIKELY(oeValidFields(msg))) {
+					const OENewOrder* m = reinterpret_cast<const OENewOrder*>(msg); // N and R share the layout up to side, C up to client order id
+					checksum += static_cast<uint64_t>(oeClientOrderId(msg)) + (m->header.msg_type != 'C' ? static_cast<uint64_t>(m->quantity) : 0);
+				}
+				next_in_seq++;
+				at += result.consumed;
+			}
+			uint64_t cycles = now_cycles() - start;
+			codec_decode_times.push_back(cycles / BLOCK);
+			codec_decode_total += cycles;
+		}
+	}
+
+	std::vector<char> codec_buf(BLOCK * OE_MAX_MESSAGE_SIZE);
+	std::vector<uint64_t> codec_encode_times;
+	codec_encode_times.reserve(replaces / BLOCK + 1);
+	uint64_t codec_encode_total = 0;
+	{
+		uint32_t seq = 1;
+		for(size_t i = 0; i < replaces; i += BLOCK) {
+			uint64_t start = now_cycles();
+			size_t out_at = 0;
+			for(size_t k = 0; k < BLOCK; k++) {
+				out_at += oeEncodeExecutionReport(codec_buf.data() + out_at, seq++, static_cast<int64_t>(i + k), 120.0f, 10, 'B', 'T');
+			}
+			uint64_t cycles = now_cycles() - start;
+			codec_encode_times.push_back(cycles / BLOCK);
+			codec_encode_total += cycles;
+			checksum += static_cast<uint64_t>(codec_buf[out_at - 1]);
+		}
+	}
+	size_t codec_encoded = (replaces + BLOCK - 1) / BLOCK * BLOCK;
+
+	std::vector<uint64_t> decode_times;
+	decode_times.reserve(messages);
+
+	size_t offset = 0;
+	size_t decoded = 0;
+	size_t rejected = 0;
+	size_t duplicates = 0;
+	uint64_t decode_total = 0;
+
+	while(offset < stream.size()) {
+		uint64_t start = now_cycles();
+		DecodeResult result = ogw.decodeOrderEntry(stream.data() + offset, stream.size() - offset, session);
+		uint64_t end = now_cycles();
+
+		if(result.status == DecodeStatus::BACKPRESSURE) {
+			// act as the matching engine and sink the translated orders
+			while(loq.getNextRead() != nullptr) loq.updateRead();
+			continue;
+		}
+		if(result.status != DecodeStatus::OK) {
+			if(result.consumed == 0) { std::cout << " framing error at byte " << offset << "\n"; return 1; }
+			if(result.status == DecodeStatus::DUPLICATE_ORDER_ID) duplicates++;
+			rejected++;
+		}
+
+		decode_times.push_back(end - start);
+		decode_total += end - start;
+		offset += result.consumed;
+		decoded++;
+	}
+	while(loq.getNextRead() != nullptr) loq.updateRead();
+
+	// execution reports straight into a send buffer. there is no engine here, so no 'X' came back and every id is still live
+	std::vector<int> sys_ids(orders);
+	for(size_t i = 0; i < orders; i++) sys_ids[i] = ogw.GetOrAssignSystemId(makeOrderKey(1, static_cast<int>(i)), 'd');
+
+	std::vector<char> send_buf(CHUNK * OE_MAX_MESSAGE_SIZE);
+	std::vector<uint64_t> encode_times;
+	encode_times.reserve(replaces);
+	uint64_t encode_total = 0;
+	size_t out_offset = 0;
+
+	LOBAcknowledgement ack{0, 120.0f, 10, 1, 'B', 'T'};
+	for(size_t i = 0; i < replaces; i++) {
+		if(out_offset + OE_MAX_MESSAGE_SIZE > send_buf.size()) out_offset = 0; // "flushed"
+		ack.system_id = sys_ids[pick(rng)];
+
+		uint64_t start = now_cycles();
+		out_offset += ogw.encodeExecutionReport(ack, session, send_buf.data() + out_offset);
+		uint64_t end = now_cycles();
+
+		encode_times.push_back(end - start);
+		encode_total += end - start;
+	}
+
+	std::string codec_decode_name = "OE Codec Decode (frame + field checks, block average per message)";
+	std::string codec_encode_name = "OE Codec Encode Execution Report (block average per message)";
+	std::string decode_name = "OE Gateway Decode (per message, incl. id translation)";
+	std::string encode_name = "OE Gateway Encode Execution Report (per message, incl. LUT lookup)";
+	showBench(codec_decode_name, codec_decode_times, cpns);
+	showBench(codec_encode_name, codec_encode_times, cpns);
+	showBench(decode_name, decode_times, cpns);
+	showBench(encode_name, encode_times, cpns);
+
+	bool ok = (duplicates == 1 && ogw.getDuplicateOrderIds() == 1);
+	ok &= priceRangeCheck();
+
+	std::cout << " codec    : decode avg " << (double)codec_decode_total / messages / cpns << " ns/msg , encode avg "
+			  << (double)codec_encode_total / codec_encoded / cpns << " ns/msg (target : tens of ns) , checksum " << checksum << "\n";
+	std::cout << " gateway  : decoded " << decoded << " (rejected " << rejected << ", duplicate live id " << duplicates << ") , avg "
+			  << (double)decode_total / decoded / cpns << " ns/msg\n";
+	std::cout << " gateway  : encoded " << replaces << " , avg " << (double)encode_total / replaces / cpns << " ns/msg\n";
+	std::cout << " duplicate client order id : " << (ok ? "rejected" : "NOT REJECTED") << "\n";
+
+	return ok ? 0 : 1;
+}
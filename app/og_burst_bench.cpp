@@ -0,0 +1,297 @@
+// benchmark for the order gateway burst mode (group prefetched id lookups).
+// builds a gateway with 1M+ live order ids so the B+ tree and the LUT are well outside L2,
+// then pushes the same update + ack workload through the one-by-one path and the burst path.
+// the round trip run feeds every forwarded update back as its engine ack ('U') a few orders later, the way the engine
+// answers : the risk stage's per order exposure sits in the id's LUT line, so the ack finds the line the check pulled.
+
+#include <random>
+#include <numeric>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+
+static constexpr size_t CHUNK = 50000; // orders pushed per round (fits comfortably in the queues)
+static constexpr size_t ROUND_TRIP = 64; // round trip run : orders in flight before their acks come back
+static constexpr size_t SLICES = 16;    // risk off / on comparisons : slices of the workload per side
+
+// pushes 'workload' order ids as update requests through the gateway and returns the total cycles spent in the poll calls
+uint64_t runOrders(internal_lib::OrderGateway& ogw,
+				   internal_lib::LFQueue<internal_lib::UserOrder>& soq,
+				   internal_lib::LFQueue<internal_lib::LOBOrder>& loq,
+				   const std::vector<long long>& workload,
+				   bool burst) {
+	uint64_t total = 0;
+
+	for(size_t base = 0; base < workload.size(); base += CHUNK) {
+		size_t end = std::min(workload.size(), base + CHUNK);
+
+		for(size_t i = base; i < end; i++) {
+			internal_lib::UserOrder* w = soq.getNextWrite();
+			w->order_id = static_cast<int>(workload[i]);
+			w->trader_id = 1;
+			w->req_type = 'u';
+			w->order_type = 'b';
+			w->price = 120.0;
+			w->quantity = 10;
+			soq.updateWrite();
+		}
+
+		uint64_t start = internal_lib::now_cycles();
+		while(soq.getNextRead() != nullptr) {
+			if(burst) ogw.pollSniperOrderBurst();
+			else ogw.pollSniperOrder();
+		}
+		total += internal_lib::now_cycles() - start;
+
+		// act as the matching engine and sink the translated orders
+		while(loq.getNextRead() != nullptr) loq.updateRead();
+	}
+	return total;
+}
+
+uint64_t runAcks(internal_lib::OrderGateway& ogw,
+				 internal_lib::LFQueue<internal_lib::LOBAcknowledgement>& laq,
+				 internal_lib::LFQueue<internal_lib::UserAcknowledgement>& saq,
+				 const std::vector<int>& sys_ids,
+				 bool burst) {
+	uint64_t total = 0;
+
+	for(size_t base = 0; base < sys_ids.size(); base += CHUNK) {
+		size_t end = std::min(sys_ids.size(), base + CHUNK);
+
+		for(size_t i = base; i < end; i++) {
+			internal_lib::LOBAcknowledgement* w = laq.getNextWrite();
+			w->system_id = sys_ids[i];
+			w->price = 120.0;
+			w->quantity = 10;
+			w->trader_id = 1;
+			w->side = 'B';
+			w->status = 'T';
+			laq.updateWrite();
+		}
+
+		uint64_t start = internal_lib::now_cycles();
+		while(laq.getNextRead() != nullptr) {
+			if(burst) ogw.pollAcknowledgementBurst();
+			else ogw.pollAcknowledgement();
+		}
+		total += internal_lib::now_cycles() - start;
+
+		while(saq.getNextRead() != nullptr) saq.updateRead();
+	}
+	return total;
+}
+
+// every update goes through the single path, then comes back as its 'U' ack. returns the cycles of both poll loops
+uint64_t runRoundTrip(internal_lib::OrderGateway& ogw,
+					  internal_lib::LFQueue<internal_lib::UserOrder>& soq,
+					  internal_lib::LFQueue<internal_lib::LOBOrder>& loq,
+					  internal_lib::LFQueue<internal_lib::LOBAcknowledgement>& laq,
+					  internal_lib::LFQueue<internal_lib::UserAcknowledgement>& saq,
+					  const std::vector<long long>& workload) {
+	uint64_t total = 0;
+
+	for(size_t base = 0; base < workload.size(); base += ROUND_TRIP) {
+		size_t end = std::min(workload.size(), base + ROUND_TRIP);
+
+		for(size_t i = base; i < end; i++) {
+			internal_lib::UserOrder* w = soq.getNextWrite();
+			w->order_id = static_cast<int>(workload[i]);
+			w->trader_id = 1;
+			w->req_type = 'u';
+			w->order_type = 'b';
+			w->price = 120.0;
+			w->quantity = 10 + static_cast<int>(i & 7);
+			soq.updateWrite();
+		}
+
+		uint64_t start = internal_lib::now_cycles();
+		while(soq.getNextRead() != nullptr) ogw.pollSniperOrder();
+		total += internal_lib::now_cycles() - start;
+
+		// act as the matching engine : every forwarded update is acknowledged
+		internal_lib::LOBOrder* o;
+		while((o = loq.getNextRead()) != nullptr) {
+			internal_lib::LOBAcknowledgement* a = laq.getNextWrite();
+			a->system_id = o->system_id;
+			a->price = o->price;
+			a->quantity = o->quantity;
+			a->trader_id = o->trader_id;
+			a->side = 'B';
+			a->status = 'U';
+			laq.updateWrite();
+			loq.updateRead();
+		}
+
+		start = internal_lib::now_cycles();
+		while(laq.getNextRead() != nullptr) ogw.pollAcknowledgement();
+		total += internal_lib::now_cycles() - start;
+
+		while(saq.getNextRead() != nullptr) saq.updateRead();
+	}
+	return total;
+}
+
+// a create the risk stage rejects, then a replace of the same key in the same burst : the replace looked its id up before the
+// create was rejected and its id handed back. it must be rejected too, book no exposure and forward nothing
+bool burstCreateRejectCheck() {
+	internal_lib::LFQueue<internal_lib::UserOrder> soq(64);
+	internal_lib::LFQueue<internal_lib::UserAcknowledgement> saq(64);
+	internal_lib::LFQueue<internal_lib::LOBOrder> loq(64);
+	internal_lib::LFQueue<internal_lib::LOBAcknowledgement> laq(64);
+	internal_lib::LFQueue<internal_lib::UserOrder> mmoq(64);
+
+	internal_lib::OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setAckRoute(1, &saq);
+	ogw.setThrottleCycles(0);
+	ogw.setBurstSize(16);
+
+	internal_lib::RiskLimits limits;
+	limits.max_order_qty = 100;
+	ogw.getRisk().setLimitsAll(limits);
+	ogw.getRisk().refresh();
+
+	auto put = [&](char req, int qty) {
+		internal_lib::UserOrder* w = soq.getNextWrite();
+		w->order_id = 7;
+		w->trader_id = 1;
+		w->req_type = req;
+		w->order_type = 'b';
+		w->price = 120.0f;
+		w->quantity = qty;
+		w->arrived_cycle_count = 0;
+		soq.updateWrite();
+	};
+	put('c', 500); // over max_order_qty
+	put('u', 10);
+	ogw.pollSniperOrderBurst();
+
+	int rejects = 0;
+	while(internal_lib::UserAcknowledgement* a = saq.getNextRead()) {
+		rejects += (a->status == 'R');
+		saq.updateRead();
+	}
+	bool ok = (rejects == 2 && loq.getNextRead() == nullptr && ogw.getRisk().openNotional(1) == 0 && ogw.liveSystemIds() == 0);
+	std::cout << " burst create reject + replace of the same key : " << (ok ? "both rejected" : "REPLACE GOT THROUGH") << "\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	size_t live_ids = (argc > 1) ? std::stoul(argv[1]) : 2000000;
+	size_t lookups = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+	int burst = (argc > 3) ? std::stoi(argv[3]) : 16;
+	if(live_ids > static_cast<size_t>(internal_lib::SYSTEM_ID_CAPACITY)) live_ids = internal_lib::SYSTEM_ID_CAPACITY;
+
+	internal_lib::LFQueue<internal_lib::UserOrder> soq(CHUNK);
+	internal_lib::LFQueue<internal_lib::UserAcknowledgement> saq(CHUNK);
+	internal_lib::LFQueue<internal_lib::LOBOrder> loq(CHUNK);
+	internal_lib::LFQueue<internal_lib::LOBAcknowledgement> laq(CHUNK);
+	internal_lib::LFQueue<internal_lib::UserOrder> mmoq(100);
+
+	internal_lib::OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setAckRoute(1, &saq);
+	ogw.setThrottleCycles(0);
+
+	// random (sparse) order ids so the tree gets a realistic shape
+	std::mt19937_64 rng(42);
+	std::vector<long long> order_ids(live_ids);
+	std::iota(order_ids.begin(), order_ids.end(), 0);
+	for(auto& id : order_ids) id = id * 3 + 1;
+	std::shuffle(order_ids.begin(), order_ids.end(), rng);
+
+	for(long long id : order_ids) ogw.GetOrAssignSystemId(internal_lib::makeOrderKey(1, static_cast<int>(id)), 'c');
+
+	std::cout << "[OGW BURST BENCH] live ids : " << live_ids << " , lookups : " << lookups << " , burst : " << burst << "\n\n";
+
+	std::vector<long long> workload(lookups);
+	std::vector<int> ack_ids(lookups);
+	std::uniform_int_distribution<size_t> pick(0, live_ids - 1);
+	for(size_t i = 0; i < lookups; i++) {
+		workload[i] = order_ids[pick(rng)];
+		ack_ids[i] = static_cast<int>(pick(rng));
+	}
+
+	double cpns = internal_lib::get_cycles_per_ns();
+
+	std::string single_name = "OGW Processing Time (single)";
+	std::string burst_name = "OGW Processing Time (burst, amortized)";
+
+	// realistic limits (wide enough that the workload passes) so the risk stage does its full work
+	internal_lib::RiskLimits limits;
+	limits.price_lo = 50.0f;
+	limits.price_hi = 200.0f;
+	limits.max_order_qty = 1000;
+	limits.max_position = 1 << 30;
+	limits.rate_interval_cycles = 10;
+	limits.rate_burst_cycles = 1ull << 40;
+	ogw.getRisk().setLimitsAll(limits);
+	ogw.getRisk().refresh();
+
+	// risk off and risk on take turns over slices of the workload (every slice is run once) so a noisy stretch of the box
+	// hits both alike. each side gets half of the lookups
+	size_t slice = workload.size() / (2 * SLICES);
+	size_t half = slice * SLICES;
+	auto alternate = [&](auto&& runner, uint64_t& off, uint64_t& on, std::vector<uint64_t>& off_times, std::vector<uint64_t>& on_times) {
+		for(size_t k = 0; k < 2 * SLICES; k++) {
+			std::vector<long long> part(workload.begin() + k * slice, workload.begin() + (k + 1) * slice);
+			bool risk = (k & 1);
+			ogw.setPreTradeRisk(risk);
+			(risk ? on : off) += runner(part);
+			std::vector<uint64_t>& times = risk ? on_times : off_times;
+			times.insert(times.end(), ogw.getProcessingTimes().begin(), ogw.getProcessingTimes().end());
+			ogw.getProcessingTimes().clear();
+		}
+		ogw.setPreTradeRisk(true);
+	};
+
+	uint64_t no_risk_cycles = 0, single_cycles = 0, burst_no_risk_cycles = 0, burst_cycles = 0, trip_no_risk_cycles = 0, trip_cycles = 0;
+	std::vector<uint64_t> no_risk_times, single_times, burst_no_risk_times, burst_times, trip_no_risk_times, trip_times;
+
+	ogw.setBurstSize(1);
+	alternate([&](const std::vector<long long>& part) { return runOrders(ogw, soq, loq, part, false); },
+			  no_risk_cycles, single_cycles, no_risk_times, single_times);
+	alternate([&](const std::vector<long long>& part) { return runRoundTrip(ogw, soq, loq, laq, saq, part); },
+			  trip_no_risk_cycles, trip_cycles, trip_no_risk_times, trip_times);
+
+	ogw.setBurstSize(burst);
+	alternate([&](const std::vector<long long>& part) { return runOrders(ogw, soq, loq, part, true); },
+			  burst_no_risk_cycles, burst_cycles, burst_no_risk_times, burst_times);
+
+	std::string no_risk_name = "OGW Processing Time (single, no pre trade risk)";
+	internal_lib::showBench(no_risk_name, no_risk_times, cpns);
+	internal_lib::showBench(single_name, single_times, cpns);
+	internal_lib::showBench(burst_name, burst_times, cpns);
+
+	uint64_t ack_single_cycles = runAcks(ogw, laq, saq, ack_ids, false);
+	uint64_t ack_burst_cycles = runAcks(ogw, laq, saq, ack_ids, true);
+
+	auto per_op = [&](uint64_t cycles) { return (double)cycles / lookups / cpns; };
+	auto per_half = [&](uint64_t cycles) { return (double)cycles / half / cpns; };
+
+	std::cout << " orders  single (no risk) : " << per_half(no_risk_cycles) << " ns/order\n";
+	std::cout << " orders  single : " << per_half(single_cycles) << " ns/order , risk overhead " << per_half(single_cycles) - per_half(no_risk_cycles)
+			  << " ns , risk rejects : " << ogw.getRiskRejects() << "\n";
+	std::cout << " orders  burst  (no risk) : " << per_half(burst_no_risk_cycles) << " ns/order\n";
+	std::cout << " orders  burst  : " << per_half(burst_cycles) << " ns/order , risk overhead " << per_half(burst_cycles) - per_half(burst_no_risk_cycles) << " ns\n";
+	std::cout << " order + ack (no risk) : " << per_half(trip_no_risk_cycles) << " ns/order\n";
+	std::cout << " order + ack    : " << per_half(trip_cycles) << " ns/order , risk overhead " << per_half(trip_cycles) - per_half(trip_no_risk_cycles) << " ns\n";
+	std::cout << " acks    single : " << per_op(ack_single_cycles) << " ns/ack\n";
+	std::cout << " acks    burst  : " << per_op(ack_burst_cycles) << " ns/ack\n";
+
+	// a replace naming the other side must not book its quantity there (the old one sits on the first side)
+	internal_lib::RiskOrder flip;
+	internal_lib::PreTradeRisk& risk = ogw.getRisk();
+	bool created = (risk.check('c', 2, flip, 'b', 120.0f, 10, 0) == 0);
+	bool refused = (risk.check('u', 2, flip, 's', 120.0f, 10, 0) & internal_lib::RISK_SIDE_CHANGE) != 0;
+	bool same_side = (risk.check('u', 2, flip, 'b', 120.0f, 4, 0) == 0) && flip.quantity == 4;
+	bool ok = created && refused && same_side;
+	std::cout << " side changing replace : " << (ok ? "rejected" : "NOT REJECTED") << "\n";
+	ok &= burstCreateRejectCheck();
+
+	return ok ? 0 : 1;
+}
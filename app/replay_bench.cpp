@@ -0,0 +1,150 @@
+// benchmark for the order flow replay driver.
+// writes a synthetic recording (sniper creates + market maker creates / replaces / cancels with Poisson timestamps) to a temp
+// file, then maps it and replays it through one gateway into the engine, all from this thread : once as fast as possible
+// (throughput, tick-to-trade) and once at recorded timing x SPEED (pacing : wall time and worst lag behind the schedule).
+
+#include <random>
+#include <cstdio>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "replay_format.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/replay_driver.cpp"
+
+using namespace internal_lib;
+
+static constexpr short SNIPER = 1;
+static constexpr short FIRST_MM = 2;
+static constexpr int MM_TRADERS = 99;
+static constexpr size_t RING = 1 << 16;
+
+// recording : rate events per second of recorded time, 1 in 10 from the sniper
+static bool writeRecording(const char* path, size_t count, double rate) {
+	ReplayWriter writer;
+	if(!writer.open(path)) return false;
+
+	std::mt19937_64 rng(11);
+	std::exponential_distribution<double> gap(rate * 1e-9);
+	std::vector<std::vector<ReplayEvent>> live(FIRST_MM + MM_TRADERS);
+	std::vector<int> next_id(FIRST_MM + MM_TRADERS, 0);
+	double ts = 1.7e18;
+
+	for(size_t i = 0; i < count; i++) {
+		ts += gap(rng);
+		ReplayEvent ev{};
+		ev.ts_ns = static_cast<uint64_t>(ts);
+		ev.trader_id = (rng() % 10 == 0) ? SNIPER : static_cast<int16_t>(FIRST_MM + rng() % MM_TRADERS);
+
+		std::vector<ReplayEvent>& quotes = live[ev.trader_id];
+		uint64_t dice = rng() % 10;
+		if(ev.trader_id == SNIPER || quotes.size() < 5 || dice < 4) {
+			bool buy = rng() & 1;
+			ev.order_id = next_id[ev.trader_id]++;
+			ev.order_type = buy ? 'b' : 's';
+			float offset = 0.1f * static_cast<float>(1 + rng() % 50);
+			if(ev.trader_id == SNIPER) offset = -offset; // the sniper takes liquidity
+			ev.price = buy ? 130.0f - offset : 130.0f + offset;
+			ev.quantity = 1 + static_cast<int32_t>(rng() % 100);
+			ev.req_type = 'c';
+			if(ev.trader_id != SNIPER) quotes.push_back(ev);
+		} else {
+			size_t pick = rng() % quotes.size();
+			ReplayEvent quote = quotes[pick];
+			ev.order_id = quote.order_id;
+			ev.order_type = quote.order_type;
+			ev.price = quote.price;
+			if(dice < 7) {
+				ev.req_type = 'd';
+				ev.quantity = 0;
+				quotes[pick] = quotes.back();
+				quotes.pop_back();
+			} else {
+				ev.req_type = 'u';
+				ev.quantity = 1 + static_cast<int32_t>(rng() % 100);
+				quotes[pick].quantity = ev.quantity;
+			}
+		}
+		if(!writer.append(ev)) return false;
+	}
+	return writer.close();
+}
+
+static void replay(const char* path, double speed, double cpns) {
+	LFQueue<UserOrder> soq(RING);
+	LFQueue<UserOrder> mmoq(RING);
+	LFQueue<UserOrder> mmcq(RING);
+	LFQueue<UserAcknowledgement> saq(RING * 4);
+	LFQueue<LOBOrder> loq(RING);
+	LFQueue<LOBAcknowledgement> laq(RING * 4);
+	LFQueue<BroadcastElement> bq(RING * 4);
+
+	MatchingEngine engine(10000, 400, &loq, &laq, &bq);
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.setThrottleCycles(0);
+	ogw.attachCancelLanes(nullptr, &mmcq);
+	ogw.setAckRoute(SNIPER, &saq);
+
+	ReplayDriver driver(cpns);
+	if(!driver.open(path)) {
+		std::cout << "can not map " << path << "\n";
+		return;
+	}
+	driver.setRoute(SNIPER, &soq);
+	for(int t = 0; t < MM_TRADERS; t++) driver.setRoute(static_cast<short>(FIRST_MM + t), &mmoq, &mmcq);
+	driver.setSpeed(speed);
+
+	uint64_t start = now_cycles();
+	driver.begin(start);
+	while(!driver.done() || soq.getNextRead() != nullptr || mmoq.getNextRead() != nullptr || mmcq.getNextRead() != nullptr ||
+		  loq.getNextRead() != nullptr) {
+		driver.poll(now_cycles());
+		ogw.pollOrders();
+		while(loq.getNextRead() != nullptr) engine.readOrder();
+		while(laq.getNextRead() != nullptr) ogw.pollAcknowledgement();
+		while(saq.getNextRead() != nullptr) saq.updateRead();
+		while(bq.getNextRead() != nullptr) bq.updateRead();
+	}
+	double wall_ns = static_cast<double>(now_cycles() - start) / cpns;
+
+	std::string mode = (speed > 0.0) ? "recorded timing x" + std::to_string(static_cast<int>(speed)) : "as fast as possible";
+	std::cout << "---------------- " << mode << " ----------------\n";
+	std::cout << " " << driver.getSent() << " events in " << wall_ns * 1e-6 << " ms (" << static_cast<double>(driver.getSent()) / (wall_ns * 1e-9)
+			  << " events/s) , unrouted " << driver.getUnrouted() << " , stalls " << driver.getStalls();
+	if(speed > 0.0) {
+		std::cout << " , schedule " << static_cast<double>(driver.getRecordedSpanNs()) / speed * 1e-6 << " ms , worst lag "
+				  << static_cast<double>(driver.getMaxLagCycles()) / cpns << " ns";
+	}
+	std::cout << "\n\n";
+
+	std::string ttt = mode + " : engine tick to trade (gateway pop -> engine done)";
+	showBench(ttt, engine.getTickToTradeTimes(), cpns);
+}
+
+int main(int argc, char** argv) {
+
+	size_t count = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+	double speed = (argc > 2) ? std::stod(argv[2]) : 2.0;
+	const char* path = "/tmp/capitol_replay_bench.bin";
+
+	double cpns = get_cycles_per_ns();
+	double rate = 200000.0; // recorded events per second
+
+	uint64_t w = now_cycles();
+	if(!writeRecording(path, count, rate)) {
+		std::cout << "can not write " << path << "\n";
+		return 1;
+	}
+	std::cout << "[REPLAY BENCH] " << count << " events (" << count * sizeof(ReplayEvent) / (1 << 20) << " MB, " << count / rate
+			  << " s recorded) written in " << static_cast<double>(now_cycles() - w) / cpns * 1e-6 << " ms\n\n";
+
+	replay(path, 0.0, cpns);
+	replay(path, speed, cpns);
+
+	std::remove(path);
+	return 0;
+}
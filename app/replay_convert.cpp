@@ -0,0 +1,114 @@
+// csv recording ---> replay file (replay_format.h) for the replay driver.
+//
+//   replay_convert <in.csv> <out.bin>
+//
+// one event per line : ts_ns,trader_id,order_id,side,req_type,price,quantity
+//   side     : b / s (buy / sell, any case)
+//   req_type : c / u / d (create / update / delete, any case)
+// lines that do not start with a digit (header, comments) are skipped, malformed lines are skipped and counted. timestamps
+// must not go backwards, an event stamped before the previous one is moved up to it (counted).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <iostream>
+
+#include "replay_format.h"
+
+using namespace internal_lib;
+
+// parses one csv line into ev, false if malformed
+static bool parseLine(char* line, ReplayEvent& ev) {
+	char* at = line;
+	char* end;
+
+	ev.ts_ns = std::strtoull(at, &end, 10);
+	if(end == at || *end != ',') return false;
+	at = end + 1;
+
+	long trader = std::strtol(at, &end, 10);
+	if(end == at || *end != ',' || trader < 0 || trader > 32767) return false;
+	ev.trader_id = static_cast<int16_t>(trader);
+	at = end + 1;
+
+	long order_id = std::strtol(at, &end, 10);
+	if(end == at || *end != ',' || order_id < 0 || order_id > 0x7FFFFFFF) return false;
+	ev.order_id = static_cast<int32_t>(order_id);
+	at = end + 1;
+
+	char side = static_cast<char>(std::tolower(static_cast<unsigned char>(*at)));
+	if(side != 'b' && side != 's') return false;
+	ev.order_type = side;
+	while(*at != ',' && *at != '\0') at++;
+	if(*at++ != ',') return false;
+
+	char req = static_cast<char>(std::tolower(static_cast<unsigned char>(*at)));
+	if(req != 'c' && req != 'u' && req != 'd') return false;
+	ev.req_type = req;
+	while(*at != ',' && *at != '\0') at++;
+	if(*at++ != ',') return false;
+
+	ev.price = std::strtof(at, &end);
+	if(end == at || *end != ',') return false;
+	at = end + 1;
+
+	long quantity = std::strtol(at, &end, 10);
+	if(end == at || quantity < 0 || quantity > 0x7FFFFFFF) return false;
+	ev.quantity = static_cast<int32_t>(quantity);
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	if(argc < 3) {
+		std::cerr << "usage : replay_convert <in.csv> <out.bin>\n";
+		return 2;
+	}
+
+	FILE* in = std::fopen(argv[1], "r");
+	if(in == nullptr) {
+		std::cerr << "replay_convert : can not open " << argv[1] << "\n";
+		return 1;
+	}
+
+	ReplayWriter writer;
+	if(!writer.open(argv[2])) {
+		std::cerr << "replay_convert : can not create " << argv[2] << "\n";
+		std::fclose(in);
+		return 1;
+	}
+
+	char line[512];
+	uint64_t lines = 0;
+	uint64_t malformed = 0;
+	uint64_t reordered = 0;
+	uint64_t last_ts = 0;
+	bool write_ok = true;
+
+	while(std::fgets(line, sizeof(line), in) != nullptr) {
+		lines++;
+		if(!std::isdigit(static_cast<unsigned char>(line[0]))) continue;
+
+		ReplayEvent ev{};
+		if(!parseLine(line, ev)) {
+			malformed++;
+			continue;
+		}
+		if(writer.getEventCount() > 0 && ev.ts_ns < last_ts) {
+			ev.ts_ns = last_ts;
+			reordered++;
+		}
+		last_ts = ev.ts_ns;
+		write_ok = writer.append(ev) && write_ok;
+	}
+	std::fclose(in);
+
+	write_ok = writer.close() && write_ok;
+	std::cout << "replay_convert : " << lines << " lines , " << writer.getEventCount() << " events , " << malformed << " malformed , "
+			  << reordered << " out of order\n";
+	if(!write_ok) {
+		std::cerr << "replay_convert : write to " << argv[2] << " failed\n";
+		return 1;
+	}
+	return 0;
+}
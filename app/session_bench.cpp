@@ -0,0 +1,251 @@
+// benchmark for the TCP session layer in front of the order gateway, over loopback with the bundled client.
+//
+// everything runs on ONE thread, round robin (clients -> session server -> gateway -> stand-in engine -> gateway -> session server
+// -> clients), so the numbers are pure cpu cost + kernel loopback, without any thread hand-off or scheduler noise.
+// per session count it reports :
+//   wire -> gateway : client send() -> order written into the LOB queue by the gateway
+//   recv -> gateway : server recv() completed the message -> order in the LOB queue (session layer + ring + decode)
+//   round trip      : client send() -> execution report parsed by the client
+//   session layer cpu per message (in + out) ---> messages/s one network core sustains ---> sessions per core at a given rate
+
+#include <random>
+#include <numeric>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "order_entry_protocol.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/session_server.cpp"
+#include "../core/src/session_client.cpp"
+
+using namespace internal_lib;
+
+// stands in for the matching engine : every create rests ('C'), every cancel removes ('D') and retires the id ('X')
+static void fakeEngine(LFQueue<LOBOrder>& loq, LFQueue<LOBAcknowledgement>& laq, OrderGateway& ogw,
+					   std::vector<std::vector<uint64_t>>& send_stamp, std::vector<uint64_t>& wire_to_gateway) {
+	LOBOrder* o;
+	while((o = loq.getNextRead()) != nullptr) {
+		long long key = ogw.SystemToOrderKey(o->system_id);
+		wire_to_gateway.push_back(o->arrived_cycle_count - send_stamp[orderKeyTraderId(key)][orderKeyOrderId(key)]);
+
+		LOBAcknowledgement* a = laq.getNextWrite();
+		*a = {o->system_id, o->price, o->quantity, o->trader_id, (o->order_type == 'b') ? 'B' : 'S', (o->req_type == 'c') ? 'C' : 'D'};
+		laq.updateWrite();
+
+		if(o->req_type == 'd') {
+			a = laq.getNextWrite();
+			*a = {o->system_id, 0, 0, -1, ' ', 'X'};
+			laq.updateWrite();
+		}
+		loq.updateRead();
+	}
+}
+
+static void runSessions(int sessions, int burst, int rounds, double cpns) {
+	size_t ring = static_cast<size_t>(sessions) * burst * 2;
+
+	LFQueue<UserOrder> soq(100);
+	LFQueue<UserOrder> mmoq(100);
+	LFQueue<LOBOrder> loq(ring);
+	LFQueue<LOBAcknowledgement> laq(ring * 2);
+	LFQueue<OEFrame> inbound(ring);
+	LFQueue<OEFrame> outbound(ring);
+
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.attachSessionLane(&inbound, &outbound);
+
+	SessionServer server(&inbound, &outbound, sessions + 8);
+	uint16_t port = server.listen(0);
+	ASSERT(port != 0, "session bench : listen failed");
+
+	std::vector<OrderEntryClient*> clients;
+	for(int s = 0; s < sessions; s++) {
+		clients.push_back(new OrderEntryClient(static_cast<short>(s)));
+		ASSERT(clients.back()->connect("127.0.0.1", port), "session bench : connect failed");
+		clients.back()->sendLogon();
+	}
+
+	int logged_on = 0;
+	while(logged_on < sessions) {
+		server.poll();
+		logged_on = 0;
+		for(auto* c : clients) {
+			c->poll([](const OEExecutionReport&) {});
+			logged_on += c->isLoggedOn();
+		}
+	}
+
+	std::vector<std::vector<uint64_t>> send_stamp(sessions, std::vector<uint64_t>(static_cast<size_t>(burst) * 2, 0));
+	std::vector<uint64_t> wire_to_gateway, round_trip;
+	wire_to_gateway.reserve(static_cast<size_t>(sessions) * burst * rounds * 2);
+	round_trip.reserve(static_cast<size_t>(sessions) * burst * rounds * 2);
+
+	uint64_t server_cycles = 0;
+	uint64_t messages = 0;
+
+	for(int r = 0; r < rounds * 2; r++) {
+		bool cancels = (r & 1);
+		int base = ((r >> 1) & 1) * burst; // alternate between two id blocks so a late report can never be mistaken
+
+		for(int s = 0; s < sessions; s++) {
+			OrderEntryClient* c = clients[s];
+			for(int i = 0; i < burst; i++) {
+				if(cancels) c->cancelOrder(base + i, 'b');
+				else c->newOrder(base + i, 100.0f + 0.1f * i, 10, 'b');
+			}
+			uint64_t now = now_cycles();
+			for(int i = 0; i < burst; i++) send_stamp[s][base + i] = now;
+			c->flush();
+		}
+
+		int expected = sessions * burst;
+		int received = 0;
+		while(received < expected) {
+			uint64_t start = now_cycles();
+			server.poll();
+			server_cycles += now_cycles() - start;
+
+			while(ogw.pollSessionOrder()) {}
+			fakeEngine(loq, laq, ogw, send_stamp, wire_to_gateway);
+			while(laq.getNextRead() != nullptr) ogw.pollAcknowledgement();
+
+			start = now_cycles();
+			server.poll();
+			server_cycles += now_cycles() - start;
+
+			for(int s = 0; s < sessions; s++) {
+				received += clients[s]->poll([&](const OEExecutionReport& report) {
+					round_trip.push_back(now_cycles() - send_stamp[s][report.client_order_id]);
+				});
+			}
+		}
+		messages += static_cast<uint64_t>(expected) * 2; // order in + report out
+	}
+
+	std::string w2g = "wire -> gateway (" + std::to_string(sessions) + " sessions)";
+	std::string r2g = "recv -> gateway (" + std::to_string(sessions) + " sessions)";
+	std::string rtt = "round trip (" + std::to_string(sessions) + " sessions)";
+	showBench(w2g, wire_to_gateway, cpns);
+	showBench(r2g, ogw.getSessionIngressTimes(), cpns);
+	showBench(rtt, round_trip, cpns);
+
+	double ns_per_message = (double)server_cycles / messages / cpns;
+	double messages_per_core = 1e9 / ns_per_message;
+	std::cout << " session layer : " << ns_per_message << " ns/message (in + out) , " << messages_per_core / 1e6
+			  << " M messages/s per core , recv calls : " << server.getRecvCalls() << " for " << server.getMessagesIn() << " messages\n";
+	std::cout << " sessions per core @ 10k orders/s each (order + report) : " << (long long)(messages_per_core / 20000.0) << "\n\n";
+
+	for(auto* c : clients) {
+		c->sendLogout();
+		delete c;
+	}
+}
+
+// ack routes of session traders : an in process trader can not log on, a logout hands the trader's route back
+// (its acks are no longer encoded for the session) and the gateway refuses session orders of a trader served in process
+static bool routeCheck() {
+	static constexpr short IN_PROCESS = 5;
+	static constexpr short NET = 3;
+	static constexpr short LATE = 7; // logs on, only then gets an in process route
+
+	LFQueue<UserOrder> soq(16);
+	LFQueue<UserOrder> mmoq(16);
+	LFQueue<LOBOrder> loq(64);
+	LFQueue<LOBAcknowledgement> laq(64);
+	LFQueue<OEFrame> inbound(64);
+	LFQueue<OEFrame> outbound(64);
+	LFQueue<UserAcknowledgement> in_process(64);
+
+	OrderGateway ogw(&laq, &soq, &mmoq, &loq);
+	ogw.attachSessionLane(&inbound, &outbound);
+	ogw.setAckRoute(IN_PROCESS, &in_process);
+
+	SessionServer server(&inbound, &outbound, 8);
+	server.reserveTrader(IN_PROCESS);
+	uint16_t port = server.listen(0);
+	ASSERT(port != 0, "session bench : listen failed");
+
+	// one turn of everybody, the engine rests every create
+	int last_sys_id = -1;
+	auto pump = [&]() {
+		server.poll();
+		while(ogw.pollSessionOrder()) {}
+		while(LOBOrder* o = loq.getNextRead()) {
+			LOBAcknowledgement* a = laq.getNextWrite();
+			*a = {o->system_id, o->price, o->quantity, o->trader_id, 'B', 'C'};
+			laq.updateWrite();
+			last_sys_id = o->system_id;
+			loq.updateRead();
+		}
+		while(laq.getNextRead() != nullptr) ogw.pollAcknowledgement();
+		server.poll();
+	};
+	auto logon = [&](OrderEntryClient& c) {
+		ASSERT(c.connect("127.0.0.1", port), "session bench : connect failed");
+		c.sendLogon();
+		while(!c.isLoggedOn() && c.poll([](const OEExecutionReport&) {}) != -1) pump();
+		return c.isLoggedOn();
+	};
+	auto nextReport = [&](OrderEntryClient& c) {
+		char status = 0;
+		while(status == 0 && c.poll([&](const OEExecutionReport& r) { status = r.status; }) != -1) pump();
+		return status;
+	};
+
+	OrderEntryClient squatter(IN_PROCESS);
+	bool refused = !logon(squatter) && squatter.getLogoutReason() == 'I';
+
+	OrderEntryClient net(NET);
+	bool traded = logon(net);
+	net.newOrder(1, 100.0f, 10, 'b');
+	net.flush();
+	traded &= (nextReport(net) == 'C');
+	int resting_id = last_sys_id;
+
+	net.sendLogout();
+	while(net.poll([](const OEExecutionReport&) {}) != -1) pump();
+	for(int i = 0; i < 4; i++) pump(); // the logout notice reaches the gateway
+
+	// the resting order fills while its trader is away : counted, not encoded for a session nobody holds
+	uint64_t unrouted = ogw.getUnroutedAcks();
+	uint64_t out_before = server.getMessagesOut();
+	LOBAcknowledgement* fill = laq.getNextWrite();
+	*fill = {resting_id, 100.0f, 10, NET, 'B', 'T'};
+	laq.updateWrite();
+	pump();
+	bool released = (resting_id >= 0 && ogw.getUnroutedAcks() == unrouted + 1 && server.getMessagesOut() == out_before);
+
+	OrderEntryClient late(LATE);
+	bool guarded = logon(late);
+	ogw.setAckRoute(LATE, &in_process);
+	late.newOrder(1, 100.0f, 10, 'b');
+	late.flush();
+	guarded &= (nextReport(late) == 'R' && loq.getNextRead() == nullptr && in_process.getNextRead() == nullptr);
+
+	bool ok = refused && traded && released && guarded;
+	std::cout << " ack routes : in process logon " << (refused ? "refused" : "ACCEPTED") << " , logout "
+			  << (released ? "releases the route" : "KEEPS THE ROUTE") << " , session order of an in process trader "
+			  << (guarded ? "rejected" : "NOT REJECTED") << (traded ? "" : " , session trade FAILED") << "\n\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	int burst = (argc > 1) ? std::stoi(argv[1]) : 32;
+	int rounds = (argc > 2) ? std::stoi(argv[2]) : 500;
+
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[SESSION BENCH] burst : " << burst << " orders per session per round , rounds : " << rounds << "\n\n";
+
+	bool ok = routeCheck();
+
+	for(int sessions : {1, 16, 64, 127}) {
+		runSessions(sessions, burst, rounds, cpns);
+	}
+
+	return ok ? 0 : 1;
+}
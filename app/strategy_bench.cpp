@@ -0,0 +1,201 @@
+// benchmark for the CRTP strategy interface (core/src/strategy.cpp).
+// a small taker strategy (buy every sell add at or below a limit, cancel what is still resting on a timer) is run once through
+// Strategy<> and once hand inlined over the same rings. the feed is synthetic and written one event at a time, so the number
+// is feed event stamp -> order written into the gateway queue, the reaction cost of the strategy layer itself. both should be
+// the same, the interface must not cost anything over writing the loop by hand.
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/strategy.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t RING = 1 << 16;
+static constexpr int EVENTS = 1000000;
+static constexpr float LIMIT = 100.0f;
+
+class TakerStrategy : public Strategy<TakerStrategy> {
+	public :
+		using Strategy<TakerStrategy>::Strategy;
+
+		void onBookUpdate(const BroadcastElement& be) noexcept {
+			if(be.type == 'N' && be.side == 'S' && be.price <= LIMIT) {
+				int id = sendOrder('b', be.price, be.quantity);
+				if(id >= 0) resting[resting_count++ & (RESTING - 1)] = id;
+			}
+		}
+
+		void onTimer(uint64_t) noexcept {
+			int n = (resting_count < RESTING) ? resting_count : RESTING;
+			for(int k = 0; k < n; k++) cancelOrder(resting[k]);
+			resting_count = 0;
+		}
+
+	private :
+		static constexpr int RESTING = 64;
+		int resting[RESTING];
+		int resting_count = 0;
+};
+
+// synthetic feed : adds on both sides around the limit
+static void writeEvent(LFQueue<BroadcastElement>& bq, std::mt19937& rng, int i) {
+	BroadcastElement* be = bq.getNextWrite();
+	be->system_id = i;
+	be->price = 99.0f + 0.1f * static_cast<float>(rng() % 21);
+	be->quantity = 1 + static_cast<int>(rng() % 100);
+	be->side = (rng() & 1) ? 'S' : 'B';
+	be->type = 'N';
+	be->event_cycle = now_cycles();
+	bq.updateWrite();
+}
+
+// event stamp -> order stamp for every order sent since the last call. with an ack queue it also stands in for the market :
+// every buy is filled in full on arrival, so the strategy's order table frees up (it never reuses a live id)
+static void drainOrders(LFQueue<UserOrder>& oq, uint64_t event_cycle, std::vector<uint64_t>& samples, uint64_t& orders,
+						LFQueue<UserAcknowledgement>* aq = nullptr) {
+	UserOrder* o;
+	while((o = oq.getNextRead()) != nullptr) {
+		if(o->req_type == 'c') {
+			samples.push_back(o->arrived_cycle_count - event_cycle);
+			UserAcknowledgement* a = (aq != nullptr) ? aq->getNextWrite() : nullptr;
+			if(a != nullptr) {
+				*a = UserAcknowledgement{o->order_id, o->price, o->quantity, -1, 'B', 'T', 0};
+				aq->updateWrite();
+			}
+		}
+		orders++;
+		oq.updateRead();
+	}
+}
+
+// order table bookkeeping : a live id is never handed out again, a refused replace keeps the order, a refused create ends it
+class ProbeStrategy : public Strategy<ProbeStrategy> {
+	public :
+		using Strategy<ProbeStrategy>::Strategy;
+		int send() noexcept { return sendOrder('b', 100.0f, 10); }
+		bool replace(int id) noexcept { return replaceOrder(id, 100.5f, 10); }
+};
+
+static bool orderTableCheck() {
+	LFQueue<UserOrder> oq(64);
+	LFQueue<UserAcknowledgement> aq(64);
+	ProbeStrategy probe(&oq, &aq, nullptr, 1, 4);
+
+	auto ack = [&](int id, char status, int qty, char req_type) {
+		UserAcknowledgement* a = aq.getNextWrite();
+		*a = UserAcknowledgement{id, 100.0f, qty, id, 'B', status, req_type};
+		aq.updateWrite();
+		probe.poll();
+	};
+
+	bool ok = true;
+	for(int i = 0; i < 4; i++) ok &= (probe.send() == i);
+	ok &= (probe.send() == -1);                           // all 4 live, nothing to wrap onto
+	ack(2, 'T', 10, 0);                                   // 2 filled
+	ok &= (probe.send() == 2);                            // the only free slot
+
+	ok &= probe.replace(0);
+	ack(0, 'R', 0, 'u');                                  // replace refused, 0 still rests
+	ok &= probe.getOrder(0).live;
+	ack(2, 'R', 0, 'c');                                  // create refused
+	ok &= !probe.getOrder(2).live;
+
+	std::cout << " order table : live ids skipped , refused replace keeps / refused create ends the order : " << (ok ? "ok" : "FAILED") << "\n\n";
+	return ok;
+}
+
+int main() {
+
+	bool ok = orderTableCheck();
+
+	double cpns = get_cycles_per_ns();
+	uint64_t timer = static_cast<uint64_t>(20000 * cpns); // 20 us
+
+	LFQueue<UserOrder> oq(RING);
+	LFQueue<UserAcknowledgement> aq(RING);
+	LFQueue<BroadcastElement> bq(RING);
+
+	// CRTP strategy
+	std::vector<uint64_t> crtp;
+	crtp.reserve(EVENTS);
+	uint64_t crtp_orders = 0;
+	{
+		TakerStrategy strategy(&oq, &aq, &bq, 1);
+		strategy.setTimer(timer);
+		std::mt19937 rng(3);
+		for(int i = 0; i < EVENTS; i++) {
+			writeEvent(bq, rng, i);
+			uint64_t stamp = bq.getNextRead()->event_cycle;
+			strategy.poll();
+			drainOrders(oq, stamp, crtp, crtp_orders, &aq);
+		}
+	}
+
+	// the same logic written straight into the loop
+	std::vector<uint64_t> inlined;
+	inlined.reserve(EVENTS);
+	uint64_t inlined_orders = 0;
+	{
+		std::mt19937 rng(3);
+		int next_id = 0;
+		int resting[64];
+		int resting_count = 0;
+		uint64_t next_timer = now_cycles() + timer;
+		for(int i = 0; i < EVENTS; i++) {
+			writeEvent(bq, rng, i);
+			uint64_t stamp = bq.getNextRead()->event_cycle;
+
+			BroadcastElement* be;
+			while((be = bq.getNextRead()) != nullptr) {
+				if(be->type == 'N' && be->side == 'S' && be->price <= LIMIT) {
+					UserOrder* o = oq.getNextWrite();
+					if(o != nullptr) {
+						o->arrived_cycle_count = now_cycles();
+						o->order_id = next_id;
+						o->trader_id = 1;
+						o->order_type = 'b';
+						o->req_type = 'c';
+						o->price = be->price;
+						o->quantity = be->quantity;
+						o->out_cycle_count = o->arrived_cycle_count;
+						oq.updateWrite();
+						resting[resting_count++ & 63] = next_id++;
+					}
+				}
+				bq.updateRead();
+			}
+			uint64_t now = now_cycles();
+			if(now >= next_timer) {
+				next_timer = now + timer;
+				int n = (resting_count < 64) ? resting_count : 64;
+				for(int k = 0; k < n; k++) {
+					UserOrder* o = oq.getNextWrite();
+					if(o == nullptr) break;
+					o->arrived_cycle_count = now_cycles();
+					o->order_id = resting[k];
+					o->trader_id = 1;
+					o->order_type = 'b';
+					o->req_type = 'd';
+					o->quantity = 0;
+					o->out_cycle_count = o->arrived_cycle_count;
+					oq.updateWrite();
+				}
+				resting_count = 0;
+			}
+			drainOrders(oq, stamp, inlined, inlined_orders);
+		}
+	}
+
+	std::cout << "[STRATEGY BENCH] " << EVENTS << " feed events , CRTP strategy sent " << crtp_orders << " orders , hand inlined "
+			  << inlined_orders << "\n\n";
+	std::string crtp_name = "CRTP strategy : feed event -> order in gateway queue";
+	showBench(crtp_name, crtp, cpns);
+	std::string inlined_name = "hand inlined : feed event -> order in gateway queue";
+	showBench(inlined_name, inlined, cpns);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+// benchmark for the parallel parameter sweep (core/src/sweep_runner.cpp).
+// one recording (a synthetic one written to a temp file, or a replay_convert file) is mapped once and shared by every worker.
+// a grid of mean reversion parameters (timer x band x lot) is backtested against it at recorded timing, each job on a
+// worker's own Backtest (reset between jobs), with 1 .. max workers. reports backtests per hour and the steal count, checks
+// that every worker count gives the same results in the same order and that they match a freshly built Backtest.
+// sweep_bench [max workers] [recorded seconds] [recording.bin]
+
+#include <random>
+#include <cstdio>
+#include <thread>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "replay_format.h"
+#include "book_builder.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/order_gateway.cpp"
+#include "../core/src/matching_engine.cpp"
+#include "../core/src/replay_driver.cpp"
+#include "../core/src/strategy.cpp"
+#include "../core/src/backtest.cpp"
+#include "../core/src/mean_reversion.cpp"
+#include "../core/src/sweep_runner.cpp"
+
+using namespace internal_lib;
+
+static constexpr short TAKER = 2;
+static constexpr short FIRST_MM = 3;
+static constexpr int MM_TRADERS = 97;
+
+struct SweepResult {
+	uint64_t feed_hash = 0;
+	uint64_t trades = 0;
+	uint64_t fills = 0;
+	int position = 0;
+	double pnl = 0.0;
+
+	bool operator==(const SweepResult& o) const noexcept {
+		return feed_hash == o.feed_hash && trades == o.trades && fills == o.fills && position == o.position && pnl == o.pnl;
+	}
+};
+
+struct SweepWorker {
+	Backtest bt;
+	BookBuilder book{10000};
+};
+
+// market makers quoting around 130 (creates / replaces / cancels), 1 in 10 events a taker crossing the spread
+static bool writeRecording(const char* path, double seconds, double rate) {
+	ReplayWriter writer;
+	if(!writer.open(path)) return false;
+
+	std::mt19937_64 rng(23);
+	std::exponential_distribution<double> gap(rate * 1e-9);
+	std::vector<std::vector<ReplayEvent>> live(FIRST_MM + MM_TRADERS);
+	std::vector<int> next_id(FIRST_MM + MM_TRADERS, 0);
+	double ts = 1.7e18;
+	double end = ts + seconds * 1e9;
+	float mid = 130.0f;
+
+	while((ts += gap(rng)) < end) {
+		if(rng() % 1000 == 0) mid += (rng() & 1) ? 0.5f : -0.5f; // the mid drifts, something to revert to
+		ReplayEvent ev{};
+		ev.ts_ns = static_cast<uint64_t>(ts);
+		ev.trader_id = (rng() % 10 == 0) ? TAKER : static_cast<int16_t>(FIRST_MM + rng() % MM_TRADERS);
+
+		std::vector<ReplayEvent>& quotes = live[ev.trader_id];
+		uint64_t dice = rng() % 10;
+		if(ev.trader_id == TAKER || quotes.size() < 5 || dice < 4) {
+			bool buy = rng() & 1;
+			ev.order_id = next_id[ev.trader_id]++;
+			ev.order_type = buy ? 'b' : 's';
+			float offset = 0.1f * static_cast<float>(1 + rng() % 30);
+			if(ev.trader_id == TAKER) offset = -offset;
+			ev.price = buy ? mid - offset : mid + offset;
+			ev.quantity = 1 + static_cast<int32_t>(rng() % 100);
+			ev.req_type = 'c';
+			if(ev.trader_id != TAKER) quotes.push_back(ev);
+		} else {
+			size_t pick = rng() % quotes.size();
+			ReplayEvent quote = quotes[pick];
+			ev.order_id = quote.order_id;
+			ev.order_type = quote.order_type;
+			ev.price = quote.price;
+			if(dice < 7) {
+				ev.req_type = 'd';
+				ev.quantity = 0;
+				quotes[pick] = quotes.back();
+				quotes.pop_back();
+			} else {
+				ev.req_type = 'u';
+				ev.quantity = 1 + static_cast<int32_t>(rng() % 100);
+				quotes[pick].quantity = ev.quantity;
+			}
+		}
+		if(!writer.append(ev)) return false;
+	}
+	return writer.close();
+}
+
+static SweepResult backtest(Backtest& bt, BookBuilder& book, const ReplayMapping& recording, const MeanReversionConfig& params) {
+	ReplayDriver flow(BACKTEST_CYCLES_PER_NS);
+	flow.attach(recording);
+	flow.setSpeed(1.0);
+	for(int t = 0; t < OE_MAX_TRADERS; t++) {
+		if(t != bt.strategyTrader()) flow.setRoute(static_cast<short>(t), bt.flowOrders(), bt.flowCancels());
+	}
+
+	MeanReversion strategy(bt, book, params);
+	BacktestResult r = bt.run(flow, strategy, flow.getRecordedSpanNs() + 1000);
+	return SweepResult{r.feed_hash, r.trades, strategy.getFills(), strategy.getPosition(), strategy.pnl()};
+}
+
+int main(int argc, char** argv) {
+
+	int hardware = static_cast<int>(std::thread::hardware_concurrency());
+	int max_workers = (argc > 1) ? std::stoi(argv[1]) : ((hardware > 2) ? hardware : 2);
+	double seconds = (argc > 2) ? std::stod(argv[2]) : 2.0;
+
+	std::string path = "/tmp/capitol_sweep_bench.bin";
+	if(argc > 3) path = argv[3];
+	else if(!writeRecording(path.c_str(), seconds, 20000.0)) {
+		std::cout << "can not write " << path << "\n";
+		return 1;
+	}
+
+	ReplayMapping recording;
+	if(!recording.open(path.c_str())) {
+		std::cout << "can not map " << path << "\n";
+		return 1;
+	}
+
+	std::vector<MeanReversionConfig> grid;
+	for(uint64_t timer : {50000ull, 100000ull, 200000ull, 500000ull}) {
+		for(double band : {0.02, 0.05, 0.1, 0.2}) {
+			for(int lot : {1, 5}) {
+				MeanReversionConfig c;
+				c.timer_ns = timer;
+				c.band = band;
+				c.lot = lot;
+				grid.push_back(c);
+			}
+		}
+	}
+
+	std::cout << "[SWEEP BENCH] " << grid.size() << " parameter sets x " << recording.getEventCount() << " recorded events ("
+			  << (recording.getHeader()->last_ts_ns - recording.getHeader()->first_ts_ns) * 1e-9 << " s) , "
+			  << hardware << " hardware threads\n\n";
+
+	auto job = [&recording](SweepWorker& worker, const MeanReversionConfig& params) {
+		worker.bt.reset();
+		return backtest(worker.bt, worker.book, recording, params);
+	};
+
+	std::vector<SweepResult> reference;
+	bool same = true;
+	for(int workers = 1; workers <= max_workers; workers *= 2) {
+		SweepRunner<MeanReversionConfig, SweepResult> runner(workers);
+		std::vector<SweepResult> results = runner.run<SweepWorker>(grid, job);
+		const SweepStats& stats = runner.getStats();
+
+		if(reference.empty()) reference = results;
+		else same = same && (results == reference);
+
+		std::cout << " " << workers << " workers : " << stats.wall_ns * 1e-9 << " s , "
+				  << static_cast<double>(stats.jobs) / (static_cast<double>(stats.wall_ns) * 1e-9) * 3600.0 << " backtests/hour , steals "
+				  << stats.steals << " , jobs per worker";
+		for(uint64_t n : stats.jobs_per_worker) std::cout << " " << n;
+		std::cout << "\n";
+	}
+
+	// the first and the last job again on a Backtest that never ran anything
+	bool fresh = true;
+	for(size_t i : {static_cast<size_t>(0), grid.size() - 1}) {
+		SweepWorker worker;
+		fresh = fresh && (backtest(worker.bt, worker.book, recording, grid[i]) == reference[i]);
+	}
+
+	size_t best = 0;
+	for(size_t i = 1; i < reference.size(); i++) if(reference[i].pnl > reference[best].pnl) best = i;
+	std::cout << "\n same results for every worker count : " << (same ? "yes" : "NO") << " , reset backtest = fresh backtest : "
+			  << (fresh ? "yes" : "NO") << "\n best : timer " << grid[best].timer_ns / 1000 << " us band " << grid[best].band << " lot "
+			  << grid[best].lot << " -> pnl " << reference[best].pnl << " (fills " << reference[best].fills << " position "
+			  << reference[best].position << ")\n";
+
+	if(argc <= 3) std::remove(path.c_str());
+	return (same && fresh) ? 0 : 1;
+}
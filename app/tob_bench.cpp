@@ -0,0 +1,117 @@
+// benchmark for the seqlock top of book.
+// engine cost of keeping the BBO record + depth-10 page up to date on a create/cancel/modify workload (some of it crossing),
+// and the cost of a consistent read of each from another component (same thread here, no writer contention).
+
+#include <random>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "top_of_book.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/matching_engine.cpp"
+
+using namespace internal_lib;
+
+static constexpr size_t CHUNK = 256;
+static constexpr size_t MAX_TICKS = 10000;
+
+int main(int argc, char** argv) {
+
+	size_t ops = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+	size_t reads = (argc > 2) ? std::stoul(argv[2]) : 1000000;
+
+	// workload : creates around 150.0 (about 1 in 10 crosses), cancels / quantity modifies of live orders
+	std::mt19937_64 rng(3);
+	std::vector<LOBOrder> workload;
+	workload.reserve(ops);
+	std::vector<LOBOrder> live;
+	int next_id = 0;
+
+	for(size_t i = 0; i < ops; i++) {
+		LOBOrder o{};
+		uint64_t dice = rng() % 10;
+		if(live.size() < 1000 || dice < 5) {
+			bool buy = rng() & 1;
+			o.system_id = next_id++;
+			o.order_type = buy ? 'b' : 's';
+			float offset = 0.1f * static_cast<float>(1 + rng() % 200);
+			if(rng() % 10 == 0) offset = -offset * 0.05f;
+			o.price = buy ? 150.0f - offset : 150.0f + offset;
+			o.quantity = 1 + static_cast<int>(rng() % 100);
+			o.trader_id = 2 + static_cast<short>(rng() % 98);
+			o.req_type = 'c';
+			live.push_back(o);
+		} else {
+			size_t pick = rng() % live.size();
+			o = live[pick];
+			if(dice < 8) {
+				o.req_type = 'd';
+				o.quantity = 0;
+				live[pick] = live.back();
+				live.pop_back();
+			} else {
+				o.req_type = 'u';
+				o.quantity = 1 + static_cast<int>(rng() % 100);
+				live[pick].quantity = o.quantity;
+			}
+		}
+		workload.push_back(o);
+	}
+
+	std::cout << "[TOP OF BOOK BENCH] ops : " << ops << "\n\n";
+	double cpns = get_cycles_per_ns();
+
+	for(int mode = 0; mode < 2; mode++) {
+		LFQueue<LOBOrder> loq(CHUNK);
+		LFQueue<LOBAcknowledgement> laq(CHUNK * 16);
+		LFQueue<BroadcastElement> bq(CHUNK * 16);
+
+		MatchingEngine engine(MAX_TICKS, 400, &loq, &laq, &bq);
+		TopOfBook top(MAX_TICKS);
+		if(mode == 1) engine.attachTopOfBook(&top);
+
+		uint64_t engine_cycles = 0;
+		for(size_t base = 0; base < workload.size(); base += CHUNK) {
+			size_t end = std::min(workload.size(), base + CHUNK);
+			for(size_t i = base; i < end; i++) {
+				LOBOrder* w = loq.getNextWrite();
+				*w = workload[i];
+				w->arrived_cycle_count = now_cycles();
+				w->out_cycle_count = w->arrived_cycle_count;
+				loq.updateWrite();
+			}
+
+			uint64_t start = now_cycles();
+			while(loq.getNextRead() != nullptr) engine.readOrder();
+			engine_cycles += now_cycles() - start;
+
+			while(laq.getNextRead() != nullptr) laq.updateRead();
+			while(bq.getNextRead() != nullptr) bq.updateRead();
+		}
+
+		std::cout << " " << (mode == 0 ? "no top of book" : "top of book   ") << " : engine " << (double)engine_cycles / ops / cpns << " ns/order\n";
+
+		if(mode == 1) {
+			BBOView bbo{};
+			DepthView depth{};
+			int64_t sink = 0;
+
+			uint64_t start = now_cycles();
+			for(size_t r = 0; r < reads; r++) { top.readBBO(bbo); compiler_barrier(); sink += bbo.bid_quantity; }
+			uint64_t bbo_cycles = now_cycles() - start;
+
+			start = now_cycles();
+			for(size_t r = 0; r < reads; r++) { top.readDepth(depth); compiler_barrier(); sink += depth.asks[0].quantity; }
+			uint64_t depth_cycles = now_cycles() - start;
+
+			std::cout << " readBBO   : " << (double)bbo_cycles / reads / cpns << " ns  (" << bbo.bid_quantity << " @ " << bbo.bid_price
+					  << " / " << bbo.ask_quantity << " @ " << bbo.ask_price << ")\n";
+			std::cout << " readDepth : " << (double)depth_cycles / reads / cpns << " ns  (" << depth.bid_levels << " bid / "
+					  << depth.ask_levels << " ask levels)" << (sink == 42 ? " " : "") << "\n";
+		}
+	}
+
+	return 0;
+}
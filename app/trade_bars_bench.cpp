@@ -0,0 +1,80 @@
+// benchmark for the trade tape + bar aggregation.
+// a random walk of trades goes through TradeBars (the publisher's per trade work), then the bars are checked against a
+// plain recomputation from the same trades and the query paths are timed.
+
+#include <random>
+#include <cmath>
+
+#include "trade_bars.h"
+#include "benchmark_utility.h"
+
+using namespace internal_lib;
+
+struct Trade {
+	float price;
+	int32_t quantity;
+	uint64_t cycle;
+};
+
+int main(int argc, char** argv) {
+
+	size_t trades = (argc > 1) ? std::stoul(argv[1]) : 5000000;
+	uint64_t interval = (argc > 2) ? std::stoull(argv[2]) : 100000; // cycles per bar
+
+	std::mt19937_64 rng(9);
+	std::vector<Trade> tape(trades);
+	float price = 150.0f;
+	uint64_t cycle = 1000000;
+	for(auto& t : tape) {
+		price += 0.1f * (static_cast<float>(rng() % 3) - 1.0f);
+		if(price < 1.0f) price = 1.0f;
+		cycle += 1 + rng() % 400;
+		t = Trade{price, 1 + static_cast<int32_t>(rng() % 100), cycle};
+	}
+
+	double cpns = get_cycles_per_ns();
+	TradeBars bars(interval, 1 << 16);
+
+	uint64_t start = now_cycles();
+	for(const auto& t : tape) bars.onTrade(t.price, t.quantity, t.cycle);
+	uint64_t write_cycles = now_cycles() - start;
+
+	// reference : the last bar recomputed from scratch
+	uint64_t last_index = tape.back().cycle / interval;
+	int64_t volume = 0;
+	double notional = 0;
+	float high = 0, low = 1e9f;
+	for(const auto& t : tape) {
+		if(t.cycle / interval != last_index) continue;
+		volume += t.quantity;
+		notional += static_cast<double>(t.price) * t.quantity;
+		if(t.price > high) high = t.price;
+		if(t.price < low) low = t.price;
+	}
+
+	BarView latest{};
+	bars.latest(latest);
+	bool ok = latest.index == last_index && latest.volume == volume && latest.high == high && latest.low == low &&
+			  std::fabs(latest.vwap - notional / static_cast<double>(volume)) < 1e-6;
+
+	size_t queries = 1000000;
+	BarView view{};
+	int64_t sink = 0;
+	start = now_cycles();
+	for(size_t q = 0; q < queries; q++) { bars.latest(view); compiler_barrier(); sink += view.volume; }
+	uint64_t latest_cycles = now_cycles() - start;
+
+	start = now_cycles();
+	for(size_t q = 0; q < queries / 100; q++) { bars.window(60, view); compiler_barrier(); sink += view.volume; }
+	uint64_t window_cycles = now_cycles() - start;
+
+	std::cout << "[TRADE BARS BENCH] trades : " << trades << " , interval : " << interval << " cycles , bars : " << bars.barCount() << "\n\n";
+	std::cout << " onTrade        : " << (double)write_cycles / trades / cpns << " ns/trade\n";
+	std::cout << " latest()       : " << (double)latest_cycles / queries / cpns << " ns\n";
+	std::cout << " window(60)     : " << (double)window_cycles / (queries / 100) / cpns << " ns\n";
+	std::cout << " last bar       : O " << latest.open << " H " << latest.high << " L " << latest.low << " C " << latest.close
+			  << " V " << latest.volume << " VWAP " << latest.vwap << " (" << (ok ? "matches" : "DOES NOT match") << " recomputation)"
+			  << (sink == 42 ? " " : "") << "\n";
+
+	return ok ? 0 : 1;
+}
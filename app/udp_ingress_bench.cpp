@@ -0,0 +1,247 @@
+// benchmark for the market maker UDP quote ingress over loopback.
+// a sender pushes bursts of quote datagrams with sendmmsg, the ingress drains them with recvmmsg (batch 1 = recvfrom style vs
+// batched) into the MM queue. only the cycles spent inside UdpQuoteIngress::poll() are counted ---> packets per second per core.
+// then with the cancel lane attached : a stand-in gateway drains the cancel lane first and only half of the MM queue per
+// poll (a backlog like the real one), per quote the last operation it saw must be the last one sent ---> a cancel never
+// overtakes its quote (non zero exit otherwise).
+
+#include <random>
+#include <limits>
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "quote_protocol.h"
+#include "benchmark_utility.h"
+
+#include "../core/src/udp_quote_ingress.cpp"
+
+using namespace internal_lib;
+
+static constexpr int SEND_BURST = 256; // datagrams per sendmmsg round
+
+static void runIngress(int batch, int quotes_per_packet, int rounds, double cpns) {
+	LFQueue<UserOrder> mmoq(static_cast<size_t>(SEND_BURST) * quotes_per_packet);
+
+	UdpQuoteIngress ingress(&mmoq);
+	ingress.setBatchSize(batch);
+	uint16_t port = ingress.bind(0);
+	ASSERT(port != 0, "udp ingress bench : bind failed");
+
+	int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in dest{};
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(port);
+	::inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+	::connect(tx, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+
+	size_t packet_len = sizeof(QuotePacketHeader) + static_cast<size_t>(quotes_per_packet) * sizeof(QuoteMessage);
+	std::vector<char> packets(static_cast<size_t>(SEND_BURST) * packet_len);
+	mmsghdr msgs[SEND_BURST];
+	iovec iovs[SEND_BURST];
+
+	std::mt19937 rng(11);
+	uint32_t packet_seq = 1;
+	uint64_t sent = 0;
+	uint64_t ingress_cycles = 0;
+
+	std::vector<uint64_t> poll_times;
+	poll_times.reserve(static_cast<size_t>(rounds) * SEND_BURST);
+
+	for(int r = 0; r < rounds; r++) {
+		for(int p = 0; p < SEND_BURST; p++) {
+			char* at = packets.data() + static_cast<size_t>(p) * packet_len;
+			QuotePacketHeader* header = reinterpret_cast<QuotePacketHeader*>(at);
+			header->length = static_cast<uint16_t>(packet_len);
+			header->version = QUOTE_PROTOCOL_VERSION;
+			header->count = static_cast<uint8_t>(quotes_per_packet);
+			header->packet_seq = packet_seq++;
+			header->trader_id = 2;
+
+			QuoteMessage* quote = reinterpret_cast<QuoteMessage*>(at + sizeof(QuotePacketHeader));
+			for(int q = 0; q < quotes_per_packet; q++) {
+				quote[q].type = (rng() % 10 == 0) ? 'X' : 'Q';
+				quote[q].side = (q & 1) ? 's' : 'b';
+				quote[q].quote_id = static_cast<int32_t>(rng() % 1000);
+				quote[q].price = 100.0f + 0.1f * static_cast<float>(rng() % 100);
+				quote[q].quantity = 1 + static_cast<int32_t>(rng() % 50);
+			}
+
+			iovs[p].iov_base = at;
+			iovs[p].iov_len = packet_len;
+			msgs[p].msg_hdr = msghdr{};
+			msgs[p].msg_hdr.msg_iov = &iovs[p];
+			msgs[p].msg_hdr.msg_iovlen = 1;
+		}
+
+		int out = ::sendmmsg(tx, msgs, SEND_BURST, 0);
+		if(out > 0) sent += static_cast<uint64_t>(out);
+
+		while(true) {
+			uint64_t start = now_cycles();
+			int got = ingress.poll();
+			uint64_t end = now_cycles();
+			if(got == 0) break;
+
+			ingress_cycles += end - start;
+			poll_times.push_back((end - start) / static_cast<uint64_t>(got)); // per datagram
+
+			// stand-in for the gateway
+			while(mmoq.getNextRead() != nullptr) mmoq.updateRead();
+		}
+	}
+	::close(tx);
+
+	std::string name = "UDP ingress per datagram (batch " + std::to_string(batch) + ", " + std::to_string(quotes_per_packet) + " quotes/packet)";
+	showBench(name, poll_times, cpns);
+
+	double seconds = (double)ingress_cycles / cpns / 1e9;
+	std::cout << " sent : " << sent << " , received : " << ingress.getPackets() << " (lost " << ingress.getLostPackets()
+			  << ") , recv calls : " << ingress.getRecvCalls() << " , quotes : " << ingress.getQuotes()
+			  << " , dropped : " << ingress.getDroppedQuotes() << "\n";
+	std::cout << " " << (double)ingress.getPackets() / seconds / 1e6 << " M packets/s per core , "
+			  << (double)ingress.getQuotes() / seconds / 1e6 << " M quotes/s per core\n\n";
+}
+
+// returns false if a quote ended up in another state than the sender left it in
+static bool runOrdering(int rounds, int quotes_per_packet) {
+	static constexpr int QUOTE_IDS = 256; // few ids ---> a cancel often follows a quote that is still queued
+
+	LFQueue<UserOrder> mmoq(static_cast<size_t>(SEND_BURST) * quotes_per_packet);
+	LFQueue<UserOrder> mmcq(static_cast<size_t>(SEND_BURST) * quotes_per_packet);
+
+	UdpQuoteIngress ingress(&mmoq, &mmcq);
+	uint16_t port = ingress.bind(0);
+	ASSERT(port != 0, "udp ingress bench : bind failed");
+
+	int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in dest{};
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(port);
+	::inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+	::connect(tx, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+
+	size_t packet_len = sizeof(QuotePacketHeader) + static_cast<size_t>(quotes_per_packet) * sizeof(QuoteMessage);
+	std::vector<char> packet(packet_len);
+	std::vector<char> sent_last(QUOTE_IDS, 'X');
+	std::vector<char> seen_last(QUOTE_IDS, 'X');
+
+	std::mt19937 rng(13);
+	uint32_t packet_seq = 1;
+
+	auto drainCancels = [&]() {
+		while(UserOrder* o = mmcq.getNextRead()) { seen_last[o->order_id] = 'X'; mmcq.updateRead(); }
+	};
+	auto drainOrders = [&](size_t most) {
+		for(size_t k = 0; k < most; k++) {
+			UserOrder* o = mmoq.getNextRead();
+			if(o == nullptr) break;
+			seen_last[o->order_id] = (o->req_type == 'q') ? 'Q' : 'X';
+			mmoq.updateRead();
+		}
+	};
+
+	for(int r = 0; r < rounds; r++) {
+		for(int p = 0; p < SEND_BURST; p++) {
+			QuotePacketHeader* header = reinterpret_cast<QuotePacketHeader*>(packet.data());
+			header->length = static_cast<uint16_t>(packet_len);
+			header->version = QUOTE_PROTOCOL_VERSION;
+			header->count = static_cast<uint8_t>(quotes_per_packet);
+			header->packet_seq = packet_seq++;
+			header->trader_id = 2;
+
+			QuoteMessage* quote = reinterpret_cast<QuoteMessage*>(packet.data() + sizeof(QuotePacketHeader));
+			for(int q = 0; q < quotes_per_packet; q++) {
+				quote[q].type = (rng() % 3 == 0) ? 'X' : 'Q';
+				quote[q].side = (q & 1) ? 's' : 'b';
+				quote[q].quote_id = static_cast<int32_t>(rng() % QUOTE_IDS);
+				quote[q].price = 100.0f + 0.1f * static_cast<float>(rng() % 100);
+				quote[q].quantity = 1 + static_cast<int32_t>(rng() % 50);
+				sent_last[quote[q].quote_id] = quote[q].type;
+			}
+			::send(tx, packet.data(), packet_len, 0);
+
+			// one datagram per poll, then the gateway's turn : the whole cancel lane, half of what waits in the MM queue
+			while(ingress.poll() != 0) {
+				drainCancels();
+				drainOrders(mmoq.entriesBetween(mmoq.readIndex(), mmoq.writeIndex()) / 2);
+			}
+		}
+		drainCancels();
+		drainOrders(static_cast<size_t>(-1));
+	}
+	::close(tx);
+
+	size_t wrong = 0;
+	for(int id = 0; id < QUOTE_IDS; id++) wrong += (sent_last[id] != seen_last[id]);
+
+	bool lossless = (ingress.getLostPackets() == 0 && ingress.getDroppedQuotes() == 0);
+	std::cout << " cancel lane ordering : " << ingress.getQuotes() << " quotes , " << ingress.getOrderedCancels()
+			  << " cancels sent behind their pending quote , " << wrong << " quotes in the wrong final state";
+	if(!lossless) std::cout << " (packets lost / dropped, not checked)";
+	std::cout << "\n";
+	return !lossless || wrong == 0;
+}
+
+// quotes priced inf / nan are dropped like any malformed quote, the rest of the packet still goes through (prices past the
+// book's last tick are the engine's to refuse, same as on the order entry path)
+static bool runBadPrice() {
+	LFQueue<UserOrder> mmoq(64);
+	UdpQuoteIngress ingress(&mmoq);
+	uint16_t port = ingress.bind(0);
+	ASSERT(port != 0, "udp ingress bench : bind failed");
+
+	int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in dest{};
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(port);
+	::inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+	::connect(tx, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+
+	static constexpr int QUOTES = 3;
+	const float prices[QUOTES] = {std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), 100.0f};
+	size_t packet_len = sizeof(QuotePacketHeader) + QUOTES * sizeof(QuoteMessage);
+	std::vector<char> packet(packet_len);
+	QuotePacketHeader* header = reinterpret_cast<QuotePacketHeader*>(packet.data());
+	header->length = static_cast<uint16_t>(packet_len);
+	header->version = QUOTE_PROTOCOL_VERSION;
+	header->count = QUOTES;
+	header->packet_seq = 1;
+	header->trader_id = 2;
+	QuoteMessage* quote = reinterpret_cast<QuoteMessage*>(packet.data() + sizeof(QuotePacketHeader));
+	for(int q = 0; q < QUOTES; q++) {
+		quote[q].type = 'Q';
+		quote[q].side = 'b';
+		quote[q].quote_id = q;
+		quote[q].price = prices[q];
+		quote[q].quantity = 10;
+	}
+	::send(tx, packet.data(), packet_len, 0);
+	while(ingress.getPackets() == 0) ingress.poll();
+	::close(tx);
+
+	size_t forwarded = mmoq.entriesBetween(mmoq.readIndex(), mmoq.writeIndex());
+	bool ok = (forwarded == 1 && ingress.getBadPackets() == 2);
+	std::cout << " bad prices : " << ingress.getBadPackets() << " quotes dropped , " << forwarded << " forwarded (expect 2 , 1) "
+			  << (ok ? "ok" : "FAILED") << "\n";
+	return ok;
+}
+
+int main(int argc, char** argv) {
+
+	int rounds = (argc > 1) ? std::stoi(argv[1]) : 2000;
+	int quotes_per_packet = (argc > 2) ? std::stoi(argv[2]) : 8;
+	if(quotes_per_packet < 1) quotes_per_packet = 1;
+	if(quotes_per_packet > static_cast<int>(QUOTE_MAX_PER_PACKET)) quotes_per_packet = QUOTE_MAX_PER_PACKET;
+
+	double cpns = get_cycles_per_ns();
+
+	std::cout << "[UDP INGRESS BENCH] rounds : " << rounds << " x " << SEND_BURST << " datagrams , quotes per packet : " << quotes_per_packet << "\n\n";
+
+	for(int batch : {1, 16, 64}) {
+		runIngress(batch, quotes_per_packet, rounds, cpns);
+	}
+	bool ok = runOrdering(rounds / 10 + 1, quotes_per_packet);
+	ok &= runBadPrice();
+
+	return ok ? 0 : 1;
+}
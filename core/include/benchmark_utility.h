@@ -40,6 +40,12 @@ namespace internal_lib {
 		
 		std::cout<<"================ BENCHMARK FOR : "<<bench_string<<" ================\n\n\n";
 
+		if(time_vector.empty()) { // e.g. a gateway that received no traffic
+			std::cout<<" no samples\n\n";
+			std::cout<<"====================================================================\n\n\n";
+			return ;
+		}
+
 		std::sort(time_vector.begin(),time_vector.end());
 		size_t siz = time_vector.size();
 
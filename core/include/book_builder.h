@@ -0,0 +1,283 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "lob_structs.h"           // BroadcastElement
+#include "system_id_allocator.h"
+#include "top_of_book.h"           // DepthLevel
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// client side book builder : rebuilds the order book (L3, every order) and its price levels (L2) from the incremental
+	// feed ('N' add, 'U' new balance, 'D' delete, 'T' fill of the passive order) for anyone reading a BroadcastQueue.
+	//
+	// everything is flat and allocated in the constructor :
+	//   - orders : a node per system id slot (the same direct indexing as the engine's LUT), the full id is kept so a stale
+	//     event (old generation of the slot) is ignored. the nodes of a level form an intrusive FIFO (prev / next slot).
+	//   - levels : per side and price tick the aggregate quantity / order count and the FIFO head / tail.
+	//   - a bitmap of non empty ticks per side, so the next best level after the best one empties is a few word scans.
+	// applying an event is a handful of stores, queue position walks the level's FIFO from its head.
+	//
+	// the builder follows the engine's rules : price tick = price * 10 (truncated, as the engine does), a quantity increase
+	// loses time priority (back of the level), a decrease keeps it, a fill that takes the whole order removes it (no 'D' follows).
+
+	struct QueuePosition {
+		int64_t quantity_ahead;    // open quantity in front of the order at its level
+		int32_t orders_ahead;
+		int32_t level_orders;      // orders at the level including this one, -1 = unknown order
+	};
+
+	class BookBuilder {
+	private :
+
+		struct Node {                  // 24 byte
+			int system_id = -1;        // -1 = slot empty
+			int32_t quantity = 0;
+			int32_t tick = 0;
+			int32_t prev = -1;         // FIFO neighbours (slot), -1 = none
+			int32_t next = -1;
+			int8_t side = 0;           // 0 buy, 1 sell
+		};
+
+		struct Level {                 // 16 byte
+			int64_t quantity = 0;
+			int32_t head = -1;
+			int32_t tail = -1;
+		};
+
+		size_t ticks;
+		std::vector<Node> Nodes;
+		std::vector<Level> Levels[2];          // [0] buy, [1] sell
+		std::vector<int32_t> Counts[2];
+		std::vector<uint64_t> Live[2];         // bit t = tick t has orders
+		long best[2] = {-1, -1};
+
+		uint64_t applied = 0;
+		uint64_t ignored = 0;
+
+	public :
+
+		explicit BookBuilder(size_t max_price_ticks)
+			: ticks(max_price_ticks + 1), Nodes(SYSTEM_ID_CAPACITY) {
+			for(int s = 0; s < 2; s++) {
+				Levels[s].assign(ticks, Level{});
+				Counts[s].assign(ticks, 0);
+				Live[s].assign((ticks + 63) / 64, 0);
+			}
+		}
+
+		BookBuilder(const BookBuilder&) = delete;
+		BookBuilder& operator=(const BookBuilder&) = delete;
+
+		// one feed event, false if it did not change the book (unknown / stale id, price out of range)
+		inline bool apply(const BroadcastElement& be) noexcept {
+			bool changed;
+			switch(be.type) {
+				case 'N': changed = add(be); break;
+				case 'U': changed = rebalance(be.system_id, be.quantity); break;
+				case 'T': changed = fill(be.system_id, be.quantity); break;
+				case 'D': changed = remove(be.system_id); break;
+				default : changed = false; break;
+			}
+			if(LIKELY(changed)) applied++;
+			else ignored++;
+			return changed;
+		}
+
+		// best first, returns the number of levels written (<= n)
+		inline int topN(bool is_buy, DepthLevel* out, int n) const noexcept {
+			int s = is_buy ? 0 : 1;
+			int k = 0;
+			for(long t = best[s]; t != -1 && k < n; t = nextLive(s, t)) {
+				out[k++] = DepthLevel{static_cast<float>(t) * 0.1f, Counts[s][t], Levels[s][t].quantity};
+			}
+			return k;
+		}
+
+		inline bool bestLevel(bool is_buy, DepthLevel& out) const noexcept {
+			return topN(is_buy, &out, 1) == 1;
+		}
+
+		inline QueuePosition queuePosition(int system_id) const noexcept {
+			const Node* node = find(system_id);
+			if(node == nullptr) return QueuePosition{0, 0, -1};
+
+			QueuePosition qp{0, 0, Counts[node->side][node->tick]};
+			int me = systemIdIndex(system_id);
+			for(int at = Levels[node->side][node->tick].head; at != me && at != -1; at = Nodes[at].next) {
+				qp.quantity_ahead += Nodes[at].quantity;
+				qp.orders_ahead++;
+			}
+			return qp;
+		}
+
+		// open quantity of a resting order, 0 if it is not in the book
+		inline int32_t orderQuantity(int system_id) const noexcept {
+			const Node* node = find(system_id);
+			return (node != nullptr) ? node->quantity : 0;
+		}
+
+		// empty book, walks only the orders still resting (a builder that is reused per run does not re-touch its tables)
+		void reset() noexcept {
+			for(int s = 0; s < 2; s++) {
+				for(long t = best[s]; t != -1; t = nextLive(s, t)) {
+					for(int at = Levels[s][t].head; at != -1;) {
+						int next = Nodes[at].next;
+						Nodes[at] = Node{};
+						at = next;
+					}
+					Levels[s][t] = Level{};
+					Counts[s][t] = 0;
+					Live[s][t >> 6] &= ~(1ULL << (t & 63));
+				}
+				best[s] = -1;
+			}
+			applied = 0;
+			ignored = 0;
+		}
+
+		uint64_t getApplied() const noexcept { return applied; }
+		uint64_t getIgnored() const noexcept { return ignored; }
+
+	private :
+
+		inline const Node* find(int system_id) const noexcept {
+			if(UNLIKELY(system_id < 0)) return nullptr;
+			const Node& node = Nodes[systemIdIndex(system_id)];
+			return (node.system_id == system_id) ? &node : nullptr;
+		}
+
+		inline bool add(const BroadcastElement& be) noexcept {
+			if(UNLIKELY(be.system_id < 0 || be.quantity <= 0)) return false;
+			size_t tick = static_cast<size_t>(be.price * 10);
+			if(UNLIKELY(tick >= ticks)) return false;
+
+			int slot = systemIdIndex(be.system_id);
+			if(UNLIKELY(Nodes[slot].system_id != -1)) unlink(slot); // missed the end of the slot's previous order
+
+			Node& node = Nodes[slot];
+			node.system_id = be.system_id;
+			node.quantity = be.quantity;
+			node.tick = static_cast<int32_t>(tick);
+			node.side = (be.side == 'B') ? 0 : 1;
+			link(slot);
+			return true;
+		}
+
+		inline bool rebalance(int system_id, int quantity) noexcept {
+			if(find(system_id) == nullptr) return false;
+			int slot = systemIdIndex(system_id);
+			if(quantity <= 0) {
+				unlink(slot);
+				return true;
+			}
+
+			Node& node = Nodes[slot];
+			if(quantity > node.quantity) {
+				// bigger : back of the queue
+				unlink(slot);
+				node.system_id = system_id;
+				node.quantity = quantity;
+				link(slot);
+			} else {
+				Levels[node.side][node.tick].quantity += quantity - node.quantity;
+				node.quantity = quantity;
+			}
+			return true;
+		}
+
+		inline bool fill(int system_id, int traded) noexcept {
+			if(find(system_id) == nullptr) return false;
+			int slot = systemIdIndex(system_id);
+			Node& node = Nodes[slot];
+			if(traded >= node.quantity) {
+				unlink(slot);
+			} else {
+				node.quantity -= traded;
+				Levels[node.side][node.tick].quantity -= traded;
+			}
+			return true;
+		}
+
+		inline bool remove(int system_id) noexcept {
+			if(find(system_id) == nullptr) return false;
+			unlink(systemIdIndex(system_id));
+			return true;
+		}
+
+		// appends the slot (fields set) to the tail of its level
+		inline void link(int slot) noexcept {
+			Node& node = Nodes[slot];
+			int s = node.side;
+			long t = node.tick;
+			Level& level = Levels[s][t];
+
+			node.prev = level.tail;
+			node.next = -1;
+			if(level.tail != -1) Nodes[level.tail].next = slot;
+			else level.head = slot;
+			level.tail = slot;
+			level.quantity += node.quantity;
+
+			if(Counts[s][t]++ == 0) {
+				Live[s][t >> 6] |= (1ULL << (t & 63));
+				if(best[s] == -1 || (s == 0 ? t > best[s] : t < best[s])) best[s] = t;
+			}
+		}
+
+		// takes the slot out of its level and frees it
+		inline void unlink(int slot) noexcept {
+			Node& node = Nodes[slot];
+			int s = node.side;
+			long t = node.tick;
+			Level& level = Levels[s][t];
+
+			if(node.prev != -1) Nodes[node.prev].next = node.next;
+			else level.head = node.next;
+			if(node.next != -1) Nodes[node.next].prev = node.prev;
+			else level.tail = node.prev;
+			level.quantity -= node.quantity;
+
+			node.system_id = -1;
+			node.quantity = 0;
+			node.prev = node.next = -1;
+
+			if(--Counts[s][t] == 0) {
+				Live[s][t >> 6] &= ~(1ULL << (t & 63));
+				if(t == best[s]) best[s] = nextLive(s, t);
+			}
+		}
+
+		// next non empty tick behind 'from' (worse price), -1 if there is none
+		inline long nextLive(int s, long from) const noexcept {
+			const std::vector<uint64_t>& live = Live[s];
+			if(s == 0) {
+				if(from <= 0) return -1;
+				long t = from - 1;
+				long w = t >> 6;
+				uint64_t bits = live[w] & (~0ULL >> (63 - (t & 63)));  // ticks <= t in this word
+				while(true) {
+					if(bits != 0) return (w << 6) + 63 - __builtin_clzll(bits);
+					if(--w < 0) return -1;
+					bits = live[w];
+				}
+			} else {
+				long t = from + 1;
+				if(t >= static_cast<long>(ticks)) return -1;
+				long w = t >> 6;
+				long words = static_cast<long>(live.size());
+				uint64_t bits = live[w] & (~0ULL << (t & 63));          // ticks >= t in this word
+				while(true) {
+					if(bits != 0) return (w << 6) + __builtin_ctzll(bits);
+					if(++w >= words) return -1;
+					bits = live[w];
+				}
+			}
+		}
+	};
+}
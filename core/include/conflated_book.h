@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// conflated price level feed : the engine overwrites the aggregate (total quantity, order count) of every price level it
+	// touches in place, readers pick up the LATEST value of each level that changed since they last looked, at their own pace.
+	// nothing is queued, so a reader that is slow (or stopped) only ever misses intermediate values, it never holds the engine.
+	//
+	// every level is a 16 byte record under its own sequence lock. every reader has a dirty bitmap per side (one bit per price
+	// tick) plus a summary bitmap (one bit per 64 bit word), the writer sets them with fetch_or and the reader takes them with
+	// exchange. the writer cost per change is the level stores + at most 2 atomic ors per registered reader, no matter how far
+	// behind any reader is.
+
+	class ConflatedBook {
+	public :
+
+		static constexpr int MAX_READERS = 4;
+
+	private :
+
+		struct alignas(16) Level {
+			std::atomic<uint32_t> seq{0};   // odd while the writer is in the middle of an update
+			int32_t orders = 0;
+			int64_t quantity = 0;
+		};
+
+		struct DirtyBits {
+			std::unique_ptr<std::atomic<uint64_t>[]> words[2];    // [0] buy, [1] sell : bit t = tick t changed
+			std::unique_ptr<std::atomic<uint64_t>[]> summary[2];  // bit w = words[w] is non zero
+		};
+
+		size_t ticks;
+		size_t word_count;
+		size_t summary_count;
+
+		std::vector<Level> levels[2];
+		DirtyBits dirty[MAX_READERS];
+		alignas(64) std::atomic<int> reader_count = {0};
+
+	public :
+
+		explicit ConflatedBook(size_t max_price_ticks) : ticks(max_price_ticks + 1) {
+			word_count = (ticks + 63) / 64;
+			summary_count = (word_count + 63) / 64;
+
+			for(int s = 0; s < 2; s++) levels[s] = std::vector<Level>(ticks);
+			for(auto& d : dirty) {
+				for(int s = 0; s < 2; s++) {
+					d.words[s].reset(new std::atomic<uint64_t>[word_count]);
+					d.summary[s].reset(new std::atomic<uint64_t>[summary_count]);
+					for(size_t w = 0; w < word_count; w++) d.words[s][w].store(0, std::memory_order_relaxed);
+					for(size_t w = 0; w < summary_count; w++) d.summary[s][w].store(0, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		ConflatedBook(const ConflatedBook&) = delete;
+		ConflatedBook& operator=(const ConflatedBook&) = delete;
+
+		// ======================== engine thread (single writer) ========================
+
+		inline void apply(bool is_buy, size_t tick, int64_t quantity_delta, int32_t orders_delta) noexcept {
+			if(UNLIKELY(tick >= ticks)) return;
+			int side = is_buy ? 0 : 1;
+			Level& level = levels[side][tick];
+
+			uint32_t seq = level.seq.load(std::memory_order_relaxed);
+			level.seq.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			level.quantity += quantity_delta;
+			level.orders += orders_delta;
+			level.seq.store(seq + 2, std::memory_order_release);
+
+			size_t word = tick >> 6;
+			uint64_t bit = 1ull << (tick & 63);
+			int readers = reader_count.load(std::memory_order_relaxed);
+			for(int r = 0; r < readers; r++) {
+				// the summary bit is only needed when the word goes from clean to dirty
+				if(dirty[r].words[side][word].fetch_or(bit, std::memory_order_release) == 0) {
+					dirty[r].summary[side][word >> 6].fetch_or(1ull << (word & 63), std::memory_order_release);
+				}
+			}
+		}
+
+		// ======================== readers ========================
+
+		// returns the reader index (-1 if all slots are taken). every level is dirty for a new reader, its first collect() is a
+		// full snapshot.
+		int registerReader() noexcept {
+			int r = reader_count.load(std::memory_order_relaxed);
+			if(r >= MAX_READERS) return -1;
+
+			for(int s = 0; s < 2; s++) {
+				for(size_t w = 0; w < word_count; w++) {
+					uint64_t valid = (w == word_count - 1 && (ticks & 63) != 0) ? ((1ull << (ticks & 63)) - 1) : ~0ull;
+					dirty[r].words[s][w].store(valid, std::memory_order_relaxed);
+				}
+				for(size_t w = 0; w < summary_count; w++) {
+					uint64_t valid = (w == summary_count - 1 && (word_count & 63) != 0) ? ((1ull << (word_count & 63)) - 1) : ~0ull;
+					dirty[r].summary[s][w].store(valid, std::memory_order_relaxed);
+				}
+			}
+			reader_count.store(r + 1, std::memory_order_release); // one control thread registers readers
+			return r;
+		}
+
+		// on_level(bool is_buy, size_t tick, int64_t quantity, int32_t orders) once for every level that changed since the last
+		// collect of this reader, with its latest value. returns the number of levels reported.
+		template<typename Handler>
+		size_t collect(int reader, Handler&& on_level) noexcept {
+			size_t reported = 0;
+			DirtyBits& d = dirty[reader];
+
+			for(int s = 0; s < 2; s++) {
+				for(size_t sw = 0; sw < summary_count; sw++) {
+					uint64_t words = d.summary[s][sw].exchange(0, std::memory_order_acquire);
+					while(words != 0) {
+						size_t word = (sw << 6) + static_cast<size_t>(__builtin_ctzll(words));
+						words &= words - 1;
+
+						uint64_t bits = d.words[s][word].exchange(0, std::memory_order_acquire);
+						while(bits != 0) {
+							size_t tick = (word << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+							bits &= bits - 1;
+
+							int64_t quantity;
+							int32_t orders;
+							read(s, tick, quantity, orders);
+							on_level(s == 0, tick, quantity, orders);
+							reported++;
+						}
+					}
+				}
+			}
+			return reported;
+		}
+
+		// consistent copy of one level (any thread, any time)
+		inline void read(int side, size_t tick, int64_t& quantity, int32_t& orders) const noexcept {
+			const Level& level = levels[side][tick];
+			while(true) {
+				uint32_t before = level.seq.load(std::memory_order_acquire);
+				if(UNLIKELY(before & 1)) continue;
+				quantity = level.quantity;
+				orders = level.orders;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(LIKELY(level.seq.load(std::memory_order_relaxed) == before)) return;
+			}
+		}
+
+		size_t getTicks() const noexcept { return ticks; }
+	};
+}
@@ -83,6 +83,26 @@ namespace internal_lib {
 			next_index_to_write = ((next_index_to_write + 1)&( capacity_mask));
 		}
 
+		// batched writes : reserve up to 'wanted' slots, fill them with getWriteAhead(0 .. n-1) and publish all of them with one
+		// updateWrite(n) ---> one store of the write index (one cache line handed to the consumer) per burst instead of per entry.
+		// returns how many slots are free right now, capped at 'wanted'.
+		size_t getWriteSpace(size_t wanted) noexcept {
+			size_t free_slots = (lazy_read - next_index_to_write - 1)&(capacity_mask);
+			if(free_slots < wanted) {
+				lazy_read = next_index_to_read;
+				free_slots = (lazy_read - next_index_to_write - 1)&(capacity_mask);
+			}
+			return (free_slots < wanted) ? free_slots : wanted;
+		}
+
+		T* getWriteAhead(size_t ahead) noexcept {
+			return &(store_[(next_index_to_write + ahead)&(capacity_mask)]);
+		}
+
+		void updateWrite(size_t count) noexcept { // count must not exceed what getWriteSpace returned
+			next_index_to_write = ((next_index_to_write + count)&( capacity_mask));
+		}
+
 		T* getNextRead() noexcept {
 			// if the consumer consumed all the values and is now pointing to the next write index ==> means the place to which it is pointintg has no data yet so we return nullptr
 
@@ -104,7 +124,32 @@ namespace internal_lib {
 			}
 
 			next_index_to_read = ((next_index_to_read + 1)&( capacity_mask));
-		}	
+		}
+
+		void updateRead(size_t count) noexcept { // releases a burst read through getReadAhead, count must not exceed what it returned
+			next_index_to_read = ((next_index_to_read + count)&( capacity_mask));
+		}
+
+		// peek 'ahead' slots past the read head without consuming anything ---> lets a consumer look at a burst of pending entries
+		// (to issue prefetches for them) before it processes the head. returns nullptr if that many entries are not published yet.
+		T* getReadAhead(size_t ahead) noexcept {
+			size_t read_idx = next_index_to_read;
+
+			if(((lazy_write - read_idx)&(capacity_mask)) <= ahead) {
+				lazy_write = next_index_to_write; // refresh our cached copy of the writer only when the cached one is not enough
+				if(((lazy_write - read_idx)&(capacity_mask)) <= ahead) {
+					return nullptr;
+				}
+			}
+
+			return &(store_[(read_idx + ahead)&(capacity_mask)]);
+		}
+
+		// positions for a consumer that has to wait on this queue from somewhere else : writeIndex() = everything published so far,
+		// readIndex() = how far the consumer got. indices wrap, entriesBetween(from, to) counts the entries from one to the other.
+		size_t writeIndex() const noexcept { return next_index_to_write.load(std::memory_order_acquire); }
+		size_t readIndex() const noexcept { return next_index_to_read.load(std::memory_order_relaxed); }
+		size_t entriesBetween(size_t from, size_t to) const noexcept { return (to - from)&(capacity_mask); }
 
 
 	};
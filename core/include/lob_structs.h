@@ -1,6 +1,7 @@
 
 
 #include "order_gateway_structs.h"
+#include "system_id_allocator.h"
 
  #pragma once
 
@@ -65,7 +66,7 @@ namespace internal_lib {
 
             
             active_counts.resize(max_price_ticks + 1, 0);
-            LUT.resize(10000000, {-1, -1}); // 10 Million Systems Id's mapping
+            LUT.resize(SYSTEM_ID_CAPACITY, {-1, -1}); // one entry per system id slot (ids are recycled, see system_id_allocator.h)
 
             // initialize optimum
             if (IsBuy) optimum_price = 0; 
@@ -74,8 +75,37 @@ namespace internal_lib {
 		}
 
 		LOBOrder* peekLOBEntry(int systemId) noexcept {
-			if(UNLIKELY(LUT[systemId].first == -1 || LUT[systemId].second == -1)) return nullptr; // if it does not exists in the LOB return null ptr.
-			return &(store_[LUT[systemId].first][LUT[systemId].second]);
+			if(UNLIKELY(systemId < 0)) return nullptr;
+			int slot = systemIdIndex(systemId);
+			if(UNLIKELY(LUT[slot].first == -1 || LUT[slot].second == -1)) return nullptr; // if it does not exists in the LOB return null ptr.
+
+			LOBOrder* entry = &(store_[LUT[slot].first][LUT[slot].second]);
+			if(UNLIKELY(entry->system_id != systemId)) return nullptr; // slot now belongs to a newer generation, stale id
+			return entry;
+		}
+
+		// lookahead prefetching (used by the engine for orders still sitting in the queue)
+		// stage 1 : pull the LUT slot of the order.
+		void prefetchLUT(int systemId) const noexcept {
+			if(LIKELY(systemId >= 0)) __builtin_prefetch(&LUT[systemIdIndex(systemId)], 1, 3);
+		}
+
+		// stage 2 : by now the LUT slot should be warm, follow it and pull the row entry this order is going to touch.
+		// resting entry for update/delete, the row tail (where push_back lands) for create.
+		void prefetchTarget(const LOBOrder& order) const noexcept {
+			if(order.req_type == 'c') {
+				size_t price_index = static_cast<size_t>(order.price*10);
+				if(LIKELY(price_index < store_.size())) {
+					const auto& row = store_[price_index];
+					__builtin_prefetch(row.data() + row.size(), 1, 3);
+				}
+				return;
+			}
+
+			if(UNLIKELY(order.system_id < 0)) return;
+			int slot = systemIdIndex(order.system_id);
+			int row = LUT[slot].first;
+			if(row != -1) __builtin_prefetch(&store_[row][LUT[slot].second], 1, 3);
 		}
 
 		std::vector<internal_lib::LOBOrder>& getLevel(size_t best_ask_idx) noexcept { // returning a reference to a row of LOBORders
@@ -108,7 +138,7 @@ namespace internal_lib {
 			store_[price_index].push_back(order);
 
 			// update the LUT
-			LUT[order.system_id] = {price_index,store_[price_index].size() - 1};
+			LUT[systemIdIndex(order.system_id)] = {price_index,store_[price_index].size() - 1};
 			// update active count
 			active_counts[price_index]++;
 
@@ -121,8 +151,9 @@ namespace internal_lib {
 
 
 			// find the order from LUT.
-			size_t price_row = LUT[data.system_id].first;
-			size_t order_col = LUT[data.system_id].second;
+			int slot = systemIdIndex(data.system_id);
+			size_t price_row = LUT[slot].first;
+			size_t order_col = LUT[slot].second;
 
 
 			if(data.quantity != store_[price_row][order_col].quantity) {
@@ -138,45 +169,94 @@ namespace internal_lib {
 					store_[price_row].push_back(data);
 					
 					// update LUT
-					LUT[data.system_id] = {price_row,store_[price_row].size() - 1};
+					LUT[slot] = {price_row,store_[price_row].size() - 1};
 				}
 			}
 		}
 
-		void deleteOrder(int system_id) noexcept {
+		// returns true only if this exact id (slot + generation) was resting and got removed
+		bool deleteOrder(int system_id) noexcept {
 
-            if (UNLIKELY(system_id >= LUT.size())) return;
+            if (UNLIKELY(system_id < 0)) return false;
 
-            int price_row = LUT[system_id].first;
-            int order_col = LUT[system_id].second;
+            int slot = systemIdIndex(system_id);
+            int price_row = LUT[slot].first;
+            int order_col = LUT[slot].second;
 
             if (LIKELY(price_row != -1)) {
+                if (UNLIKELY(store_[price_row][order_col].system_id != system_id)) return false; // stale id, slot re-used
+
                 //  lazy delete (mark delete)
                 store_[price_row][order_col].quantity = 0;
                 
                 // update LUT and active array
-                LUT[system_id] = {-1, -1};
+                LUT[slot] = {-1, -1};
                 active_counts[price_row]--;
 
                 // only expensive glide if we emptied the BEST price level
                 if (UNLIKELY(active_counts[price_row] == 0 && price_row == (int)optimum_price)) {
                     glideOptimum(); 
                 }
+                return true;
             }
+            return false;
         }
 
+		// mass cancel : walks every non empty level and removes each live order of the trader.
+		// on_cancel(entry) is called while the entry still holds its quantity (for the broadcast/ack), returns how many were removed.
+		// cold path (a trader pulling everything), so a plain scan is fine here ---> no per trader index to maintain on the hot path.
+		template <typename OnCancel>
+		int cancelAllForTrader(short trader_id, OnCancel&& on_cancel) noexcept {
+			int cancelled = 0;
+
+			for(size_t price_row = 0; price_row < store_.size(); price_row++) {
+				if(active_counts[price_row] == 0) continue;
+
+				for(auto& entry : store_[price_row]) {
+					if(entry.quantity > 0 && entry.trader_id == trader_id) {
+						on_cancel(entry);
+
+						entry.quantity = 0;
+						LUT[systemIdIndex(entry.system_id)] = {-1, -1};
+						active_counts[price_row]--;
+						cancelled++;
+					}
+				}
+			}
+
+			if(cancelled != 0 && active_counts[optimum_price] == 0) glideOptimum();
+			return cancelled;
+		}
+
 		size_t getOptimumPriceIndex() noexcept {
 			return optimum_price;
 		}
 
+		// empty book again, rows keep their capacity. only live entries own their LUT slot (a dead entry's slot may already
+		// belong to a newer order), so those are the ones cleared
+		void reset() noexcept {
+			for(size_t price_row = 0; price_row < store_.size(); price_row++) {
+				if(store_[price_row].empty()) continue;
+				if(active_counts[price_row] != 0) {
+					for(auto& entry : store_[price_row]) {
+						if(entry.quantity > 0) LUT[systemIdIndex(entry.system_id)] = {-1, -1};
+					}
+					active_counts[price_row] = 0;
+				}
+				store_[price_row].clear();
+			}
+			optimum_price = IsBuy ? 0 : max_price_limit;
+		}
+
 	};
 
 	struct BroadcastElement {
+        uint64_t event_cycle; // engine cycle count when the book changed (publish latency is measured from here)
         int system_id;    // Reference to the order in the book
         float price;         // Trade Price
         int quantity;     // AMOUNT TRADED (if type=='T') or NEW BALANCE (if type=='U') or FULL SIZE (if type=='A')
         char side;            // 'B'uy or 'S'ell
-        char type;            // 'A'dd, 'U'pdate, 'D'elete, 'T'rade
+        char type;            // 'N'ew (add), 'U'pdate, 'D'elete, 'T'rade
     };
 
 
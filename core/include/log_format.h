@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Capitol binary log (v1) : the file Async_Logger (logger.h) writes and log_decode turns back into text.
+//
+// a 24 byte header, the token registry, then fixed size 48 byte records until the end of the file, nothing else. the
+// logger thread only copies records, no formatting : a record is the LogElement minus its padding (time stamp, token, core,
+// component and the 32 byte payload as it was written), the text is made offline from the registry.
+//
+// the registry maps a string token to its format string. the format says how to read the payload : every {i16} {i32} {i64}
+// {u64} {f32} {f64} {c} {x32} (uint32 in hex) takes the next field of that type (natural alignment, the way the payload struct is laid out), the
+// rest is copied as is. the registry is written into the file, a log decodes without the build that produced it.
+// little endian, host layout. the record count is not stored : a record cut short by a crash is dropped by the decoder.
+
+namespace internal_lib {
+
+	constexpr uint32_t LOG_MAGIC = 0x4c504143; // "CAPL"
+	constexpr uint16_t LOG_VERSION = 1;
+	constexpr size_t LOG_PAYLOAD_BYTES = 32;
+
+	struct LogFileHeader {			// 24 byte
+		uint32_t magic;				// LOG_MAGIC
+		uint16_t version;			// LOG_VERSION
+		uint16_t record_size;		// sizeof(LogRecord)
+		uint32_t token_count;		// registry entries that follow the header
+		uint32_t registry_bytes;	// size of the registry, the first record is at sizeof(LogFileHeader) + registry_bytes
+		int64_t start_ns;			// wall clock when the log was opened
+	};
+
+	struct LogRecord {				// 48 byte, packed LogElement
+		uint64_t time_stamp;
+		int32_t string_token;
+		int16_t core_id;
+		uint8_t component;			// ComponentId
+		uint8_t reserved;
+		unsigned char payload[LOG_PAYLOAD_BYTES];
+	};
+
+	static_assert(sizeof(LogFileHeader) == 24, "log header layout");
+	static_assert(sizeof(LogRecord) == 48, "log record layout");
+
+	// token -> format string. tokens are small non negative ints (direct index), registered once at startup
+	class LogRegistry {
+		private :
+			std::vector<std::string> formats; // "" = not registered
+
+		public :
+			// false if the token is negative or already taken
+			bool add(int32_t token, const char* format) {
+				if(token < 0) return false;
+				if(static_cast<size_t>(token) >= formats.size()) formats.resize(static_cast<size_t>(token) + 1);
+				if(!formats[token].empty()) return false;
+				formats[token] = format;
+				return true;
+			}
+
+			// nullptr if the token is not registered
+			const char* format(int32_t token) const noexcept {
+				if(token < 0 || static_cast<size_t>(token) >= formats.size() || formats[token].empty()) return nullptr;
+				return formats[token].c_str();
+			}
+
+			uint32_t count() const noexcept {
+				uint32_t n = 0;
+				for(const std::string& f : formats) n += !f.empty();
+				return n;
+			}
+
+			// on disk : per token int32 token, uint32 length, the format without its terminating 0
+			std::vector<char> serialize() const {
+				std::vector<char> out;
+				for(size_t t = 0; t < formats.size(); t++) {
+					if(formats[t].empty()) continue;
+					int32_t token = static_cast<int32_t>(t);
+					uint32_t length = static_cast<uint32_t>(formats[t].size());
+					out.insert(out.end(), reinterpret_cast<const char*>(&token), reinterpret_cast<const char*>(&token) + sizeof(token));
+					out.insert(out.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+					out.insert(out.end(), formats[t].begin(), formats[t].end());
+				}
+				return out;
+			}
+
+			// false on a truncated / malformed registry
+			bool deserialize(const char* data, size_t bytes, uint32_t token_count) {
+				formats.clear();
+				size_t at = 0;
+				for(uint32_t k = 0; k < token_count; k++) {
+					int32_t token;
+					uint32_t length;
+					if(bytes - at < sizeof(token) + sizeof(length)) return false;
+					std::memcpy(&token, data + at, sizeof(token));
+					std::memcpy(&length, data + at + sizeof(token), sizeof(length));
+					at += sizeof(token) + sizeof(length);
+					if(bytes - at < length || length == 0) return false;
+					if(!add(token, std::string(data + at, length).c_str())) return false;
+					at += length;
+				}
+				return at == bytes;
+			}
+	};
+
+	// the payload as text following the token's format, returns the length written (out holds cap bytes, always terminated).
+	// an unregistered token prints its number and the payload as 4 hex words
+	inline size_t formatPayload(const LogRegistry& registry, const LogRecord& r, char* out, size_t cap) noexcept {
+		if(cap == 0) return 0;
+		size_t n = 0;
+		auto put = [&](int written) {
+			if(written > 0) n += (static_cast<size_t>(written) < cap - n) ? static_cast<size_t>(written) : cap - n - 1;
+		};
+
+		const char* f = registry.format(r.string_token);
+		if(f == nullptr) {
+			uint64_t words[4];
+			std::memcpy(words, r.payload, sizeof(words));
+			put(std::snprintf(out, cap, "token %d : %016llx %016llx %016llx %016llx", r.string_token, static_cast<unsigned long long>(words[0]),
+							  static_cast<unsigned long long>(words[1]), static_cast<unsigned long long>(words[2]), static_cast<unsigned long long>(words[3])));
+			return n;
+		}
+
+		size_t field = 0; // byte offset of the next field in the payload
+		auto take = [&](auto& value) -> bool {
+			size_t size = sizeof(value);
+			field = (field + size - 1) / size * size;
+			if(field + size > LOG_PAYLOAD_BYTES) return false;
+			std::memcpy(&value, r.payload + field, size);
+			field += size;
+			return true;
+		};
+
+		out[0] = '\0';
+		while(*f != '\0' && n + 1 < cap) {
+			if(*f == '{') {
+				const char* close = std::strchr(f, '}');
+				if(close != nullptr) {
+					std::string spec(f + 1, close);
+					bool ok = true;
+					if(spec == "i16") { int16_t v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%d", v)); }
+					else if(spec == "i32") { int32_t v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%d", v)); }
+					else if(spec == "i64") { int64_t v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%lld", static_cast<long long>(v))); }
+					else if(spec == "u64") { uint64_t v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%llu", static_cast<unsigned long long>(v))); }
+					else if(spec == "f32") { float v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%.2f", v)); }
+					else if(spec == "f64") { double v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%.4f", v)); }
+					else if(spec == "x32") { uint32_t v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%x", v)); }
+					else if(spec == "c") { char v; ok = take(v); if(ok) put(std::snprintf(out + n, cap - n, "%c", v)); }
+					else ok = false;
+
+					if(ok) {
+						f = close + 1;
+						continue;
+					}
+				}
+			}
+			out[n++] = *f++;
+			out[n] = '\0';
+		}
+		return n;
+	}
+
+	// sequential reader for the decoder (and anyone checking a log), records in file order
+	class LogReader {
+		private :
+			FILE* file = nullptr;
+			LogFileHeader header{};
+			LogRegistry registry;
+
+		public :
+			LogReader() = default;
+			LogReader(const LogReader&) = delete;
+			LogReader& operator=(const LogReader&) = delete;
+			~LogReader() { if(file != nullptr) std::fclose(file); }
+
+			// false if the file can not be opened or is not a v1 log
+			bool open(const char* path) {
+				file = std::fopen(path, "rb");
+				if(file == nullptr) return false;
+				if(std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != LOG_MAGIC || header.version != LOG_VERSION ||
+				   header.record_size != sizeof(LogRecord)) return false;
+
+				std::vector<char> tokens(header.registry_bytes);
+				if(header.registry_bytes > 0 && std::fread(tokens.data(), 1, tokens.size(), file) != tokens.size()) return false;
+				return registry.deserialize(tokens.data(), tokens.size(), header.token_count);
+			}
+
+			// false at the end of the file (a trailing partial record included)
+			bool next(LogRecord& r) noexcept { return std::fread(&r, sizeof(r), 1, file) == 1; }
+
+			const LogFileHeader& getHeader() const noexcept { return header; }
+			const LogRegistry& getRegistry() const noexcept { return registry; }
+	};
+}
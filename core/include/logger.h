@@ -1,12 +1,20 @@
 #pragma once 
 
-#include<fstream>
 #include<thread>
 #include<atomic>
+#include<vector>
+#include<cstring>
+#include<cstddef>
+#include<cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <x86intrin.h>
 
 #include "lf_queue.h"
 #include "time_util.h"
 #include "imp_macros.h"
+#include "log_format.h"
 
 
 namespace internal_lib {
@@ -27,14 +35,24 @@ namespace internal_lib {
 	};
 
 
-	struct limited_order_book_log_object { // this will be the data object lob logs
-		// WE WILL DEFINE THIS WHEN WE WRITE THE LOB COMPONENT  
-		int y;
+	struct limited_order_book_log_object { // one engine event, logged where the engine acks it (16 byte)
+		int32_t system_id;
+		int32_t quantity;	// resting quantity for accept / cancel, traded quantity for a fill
+		float price;		// order price, trade price for a fill
+		int16_t trader_id;
+		char side;			// 'B' / 'S'
+		char status;		// the ack status : 'C' 'U' 'D' 'T' 'K'
 	};
 
-	struct network_order_gateway_log_object { // will be the log data whihc network gateway object logs 
-		// WE WILL DEFINE THIS WHEN WE WRITE THE ORDER GATEWAY COMPONENT 
-		int z;
+	struct network_order_gateway_log_object { // one gateway event : a client order forwarded under its system id, or a reject (32 byte)
+		int64_t order_id;	// client order id
+		int32_t system_id;	// -1 if none was assigned
+		float price;
+		int32_t quantity;
+		int16_t trader_id;
+		char side;
+		char req_type;		// 'c' 'u' 'd'
+		uint32_t reasons;	// risk reject reasons (RiskReason bits), 0 otherwise
 	};
 
 	// we make our LogElement 64 bytes long in order to make it fit exactly in one cache line- so that when data pull.push happens complete data gets picked up
@@ -46,7 +64,7 @@ namespace internal_lib {
 		int32_t string_token; // 4 bytes for string token; 
 
 		// the log data container
-		union {
+		union { // at most LOG_PAYLOAD_BYTES, a record keeps that much of it
 			market_data_publisher_log_object mkt;
 			limited_order_book_log_object lob;
 			network_order_gateway_log_object ogw;
@@ -55,6 +73,99 @@ namespace internal_lib {
 	};
 
 
+	static_assert(sizeof(LogElement::data_object) <= LOG_PAYLOAD_BYTES, "the payload must fit a LogRecord");
+	static_assert(offsetof(LogElement, data_object) + LOG_PAYLOAD_BYTES <= sizeof(LogElement), "a record copies LOG_PAYLOAD_BYTES from the payload");
+
+	// log levels are picked at compile time : -DCAPITOL_LOG_LEVEL=<n>, a call below it is not compiled at all (no branch, no
+	// stores, no time stamp). 0 debug , 1 info (default) , 2 warn , 3 error , 4 off
+	enum class LogLevel : int { DEBUG = 0, INFO = 1, WARN = 2, ERROR = 3, OFF = 4 };
+
+#ifndef CAPITOL_LOG_LEVEL
+#define CAPITOL_LOG_LEVEL 1
+#endif
+
+	constexpr LogLevel COMPILED_LOG_LEVEL = static_cast<LogLevel>(CAPITOL_LOG_LEVEL);
+
+	template<LogLevel L>
+	constexpr bool logEnabled() noexcept { return L != LogLevel::OFF && static_cast<int>(L) >= static_cast<int>(COMPILED_LOG_LEVEL); }
+
+	// tokens of the engine and gateway records, registerCoreLogTokens() gives the logger their formats. the formats read the
+	// payload structs above field by field
+	enum CoreLogToken : int32_t {
+		LOG_ENGINE_ACCEPT = 16,		// order rests in the book ('C' create, 'U' update)
+		LOG_ENGINE_FILL = 17,		// one side of a trade
+		LOG_ENGINE_CANCEL = 18,		// order left the book
+		LOG_ENGINE_REJECT = 19,		// killed ('K' wash trade / create priced off the book) or replace refused ('R')
+		LOG_GATEWAY_ORDER = 32,		// client order forwarded to the engine
+		LOG_GATEWAY_REJECT = 33,	// client order rejected before the engine
+		LOG_GATEWAY_RISK = 34		// pre trade risk reject and its reasons
+	};
+
+	inline void registerCoreLogTokens(LogRegistry& registry) {
+		registry.add(LOG_ENGINE_ACCEPT, "accept sys {i32} qty {i32} px {f32} trader {i16} side {c} ({c})");
+		registry.add(LOG_ENGINE_FILL, "fill sys {i32} qty {i32} px {f32} trader {i16} side {c}");
+		registry.add(LOG_ENGINE_CANCEL, "cancel sys {i32} qty {i32} px {f32} trader {i16} side {c}");
+		registry.add(LOG_ENGINE_REJECT, "reject sys {i32} qty {i32} px {f32} trader {i16} side {c} ({c})");
+		registry.add(LOG_GATEWAY_ORDER, "order {i64} -> sys {i32} px {f32} qty {i32} trader {i16} side {c} req {c}");
+		registry.add(LOG_GATEWAY_REJECT, "reject order {i64} sys {i32} px {f32} qty {i32} trader {i16} side {c} req {c}");
+		registry.add(LOG_GATEWAY_RISK, "risk reject order {i64} sys {i32} px {f32} qty {i32} trader {i16} side {c} req {c} reasons {x32}");
+	}
+
+	// producer side of one logger queue, owned by the component that logs (engine, gateway). the record is written straight
+	// into the queue slot, nothing is copied on the hot path :
+	//
+	//   Log.write<LogLevel::INFO>(LOG_ENGINE_FILL, stamp, [&](LogElement& e) { e.data_object.lob = {...}; });
+	//
+	// a level the build does not log compiles to nothing, the fill lambda included. logging never blocks : with no queue
+	// attached the record is skipped, with the queue full it is dropped and counted.
+	class LogProducer {
+		private :
+			LFQueue<LogElement>* queue = nullptr;
+			ComponentId component;
+			int32_t core_id = -1;
+			uint64_t dropped = 0;
+
+		public :
+			explicit LogProducer(ComponentId c) noexcept : component(c) {}
+
+			// nullptr detaches
+			void attach(LFQueue<LogElement>* q, int32_t core) noexcept {
+				queue = q;
+				core_id = core;
+			}
+
+			bool attached() const noexcept { return queue != nullptr; }
+			uint64_t getDropped() const noexcept { return dropped; }
+
+			// stamp : the cycle count of the event, callers on the order path pass the one they already took for the order
+			// (a tsc read is ~25 ns on some virtualised hosts, paid per record otherwise)
+			template<LogLevel L, typename Fill>
+			inline void write(int32_t token, uint64_t stamp, Fill&& fill) noexcept {
+				if constexpr (logEnabled<L>()) {
+					if(queue == nullptr) return;
+					LogElement* e = queue->getNextWrite();
+					if(e == nullptr) {
+						dropped++;
+						return;
+					}
+					e->time_stamp = stamp;
+					e->component = component;
+					e->core_id = core_id;
+					e->string_token = token;
+					fill(*e);
+					queue->updateWrite();
+				}
+			}
+
+			// stamped now (raw tsc, not serialized) : for the cold paths
+			template<LogLevel L, typename Fill>
+			inline void write(int32_t token, Fill&& fill) noexcept {
+				if constexpr (logEnabled<L>()) {
+					if(queue != nullptr) write<L>(token, __rdtsc(), fill);
+				}
+			}
+	};
+
 	// define a logger class 
 
 	// main optimizations :- 
@@ -62,9 +173,9 @@ namespace internal_lib {
 	// 2. batching -> we dintjus insert each entry from queue to the log file one by one, instead we collect them and when a certain threshold of them is in our hands 
 	// we persist them via a single system call
 
-	// 3. In batching to store these elements we add them to a string but dynamically adding to string uses heap allocation whihc might be slow so we define 
-	// a charecter buffer of say 4KB which lives in stack memory hence it is fast and accumulate teh log entries there
-	// once the batch is processed we flush this stack memmory into the log file
+	// 3. binary : no formatting on the logger thread, every element is copied as a packed 48 byte LogRecord (log_format.h) into one
+	// big staging buffer and the buffer goes to the file with a single write() once it is full. the text is made offline by
+	// log_decode from the token registry the logger writes at the top of the file.
 
 
 
@@ -85,13 +196,24 @@ namespace internal_lib {
 
 		private : 
 
-		internal_lib::LFQueue<LogElement>* mk_pub_queue; // pointer to the market publisher service logger
-		internal_lib::LFQueue<LogElement>* lob_queue; // pointer to limited order book  logger
-		internal_lib::LFQueue<LogElement>* network_gw_queue; // pointer to network gate way logger
+		// one SPSC queue per producer thread (publisher, engine, every gateway ..), drained round robin. nullptr entries are skipped
+		std::vector<internal_lib::LFQueue<LogElement>*> queues;
 
 		std::string file_path;
+		const LogRegistry* registry; // token -> format, written into the file header (nullptr = empty registry)
 		std::atomic<bool> running = {true};
 
+		static constexpr size_t STAGING_BYTES = 1 << 20; // records per write() = 1 MB / 48
+		static constexpr int BATCH = 1024;               // records taken from one queue before moving to the next
+
+		std::vector<char> staging;
+		size_t staged = 0;
+		int fd = -1;
+
+		uint64_t records_written = 0;
+		uint64_t bytes_written = 0;
+		bool write_failed = false;
+
 
 		public : 
 
@@ -99,7 +221,13 @@ namespace internal_lib {
 		Async_Logger(std::string& path,
 					internal_lib::LFQueue<LogElement>* mkpbq,
 					internal_lib::LFQueue<LogElement>* lbq,
-					internal_lib::LFQueue<LogElement>* ntgwq) : mk_pub_queue(mkpbq), lob_queue(lbq), network_gw_queue(ntgwq), file_path(path) {
+					internal_lib::LFQueue<LogElement>* ntgwq,
+					const LogRegistry* tokens = nullptr) : Async_Logger(path, {mkpbq, lbq, ntgwq}, tokens) {}
+
+		// any number of producers, e.g. the engine + N gateways. a queue must never be shared by two writer threads
+		Async_Logger(std::string& path,
+					std::vector<internal_lib::LFQueue<LogElement>*> producer_queues,
+					const LogRegistry* tokens = nullptr) : queues(std::move(producer_queues)), file_path(path), registry(tokens) {
 			// empty body here 	
 		}
 
@@ -107,119 +235,108 @@ namespace internal_lib {
 			running = false;
 		}
 
-		void run() noexcept {
-			std::ofstream file(file_path, std::ios::out | std::ios::trunc); // if the file exists it clears the content inside it if it doesnt exists it will create a new one 
-		 	
-		 	ASSERT(file.is_open(), " FILE not accessible ");
-
-		 	std::vector<char> buff(128*1024); // defined a custom buffer of size 128 kb;
+		// after run() / close() returned
+		uint64_t getRecordsWritten() const noexcept { return records_written; }
+		uint64_t getBytesWritten() const noexcept { return bytes_written; }
+		bool writeFailed() const noexcept { return write_failed; }
 
-		 	file.rdbuf()->pubsetbuf(buff.data(),buff.size());
-		 	// MACRO OPTIMIZATION 
+		void run() noexcept {
+			ASSERT(open(), " FILE not accessible ");
 
-		 	// we do a tweaking here 
-		 	// normally when we do ofstream << or file << it does nto write to disk at that moment it stores that data into it's buffer
-		 	// now it's buffer is by default of size 4kb or 8kb which gets fulled very quickly
+		 	while(running.load(std::memory_order_acquire)) {
+		 		if(poll() == false) std::this_thread::yield();
+		 	}
 
-		 	// so means more sys calls to flush this to  disk due to shorter size
-		 	// so we make the size of it to large to that it can flush large chunks of data in one system call
+		 	close();
+		}
 
-		 	while(running) {
+		// run() in steps, for a single threaded pipeline that drives the logger itself (benches, backtests) :
+		// open() once, poll() between events, close() at the end. false if the file can not be created
+		bool open() noexcept {
+			fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); // if the file exists it clears the content inside it if it doesnt exists it will create a new one 
+			if(fd == -1) return false;
 
-		 		bool busy  = false; // define a buys variable 
+		 	staging.resize(STAGING_BYTES);
+		 	writeHeader();
+		 	return true;
+		}
 
-		 		busy |= drainBatch(mk_pub_queue, file, 50 );
-		 		busy |= drainBatch(lob_queue, file, 50 );
-		 		busy |= drainBatch(network_gw_queue, file, 50 );
+		// one round over the queues, true if anything was read
+		bool poll() noexcept {
+			bool busy  = false; // define a buys variable 
 
-		 		if(busy == false) std::this_thread::yield();
-		 	}
+			for(LFQueue<LogElement>* q : queues) busy |= drainBatch(q, BATCH);
+			return busy;
+		}
 
-		 	// in the while loop when say the 128kb buffer will fill in one write what will happen is system call will be made you process wil be stopepd 
-		 	// the buffer will flush this data to the disk 
-		 	// process continues and the new writes data will be filled in this buffer again. this we need not to handle it is automatically taken care of 
+		// the producers are done : whatever they wrote before still goes to the file
+		void close() noexcept {
+			if(fd == -1) return;
+		 	while(poll()) {}
 
+		 	flush();
+		 	::close(fd);
+		 	fd = -1;
+		}
 
-		 	file.flush(); // when we are done running and the server is closing now we would like to collect any remaining data in the buffer and store it into the disk so we flush it one last time
+		// copies up to limit elements of q as packed records into the staging buffer (one release of the queue for all of them),
+		// the buffer is written out when the next batch would not fit. returns true if anything was read
+		bool drainBatch(LFQueue<LogElement>* q, int limit) noexcept {
+			if(q == nullptr) return false;
+
+			if(staged + static_cast<size_t>(limit) * sizeof(LogRecord) > staging.size()) flush();
+
+			LogRecord* out = reinterpret_cast<LogRecord*>(staging.data() + staged);
+			int count = 0;
+			LogElement* elem;
+			while(count < limit && (elem = q->getReadAhead(count)) != nullptr) {
+				LogRecord& r = out[count];
+				r.time_stamp = elem->time_stamp;
+				r.string_token = elem->string_token;
+				r.core_id = static_cast<int16_t>(elem->core_id);
+				r.component = static_cast<uint8_t>(elem->component);
+				r.reserved = 0;
+				std::memcpy(r.payload, &elem->data_object, LOG_PAYLOAD_BYTES);
+				count++;
+			}
+
+			if(count == 0) return false;
+			q->updateRead(count);
+			staged += static_cast<size_t>(count) * sizeof(LogRecord);
+			records_written += count;
+			return true;
 		}
 
-		// on a given offset write the number digit by digit on write pointer's memory nd keeps incrementing the ppointer
-		char* fast_u64_to_str(uint64_t value, char* buffer) {
+		private :
 
-    		char temp[24];
-    		char* p = temp + 23;
-    		*p = '\0';
+		void writeHeader() noexcept {
+			std::vector<char> tokens;
+			if(registry != nullptr) tokens = registry->serialize();
+
+			LogFileHeader header{LOG_MAGIC, LOG_VERSION, static_cast<uint16_t>(sizeof(LogRecord)),
+								 (registry != nullptr) ? registry->count() : 0, static_cast<uint32_t>(tokens.size()), getCurrentNanos()};
+			writeAll(reinterpret_cast<const char*>(&header), sizeof(header));
+			if(!tokens.empty()) writeAll(tokens.data(), tokens.size());
+		}
 
-    		do {
-        		*--p = (value % 10) + '0';
-        		value /= 10;
-    		} while (value > 0);
-    
-    		while (*p) *buffer++ = *p++;
-    		return buffer;
+		void flush() noexcept {
+			if(staged == 0) return;
+			writeAll(staging.data(), staged);
+			staged = 0;
 		}
 
-		bool drainBatch(LFQueue<LogElement>* q, std::ofstream& file, int limit) {
-
-			// define a 4kb stack buffer
-    		char buffer[4096]; 
-    		char* offset = buffer; // current write position
-    		char* end = buffer + sizeof(buffer) - 128; // safe margin
-
-    		int count = 0;
-    		
-    		// untill the batch processing completes or buffer is full 
-    		while (count < limit && offset < end) {
-        		LogElement* elem = q->getNextRead(); // read next element
-        		if (!elem) break; // nul waiting so quit
-
-        		offset = fast_u64_to_str(elem->time_stamp, offset); // write the number into the buffer by pointer movement and allocating
-        		*offset++ = ' '; // add a space to the where the write position was pointing to and then incrment the write pointer 
-        		offset = fast_u64_to_str(elem->string_token, offset); // add message id 
-        		*offset++ = ' '; // add another space and move on.
-
-        		// handling the data object  here 
-        		switch (elem->component) {
-        			// handling market published data log object
-            		case ComponentId::MKT_DATA:
-                		 offset = fast_u64_to_str(elem->data_object.mkt.x, offset); // add the data object -> markety_data_publisher_log_object.x to it 
-                 		*offset++ = ' ';
-                 		break;
-                 	// handling generic log object
-            		case ComponentId::SYSTEM_CORE:
-                	 	offset = fast_u64_to_str(elem->data_object.generic_data, offset);
-                	 	*offset++ = ' ';
-                 		break;
-                 	// handling LOB matchign log object
-                 	case ComponentId::LOB_ENGINE:
-                 		offset = fast_u64_to_str(elem->data_object.lob.y,offset);
-                 		*offset++ = ' ';
-                 		break;
-                 	// handling order gateway log object
-                 	case ComponentId::ORDER_GATEWAY:
-                 		offset = fast_u64_to_str(elem->data_object.ogw.z,offset);
-                 		*offset++ = ' ';
-                 		break;
-        		}
-        
-       		 	*offset++ = '\n'; // add a new line charecter and increment the write position and 
-
-	       	 	q->updateRead(); // update read index in the queue 
-    	   	 	count++; // one log read
-    		}
-
-    		// at last there coulkd be 2 scenarios either the offset reached end, or before the buffer was full the batch was done or the queue became empty
-    		// in any case we have fetched some logs and written them untill the offset pointer in our charectr buffer 
-    		// flush that into file's 128KB buffer
-
-	    	if (offset > buffer) { 
-    	    	file.write(buffer, offset - buffer);
-    		}
-
-	    	return count > 0; // if read happened then return true;
+		void writeAll(const char* data, size_t bytes) noexcept {
+			while(bytes > 0) {
+				ssize_t n = ::write(fd, data, bytes);
+				if(n < 0 && errno == EINTR) continue;
+				if(n <= 0) {
+					write_failed = true; // disk full / io error : the rest of this batch is lost, logging must not stop the server
+					return;
+				}
+				data += n;
+				bytes -= static_cast<size_t>(n);
+				bytes_written += static_cast<uint64_t>(n);
+			}
 		}
 	};
 }
-
-
-
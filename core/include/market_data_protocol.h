@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// Capitol market data feed (v1), ITCH like, UDP multicast or shared memory ring
+//
+// one packet (datagram / ring slot) = one MDPacketHeader + count packed messages. every message has a feed wide sequence number,
+// it is not carried in the message : message i of a packet has first_seq + i, the next packet starts at first_seq + count.
+// a receiver that sees first_seq above what it expected lost (first_seq - expected) messages, below it is a duplicate.
+// an idle publisher sends heartbeats (count 0, first_seq = next sequence) so a gap at the end of a burst shows up too.
+// session changes when the publisher restarts, sequences start at 1 again.
+//
+//   'A' add order    : order_ref rests on the book (price, full size)
+//   'U' modify order : order_ref has a new price / remaining size
+//   'D' delete order : order_ref left the book
+//   'T' trade        : quantity traded at price, order_ref is the resting order that was hit
+
+namespace internal_lib {
+
+	constexpr uint8_t MD_PROTOCOL_VERSION = 1;
+	constexpr size_t MD_MAX_DATAGRAM = 1472; // ethernet MTU - IP/UDP headers, never fragment
+
+#pragma pack(push, 1)
+
+	struct MDPacketHeader {			// 16 byte
+		uint16_t length;			// total packet length
+		uint8_t version;			// MD_PROTOCOL_VERSION
+		uint8_t count;				// messages following the header, 0 = heartbeat
+		uint32_t session;
+		uint64_t first_seq;			// sequence number of the first message
+	};
+
+	struct MDOrderMessage {			// 16 byte, 'A' / 'U' / 'T'
+		char type;
+		char side;					// 'B' or 'S'
+		char pad[2];
+		int32_t order_ref;			// system id of the order while it is live
+		float price;
+		int32_t quantity;
+	};
+
+	struct MDDeleteMessage {		// 8 byte, 'D'
+		char type;
+		char side;
+		char pad[2];
+		int32_t order_ref;
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(MDPacketHeader) == 16, "md packet header layout");
+	static_assert(sizeof(MDOrderMessage) == 16, "md order message layout");
+	static_assert(sizeof(MDDeleteMessage) == 8, "md delete message layout");
+
+	constexpr size_t MD_MAX_PER_PACKET = (MD_MAX_DATAGRAM - sizeof(MDPacketHeader)) / sizeof(MDDeleteMessage); // 182
+
+	// 0 = unknown type (the rest of the packet can not be walked)
+	inline size_t mdMessageLength(char type) noexcept {
+		switch(type) {
+			case 'A' : case 'U' : case 'T' : return sizeof(MDOrderMessage);
+			case 'D' : return sizeof(MDDeleteMessage);
+			default  : return 0;
+		}
+	}
+
+	// ======================== shared memory transport ========================
+	//
+	// single writer ring of packets in a POSIX shm object, any number of readers that never write to it (a slow reader can not
+	// hold the publisher back, it gets lapped and sees a sequence gap). every slot is guarded by its own sequence lock :
+	// packet n goes to slot n & (slot_count - 1), stamp is 2n+1 while it is written and 2n+2 once it is complete.
+
+	constexpr uint32_t MD_SHM_MAGIC = 0x43504d44; // "DMPC"
+
+	struct alignas(64) MDShmRingHeader {
+		uint32_t magic;
+		uint32_t slot_count;					// power of 2
+		alignas(64) std::atomic<uint64_t> write_index;	// packets published so far
+	};
+
+	struct alignas(64) MDShmSlot {
+		std::atomic<uint64_t> stamp;
+		uint16_t length;
+		char data[MD_MAX_DATAGRAM];
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm ring needs lock free 64 bit atomics");
+
+	inline size_t mdShmRingBytes(uint32_t slot_count) noexcept {
+		return sizeof(MDShmRingHeader) + static_cast<size_t>(slot_count) * sizeof(MDShmSlot);
+	}
+}
@@ -76,6 +76,16 @@ public:
         return ptr;
     }
 
+    // every object back at once (cold path, the owner drops all its pointers) : the memory stays allocated and touched,
+    // the next allocate() starts again from the first block
+    void reset() noexcept {
+        free_indices.clear();
+        high_water_mark = 0;
+    }
+
+    // objects handed out and not given back
+    size_t used() const noexcept { return high_water_mark - free_indices.size(); }
+
     // hot path deallocator
     void deallocate(T* ptr) noexcept {
         // assume ptr is valid cuz single threaded
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+// Capitol binary order entry protocol (v1)
+//
+// every message is a fixed layout, packed, little endian struct that starts with the same 8 byte header.
+// no text, no variable length fields, no optional fields ---> decoding is a couple of compares and loads straight out of the
+// receive buffer and encoding is a couple of stores straight into the send buffer.
+//
+//   inbound  (client -> gateway) : 'N' new order, 'C' cancel, 'R' replace, 'M' mass cancel
+//   outbound (gateway -> client) : 'E' execution report (one per LOBAcknowledgement status : N/C/U/D/T/K/R)
+//
+// seq_num : every direction of a session has its own sequence starting at 1, +1 per application message.
+// the gateway only accepts next_in_seq exactly, lower is a duplicate (dropped), higher is a gap (the session layer recovers it).
+//
+// session level messages (seq_num 0, never sequenced, handled by the session layer and never seen by the gateway) :
+//   client -> server : 'L' logon, 'H' heartbeat, 'O' logout
+//   server -> client : 'A' logon accepted, 'H' heartbeat, 'O' logout (with reason)
+// the one exception : when a logged on trader goes away the session layer hands the gateway an 'O' frame, so its acks stop
+// being encoded for the session lane.
+// sequences live as long as the trader, not the connection : on a re-logon both sides tell each other the next seq they
+// expect and each resends what the other missed.
+
+namespace internal_lib {
+
+	constexpr uint8_t OE_PROTOCOL_VERSION = 1;
+
+#pragma pack(push, 1)
+
+	struct OEHeader {				// 8 byte
+		uint16_t length;			// total message length including this header
+		char msg_type;				// 'N', 'C', 'R', 'M', 'E' ...
+		uint8_t version;			// OE_PROTOCOL_VERSION
+		uint32_t seq_num;
+	};
+
+	struct OENewOrder {				// 24 byte
+		OEHeader header;
+		int32_t client_order_id;	// unique per trader
+		float price;
+		int32_t quantity;
+		char side;					// 'b' or 's'
+		char pad[3];
+	};
+
+	struct OECancelOrder {			// 16 byte
+		OEHeader header;
+		int32_t client_order_id;
+		char side;					// side of the resting order (books are per side)
+		char pad[3];
+	};
+
+	struct OEReplaceOrder {			// 24 byte --> new price and/or new quantity for a resting order
+		OEHeader header;
+		int32_t client_order_id;
+		float price;
+		int32_t quantity;
+		char side;
+		char pad[3];
+	};
+
+	struct OEMassCancel {			// 16 byte --> cancel every resting order of the session's trader
+		OEHeader header;
+		char side;					// 'b', 's' or '*' for both sides
+		char pad[7];
+	};
+
+	struct OEExecutionReport {		// 32 byte
+		OEHeader header;
+		int64_t client_order_id;
+		float price;
+		int32_t quantity;
+		char side;					// 'B' or 'S'
+		char status;				// same codes as UserAcknowledgement
+		char pad[6];
+	};
+
+	struct OELogon {				// 16 byte
+		OEHeader header;
+		int16_t trader_id;
+		uint16_t heartbeat_ms;		// 0 = server default
+		uint32_t next_expected_seq;	// next execution report seq the client wants ---> server replays from here
+	};
+
+	struct OELogonAccept {			// 16 byte
+		OEHeader header;
+		uint32_t next_expected_seq;	// next inbound seq the server wants ---> client resends from here
+		char pad[4];
+	};
+
+	struct OEHeartbeat {			// 8 byte
+		OEHeader header;
+	};
+
+	struct OELogout {				// 16 byte
+		OEHeader header;
+		char reason;				// 'U' user, 'T' heartbeat timeout, 'B' trader already logged on, 'I' invalid trader,
+									// 'S' sequence not recoverable, 'P' protocol error, 'W' slow consumer
+		char pad[7];
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(OEHeader) == 8, "OE header layout");
+	static_assert(sizeof(OENewOrder) == 24, "OE new order layout");
+	static_assert(sizeof(OECancelOrder) == 16, "OE cancel layout");
+	static_assert(sizeof(OEReplaceOrder) == 24, "OE replace layout");
+	static_assert(sizeof(OEMassCancel) == 16, "OE mass cancel layout");
+	static_assert(sizeof(OEExecutionReport) == 32, "OE execution report layout");
+
+	static_assert(sizeof(OELogon) == 16, "OE logon layout");
+	static_assert(sizeof(OELogonAccept) == 16, "OE logon accept layout");
+	static_assert(sizeof(OELogout) == 16, "OE logout layout");
+
+	constexpr size_t OE_MAX_MESSAGE_SIZE = 32;
+	constexpr int OE_MAX_TRADERS = 128; // trader ids 0 .. 127 (sessions are indexed by trader id)
+
+	// expected length of an inbound message type, 0 = not an inbound application message
+	inline uint16_t oeInboundLength(char msg_type) noexcept {
+		switch(msg_type) {
+			case 'N': return sizeof(OENewOrder);
+			case 'C': return sizeof(OECancelOrder);
+			case 'R': return sizeof(OEReplaceOrder);
+			case 'M': return sizeof(OEMassCancel);
+			default : return 0;
+		}
+	}
+
+	// expected length of a session level message type, 0 = not a session message
+	inline uint16_t oeSessionLength(char msg_type) noexcept {
+		switch(msg_type) {
+			case 'L': return sizeof(OELogon);
+			case 'A': return sizeof(OELogonAccept);
+			case 'H': return sizeof(OEHeartbeat);
+			case 'O': return sizeof(OELogout);
+			default : return 0;
+		}
+	}
+
+	// one application message in flight between the session (network) thread and the gateway, both directions.
+	// the session layer only forwards complete, in sequence messages ---> the gateway never sees a gap or a duplicate.
+	struct OEFrame {					// 48 byte
+		uint64_t rx_cycle_count;		// inbound : cycle count right after the recv() that completed the message
+		int16_t trader_id;
+		uint16_t length;
+		char pad[4];
+		char msg[OE_MAX_MESSAGE_SIZE];
+	};
+
+	// per session protocol state, owned by whoever owns the connection
+	struct OrderEntrySession {
+		short trader_id;			// fixed at logon, every order of the session is booked under it
+		uint32_t next_in_seq = 1;	// next inbound seq_num we accept
+		uint32_t next_out_seq = 1;	// seq_num stamped on the next outbound message
+	};
+
+	enum class DecodeStatus : uint8_t {
+		OK = 0,				// message mapped into the LOB queue
+		INCOMPLETE,			// not enough bytes for a full message yet, wait for more
+		BAD_LENGTH,			// header length does not match the message type
+		BAD_TYPE,			// unknown message type / protocol version
+		BAD_FIELD,			// side/price/quantity out of range
+		SEQ_GAP,			// seq_num ahead of what we expect, nothing consumed
+		DUPLICATE,			// seq_num already seen, consumed and dropped
+		UNKNOWN_ORDER,		// cancel/replace for an order id we do not know (or system id range exhausted for a new order)
+		BACKPRESSURE,		// LOB queue full, nothing consumed, retry
+		RISK_REJECT,		// failed a pre trade risk check (pre_trade_risk.h), consumed
+		DUPLICATE_ORDER_ID	// new order reusing the client order id of an order that is still live, consumed
+	};
+
+	struct DecodeResult {
+		DecodeStatus status;
+		uint16_t consumed;	// bytes of the receive buffer this call used up
+	};
+
+	// ======================== codec (no id translation, no gateway state) ========================
+
+	// framing + sequencing of the message at the front of buf : OK (consumed = message length) when a whole, in sequence
+	// application message is there. INCOMPLETE / BAD_TYPE / BAD_LENGTH / SEQ_GAP consume nothing, DUPLICATE consumes the message.
+	inline DecodeResult oeFrame(const char* buf, size_t len, uint32_t next_in_seq) noexcept {
+		if(UNLIKELY(len < sizeof(OEHeader))) return {DecodeStatus::INCOMPLETE, 0};
+
+		const OEHeader* header = reinterpret_cast<const OEHeader*>(buf);
+		uint16_t expected = oeInboundLength(header->msg_type);
+
+		if(UNLIKELY(expected == 0 || header->version != OE_PROTOCOL_VERSION)) return {DecodeStatus::BAD_TYPE, 0};
+		if(UNLIKELY(header->length != expected)) return {DecodeStatus::BAD_LENGTH, 0};
+		if(UNLIKELY(len < expected)) return {DecodeStatus::INCOMPLETE, 0};
+
+		if(UNLIKELY(header->seq_num != next_in_seq)) {
+			if(header->seq_num < next_in_seq) return {DecodeStatus::DUPLICATE, expected};
+			return {DecodeStatus::SEQ_GAP, 0};
+		}
+		return {DecodeStatus::OK, expected};
+	}
+
+	inline bool oeValidSide(char side) noexcept {
+		return (side == 'b') | (side == 's');
+	}
+
+	// client order id of an inbound order entry message, -1 for a mass cancel
+	inline long long oeClientOrderId(const char* msg) noexcept {
+		switch(reinterpret_cast<const OEHeader*>(msg)->msg_type) {
+			case 'N' : return reinterpret_cast<const OENewOrder*>(msg)->client_order_id;
+			case 'C' : return reinterpret_cast<const OECancelOrder*>(msg)->client_order_id;
+			case 'R' : return reinterpret_cast<const OEReplaceOrder*>(msg)->client_order_id;
+			default  : return -1;
+		}
+	}
+
+	// positive and finite (nan fails the compare). the tick range is the book's, the engine refuses prices past it
+	inline bool oeValidPrice(float price) noexcept { return price > 0.0f && std::isfinite(price); }
+
+	// side / price / quantity of a framed message (oeFrame() said OK) ---> false = BAD_FIELD
+	inline bool oeValidFields(const char* msg) noexcept {
+		switch(reinterpret_cast<const OEHeader*>(msg)->msg_type) {
+			case 'N' : {
+				const OENewOrder* m = reinterpret_cast<const OENewOrder*>(msg);
+				return oeValidSide(m->side) && m->quantity > 0 && oeValidPrice(m->price);
+			}
+			case 'C' : return oeValidSide(reinterpret_cast<const OECancelOrder*>(msg)->side);
+			case 'R' : {
+				const OEReplaceOrder* m = reinterpret_cast<const OEReplaceOrder*>(msg);
+				return oeValidSide(m->side) && m->quantity > 0 && oeValidPrice(m->price);
+			}
+			default  : {
+				char side = reinterpret_cast<const OEMassCancel*>(msg)->side;
+				return oeValidSide(side) || side == '*';
+			}
+		}
+	}
+
+	// execution report straight into out (needs OE_MAX_MESSAGE_SIZE bytes of room), returns bytes written
+	inline size_t oeEncodeExecutionReport(char* out, uint32_t seq_num, int64_t client_order_id, float price, int32_t quantity,
+										  char side, char status) noexcept {
+		OEExecutionReport* report = reinterpret_cast<OEExecutionReport*>(out);
+		report->header.length = sizeof(OEExecutionReport);
+		report->header.msg_type = 'E';
+		report->header.version = OE_PROTOCOL_VERSION;
+		report->header.seq_num = seq_num;
+		report->client_order_id = client_order_id;
+		report->price = price;
+		report->quantity = quantity;
+		report->side = side;
+		report->status = status;
+		return sizeof(OEExecutionReport);
+	}
+}
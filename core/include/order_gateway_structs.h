@@ -39,7 +39,7 @@ namespace internal_lib {
 		int order_id; // unique order id ==> how >> this will be single for each trader id and trader id it self is unique so we can say , (trader_id_x, ordeR_id_y) will be unique   4 byte
 		short trader_id; // id of trader ~ 2 Byte ( 100 user total ==> 1 sniper and 99 will be market makers, ids will be 0 based indexed)
 		char order_type; // 'b' or 's' 1 byte
-		char req_type; // 'c'-create, 'u'-update, 'd'-delete // 1 byte
+		char req_type; // 'c'-create, 'u'-update, 'd'-delete, 'q'-quote (market makers : update if live, create otherwise) // 1 byte
 
 		// 8 Byte
 		float price; // we expect price ~ 32k only (use case)    4 byte
@@ -56,11 +56,13 @@ namespace internal_lib {
 
 
     struct LOBAcknowledgement {
+        // 16 Byte
         int system_id;    // Key to find the Client Order ID
         
         float price;         // Context: Price of the fill or the order
         int quantity;     // Context: Traded Qty (if Match) or Remaining Qty (if Update/New)
         
+        short trader_id;      // origin of the order ---> the gateway's ack routing table is indexed by it
         char side;            // 'B' or 'S'
         char status;          // The Result Code (See below)
 
@@ -70,23 +72,44 @@ namespace internal_lib {
     	// 'C' = Cancel Accepted     (Qty = 0)
     	// 'T' = Trade / Fill        (Qty = Executed Amount)
     	// 'R' = Rejected            (Qty = 0)
+    	// 'X' = System Id Released  (order is terminal, gateway recycles the id, never forwarded to the user)
     };
 
+    static_assert(sizeof(LOBAcknowledgement) == 16, "LOBAcknowledgement must stay 16 byte (4 per cache line)");
+
+    // order ids are only unique per trader ---> the gateway's translation tree is keyed by (trader_id, order_id) packed in a long long
+    inline long long makeOrderKey(short trader_id, int order_id) noexcept {
+        return (static_cast<long long>(trader_id) << 32) | static_cast<uint32_t>(order_id);
+    }
+
+    inline int orderKeyOrderId(long long order_key) noexcept {
+        return static_cast<int>(static_cast<uint32_t>(order_key));
+    }
+
+    inline short orderKeyTraderId(long long order_key) noexcept {
+        return static_cast<short>(order_key >> 32);
+    }
+
     struct UserAcknowledgement {
         //   8 bytes
         long long order_id;     // client ID (translated from system_id) uing look up table (LUT)
         
         float price;         // Context: Price of the fill or the order
         int quantity;     // Context: Traded Qty (if Match) or Remaining Qty (if Update/New)
+
+        int system_id;    // the id the book (and the market data feed) knows the order by, -1 for gateway rejects
         
         char side;            // 'B' or 'S'
         char status;          // The Result Code (See below)
+        char req_type;        // 'R' only : the refused request, 'c' create / 'u' replace / 'd' cancel (a quote is resolved to 'c' / 'u'). 0 otherwise
 
         // STATUS CODES:
     	// 'N' = New Order Accepted  (Qty = Initial Size)
     	// 'U' = Update Accepted     (Qty = New Balance)
     	// 'C' = Cancel Accepted     (Qty = 0)
     	// 'T' = Trade / Fill        (Qty = Executed Amount)
-    	// 'R' = Rejected         
+    	// 'R' = Rejected            (only a refused create ends the order, a refused replace / cancel leaves it as it was)
     };
+
+    static_assert(sizeof(UserAcknowledgement) == 24, "UserAcknowledgement stays 24 byte (system_id and req_type fill the old padding)");
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "order_entry_protocol.h" // OE_MAX_TRADERS
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// pre trade risk stage of the order gateway.
+	//
+	// every trader has one 64 byte line of limits and one 64 byte line of state, both in flat arrays indexed by trader_id
+	// (128 traders = 16 KB, lives in L1/L2 of the gateway core). a check computes ALL the limit tests as 0/1 values, ORs them
+	// into a reason mask and branches once on the result, so the cost is the same whether an order passes or not.
+	//
+	// exposure is tracked per live order (a RiskOrder : price + signed remaining quantity) so that replaces, fills ('T' acks)
+	// and terminal orders (id release) can take exactly that order's share back out. the RiskOrder is owned by the caller : the
+	// gateway keeps it next to the order key in its per system id LUT entry, the line a create writes and an ack reads anyway,
+	// so the per order exposure costs no cache line of its own.
+	// a replace can not move an order to the other side (the engine looks it up in the book of the side it names) ---> rejected.
+	//
+	// limits are hot reloadable from any ONE control thread : setLimits() writes a staging copy under a sequence lock, the gateway
+	// pulls it into its private copy in refresh() (one acquire load per loop when nothing changed).
+
+	// reject reasons (bit mask, 0 = order passes)
+	constexpr uint32_t RISK_PRICE_BAND    = 1u << 0;
+	constexpr uint32_t RISK_ORDER_QTY     = 1u << 1;
+	constexpr uint32_t RISK_OPEN_NOTIONAL = 1u << 2;
+	constexpr uint32_t RISK_POSITION      = 1u << 3;
+	constexpr uint32_t RISK_MESSAGE_RATE  = 1u << 4;
+	constexpr uint32_t RISK_BAD_TRADER    = 1u << 5;
+	constexpr uint32_t RISK_SIDE_CHANGE   = 1u << 6;   // replace naming the other side than the live order's
+
+	struct RiskLimits {
+		float price_lo = 0.0f;                                              // accepted price band [lo, hi]
+		float price_hi = std::numeric_limits<float>::max();
+		int32_t max_order_qty = std::numeric_limits<int32_t>::max();
+		int32_t max_position = std::numeric_limits<int32_t>::max();         // |position + everything open on that side|
+		int64_t max_open_notional = std::numeric_limits<int64_t>::max();    // sum of price ticks * quantity of open orders
+		uint64_t rate_interval_cycles = 0;                                  // message rate : one order every interval ...
+		uint64_t rate_burst_cycles = std::numeric_limits<uint64_t>::max();  // ... with this much burst tolerance (GCRA)
+	};
+
+	struct RiskOrder {                      // 8 byte, one per live order
+		float price = 0.0f;
+		int32_t quantity = 0;               // remaining, + buy / - sell, 0 = nothing tracked
+	};
+
+	class PreTradeRisk {
+	private :
+
+		struct alignas(64) TraderLimits {
+			RiskLimits limits;
+		};
+
+		struct alignas(64) TraderState {
+			int64_t open_notional = 0;
+			int32_t open_qty[2] = {0, 0};   // [0] buy, [1] sell
+			int32_t position = 0;           // filled buys - filled sells
+			uint64_t rate_tat = 0;          // GCRA theoretical arrival time (cycles)
+		};
+
+		std::vector<TraderLimits> limits;   // gateway private copy
+		std::vector<TraderState> state;
+
+		// control plane staging
+		std::vector<TraderLimits> staged;
+		alignas(64) std::atomic<uint32_t> staged_seq = {0};
+		alignas(64) std::atomic<uint64_t> published_version = {0};
+		uint64_t applied_version = 0;
+
+		uint64_t rejects = 0;
+
+		static inline int64_t notionalOf(float price, int32_t quantity) noexcept {
+			return static_cast<int64_t>(price * 10) * quantity; // price ticks, same 0.1 quantum the books index by
+		}
+
+	public :
+
+		PreTradeRisk() {
+			limits.resize(OE_MAX_TRADERS);
+			staged.resize(OE_MAX_TRADERS);
+			state.resize(OE_MAX_TRADERS);
+		}
+
+		PreTradeRisk(const PreTradeRisk&) = delete;
+		PreTradeRisk& operator=(const PreTradeRisk&) = delete;
+
+		// ======================== control plane (one thread) ========================
+
+		void setLimits(short trader_id, const RiskLimits& new_limits) noexcept {
+			if(trader_id < 0 || trader_id >= OE_MAX_TRADERS) return;
+
+			staged_seq.fetch_add(1, std::memory_order_acq_rel);   // odd : write in progress
+			staged[trader_id].limits = new_limits;
+			staged_seq.fetch_add(1, std::memory_order_release);   // even : consistent again
+			published_version.fetch_add(1, std::memory_order_release);
+		}
+
+		void setLimitsAll(const RiskLimits& new_limits) noexcept {
+			staged_seq.fetch_add(1, std::memory_order_acq_rel);
+			for(auto& l : staged) l.limits = new_limits;
+			staged_seq.fetch_add(1, std::memory_order_release);
+			published_version.fetch_add(1, std::memory_order_release);
+		}
+
+		// ======================== gateway thread ========================
+
+		// pick up limits published since the last call
+		void refresh() noexcept {
+			uint64_t version = published_version.load(std::memory_order_acquire);
+			if(LIKELY(version == applied_version)) return;
+
+			while(true) {
+				uint32_t before = staged_seq.load(std::memory_order_acquire);
+				if(before & 1) continue; // writer in the middle of an update
+
+				for(int t = 0; t < OE_MAX_TRADERS; t++) limits[t] = staged[t];
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(staged_seq.load(std::memory_order_relaxed) == before) break;
+			}
+			applied_version = version;
+		}
+
+		// 'c' : new order, 'order' is its clean RiskOrder. 'u' : replace of the live 'order' (new price / new total quantity, same side).
+		// anything else (cancels, mass cancels) always passes. commits the exposure when the order passes, returns the reject mask.
+		uint32_t check(char req_type, short trader_id, RiskOrder& order, char side, float price, int32_t quantity, uint64_t now) noexcept {
+			if(req_type != 'c' && req_type != 'u') return 0;
+
+			uint32_t bad_trader = (static_cast<unsigned>(trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS));
+			int t = bad_trader ? 0 : trader_id;
+			const RiskLimits& l = limits[t].limits;
+			TraderState& s = state[t];
+
+			int is_sell = (side == 's');
+			int32_t signed_qty = is_sell ? -quantity : quantity;
+			uint32_t side_change = (order.quantity != 0) & ((order.quantity < 0) != static_cast<bool>(is_sell));
+
+			// a replace only adds what it changes, a new order starts from nothing (its slot is clean)
+			int64_t notional_delta = notionalOf(price, quantity) - notionalOf(order.price, order.quantity < 0 ? -order.quantity : order.quantity);
+			int32_t qty_delta = quantity - (order.quantity < 0 ? -order.quantity : order.quantity);
+
+			int32_t open_after = s.open_qty[is_sell] + qty_delta;
+			int32_t position_side = is_sell ? -s.position : s.position;
+			uint64_t tat = ((s.rate_tat > now) ? s.rate_tat : now) + l.rate_interval_cycles;
+
+			uint32_t reasons =
+				  (static_cast<uint32_t>(!(price >= l.price_lo) | !(price <= l.price_hi)) * RISK_PRICE_BAND)
+				| (static_cast<uint32_t>(quantity > l.max_order_qty) * RISK_ORDER_QTY)
+				| (static_cast<uint32_t>(s.open_notional + notional_delta > l.max_open_notional) * RISK_OPEN_NOTIONAL)
+				| (static_cast<uint32_t>(static_cast<int64_t>(position_side) + open_after > l.max_position) * RISK_POSITION)
+				| (static_cast<uint32_t>(tat - now > l.rate_burst_cycles) * RISK_MESSAGE_RATE)
+				| (bad_trader * RISK_BAD_TRADER)
+				| (side_change * RISK_SIDE_CHANGE);
+
+			if(UNLIKELY(reasons != 0)) {
+				rejects++;
+				return reasons;
+			}
+
+			s.open_notional += notional_delta;
+			s.open_qty[is_sell] = open_after;
+			s.rate_tat = tat;
+			order.price = price;
+			order.quantity = signed_qty;
+			return 0;
+		}
+
+		// 'T' ack : part (or all) of 'order' traded
+		void onFill(short trader_id, RiskOrder& order, int32_t fill_qty) noexcept {
+			if(UNLIKELY(static_cast<unsigned>(trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS))) return;
+			TraderState& s = state[trader_id];
+
+			int is_sell = (order.quantity < 0);
+			int32_t remaining = is_sell ? -order.quantity : order.quantity;
+			int32_t filled = (fill_qty < remaining) ? fill_qty : remaining;
+
+			s.open_notional -= notionalOf(order.price, filled);
+			s.open_qty[is_sell] -= filled;
+			s.position += is_sell ? -filled : filled;
+			order.quantity += is_sell ? filled : -filled;
+		}
+
+		// 'order' is terminal (cancelled / filled / never forwarded) : whatever is still open leaves the exposure
+		void onTerminal(short trader_id, RiskOrder& order) noexcept {
+			if(UNLIKELY(static_cast<unsigned>(trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS))) { order.quantity = 0; return; }
+			TraderState& s = state[trader_id];
+
+			int is_sell = (order.quantity < 0);
+			int32_t remaining = is_sell ? -order.quantity : order.quantity;
+
+			s.open_notional -= notionalOf(order.price, remaining);
+			s.open_qty[is_sell] -= remaining;
+			order.price = 0.0f;
+			order.quantity = 0;
+		}
+
+		void prefetchTrader(short trader_id) const noexcept {
+			if(LIKELY(static_cast<unsigned>(trader_id) < static_cast<unsigned>(OE_MAX_TRADERS))) {
+				__builtin_prefetch(&limits[trader_id], 0, 3);
+				__builtin_prefetch(&state[trader_id], 1, 3);
+			}
+		}
+
+		int64_t openNotional(short trader_id) const noexcept { return state[trader_id].open_notional; }
+		int32_t position(short trader_id) const noexcept { return state[trader_id].position; }
+		uint64_t getRejects() const noexcept { return rejects; }
+
+		// gateway thread : forget every position / open quantity / rate state, the limits stay (the owner clears its RiskOrders)
+		void resetExposure() noexcept {
+			for(auto& s : state) s = TraderState{};
+			rejects = 0;
+		}
+	};
+}
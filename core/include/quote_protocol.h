@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Capitol market maker quote protocol (v1), UDP
+//
+// market makers refresh quotes far more often than anybody trades on them, a lost quote is replaced by the next one anyway,
+// so quotes go over plain UDP : no session, no retransmission, one datagram carries up to QUOTE_MAX_PER_PACKET messages.
+// packet_seq is per trader and only used to drop stale (reordered) packets and to count losses, never to recover them.
+//
+//   'Q' quote  : new quote for quote_id, or replaces the live one (price and/or size)
+//   'X' cancel : pull quote_id
+
+namespace internal_lib {
+
+	constexpr uint8_t QUOTE_PROTOCOL_VERSION = 1;
+	constexpr size_t QUOTE_MAX_DATAGRAM = 1472; // ethernet MTU - IP/UDP headers, never fragment
+
+#pragma pack(push, 1)
+
+	struct QuotePacketHeader {		// 16 byte
+		uint16_t length;			// total datagram length
+		uint8_t version;			// QUOTE_PROTOCOL_VERSION
+		uint8_t count;				// QuoteMessages following the header
+		uint32_t packet_seq;		// per trader, +1 per datagram
+		int16_t trader_id;
+		char pad[6];
+	};
+
+	struct QuoteMessage {			// 16 byte
+		char type;					// 'Q' or 'X'
+		char side;					// 'b' or 's'
+		char pad[2];
+		int32_t quote_id;			// unique per trader (the order id of the quote)
+		float price;
+		int32_t quantity;
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(QuotePacketHeader) == 16, "quote packet header layout");
+	static_assert(sizeof(QuoteMessage) == 16, "quote message layout");
+
+	constexpr size_t QUOTE_MAX_PER_PACKET = (QUOTE_MAX_DATAGRAM - sizeof(QuotePacketHeader)) / sizeof(QuoteMessage); // 91
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+
+// Capitol order flow recording (v1) : the file the replay driver (replay_driver.cpp) maps.
+//
+// a 32 byte header followed by event_count fixed size 24 byte events in timestamp order, nothing else ---> the driver reads it
+// in place through mmap, event i is at sizeof(ReplayFileHeader) + i * sizeof(ReplayEvent). little endian, host layout.
+// replay_convert turns a csv recording into this format.
+
+namespace internal_lib {
+
+	constexpr uint32_t REPLAY_MAGIC = 0x52504143; // "CAPR"
+	constexpr uint16_t REPLAY_VERSION = 1;
+
+	struct ReplayFileHeader {		// 32 byte
+		uint32_t magic;				// REPLAY_MAGIC
+		uint16_t version;			// REPLAY_VERSION
+		uint16_t event_size;		// sizeof(ReplayEvent)
+		uint64_t event_count;
+		uint64_t first_ts_ns;		// recorded timestamps of the first and last event
+		uint64_t last_ts_ns;
+	};
+
+	struct ReplayEvent {			// 24 byte, the fields of a UserOrder
+		uint64_t ts_ns;				// recorded arrival time
+		int32_t order_id;			// per trader
+		int16_t trader_id;
+		char order_type;			// 'b' or 's'
+		char req_type;				// 'c', 'u', 'd'
+		float price;
+		int32_t quantity;
+	};
+
+	static_assert(sizeof(ReplayFileHeader) == 32, "replay header layout");
+	static_assert(sizeof(ReplayEvent) == 24, "replay event layout");
+
+	// sequential writer, the header is patched with the count / time range on close()
+	class ReplayWriter {
+		private :
+			FILE* file = nullptr;
+			ReplayFileHeader header{};
+
+		public :
+			ReplayWriter() = default;
+			ReplayWriter(const ReplayWriter&) = delete;
+			ReplayWriter& operator=(const ReplayWriter&) = delete;
+			~ReplayWriter() { close(); }
+
+			bool open(const char* path) noexcept {
+				file = std::fopen(path, "wb");
+				if(file == nullptr) return false;
+				header = ReplayFileHeader{REPLAY_MAGIC, REPLAY_VERSION, static_cast<uint16_t>(sizeof(ReplayEvent)), 0, 0, 0};
+				return std::fwrite(&header, sizeof(header), 1, file) == 1;
+			}
+
+			// events must come in timestamp order
+			bool append(const ReplayEvent& event) noexcept {
+				if(header.event_count == 0) header.first_ts_ns = event.ts_ns;
+				header.last_ts_ns = event.ts_ns;
+				header.event_count++;
+				return std::fwrite(&event, sizeof(event), 1, file) == 1;
+			}
+
+			bool close() noexcept {
+				if(file == nullptr) return true;
+				bool ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+				ok = (std::fclose(file) == 0) && ok;
+				file = nullptr;
+				return ok;
+			}
+
+			uint64_t getEventCount() const noexcept { return header.event_count; }
+	};
+}
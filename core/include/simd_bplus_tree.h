@@ -28,8 +28,9 @@ namespace internal_lib {
 
         using NodePool = MemPool<Node>;
         
-        // static pool shared by all trees
-        inline static NodePool* pool = nullptr;
+        // every tree owns its pool : trees now live on different threads (one per order gateway) and MemPool is
+        // single threaded by design, a shared static pool would be a data race on the free list.
+        NodePool* pool = nullptr;
 
         // node aligned to cache line 64 bytes
         struct alignas(64) Node {
@@ -108,17 +109,17 @@ namespace internal_lib {
         }
 
         //   insert logic  
-        void insert_recursive(Node* node, KeyType key, ValueType value, Node*& new_sibling, KeyType& median) {
+        void insert_recursive(Node* node, KeyType key, ValueType value, Node*& new_sibling, KeyType& median, bool& inserted) {
             int i = 0;
             // keeping scalar linear scan for insertion index finding 
             // because we need 'greater than' logic which is expensive in avx2-64bit
             // and we only insert once per order, but we search many times.
-            while (i < node->num_keys && key > node->keys[i]) i++;
-
             if (node->is_leaf) {
-                // update existing val ??
-                if (i > 0 && node->keys[i - 1] == key) {
-                    node->values[i - 1] = value;
+                while (i < node->num_keys && key > node->keys[i]) i++;
+
+                // key already there : keep its value, the caller decides what a duplicate means
+                if (i < node->num_keys && node->keys[i] == key) {
+                    inserted = false;
                     return;
                 }
                 
@@ -138,9 +139,12 @@ namespace internal_lib {
             }
 
             // internal node logic
+            // route exactly like find() (key == separator goes right), a separator can outlive its key once keys get erased
+            while (i < node->num_keys && key >= node->keys[i]) i++;
+
             Node* child_sibling = nullptr;
             KeyType child_median = 0;
-            insert_recursive(node->children[i], key, value, child_sibling, child_median);
+            insert_recursive(node->children[i], key, value, child_sibling, child_median, inserted);
 
             if (child_sibling) {
                 // shift keys and children to make space
@@ -171,6 +175,114 @@ namespace internal_lib {
             median = new_leaf->keys[0]; // copy up median
         }
 
+        //   erase logic  
+        // classic B+ tree deletion : a non root node that drops below MIN_KEYS borrows one key from a sibling, or, if both
+        // siblings are at the minimum, is merged into one of them. every non root node stays at least half full, so the node
+        // count is bounded by the live keys (worstCaseNodes) whatever the erase pattern. ids are recycled for the whole session
+        // and the erases land all over the key space (cancels / fills of any trader), with lazy deletion a long session
+        // leaves nearly empty leaves behind until the pool runs dry.
+        void erase_recursive(Node* node, KeyType key, bool& erased) {
+            if (node->is_leaf) {
+                int idx = findIndexSIMD(node, key);
+                if (idx == -1) return;
+
+                for (int k = idx; k < node->num_keys - 1; k++) {
+                    node->keys[k] = node->keys[k + 1];
+                    node->values[k] = node->values[k + 1];
+                }
+                node->num_keys--;
+                erased = true;
+                return;
+            }
+
+            int i = 0;
+            while (i < node->num_keys && key >= node->keys[i]) i++;
+
+            erase_recursive(node->children[i], key, erased);
+            if (erased && node->children[i]->num_keys < MIN_KEYS) rebalance(node, i);
+        }
+
+        // child i of parent is one key short : borrow from the richer sibling, merge with one otherwise
+        void rebalance(Node* parent, int i) {
+            Node* left = (i > 0) ? parent->children[i - 1] : nullptr;
+            Node* right = (i < parent->num_keys) ? parent->children[i + 1] : nullptr;
+
+            if (left != nullptr && left->num_keys > MIN_KEYS) borrowFromLeft(parent, i);
+            else if (right != nullptr && right->num_keys > MIN_KEYS) borrowFromRight(parent, i);
+            else if (left != nullptr) merge(parent, i - 1);
+            else merge(parent, i);
+        }
+
+        void borrowFromLeft(Node* parent, int i) {
+            Node* node = parent->children[i];
+            Node* left = parent->children[i - 1];
+
+            for (int k = node->num_keys; k > 0; k--) node->keys[k] = node->keys[k - 1];
+            if (node->is_leaf) {
+                for (int k = node->num_keys; k > 0; k--) node->values[k] = node->values[k - 1];
+                node->keys[0] = left->keys[left->num_keys - 1];
+                node->values[0] = left->values[left->num_keys - 1];
+                parent->keys[i - 1] = node->keys[0];
+            } else {
+                // rotate through the parent : its separator comes down, the left sibling's last key goes up
+                for (int k = node->num_keys + 1; k > 0; k--) node->children[k] = node->children[k - 1];
+                node->keys[0] = parent->keys[i - 1];
+                node->children[0] = left->children[left->num_keys];
+                parent->keys[i - 1] = left->keys[left->num_keys - 1];
+            }
+            left->num_keys--;
+            node->num_keys++;
+        }
+
+        void borrowFromRight(Node* parent, int i) {
+            Node* node = parent->children[i];
+            Node* right = parent->children[i + 1];
+
+            if (node->is_leaf) {
+                node->keys[node->num_keys] = right->keys[0];
+                node->values[node->num_keys] = right->values[0];
+                for (int k = 0; k < right->num_keys - 1; k++) {
+                    right->keys[k] = right->keys[k + 1];
+                    right->values[k] = right->values[k + 1];
+                }
+                parent->keys[i] = right->keys[0];
+            } else {
+                node->keys[node->num_keys] = parent->keys[i];
+                node->children[node->num_keys + 1] = right->children[0];
+                parent->keys[i] = right->keys[0];
+                for (int k = 0; k < right->num_keys - 1; k++) right->keys[k] = right->keys[k + 1];
+                for (int k = 0; k < right->num_keys; k++) right->children[k] = right->children[k + 1];
+            }
+            right->num_keys--;
+            node->num_keys++;
+        }
+
+        // children k and k+1 ---> one node (k), the separator between them goes away (leaf) or comes down (internal).
+        // both are at the minimum so the result fits (2 * MIN_KEYS + 1 < M)
+        void merge(Node* parent, int k) {
+            Node* node = parent->children[k];
+            Node* right = parent->children[k + 1];
+
+            if (node->is_leaf) {
+                for (int j = 0; j < right->num_keys; j++) {
+                    node->keys[node->num_keys + j] = right->keys[j];
+                    node->values[node->num_keys + j] = right->values[j];
+                }
+                node->num_keys += right->num_keys;
+            } else {
+                node->keys[node->num_keys] = parent->keys[k];
+                for (int j = 0; j < right->num_keys; j++) node->keys[node->num_keys + 1 + j] = right->keys[j];
+                for (int j = 0; j <= right->num_keys; j++) node->children[node->num_keys + 1 + j] = right->children[j];
+                node->num_keys += 1 + right->num_keys;
+            }
+
+            for (int j = k; j < parent->num_keys - 1; j++) parent->keys[j] = parent->keys[j + 1];
+            for (int j = k + 1; j < parent->num_keys; j++) parent->children[j] = parent->children[j + 1];
+            parent->num_keys--;
+
+            pool->deallocate(right);
+        }
+
         void split_internal(Node* node, Node*& new_node, KeyType& median) {
             int mid = M / 2;
             new_node = createNode(false); // use our factory
@@ -186,23 +298,36 @@ namespace internal_lib {
         }
 
     public:
-        // initializer  --> the main function must call this before hot path starts. 
-        // user MUST call this in main() before creating any tree
-        static void init(size_t pool_size) {
-            if (!pool) {
-                pool = new NodePool(pool_size);
-            }
+        // fewest keys of a non root node : a split leaves at least this many on either side, erase keeps it that way
+        static constexpr int MIN_KEYS = (M - 1) / 2;
+
+        // most nodes a tree of live_keys keys can need : leaves hold >= MIN_KEYS keys, internal nodes >= MIN_KEYS + 1 children,
+        // plus one partly filled node per level (the root, a leaf split in progress)
+        static constexpr size_t worstCaseNodes(size_t live_keys) noexcept {
+            return live_keys / MIN_KEYS + live_keys / (static_cast<size_t>(MIN_KEYS) * MIN_KEYS) + 16;
         }
 
-        SIMDBPlusTree() { 
-            // fallback safety: if user forgot init(), we do it here.
-            // but in prod, init() should already be called.
-            if (UNLIKELY(!pool)) {
-                init(50000); 
-            }
+        // pool_size = max nodes this tree can ever hold, the whole pool is allocated here before the hot path starts.
+        explicit SIMDBPlusTree(size_t pool_size = 50000) { 
+            pool = new NodePool(pool_size);
+            root = createNode(true);
+        }
+
+        ~SIMDBPlusTree() {
+            delete pool; // nodes are plain memory inside the pool, no need to walk the tree
+        }
+
+        SIMDBPlusTree(const SIMDBPlusTree&) = delete;
+        SIMDBPlusTree& operator=(const SIMDBPlusTree&) = delete;
+
+        // empty tree again, the node pool is kept (no walk, no free : the whole pool is rewound)
+        void clear() noexcept {
+            pool->reset();
             root = createNode(true);
         }
 
+        size_t nodeCount() const noexcept { return pool->used(); }
+
         ValueType find(KeyType key) {
             Node* curr = root;
             // internal node traversal (still scalar linear scan)
@@ -218,10 +343,65 @@ namespace internal_lib {
             return -1;
         }
 
-        void insert(KeyType key, ValueType value) {
+        // group prefetching lookup for a burst of keys.
+        // a single find() is a chain of dependent pointer loads -> every level is a full DRAM miss once the tree outgrows cache.
+        // here we walk all the keys down the tree one level at a time : route every key at level L and prefetch its child,
+        // by the time we come back to route the first key at level L+1 its node is (hopefully) already in cache.
+        // so we pay ~one miss latency per level for the whole burst instead of one per key per level.
+        // this works because a B+ tree is perfectly balanced, all the keys reach the leaves in the same round.
+        static constexpr int MAX_BATCH = 32;
+
+        void findBatch(const KeyType* keys, ValueType* out, int n) {
+            Node* curr[MAX_BATCH];
+            if (UNLIKELY(n > MAX_BATCH)) n = MAX_BATCH;
+
+            for (int b = 0; b < n; b++) curr[b] = root;
+
+            while (n > 0 && !curr[0]->is_leaf) {
+                for (int b = 0; b < n; b++) {
+                    Node* node = curr[b];
+                    int i = 0;
+                    while (i < node->num_keys && keys[b] >= node->keys[i]) i++;
+                    curr[b] = node->children[i];
+                    prefetchNode(curr[b]);
+                }
+            }
+
+            for (int b = 0; b < n; b++) {
+                int idx = findIndexSIMD(curr[b], keys[b]);
+                out[b] = (idx != -1) ? curr[b]->values[idx] : -1;
+            }
+        }
+
+        // pull the head of a node (flags + first few key lines) towards L1, the linear key scan streams the rest
+        static inline void prefetchNode(const Node* node) noexcept {
+            const char* p = reinterpret_cast<const char*>(node);
+            __builtin_prefetch(p, 0, 3);
+            __builtin_prefetch(p + 64, 0, 3);
+            __builtin_prefetch(p + 128, 0, 3);
+            __builtin_prefetch(p + 192, 0, 3);
+        }
+
+        // removes the key, returns false if it was not there
+        bool erase(KeyType key) {
+            bool erased = false;
+            erase_recursive(root, key, erased);
+
+            // an internal root left with a single child (its children merged) hands over, the depth shrinks with the tree
+            if (!root->is_leaf && root->num_keys == 0) {
+                Node* old_root = root;
+                root = root->children[0];
+                pool->deallocate(old_root);
+            }
+            return erased;
+        }
+
+        // false (and nothing changed) if the key is already in the tree : one descent for the check and the insert
+        bool insert(KeyType key, ValueType value) {
             Node* new_child = nullptr;
             KeyType median = 0;
-            insert_recursive(root, key, value, new_child, median);
+            bool inserted = true;
+            insert_recursive(root, key, value, new_child, median, inserted);
             
             // if root split create new root
             if (new_child) {
@@ -232,6 +412,7 @@ namespace internal_lib {
                 new_root->num_keys = 1;
                 root = new_root;
             }
+            return inserted;
         }
     };
 } 
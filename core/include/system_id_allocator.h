@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// a system id is not just a counter anymore, it is a (slot, generation) pair packed in a positive int :
+	//
+	//      31   30 ............ 21   20 ................ 0
+	//     [ 0 | generation (10 bit) |  slot index (21 bit) ]
+	//
+	// every id indexed table in the system (gateway LUT, both book LUTs) is indexed by the slot only, so they stay
+	// SYSTEM_ID_CAPACITY entries big for a session of any length. when an order is terminal its slot goes back to the
+	// free list and its generation is bumped, so a late message still carrying the old id can be told apart from the new
+	// owner of the slot and rejected.
+
+	constexpr int SYSTEM_ID_INDEX_BITS = 21;
+	constexpr int SYSTEM_ID_GENERATION_BITS = 10;
+	constexpr int SYSTEM_ID_CAPACITY = 1 << SYSTEM_ID_INDEX_BITS; // 2M live orders at any moment
+	constexpr int SYSTEM_ID_INDEX_MASK = SYSTEM_ID_CAPACITY - 1;
+	constexpr int SYSTEM_ID_GENERATION_MASK = (1 << SYSTEM_ID_GENERATION_BITS) - 1;
+
+	inline int systemIdIndex(int system_id) noexcept {
+		return system_id & SYSTEM_ID_INDEX_MASK;
+	}
+
+	inline int systemIdGeneration(int system_id) noexcept {
+		return (system_id >> SYSTEM_ID_INDEX_BITS) & SYSTEM_ID_GENERATION_MASK;
+	}
+
+	inline int makeSystemId(int index, int generation) noexcept {
+		return (generation << SYSTEM_ID_INDEX_BITS) | index;
+	}
+
+	// with N order gateways (N power of 2) the slot space is cut in N equal contiguous ranges, gateway g owns range g.
+	// the top log2(N) bits of a slot therefore name the gateway that issued it ---> the engine routes acks back with one shift.
+	inline int systemIdPartitionShift(int gateway_count) noexcept {
+		int bits = 0;
+		while((1 << bits) < gateway_count) bits++;
+		return SYSTEM_ID_INDEX_BITS - bits;
+	}
+
+	inline int systemIdGateway(int system_id, int partition_shift) noexcept {
+		return systemIdIndex(system_id) >> partition_shift;
+	}
+
+	// same hybrid strategy as MemPool : a high water mark for never used slots + a LIFO free list of recycled ones
+	// (the slot freed last is the one most likely still sitting in cache in all the id indexed tables)
+	class SystemIdAllocator {
+	private :
+
+		static constexpr uint16_t LIVE_BIT = 0x8000;
+
+		// per slot : current generation in the low bits + live flag in the top bit
+		std::vector<uint16_t> slot_state;
+		std::vector<int> free_indices;
+
+		int base_index; // first slot of the range we own
+		int high_water_mark = 0;
+		int capacity;
+
+	public :
+
+		// owns slots [base, base + slot_count)
+		explicit SystemIdAllocator(int base = 0, int slot_count = SYSTEM_ID_CAPACITY) : base_index(base), capacity(slot_count) {
+			if(base_index + capacity > SYSTEM_ID_CAPACITY) capacity = SYSTEM_ID_CAPACITY - base_index;
+			slot_state.resize(capacity, 0);
+			free_indices.reserve(capacity); // every slot can be free at once, never reallocate on the hot path
+		}
+
+		SystemIdAllocator(const SystemIdAllocator&) = delete;
+		SystemIdAllocator& operator=(const SystemIdAllocator&) = delete;
+
+		// returns -1 when every slot is live
+		int allocate() noexcept {
+			int index;
+
+			if(LIKELY(!free_indices.empty())) {
+				index = free_indices.back();
+				free_indices.pop_back();
+			} else if(LIKELY(high_water_mark < capacity)) {
+				index = high_water_mark++;
+			} else {
+				return -1;
+			}
+
+			slot_state[index] |= LIVE_BIT;
+			return makeSystemId(base_index + index, slot_state[index] & SYSTEM_ID_GENERATION_MASK);
+		}
+
+		// id must be the live one, a stale/duplicate release is ignored and returns false
+		bool release(int system_id) noexcept {
+			if(UNLIKELY(!isLive(system_id))) return false;
+
+			int index = localIndex(system_id);
+			uint16_t next_generation = static_cast<uint16_t>(((slot_state[index] & SYSTEM_ID_GENERATION_MASK) + 1) & SYSTEM_ID_GENERATION_MASK);
+			slot_state[index] = next_generation; // live bit cleared
+			free_indices.push_back(index);
+			return true;
+		}
+
+		bool isLive(int system_id) const noexcept {
+			if(UNLIKELY(system_id < 0)) return false;
+			unsigned index = static_cast<unsigned>(localIndex(system_id));
+			if(UNLIKELY(index >= static_cast<unsigned>(capacity))) return false; // not ours (or not a slot at all)
+			return slot_state[index] == (LIVE_BIT | systemIdGeneration(system_id));
+		}
+
+		// position of the id inside our range ---> what the owner's own id indexed tables are indexed by
+		int localIndex(int system_id) const noexcept {
+			return systemIdIndex(system_id) - base_index;
+		}
+
+		bool owns(int system_id) const noexcept {
+			return system_id >= 0 && static_cast<unsigned>(localIndex(system_id)) < static_cast<unsigned>(capacity);
+		}
+
+		void prefetchSlot(int system_id) const noexcept {
+			__builtin_prefetch(&slot_state[localIndex(system_id)], 0, 3);
+		}
+
+		// every slot free again with generation 0 (same ids as a fresh allocator), only the slots ever handed out are touched
+		void reset() noexcept {
+			for(int i = 0; i < high_water_mark; i++) slot_state[i] = 0;
+			free_indices.clear();
+			high_water_mark = 0;
+		}
+
+		int liveCount() const noexcept {
+			return high_water_mark - static_cast<int>(free_indices.size());
+		}
+
+		int getCapacity() const noexcept {
+			return capacity;
+		}
+	};
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// top of book for in process readers : a BBO record and a depth-10 L2 page, each in its own cache lines under its own
+	// sequence lock, written by the engine thread and read by anyone without touching a queue.
+	//
+	// the engine reports every level change (same hook as the conflated book). the writer keeps private per level aggregates and
+	// only publishes when the change is inside the page : a level that stays in the page is updated in place (a couple of stores,
+	// plus the BBO if it is the best), a level entering or leaving the page rebuilds that side of the page from the best price.
+	// changes further out than the 10th level cost one compare.
+
+	constexpr int TOB_DEPTH = 10;
+
+	struct DepthLevel {
+		float price;
+		int32_t orders;
+		int64_t quantity;
+	};
+
+	struct BBOView {
+		float bid_price;		// 0 / 0 quantity when the side is empty
+		int32_t bid_orders;
+		int64_t bid_quantity;
+		float ask_price;
+		int32_t ask_orders;
+		int64_t ask_quantity;
+		uint64_t version;		// changes with every update, equal versions = same book
+	};
+
+	struct DepthView {
+		int32_t bid_levels;
+		int32_t ask_levels;
+		DepthLevel bids[TOB_DEPTH];	// best first
+		DepthLevel asks[TOB_DEPTH];
+		uint64_t version;
+	};
+
+	class TopOfBook {
+	private :
+
+		struct alignas(64) BBORecord {
+			std::atomic<uint64_t> seq{0};	// odd while being written
+			DepthLevel bid{0.0f, 0, 0};
+			DepthLevel ask{0.0f, 0, 0};
+		};
+
+		struct alignas(64) DepthRecord {
+			std::atomic<uint64_t> seq{0};
+			int32_t count[2] = {0, 0};
+			DepthLevel levels[2][TOB_DEPTH];
+		};
+
+		BBORecord bbo;
+		DepthRecord depth;
+
+		// writer private
+		size_t ticks;
+		std::vector<int64_t> quantity[2];	// [0] buy, [1] sell, per tick
+		std::vector<int32_t> orders[2];
+		long best[2] = {-1, -1};			// best non empty tick, -1 = side empty
+		long page_tick[2][TOB_DEPTH];
+		int page_count[2] = {0, 0};
+
+		// is a at least as good as b for that side
+		static inline bool atLeastAsGood(int side, long a, long b) noexcept {
+			return side == 0 ? a >= b : a <= b;
+		}
+
+		static inline DepthLevel levelAt(long tick, int64_t qty, int32_t count) noexcept {
+			return DepthLevel{static_cast<float>(tick) * 0.1f, count, qty};
+		}
+
+	public :
+
+		explicit TopOfBook(size_t max_price_ticks) : ticks(max_price_ticks + 1) {
+			for(int s = 0; s < 2; s++) {
+				quantity[s].assign(ticks, 0);
+				orders[s].assign(ticks, 0);
+			}
+		}
+
+		TopOfBook(const TopOfBook&) = delete;
+		TopOfBook& operator=(const TopOfBook&) = delete;
+
+		// ======================== engine thread (single writer) ========================
+
+		inline void apply(bool is_buy, size_t tick, int64_t quantity_delta, int32_t orders_delta) noexcept {
+			if(UNLIKELY(tick >= ticks)) return;
+			int s = is_buy ? 0 : 1;
+			long t = static_cast<long>(tick);
+
+			quantity[s][tick] += quantity_delta;
+			orders[s][tick] += orders_delta;
+
+			int n = page_count[s];
+			if(n == TOB_DEPTH && !atLeastAsGood(s, t, page_tick[s][n - 1])) return; // below the page
+
+			bool live = orders[s][tick] > 0;
+			int idx = -1;
+			for(int i = 0; i < n; i++) {
+				if(page_tick[s][i] == t) { idx = i; break; }
+			}
+
+			if(idx >= 0 && live) {
+				// level stays where it is : update in place
+				DepthLevel level = levelAt(t, quantity[s][tick], orders[s][tick]);
+				beginWrite(depth.seq);
+				depth.levels[s][idx] = level;
+				endWrite(depth.seq);
+				if(idx == 0) publishBBO(s, level);
+				return;
+			}
+			if(idx < 0 && !live) return; // went empty without ever being in the page
+
+			// a level entered or left the page
+			if(live && (best[s] == -1 || atLeastAsGood(s, t, best[s]))) best[s] = t;
+			else if(!live && t == best[s]) best[s] = nextLive(s, t);
+			rebuild(s);
+		}
+
+		// ======================== readers (any thread) ========================
+
+		inline void readBBO(BBOView& out) const noexcept {
+			while(true) {
+				uint64_t before = bbo.seq.load(std::memory_order_acquire);
+				if(UNLIKELY(before & 1)) continue;
+				out.bid_price = bbo.bid.price;
+				out.bid_orders = bbo.bid.orders;
+				out.bid_quantity = bbo.bid.quantity;
+				out.ask_price = bbo.ask.price;
+				out.ask_orders = bbo.ask.orders;
+				out.ask_quantity = bbo.ask.quantity;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(LIKELY(bbo.seq.load(std::memory_order_relaxed) == before)) {
+					out.version = before;
+					return;
+				}
+			}
+		}
+
+		inline void readDepth(DepthView& out) const noexcept {
+			while(true) {
+				uint64_t before = depth.seq.load(std::memory_order_acquire);
+				if(UNLIKELY(before & 1)) continue;
+				out.bid_levels = depth.count[0];
+				out.ask_levels = depth.count[1];
+				for(int i = 0; i < TOB_DEPTH; i++) out.bids[i] = depth.levels[0][i];
+				for(int i = 0; i < TOB_DEPTH; i++) out.asks[i] = depth.levels[1][i];
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(LIKELY(depth.seq.load(std::memory_order_relaxed) == before)) {
+					out.version = before;
+					return;
+				}
+			}
+		}
+
+	private :
+
+		static inline void beginWrite(std::atomic<uint64_t>& seq) noexcept {
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		static inline void endWrite(std::atomic<uint64_t>& seq) noexcept {
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		inline void publishBBO(int s, const DepthLevel& level) noexcept {
+			beginWrite(bbo.seq);
+			if(s == 0) bbo.bid = level;
+			else bbo.ask = level;
+			endWrite(bbo.seq);
+		}
+
+		// next non empty tick behind 'from' (worse price), -1 if there is none
+		inline long nextLive(int s, long from) const noexcept {
+			if(s == 0) {
+				for(long t = from - 1; t >= 0; t--) if(orders[0][t] > 0) return t;
+			} else {
+				for(long t = from + 1; t < static_cast<long>(ticks); t++) if(orders[1][t] > 0) return t;
+			}
+			return -1;
+		}
+
+		// one side of the page from the best price outwards
+		inline void rebuild(int s) noexcept {
+			DepthLevel page[TOB_DEPTH];
+			int n = 0;
+			for(long t = best[s]; t != -1 && n < TOB_DEPTH; t = nextLive(s, t)) {
+				page_tick[s][n] = t;
+				page[n] = levelAt(t, quantity[s][t], orders[s][t]);
+				n++;
+			}
+			page_count[s] = n;
+
+			beginWrite(depth.seq);
+			depth.count[s] = n;
+			for(int i = 0; i < n; i++) depth.levels[s][i] = page[i];
+			endWrite(depth.seq);
+
+			publishBBO(s, (n > 0) ? page[0] : DepthLevel{0.0f, 0, 0});
+		}
+	};
+}
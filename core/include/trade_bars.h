@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// compiler hints for branch prediction
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// OHLCV / VWAP bars over a fixed interval, built from the trade stream ('T' BroadcastElements) by one writer thread
+	// (the market data publisher) and queryable by any thread without locks.
+	//
+	// bar k covers engine cycles [k * interval, (k + 1) * interval). the last 'history' bars live in a ring allocated once at
+	// construction, each slot under its own sequence lock. intervals without a trade produce no bar. readers ask for the
+	// latest bar, the bar n back, or a rolling aggregate over the last n bars.
+
+	struct BarView {
+		uint64_t index;		// bar number (start cycle = index * interval)
+		float open;
+		float high;
+		float low;
+		float close;
+		int64_t volume;
+		double vwap;
+		uint32_t trades;
+	};
+
+	class TradeBars {
+	private :
+
+		struct alignas(64) Bar {
+			std::atomic<uint64_t> seq{0};	// odd while being written
+			uint64_t index = 0;
+			float open = 0, high = 0, low = 0, close = 0;
+			int64_t volume = 0;
+			double notional = 0;			// sum of price * quantity, vwap = notional / volume
+			uint32_t trades = 0;
+		};
+
+		uint64_t interval_cycles;
+		std::vector<Bar> ring;
+		size_t mask;
+
+		alignas(64) std::atomic<uint64_t> bars_started = {0}; // head : ring[(bars_started - 1) & mask] is the current bar
+		uint64_t current_index = ~0ull;						   // writer private
+
+	public :
+
+		// history is rounded up to a power of 2
+		TradeBars(uint64_t interval, size_t history) : interval_cycles(interval == 0 ? 1 : interval) {
+			size_t n = 1;
+			while(n < history) n <<= 1;
+			ring = std::vector<Bar>(n);
+			mask = n - 1;
+		}
+
+		TradeBars(const TradeBars&) = delete;
+		TradeBars& operator=(const TradeBars&) = delete;
+
+		// ======================== writer (one thread) ========================
+
+		inline void onTrade(float price, int32_t quantity, uint64_t cycle) noexcept {
+			uint64_t index = cycle / interval_cycles;
+			uint64_t head = bars_started.load(std::memory_order_relaxed);
+
+			// a new interval opens the next bar. a stamp from before the current bar (the engine stamps, fills reach us in engine
+			// order, so that is never more than a few cycles) is folded into the current bar instead of reopening an old one
+			if(UNLIKELY(current_index == ~0ull || index > current_index)) {
+				Bar& bar = ring[head & mask];
+				beginWrite(bar.seq);
+				bar.index = index;
+				bar.open = bar.high = bar.low = bar.close = price;
+				bar.volume = quantity;
+				bar.notional = static_cast<double>(price) * quantity;
+				bar.trades = 1;
+				endWrite(bar.seq);
+
+				current_index = index;
+				bars_started.store(head + 1, std::memory_order_release);
+				return;
+			}
+
+			Bar& bar = ring[(head - 1) & mask];
+			beginWrite(bar.seq);
+			if(price > bar.high) bar.high = price;
+			if(price < bar.low) bar.low = price;
+			bar.close = price;
+			bar.volume += quantity;
+			bar.notional += static_cast<double>(price) * quantity;
+			bar.trades++;
+			endWrite(bar.seq);
+		}
+
+		// ======================== readers (any thread) ========================
+
+		// n = 0 is the current bar, 1 the one before ... false if there is no such bar (yet / any more)
+		inline bool bar(size_t n, BarView& out) const noexcept {
+			uint64_t head = bars_started.load(std::memory_order_acquire);
+			if(n >= head || n > mask) return false;
+
+			uint64_t pos = head - 1 - n;
+			const Bar& slot = ring[pos & mask];
+			while(true) {
+				uint64_t before = slot.seq.load(std::memory_order_acquire);
+				if(UNLIKELY(before & 1)) continue;
+				copy(slot, out);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if(LIKELY(slot.seq.load(std::memory_order_relaxed) == before)) break;
+			}
+			// lapped while we were looking : the slot already holds a newer bar
+			return bars_started.load(std::memory_order_acquire) - pos <= ring.size();
+		}
+
+		inline bool latest(BarView& out) const noexcept { return bar(0, out); }
+
+		// rolling aggregate of the last n bars (fewer if fewer exist), index = the oldest bar included. false if there is none
+		inline bool window(size_t n, BarView& out) const noexcept {
+			BarView b;
+			bool any = false;
+			double notional = 0;
+			for(size_t k = n; k-- > 0;) { // oldest first so open/close come out right
+				if(!bar(k, b)) continue;
+				if(!any) {
+					out = b;
+					notional = b.vwap * static_cast<double>(b.volume);
+					any = true;
+					continue;
+				}
+				if(b.high > out.high) out.high = b.high;
+				if(b.low < out.low) out.low = b.low;
+				out.close = b.close;
+				out.volume += b.volume;
+				out.trades += b.trades;
+				notional += b.vwap * static_cast<double>(b.volume);
+			}
+			if(any) out.vwap = (out.volume > 0) ? notional / static_cast<double>(out.volume) : 0.0;
+			return any;
+		}
+
+		uint64_t getIntervalCycles() const noexcept { return interval_cycles; }
+		uint64_t barCount() const noexcept { return bars_started.load(std::memory_order_acquire); }
+
+	private :
+
+		static inline void beginWrite(std::atomic<uint64_t>& seq) noexcept {
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		static inline void endWrite(std::atomic<uint64_t>& seq) noexcept {
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		static inline void copy(const Bar& bar, BarView& out) noexcept {
+			out.index = bar.index;
+			out.open = bar.open;
+			out.high = bar.high;
+			out.low = bar.low;
+			out.close = bar.close;
+			out.volume = bar.volume;
+			out.vwap = (bar.volume > 0) ? bar.notional / static_cast<double>(bar.volume) : 0.0;
+			out.trades = bar.trades;
+		}
+	};
+}
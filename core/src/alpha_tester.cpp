@@ -5,6 +5,9 @@
 #include "lf_queue.h"
 #include "lob_structs.h"
 #include "order_gateway_structs.h"
+#include "top_of_book.h"
+#include "system_id_allocator.h"
+#include "benchmark_utility.h"
 
 namespace internal_lib {
 	class AlphaServer {
@@ -16,6 +19,28 @@ namespace internal_lib {
 			internal_lib::LFQueue<internal_lib::BroadcastElement>* BroadcastQueue;
 			std::vector<internal_lib::UserOrder> TestStore;
 
+			// engine published BBO (optional) : read straight from the engine's seqlock record, no queue in between
+			const internal_lib::TopOfBook* TopBook = nullptr;
+			internal_lib::BBOView bbo{};
+
+			// strategy perceived round trip : every order is stamped when it is written to the gateway, its first ack closes
+			// send -> ack, the market data add ('N') carrying its system id closes send -> market data. the ack brings the
+			// system id, the feed event may come before or after it (two different paths out of the engine) so whichever
+			// arrives first parks in MdMatches (hashed on the id slot, the full id is compared) and the second one completes it.
+			// orders that never rest (filled on arrival, rejected) have no add and only count for send -> ack.
+			struct MdMatch {
+				int system_id = -1;
+				int order = -1;             // >= 0 : ack seen, waiting for the feed
+				uint64_t md_cycle = 0;      // != 0 : feed seen, waiting for the ack
+			};
+			static constexpr int MD_MATCH_BITS = 16;
+
+			std::vector<uint64_t> Sent_Cycle;           // per order id (TestStore index), 0 = not sent
+			std::vector<uint8_t> Acked;
+			std::vector<MdMatch> MdMatches;
+			std::vector<uint64_t> Send_To_Ack;
+			std::vector<uint64_t> Send_To_Market_Data;
+
 		public : 
 
 			AlphaServer(
@@ -26,13 +51,41 @@ namespace internal_lib {
 				:
 				AlphaOrderQueue(aoq),
 				UserAcknowledgementQueue(uaq),
-				BroadcastQueue(bq)
+				BroadcastQueue(bq),
+				MdMatches(1 << MD_MATCH_BITS)
 				{}; // empty constructor
 
+			void setTopOfBook(const internal_lib::TopOfBook* top) noexcept { TopBook = top; }
+
 
 			void AlphaRun(std::atomic<bool>& start,std::atomic<bool>& terminate) noexcept {
 				//  hogging
 
+				prepare();
+
+				while(!start.load(std::memory_order_acquire)){
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				// start
+				for(int i = 0 ; i < TestStore.size() && !terminate.load(std::memory_order_acquire); i++) {
+					run(i);
+				}
+
+				// keep reading until every order got its ack (or we are told to stop) so the tail is measured too
+				while(!allAcked() && !terminate.load(std::memory_order_acquire)) {
+					pollFeedback();
+				}
+
+				double cpns = internal_lib::get_cycles_per_ns();
+				std::string sta = "Alpha Server send -> ack";
+				internal_lib::showBench(sta, Send_To_Ack, cpns);
+				std::string stmd = "Alpha Server send -> market data (own add observed)";
+				internal_lib::showBench(stmd, Send_To_Market_Data, cpns);
+			}
+
+			// test orders + round trip tables, everything allocated up front
+			void prepare() noexcept {
 				// fill testStore here with 10,000 order entries each with price between 110 to 150 and price is quantum osd 0.1 so it can be anythingx*0.1 which lies betwen 110 amd 150
 				
 				for (int i = 0; i < 10000; ++i) {
@@ -51,15 +104,10 @@ namespace internal_lib {
     				TestStore.push_back(order);
 				}
 
-				while(!start.load(std::memory_order_acquire)){
-					if(terminate.load(std::memory_order_acquire)) return;
-				}
-
-				// start
-				for(int i = 0 ; i < TestStore.size() && !terminate.load(std::memory_order_acquire); i++) {
-					run(i);
-				}
-				
+				Sent_Cycle.assign(TestStore.size(), 0);
+				Acked.assign(TestStore.size(), 0);
+				Send_To_Ack.reserve(TestStore.size());
+				Send_To_Market_Data.reserve(TestStore.size());
 			}
 
 			void run(int& i) noexcept {
@@ -73,24 +121,73 @@ namespace internal_lib {
 
 				// probably we can write now.
 				*write = TestStore[i];
+				uint64_t sent = internal_lib::now_cycles();
+				write->arrived_cycle_count = sent; // the gateway measures its own ingress from here as well
+				Sent_Cycle[i] = sent;
 				// idealyly a busy wait or a spin wait should have been here but okay we can run for now
 				AlphaOrderQueue->updateWrite();
 
+				pollFeedback();
+
+				// latest BBO, a real strategy would price off this
+				if(TopBook != nullptr) TopBook->readBBO(bbo);
+			}
+
+			size_t orderCount() const noexcept { return TestStore.size(); }
+			bool allAcked() const noexcept { return Send_To_Ack.size() >= TestStore.size(); }
+			std::vector<uint64_t>& getSendToAck() noexcept { return Send_To_Ack; }
+			std::vector<uint64_t>& getSendToMarketData() noexcept { return Send_To_Market_Data; }
+
+			// everything that came back since the last look : incremental feed and acks
+			void pollFeedback() noexcept {
+				internal_lib::BroadcastElement* be;
+				while((be = BroadcastQueue->getNextRead()) != nullptr) {
+					if(be->type == 'N') onMarketData(be->system_id, internal_lib::now_cycles());
+					BroadcastQueue->updateRead();
+				}
 
+				internal_lib::UserAcknowledgement* ack;
+				while((ack = UserAcknowledgementQueue->getNextRead()) != nullptr) {
+					onAck(*ack, internal_lib::now_cycles());
+					UserAcknowledgementQueue->updateRead();
+				}
+			}
 
-				// read from incremental change log,
-				auto* broadcastIncrement = BroadcastQueue->getNextRead();
-				if (broadcastIncrement) {
-    				BroadcastQueue->updateRead();
+		private :
+
+			void onAck(const internal_lib::UserAcknowledgement& ack, uint64_t now) noexcept {
+				long long order = ack.order_id;
+				if(order < 0 || order >= static_cast<long long>(Sent_Cycle.size()) || Sent_Cycle[order] == 0) return;
+				if(!Acked[order]) {
+					Acked[order] = 1;
+					Send_To_Ack.push_back(now - Sent_Cycle[order]);
 				}
 
-				// no ned to process it just let it sink in
-				// read from acknoweldgements
-				auto* ackBack = UserAcknowledgementQueue->getNextRead();
-				if (ackBack) {
-    				UserAcknowledgementQueue->updateRead();
+				// only a resting order shows up as an add (its 'C' may follow fills of the part that crossed)
+				if(ack.status != 'C' || ack.system_id < 0) return;
+				MdMatch& m = MdMatches[matchSlot(ack.system_id)];
+				if(m.system_id == ack.system_id && m.md_cycle != 0) {
+					Send_To_Market_Data.push_back(m.md_cycle - Sent_Cycle[order]);
+					m = MdMatch{};
+				} else {
+					m = MdMatch{ack.system_id, static_cast<int>(order), 0};
 				}
-				// let it sink in
+			}
+
+			void onMarketData(int system_id, uint64_t now) noexcept {
+				MdMatch& m = MdMatches[matchSlot(system_id)];
+				if(m.system_id == system_id && m.order >= 0) {
+					Send_To_Market_Data.push_back(now - Sent_Cycle[m.order]);
+					m = MdMatch{};
+				} else if(m.order < 0) {
+					// not ours yet (or somebody else's) : park it, never evict an order that is waiting for its add
+					m = MdMatch{system_id, -1, now};
+				}
+			}
+
+			static inline size_t matchSlot(int system_id) noexcept {
+				uint32_t slot = static_cast<uint32_t>(internal_lib::systemIdIndex(system_id));
+				return (slot * 0x9E3779B1u) >> (32 - MD_MATCH_BITS);
 			}
 	};
 }
\ No newline at end of file
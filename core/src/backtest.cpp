@@ -0,0 +1,221 @@
+// deterministic backtest ---> order flow, gateway, matching engine and one strategy stepped inline on the calling thread on a
+// virtual clock. no threads, no prewarm, no sleeps : a run takes as long as its events take to process and the same inputs
+// give the same book, the same fills and the same feed every time.
+//
+// the virtual clock is in ns and doubles as the "cycle" clock of everything that is handed time : build the flow (MarketMaker,
+// ReplayDriver) with cycles_per_ns = BACKTEST_CYCLES_PER_NS and give the strategy its timer in ns. nothing that decides an
+// outcome reads the TSC : flow schedules and strategy timers run on the virtual clock, the gateway's rate limits too
+// (setRiskClock), the TSC stamps the stages still take only feed their latency samples.
+//
+// the clock moves in steps of step_ns. at every step the flow emits what is due by then, then the stages are run to a fixed
+// point : gateway, engine, acks, feed to the strategy, strategy (which may send), acks back to the flow, again until nothing
+// moves. so an order reaches the book in the step it was sent (zero simulated latency), in one fixed order of the stages --->
+// deterministic. nothing is pending between steps, so the clock skips straight to the step of the next flow event or strategy
+// timer (Flow::nextDue, Strategy::nextTimer) instead of ticking through idle time.
+// the stages still talk through their usual SPSC rings (the gateway and engine only have queue interfaces), on one thread a
+// ring is just an array with two indices and never holds more than what one step produced.
+
+#pragma once
+
+#include <vector>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#include "order_gateway.cpp"
+#include "matching_engine.cpp"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	constexpr double BACKTEST_CYCLES_PER_NS = 1.0;
+	constexpr uint64_t BACKTEST_EPOCH_NS = 1000000000; // virtual time of the first step (non zero, 0 means "unset" to the timers)
+
+	struct BacktestConfig {
+		size_t max_price_ticks = 10000;
+		size_t max_entries_per_price = 400;
+		size_t ring = 1 << 16;
+		uint64_t step_ns = 1000;       // virtual clock resolution
+		short strategy_trader = 1;
+	};
+
+	struct BacktestResult {
+		uint64_t simulated_ns;
+		uint64_t wall_ns;
+		uint64_t steps;
+		uint64_t feed_events;
+		uint64_t trades;
+		uint64_t feed_hash;            // FNV-1a over every feed event (type, side, id, price, quantity), equal runs = equal hash
+	};
+
+	class Backtest {
+
+		private :
+
+			BacktestConfig config;
+
+			LFQueue<UserOrder> StrategyOrders;
+			LFQueue<UserAcknowledgement> StrategyAcks;
+			LFQueue<BroadcastElement> StrategyFeed;
+			LFQueue<UserOrder> FlowOrders;
+			LFQueue<UserOrder> FlowCancels;
+			LFQueue<UserAcknowledgement> FlowAcks;
+			LFQueue<LOBOrder> LobOrders;
+			LFQueue<LOBAcknowledgement> LobAcks;
+			LFQueue<BroadcastElement> Feed;
+
+			MatchingEngine Engine;
+			OrderGateway Gateway;
+
+			uint64_t clock = 0;
+			uint64_t feed_events = 0;
+			uint64_t trades = 0;
+			uint64_t feed_hash = 0xcbf29ce484222325ull;
+
+		public :
+
+			explicit Backtest(const BacktestConfig& cfg = BacktestConfig{})
+				: config(cfg),
+				  StrategyOrders(cfg.ring), StrategyAcks(cfg.ring * 4), StrategyFeed(cfg.ring * 4),
+				  FlowOrders(cfg.ring), FlowCancels(cfg.ring), FlowAcks(cfg.ring * 4),
+				  LobOrders(cfg.ring), LobAcks(cfg.ring * 4), Feed(cfg.ring * 4),
+				  Engine(cfg.max_price_ticks, cfg.max_entries_per_price, &LobOrders, &LobAcks, &Feed),
+				  Gateway(&LobAcks, &StrategyOrders, &FlowOrders, &LobOrders) {
+				Gateway.setThrottleCycles(0);
+				Gateway.attachCancelLanes(nullptr, &FlowCancels);
+				Gateway.setAckRoute(cfg.strategy_trader, &StrategyAcks);
+				Gateway.setRiskClock(&clock);
+			}
+
+			Backtest(const Backtest&) = delete;
+			Backtest& operator=(const Backtest&) = delete;
+
+			// the strategy trades as config.strategy_trader on these
+			short strategyTrader() const noexcept { return config.strategy_trader; }
+			LFQueue<UserOrder>* strategyOrders() noexcept { return &StrategyOrders; }
+			LFQueue<UserAcknowledgement>* strategyAcks() noexcept { return &StrategyAcks; }
+			LFQueue<BroadcastElement>* strategyFeed() noexcept { return &StrategyFeed; }
+
+			// the flow sends on these (orders, and cancels / replaces on the cancel lane if it has one)
+			LFQueue<UserOrder>* flowOrders() noexcept { return &FlowOrders; }
+			LFQueue<UserOrder>* flowCancels() noexcept { return &FlowCancels; }
+
+			// acks of traders first .. first + count - 1 go to flowAcks() (for flows that read them, like the market maker)
+			LFQueue<UserAcknowledgement>* flowAcks() noexcept { return &FlowAcks; }
+			void routeFlowAcks(short first, int count) noexcept {
+				for(int t = 0; t < count; t++) Gateway.setAckRoute(static_cast<short>(first + t), &FlowAcks);
+			}
+
+			// ready for the next run : gateway and engine back to their just constructed state, their memory kept (a
+			// Backtest is expensive to build, a sweep builds one per worker and resets it between jobs). the rings are empty
+			// after a run, the strategy and the flow of the last run must be done with them
+			void reset() noexcept {
+				Gateway.reset();
+				Engine.reset();
+				clock = 0;
+				feed_events = 0;
+				trades = 0;
+				feed_hash = 0xcbf29ce484222325ull;
+			}
+
+			OrderGateway& gateway() noexcept { return Gateway; }
+			MatchingEngine& engine() noexcept { return Engine; }
+			uint64_t now() const noexcept { return clock; }
+
+			// Flow : begin(now), poll(now, max_events), nextDue() (MarketMaker, ReplayDriver). Strat : Strategy<> derived.
+			// runs duration_ns of virtual time from BACKTEST_EPOCH_NS
+			template<typename Flow, typename Strat>
+			BacktestResult run(Flow& flow, Strat& strategy, uint64_t duration_ns) noexcept {
+				uint64_t wall_start = now_cycles();
+				uint64_t steps = 0;
+
+				clock = BACKTEST_EPOCH_NS;
+				uint64_t end = BACKTEST_EPOCH_NS + duration_ns;
+				flow.begin(clock);
+
+				while(clock < end) {
+					flow.poll(clock, 1 << 20);
+					settle(flow, strategy);
+					steps++;
+
+					// next step on the grid that has something to do
+					uint64_t due = flow.nextDue();
+					uint64_t timer = strategy.nextTimer();
+					if(timer < due) due = timer;
+					uint64_t next = clock + config.step_ns;
+					if(due > next) next = (due >= end) ? end : clock + (due - clock + config.step_ns - 1) / config.step_ns * config.step_ns;
+					clock = next;
+				}
+
+				uint64_t wall_cycles = now_cycles() - wall_start;
+				BacktestResult r{};
+				r.simulated_ns = duration_ns;
+				r.wall_ns = static_cast<uint64_t>(static_cast<double>(wall_cycles) / get_cycles_per_ns());
+				r.steps = steps;
+				r.feed_events = feed_events;
+				r.trades = trades;
+				r.feed_hash = feed_hash;
+				return r;
+			}
+
+		private :
+
+			template<typename Flow, typename Strat>
+			inline void settle(Flow& flow, Strat& strategy) noexcept {
+				bool moved = true;
+				while(moved) {
+					moved = false;
+
+					while(StrategyOrders.getNextRead() != nullptr || FlowOrders.getNextRead() != nullptr || FlowCancels.getNextRead() != nullptr) {
+						Gateway.pollOrders();
+						while(LobOrders.getNextRead() != nullptr) Engine.readOrder(); // the gateway stalls on a full LOB queue
+						moved = true;
+					}
+					while(LobOrders.getNextRead() != nullptr) {
+						Engine.readOrder();
+						moved = true;
+					}
+					while(LobAcks.getNextRead() != nullptr) {
+						// an ack ring is full : its reader drains it below, the gateway would only retry
+						if(StrategyAcks.getNextWrite() == nullptr || FlowAcks.getNextWrite() == nullptr) break;
+						Gateway.pollAcknowledgement();
+						moved = true;
+					}
+
+					BroadcastElement* be;
+					while((be = Feed.getNextRead()) != nullptr) {
+						BroadcastElement* copy = StrategyFeed.getNextWrite();
+						if(copy == nullptr) break;
+						*copy = *be;
+						StrategyFeed.updateWrite();
+						hashEvent(*be);
+						Feed.updateRead();
+						moved = true;
+					}
+
+					if(strategy.pollAt(clock, 1 << 20) > 0) moved = true;
+
+					if(flow.poll(clock, 0) > 0) moved = true; // acks back to the flow, no new events
+				}
+			}
+
+			inline void hashEvent(const BroadcastElement& be) noexcept {
+				feed_events++;
+				if(be.type == 'T') trades++;
+
+				uint32_t price_bits;
+				static_assert(sizeof(price_bits) == sizeof(be.price), "float is 32 bit");
+				__builtin_memcpy(&price_bits, &be.price, sizeof(price_bits));
+				uint64_t fields[4] = {static_cast<uint64_t>(static_cast<uint8_t>(be.type)) << 8 | static_cast<uint8_t>(be.side),
+									  static_cast<uint32_t>(be.system_id), price_bits, static_cast<uint32_t>(be.quantity)};
+				for(uint64_t f : fields) {
+					feed_hash ^= f;
+					feed_hash *= 0x100000001b3ull;
+				}
+			}
+	};
+}
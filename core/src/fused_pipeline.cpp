@@ -0,0 +1,47 @@
+// fused pipeline ---> gateway and matching engine on one thread, the gateway calls the engine directly instead of going
+// through the LOB order queue. for hosts with few isolated cores : the gateway -> LOB queue -> engine hop (a cache line
+// written on one core and read on another, ~100 ns queue wait at p50) is gone, an order is translated and matched in one go.
+//
+// the topology is picked at compile time by the gateway's order sink (order_gateway.cpp), the gateway and engine code are the
+// same in both :
+//   PipelineGateway<false> = OrderGateway       : LOB queue, engine on its own core running matchingEngineLoop (split)
+//   PipelineGateway<true>  = FusedOrderGateway  : engine called from commit(), nothing runs the engine loop (fused)
+// the engine's acks still go through its ack ring (the engine routes acks by system id, one ring per gateway), in the fused
+// topology that ring is written and read by the same thread and the gateway empties it before it takes the next orders.
+// one order can still make more acks than the ring holds (a deep sweep, a mass cancel) : the engine then calls the gateway's
+// drain itself (MatchingEngine::setAckDrain) instead of spinning on a ring only it could empty.
+// one gateway per engine only : the engine is not thread safe, two fused gateways would call it from two threads.
+
+#pragma once
+
+#include <type_traits>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+
+#include "order_gateway.cpp"
+#include "matching_engine.cpp"
+
+namespace internal_lib {
+
+	// the order is built in a scratch slot and matched as soon as the gateway commits it, the engine never sees a full queue
+	struct DirectEngineSink {
+		static constexpr bool INLINE_ENGINE = true;
+
+		MatchingEngine* engine;
+		LOBOrder order{};
+
+		DirectEngineSink(MatchingEngine* me) noexcept : engine(me) {} // implicit : FusedOrderGateway(&laq, &soq, &mmoq, &engine)
+
+		inline LOBOrder* slot() noexcept { return &order; }
+		inline void commit() noexcept { engine->processOrder(order); }
+
+		// the gateway registers its ack drain once it is constructed (it must not move afterwards)
+		inline void attachAckDrain(void (*drain)(void*) noexcept, void* gateway) noexcept { engine->setAckDrain(drain, gateway); }
+	};
+
+	using FusedOrderGateway = BasicOrderGateway<DirectEngineSink>;
+
+	template<bool Fused>
+	using PipelineGateway = std::conditional_t<Fused, FusedOrderGateway, OrderGateway>;
+}
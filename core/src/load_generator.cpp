@@ -0,0 +1,245 @@
+// open loop load generator ---> drives a gateway order queue at a fixed target rate and measures end to end latency
+// (order queued -> ack back) from the INTENDED send time.
+//
+// a closed loop sender (AlphaServer) only sends the next order once the previous one got in, so when the pipeline backs up
+// it simply sends less and the orders it does not send never show up in the numbers (coordinated omission). here every
+// request has a slot on a TSC timeline (start + j * interval, or Poisson gaps with the same mean). a request that can not be
+// sent on time (queue full, generator descheduled) goes out as soon as possible but keeps its intended stamp, so the wait
+// shows up in its latency. the raw latency (from the actual send) is kept too, the gap between both is the omitted queueing.
+//
+// workload : one trader, passive creates (buys below 100, sells above, never crossing) and every create after the first
+// `window` cancels the one `window` creates back ---> about `window` orders rest, every request gets exactly one ack
+// ('C' create accepted, 'D' cancelled), so acks can be matched to requests by (status, order id). a refused request ('R', or 'K'
+// for a create the engine would not book) still answers it but is only counted, its turnaround is not the pipeline's latency.
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <atomic>
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	struct LoadResult {
+		double target_rate;         // requests per second
+		double achieved_rate;       // acks per second over the run (first intended send -> last ack)
+		uint64_t requests;
+		uint64_t acked;
+		uint64_t rejected;          // answered with 'R' / 'K', not in the latencies
+		double p50_ns;              // corrected (from the intended send)
+		double p99_ns;
+		double p999_ns;
+		double max_ns;
+		double raw_p99_ns;          // uncorrected (from the actual send)
+		double max_send_lag_ns;     // worst actual send behind schedule
+	};
+
+	class LoadGenerator {
+
+		private :
+
+			LFQueue<UserOrder>* OrderQueue;
+			LFQueue<UserAcknowledgement>* AckQueue;
+
+			short trader_id;
+			double cycles_per_ns;
+			int window = 1000;
+			bool poisson = false;
+
+			// schedule of the current run
+			uint64_t requests = 0;
+			uint64_t next_request = 0;
+			uint64_t next_intended = 0;
+			double interval_cycles = 0;
+			double carry = 0;                    // fractional cycles of the fixed interval
+			std::mt19937_64 rng{5};
+			std::exponential_distribution<double> gap{1.0};
+
+			// per order id : intended / actual send of its create and of its cancel
+			std::vector<uint64_t> create_intended, create_sent;
+			std::vector<uint64_t> cancel_intended, cancel_sent;
+
+			std::vector<uint64_t> Corrected_Latency;
+			std::vector<uint64_t> Raw_Latency;
+			uint64_t first_intended = 0;
+			uint64_t last_ack = 0;
+			uint64_t max_send_lag = 0;
+			uint64_t rejected = 0;
+
+		public :
+
+			LoadGenerator(LFQueue<UserOrder>* oq, LFQueue<UserAcknowledgement>* aq, short trader, double cpns)
+				: OrderQueue(oq), AckQueue(aq), trader_id(trader), cycles_per_ns(cpns) {}
+
+			LoadGenerator(const LoadGenerator&) = delete;
+			LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+			void setWindow(int resting) noexcept { window = (resting < 1) ? 1 : resting; }
+			void setPoisson(bool enabled) noexcept { poisson = enabled; }
+
+			// sizes everything for 'count' requests at 'rate' per second, the first one is due at 'start'. all allocation happens here.
+			// order ids restart at 0 : the gateway must have forgotten the previous run's orders (fresh gateway or all of them acked)
+			void begin(double rate, uint64_t count, uint64_t start) noexcept {
+				requests = count;
+				next_request = 0;
+				interval_cycles = cycles_per_ns * 1e9 / rate;
+				carry = 0;
+				gap = std::exponential_distribution<double>(1.0 / interval_cycles);
+				next_intended = start;
+				first_intended = start;
+				last_ack = start;
+				max_send_lag = 0;
+				rejected = 0;
+
+				size_t ids = static_cast<size_t>(count / 2 + window + 2);
+				create_intended.assign(ids, 0);
+				create_sent.assign(ids, 0);
+				cancel_intended.assign(ids, 0);
+				cancel_sent.assign(ids, 0);
+
+				Corrected_Latency.clear();
+				Raw_Latency.clear();
+				Corrected_Latency.reserve(count);
+				Raw_Latency.reserve(count);
+			}
+
+			// sends what is due by 'now' (at most max_sends), then takes the acks that arrived. returns requests sent
+			int poll(uint64_t now, int max_sends = 64) noexcept {
+				int sent = 0;
+				while(sent < max_sends && next_request < requests && next_intended <= now) {
+					UserOrder* o = OrderQueue->getNextWrite();
+					if(UNLIKELY(o == nullptr)) break; // behind schedule from here on, the intended stamps keep counting
+
+					uint64_t actual = now_cycles();
+					if(actual - next_intended > max_send_lag) max_send_lag = actual - next_intended;
+					writeRequest(o, next_request, next_intended, actual);
+					OrderQueue->updateWrite();
+
+					next_request++;
+					advanceSchedule();
+					sent++;
+				}
+				pollAcks();
+				return sent;
+			}
+
+			bool sendsDone() const noexcept { return next_request >= requests; }
+			bool done() const noexcept { return sendsDone() && Corrected_Latency.size() + rejected >= requests; }
+
+			// threaded use : rate per second, count requests, then waits for the acks (or terminate)
+			void run(double rate, uint64_t count, std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+				begin(rate, count, now_cycles());
+				while(!done() && !terminate.load(std::memory_order_acquire)) poll(now_cycles());
+
+				LoadResult r = result(rate);
+				std::cout << "[LOAD] target " << r.target_rate << "/s achieved " << r.achieved_rate << "/s , corrected p50 " << r.p50_ns
+						  << " ns p99 " << r.p99_ns << " ns p99.9 " << r.p999_ns << " ns max " << r.max_ns << " ns , raw p99 " << r.raw_p99_ns << " ns , rejected " << r.rejected << "\n";
+			}
+
+			LoadResult result(double target_rate) noexcept {
+				LoadResult r{};
+				r.target_rate = target_rate;
+				r.requests = next_request;
+				r.acked = Corrected_Latency.size();
+				r.rejected = rejected;
+				double span_ns = static_cast<double>(last_ack - first_intended) / cycles_per_ns;
+				r.achieved_rate = (span_ns > 0) ? static_cast<double>(r.acked) / (span_ns * 1e-9) : 0.0;
+				r.p50_ns = percentileNs(Corrected_Latency, 0.50);
+				r.p99_ns = percentileNs(Corrected_Latency, 0.99);
+				r.p999_ns = percentileNs(Corrected_Latency, 0.999);
+				r.max_ns = percentileNs(Corrected_Latency, 1.0);
+				r.raw_p99_ns = percentileNs(Raw_Latency, 0.99);
+				r.max_send_lag_ns = static_cast<double>(max_send_lag) / cycles_per_ns;
+				return r;
+			}
+
+			std::vector<uint64_t>& getCorrectedLatencies() noexcept { return Corrected_Latency; }
+			std::vector<uint64_t>& getRawLatencies() noexcept { return Raw_Latency; }
+			uint64_t getRejected() const noexcept { return rejected; }
+
+		private :
+
+			// request j : the first `window` are creates 0 .. window - 1, then creates (id window + k) and cancels (id k) alternate
+			inline void writeRequest(UserOrder* o, uint64_t j, uint64_t intended, uint64_t actual) noexcept {
+				uint64_t w = static_cast<uint64_t>(window);
+				bool cancel = j >= w && ((j - w) & 1) == 1;
+				int id = static_cast<int>(j < w ? j : (cancel ? (j - w) / 2 : w + (j - w) / 2));
+
+				bool buy = (id & 1) == 0;
+				o->arrived_cycle_count = intended; // the gateway measures from here too
+				o->order_id = id;
+				o->trader_id = trader_id;
+				o->order_type = buy ? 'b' : 's';
+				o->price = buy ? 99.0f - 0.1f * static_cast<float>(id % 50) : 101.0f + 0.1f * static_cast<float>(id % 50);
+				o->out_cycle_count = actual;
+
+				if(cancel) {
+					o->req_type = 'd';
+					o->quantity = 0;
+					cancel_intended[id] = intended;
+					cancel_sent[id] = actual;
+				} else {
+					o->req_type = 'c';
+					o->quantity = 1 + id % 100;
+					create_intended[id] = intended;
+					create_sent[id] = actual;
+				}
+			}
+
+			inline void advanceSchedule() noexcept {
+				if(poisson) {
+					next_intended += static_cast<uint64_t>(gap(rng));
+				} else {
+					carry += interval_cycles;
+					uint64_t whole = static_cast<uint64_t>(carry);
+					carry -= static_cast<double>(whole);
+					next_intended += whole;
+				}
+			}
+
+			inline void pollAcks() noexcept {
+				UserAcknowledgement* ack;
+				while((ack = AckQueue->getNextRead()) != nullptr) {
+					uint64_t now = now_cycles();
+					long long id = ack->order_id;
+					if(UNLIKELY(ack->status == 'R' || ack->status == 'K')) {
+						rejected++;
+						last_ack = now;
+					} else if(LIKELY(id >= 0 && static_cast<size_t>(id) < create_intended.size())) {
+						uint64_t intended = 0, actual = 0;
+						if(ack->status == 'D') {
+							intended = cancel_intended[id];
+							actual = cancel_sent[id];
+						} else if(ack->status == 'C') {
+							intended = create_intended[id];
+							actual = create_sent[id];
+						}
+						if(intended != 0) {
+							Corrected_Latency.push_back(now - intended);
+							Raw_Latency.push_back(now - actual);
+							last_ack = now;
+						}
+					}
+					AckQueue->updateRead();
+				}
+			}
+
+			inline double percentileNs(std::vector<uint64_t>& samples, double p) const noexcept {
+				if(samples.empty()) return 0.0;
+				size_t at = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+				std::nth_element(samples.begin(), samples.begin() + at, samples.end());
+				return static_cast<double>(samples[at]) / cycles_per_ns;
+			}
+	};
+}
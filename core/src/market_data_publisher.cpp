@@ -0,0 +1,281 @@
+// market data publisher ---> the only consumer of the engine's BroadcastQueue.
+//
+// turns BroadcastElements into the sequenced binary feed of market_data_protocol.h and sends it over UDP multicast and/or a
+// shared memory ring. elements are packed into the current packet as they are read, the packet goes out when it is full or
+// when the broadcast queue ran dry ---> a lone book change is never held back waiting for company, a burst shares packets.
+// an optional local queue gets a copy of every element for an in process consumer (AlphaServer), dropped if it is full so a
+// slow local reader never backs up into the engine.
+// trades ('T', one per fill) also feed the attached OHLCV/VWAP bar series (trade_bars.h), one per interval.
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+#include <new>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "market_data_protocol.h"
+#include "trade_bars.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	class MarketDataPublisher {
+
+		private :
+
+			LFQueue<BroadcastElement>* BroadcastQueue;
+			LFQueue<BroadcastElement>* LocalQueue = nullptr;
+
+			static constexpr int MAX_BAR_SERIES = 4;
+			TradeBars* Bars[MAX_BAR_SERIES] = {};
+			int bar_series = 0;
+
+			// udp multicast
+			int udp_fd = -1;
+
+			// shared memory ring
+			std::string shm_name;
+			MDShmRingHeader* ring = nullptr;
+			MDShmSlot* slots = nullptr;
+			uint32_t slot_mask = 0;
+
+			// packet being built
+			char packet[MD_MAX_DATAGRAM];
+			size_t packet_len = sizeof(MDPacketHeader);
+			uint64_t event_cycles[MD_MAX_PER_PACKET]; // engine stamps of the messages in the packet
+
+			uint32_t session;
+			uint64_t next_seq = 1;
+
+			int batch_size = 64;                       // elements per poll
+			uint64_t heartbeat_cycles = 0;             // 0 = no heartbeats
+			uint64_t last_send_cycle = 0;
+
+			std::vector<uint64_t> Publish_Latency;     // engine event -> packet handed to the transport
+
+			// stats
+			uint64_t packets = 0;
+			uint64_t messages = 0;
+			uint64_t heartbeats = 0;
+			uint64_t send_errors = 0;
+			uint64_t local_dropped = 0;
+
+		public :
+
+			explicit MarketDataPublisher(LFQueue<BroadcastElement>* bq) : BroadcastQueue(bq) {
+				session = static_cast<uint32_t>(now_cycles() >> 20); // any value that changes between runs
+				std::memset(packet, 0, sizeof(MDPacketHeader));
+				Publish_Latency.reserve(11000);
+			}
+
+			MarketDataPublisher(const MarketDataPublisher&) = delete;
+			MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+			~MarketDataPublisher() {
+				if(udp_fd != -1) ::close(udp_fd);
+				if(ring != nullptr) {
+					::munmap(ring, mdShmRingBytes(slot_mask + 1));
+					::shm_unlink(shm_name.c_str());
+				}
+			}
+
+			// multicast group on the given interface (loopback by default, ttl 0 keeps it on the host)
+			bool openMulticast(const char* group, uint16_t port, const char* interface = "127.0.0.1", int ttl = 0) noexcept {
+				udp_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+				if(udp_fd == -1) return false;
+
+				in_addr iface{};
+				if(::inet_pton(AF_INET, interface, &iface) != 1) return false;
+				unsigned char loop = 1;
+				unsigned char hops = static_cast<unsigned char>(ttl);
+				::setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+				::setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+				::setsockopt(udp_fd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops));
+
+				sockaddr_in dest{};
+				dest.sin_family = AF_INET;
+				dest.sin_port = htons(port);
+				if(::inet_pton(AF_INET, group, &dest.sin_addr) != 1) return false;
+				return ::connect(udp_fd, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)) == 0;
+			}
+
+			// creates (replaces) the shm object name ("/capitol_md"), slot_count is rounded up to a power of 2
+			bool openShmRing(const char* name, uint32_t slot_count) noexcept {
+				uint32_t count = 1;
+				while(count < slot_count) count <<= 1;
+
+				int fd = ::shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+				if(fd == -1) return false;
+				size_t bytes = mdShmRingBytes(count);
+				if(::ftruncate(fd, static_cast<off_t>(bytes)) != 0) { ::close(fd); return false; }
+
+				void* mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+				::close(fd);
+				if(mem == MAP_FAILED) return false;
+
+				shm_name = name;
+				ring = new (mem) MDShmRingHeader{};
+				slots = reinterpret_cast<MDShmSlot*>(static_cast<char*>(mem) + sizeof(MDShmRingHeader));
+				for(uint32_t s = 0; s < count; s++) new (&slots[s]) MDShmSlot{};
+
+				ring->slot_count = count;
+				ring->write_index.store(0, std::memory_order_relaxed);
+				slot_mask = count - 1;
+				std::atomic_thread_fence(std::memory_order_release);
+				ring->magic = MD_SHM_MAGIC; // readers wait for it before they trust slot_count
+				return true;
+			}
+
+			void setLocalFanout(LFQueue<BroadcastElement>* local) noexcept { LocalQueue = local; }
+
+			// false if MAX_BAR_SERIES are attached already
+			bool addTradeBars(TradeBars* bars) noexcept {
+				if(bar_series == MAX_BAR_SERIES) return false;
+				Bars[bar_series++] = bars;
+				return true;
+			}
+			void setBatchSize(int batch) noexcept { batch_size = (batch < 1) ? 1 : batch; }
+			void setHeartbeatCycles(uint64_t cycles) noexcept { heartbeat_cycles = cycles; }
+
+			// drains up to batch_size elements, returns how many it took
+			int poll() noexcept {
+				int n = 0;
+				BroadcastElement* be;
+				while(n < batch_size && (be = BroadcastQueue->getNextRead()) != nullptr) {
+					encode(*be);
+					if(LocalQueue != nullptr) fanOut(*be);
+					if(be->type == 'T') {
+						for(int b = 0; b < bar_series; b++) Bars[b]->onTrade(be->price, be->quantity, be->event_cycle);
+					}
+					BroadcastQueue->updateRead();
+					n++;
+				}
+
+				if(packet_len > sizeof(MDPacketHeader)) flush();
+				return n;
+			}
+
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				while(!terminate.load(std::memory_order_acquire)) {
+					if(poll() == 0 && heartbeat_cycles != 0 && now_cycles() - last_send_cycle > heartbeat_cycles) heartbeat();
+				}
+
+				std::this_thread::sleep_for(std::chrono::seconds(4));
+
+				std::cout << "[MARKET DATA PUBLISHER] packets : " << packets << " , messages : " << messages << " , heartbeats : " << heartbeats
+						  << " , send errors : " << send_errors << " , local dropped : " << local_dropped << "\n";
+
+				std::string mdpl = "Market Data Publish Latency (engine event -> wire)";
+				internal_lib::showBench(mdpl, Publish_Latency, internal_lib::get_cycles_per_ns());
+			}
+
+			// empty packet carrying the next sequence number
+			void heartbeat() noexcept {
+				send();
+				heartbeats++;
+			}
+
+			std::vector<uint64_t>& getPublishLatencies() noexcept { return Publish_Latency; }
+			uint64_t getPackets() const noexcept { return packets; }
+			uint64_t getMessages() const noexcept { return messages; }
+			uint64_t getSendErrors() const noexcept { return send_errors; }
+			uint64_t getLocalDropped() const noexcept { return local_dropped; }
+			uint32_t getSession() const noexcept { return session; }
+
+		private :
+
+			inline void encode(const BroadcastElement& be) noexcept {
+				char type = (be.type == 'N') ? 'A' : be.type;
+				size_t len = (type == 'D') ? sizeof(MDDeleteMessage) : sizeof(MDOrderMessage);
+				if(UNLIKELY(packet_len + len > MD_MAX_DATAGRAM)) flush();
+
+				char* at = packet + packet_len;
+				if(type == 'D') {
+					MDDeleteMessage* msg = reinterpret_cast<MDDeleteMessage*>(at);
+					msg->type = 'D';
+					msg->side = be.side;
+					msg->order_ref = be.system_id;
+				} else {
+					MDOrderMessage* msg = reinterpret_cast<MDOrderMessage*>(at);
+					msg->type = type;
+					msg->side = be.side;
+					msg->order_ref = be.system_id;
+					msg->price = be.price;
+					msg->quantity = be.quantity;
+				}
+
+				event_cycles[pendingCount()] = be.event_cycle;
+				packet_len += len;
+				reinterpret_cast<MDPacketHeader*>(packet)->count++;
+			}
+
+			inline size_t pendingCount() const noexcept {
+				return reinterpret_cast<const MDPacketHeader*>(packet)->count;
+			}
+
+			inline void fanOut(const BroadcastElement& be) noexcept {
+				BroadcastElement* w = LocalQueue->getNextWrite();
+				if(UNLIKELY(w == nullptr)) {
+					local_dropped++;
+					return;
+				}
+				*w = be;
+				LocalQueue->updateWrite();
+			}
+
+			inline void flush() noexcept {
+				size_t count = pendingCount();
+				send();
+
+				uint64_t sent = last_send_cycle;
+				for(size_t m = 0; m < count; m++) Publish_Latency.push_back(sent - event_cycles[m]);
+				messages += count;
+				packets++;
+			}
+
+			// writes the header for whatever is in the packet, hands it to every transport and starts the next one
+			inline void send() noexcept {
+				MDPacketHeader* header = reinterpret_cast<MDPacketHeader*>(packet);
+				header->length = static_cast<uint16_t>(packet_len);
+				header->version = MD_PROTOCOL_VERSION;
+				header->session = session;
+				header->first_seq = next_seq;
+
+				if(udp_fd != -1 && UNLIKELY(::send(udp_fd, packet, packet_len, MSG_DONTWAIT) != static_cast<ssize_t>(packet_len))) send_errors++;
+				if(ring != nullptr) publishToRing();
+
+				last_send_cycle = now_cycles();
+				next_seq += header->count;
+				header->count = 0;
+				packet_len = sizeof(MDPacketHeader);
+			}
+
+			inline void publishToRing() noexcept {
+				uint64_t n = ring->write_index.load(std::memory_order_relaxed);
+				MDShmSlot& slot = slots[n & slot_mask];
+
+				slot.stamp.store(2 * n + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				slot.length = static_cast<uint16_t>(packet_len);
+				std::memcpy(slot.data, packet, packet_len);
+				slot.stamp.store(2 * n + 2, std::memory_order_release);
+
+				ring->write_index.store(n + 1, std::memory_order_release);
+			}
+	};
+}
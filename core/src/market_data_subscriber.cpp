@@ -0,0 +1,203 @@
+// bundled market data feed receiver (loopback testing, benchmarks, simple tools).
+// reads the feed of market_data_publisher.cpp from a multicast group or from the shared memory ring, walks the packets and
+// hands every message with its sequence number to the caller. gaps are counted, never recovered (no retransmission yet).
+// non blocking, driven by poll() from the caller's own loop.
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "market_data_protocol.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	class MarketDataSubscriber {
+
+		private :
+
+			int udp_fd = -1;
+
+			const MDShmRingHeader* ring = nullptr;
+			const MDShmSlot* slots = nullptr;
+			size_t ring_bytes = 0;
+			uint64_t read_index = 0;    // next ring packet we want
+
+			char buffer[MD_MAX_DATAGRAM];
+
+			uint32_t session = 0;
+			uint64_t expected_seq = 0;  // next sequence we want, taken from the first packet of a (new) session
+
+			// stats
+			uint64_t packets = 0;
+			uint64_t messages = 0;
+			uint64_t gap_messages = 0;  // lost
+			uint64_t duplicates = 0;    // already seen, skipped
+			uint64_t bad_packets = 0;
+			uint64_t overruns = 0;      // lapped by the ring writer
+
+		public :
+
+			MarketDataSubscriber() = default;
+			MarketDataSubscriber(const MarketDataSubscriber&) = delete;
+			MarketDataSubscriber& operator=(const MarketDataSubscriber&) = delete;
+
+			~MarketDataSubscriber() {
+				if(udp_fd != -1) ::close(udp_fd);
+				if(ring != nullptr) ::munmap(const_cast<MDShmRingHeader*>(ring), ring_bytes);
+			}
+
+			bool joinMulticast(const char* group, uint16_t port, const char* interface = "127.0.0.1", int rcvbuf_bytes = 8 << 20) noexcept {
+				udp_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+				if(udp_fd == -1) return false;
+
+				int reuse = 1;
+				::setsockopt(udp_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+				::setsockopt(udp_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf_bytes, sizeof(rcvbuf_bytes));
+
+				sockaddr_in addr{};
+				addr.sin_family = AF_INET;
+				addr.sin_port = htons(port);
+				if(::inet_pton(AF_INET, group, &addr.sin_addr) != 1) return false;
+				if(::bind(udp_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return false;
+
+				ip_mreq mreq{};
+				mreq.imr_multiaddr = addr.sin_addr;
+				if(::inet_pton(AF_INET, interface, &mreq.imr_interface) != 1) return false;
+				return ::setsockopt(udp_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+			}
+
+			// read only mapping of the publisher's ring, starts with the next packet the publisher writes
+			bool attachShmRing(const char* name) noexcept {
+				int fd = ::shm_open(name, O_RDONLY, 0);
+				if(fd == -1) return false;
+
+				uint32_t head[2]; // magic, slot_count
+				if(::pread(fd, head, sizeof(head), 0) != static_cast<ssize_t>(sizeof(head)) || head[0] != MD_SHM_MAGIC) {
+					::close(fd);
+					return false;
+				}
+
+				ring_bytes = mdShmRingBytes(head[1]);
+				void* mem = ::mmap(nullptr, ring_bytes, PROT_READ, MAP_SHARED, fd, 0);
+				::close(fd);
+				if(mem == MAP_FAILED) return false;
+
+				ring = static_cast<const MDShmRingHeader*>(mem);
+				slots = reinterpret_cast<const MDShmSlot*>(static_cast<const char*>(mem) + sizeof(MDShmRingHeader));
+				read_index = ring->write_index.load(std::memory_order_acquire);
+				return true;
+			}
+
+			// on_message(const char* msg, uint64_t seq) for every new message, returns the number of packets read
+			template<typename Handler>
+			int poll(Handler&& on_message, int max_packets = 64) noexcept {
+				int n = 0;
+				while(n < max_packets) {
+					size_t len = (ring != nullptr) ? readRing() : readSocket();
+					if(len == 0) break;
+					onPacket(buffer, len, on_message);
+					n++;
+				}
+				return n;
+			}
+
+			uint64_t getPackets() const noexcept { return packets; }
+			uint64_t getMessages() const noexcept { return messages; }
+			uint64_t getGapMessages() const noexcept { return gap_messages; }
+			uint64_t getDuplicates() const noexcept { return duplicates; }
+			uint64_t getBadPackets() const noexcept { return bad_packets; }
+			uint64_t getOverruns() const noexcept { return overruns; }
+			uint64_t getExpectedSeq() const noexcept { return expected_seq; }
+
+		private :
+
+			size_t readSocket() noexcept {
+				if(udp_fd == -1) return 0;
+				ssize_t got = ::recv(udp_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+				return (got > 0) ? static_cast<size_t>(got) : 0;
+			}
+
+			// copies ring packet read_index out under its slot lock. lapped ---> jump to the oldest packet still in the ring,
+			// the skipped messages show up as a sequence gap.
+			size_t readRing() noexcept {
+				uint32_t slot_count = ring->slot_count;
+				while(true) {
+					uint64_t written = ring->write_index.load(std::memory_order_acquire);
+					if(read_index >= written) return 0;
+					if(UNLIKELY(written - read_index > slot_count)) {
+						read_index = written - slot_count;
+						overruns++;
+					}
+
+					const MDShmSlot& slot = slots[read_index & (slot_count - 1)];
+					uint64_t before = slot.stamp.load(std::memory_order_acquire);
+					if(UNLIKELY(before != 2 * read_index + 2)) { // being rewritten for a later packet
+						overruns++;
+						read_index++;
+						continue;
+					}
+
+					size_t len = slot.length;
+					if(UNLIKELY(len > MD_MAX_DATAGRAM)) len = MD_MAX_DATAGRAM;
+					std::memcpy(buffer, slot.data, len);
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if(UNLIKELY(slot.stamp.load(std::memory_order_relaxed) != before)) {
+						overruns++;
+						read_index++;
+						continue;
+					}
+
+					read_index++;
+					return len;
+				}
+			}
+
+			template<typename Handler>
+			void onPacket(const char* data, size_t len, Handler& on_message) noexcept {
+				const MDPacketHeader* header = reinterpret_cast<const MDPacketHeader*>(data);
+				if(UNLIKELY(len < sizeof(MDPacketHeader) || header->version != MD_PROTOCOL_VERSION || header->length != len)) {
+					bad_packets++;
+					return;
+				}
+				packets++;
+
+				if(UNLIKELY(header->session != session)) { // first packet or publisher restart
+					session = header->session;
+					expected_seq = header->first_seq;
+				}
+
+				uint64_t seq = header->first_seq;
+				if(UNLIKELY(seq > expected_seq)) gap_messages += seq - expected_seq;
+
+				const char* at = data + sizeof(MDPacketHeader);
+				const char* end = data + len;
+				for(uint8_t m = 0; m < header->count; m++, seq++) {
+					size_t msg_len = (at < end) ? mdMessageLength(*at) : 0;
+					if(UNLIKELY(msg_len == 0 || at + msg_len > end)) {
+						bad_packets++;
+						break;
+					}
+
+					if(LIKELY(seq >= expected_seq)) {
+						on_message(at, seq);
+						messages++;
+					} else {
+						duplicates++;
+					}
+					at += msg_len;
+				}
+
+				if(seq > expected_seq) expected_seq = seq;
+			}
+	};
+}
@@ -1 +1,338 @@
-// this component will read market data from a real stock/trade day and feed those orders to test our strategy against real world.
\ No newline at end of file
+// market maker traffic simulator ---> feeds the gateway's MMOrderQueue (and its MM cancel lane) like the 99 market makers would.
+//
+// one MarketMaker object = one generator thread, quoting for a contiguous block of trader ids. several generators run side by
+// side, each on its own SPSC lanes into its own gateway (every gateway owns an id slice, see system_id_allocator.h).
+//
+// traffic model :
+//   - events are a Poisson process (exponential gaps at arrival_rate per second). the schedule is open loop : a generator that
+//     falls behind sends back to back until it caught up, it never stretches the gaps.
+//   - every trader keeps a ladder of ladder_levels quotes per side around a common mid, rung k at mid -/+ (half_spread + k * ladder_step).
+//   - the mid is a random walk of mid_tick every drift_interval_ns. all generators derive it from the same seed and epoch so they
+//     agree on it without sharing anything, quotes left behind by the drift go stale and get hit by the other side's new quotes.
+//   - each event hits one rung of one trader at random. an empty rung gets a new quote ('c'), a live one is pulled ('d') with
+//     cancel_ratio, otherwise re-priced to its rung / re-sized ('u'). so new quotes only refill what cancels and fills emptied,
+//     and the share of cancels vs replaces is what the config sets (the realized mix is reported).
+//   - fills come back as acks (setAckQueue + OrderGateway::setAckRoute for every trader of the block), a fully filled or
+//     killed or refused quote frees its rung. a refused replace does not : the quote still rests as it was, the rung goes
+//     back to that price / size.
+//
+// order ids encode the rung : order_id = rung_seq * rung_count + rung, so an ack maps straight back to its rung, an ack for an
+// older order of that rung is ignored.
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <atomic>
+#include <climits>
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	struct MarketMakerConfig {
+		double arrival_rate = 200000.0;     // events per second per generator
+		double cancel_ratio = 0.3;          // share of the events on a live quote that pull it, the rest re-price / re-size it
+
+		int ladder_levels = 5;              // rungs per side per trader
+		float ladder_step = 0.1f;           // price distance between rungs
+		float half_spread = 0.1f;           // best rung distance from the mid
+		int min_quantity = 1;
+		int max_quantity = 100;
+
+		float start_mid = 130.0f;
+		float mid_tick = 0.1f;              // random walk step
+		uint64_t drift_interval_ns = 2000000;
+		float price_lo = 1.0f;              // the mid stays inside [price_lo, price_hi] with the whole ladder
+		float price_hi = 999.0f;
+
+		uint64_t seed = 1;                  // order flow seed (per generator it is mixed with the first trader id)
+		uint64_t mid_seed = 7;              // must be the same for all generators
+	};
+
+	class MarketMaker {
+
+		private :
+
+			struct Rung {
+				int order_id = -1;      // -1 = nothing live
+				int remaining = 0;      // as far as we know (fills arrive as acks)
+				float price = 0;
+				float rest_price = 0;   // what the book holds if the replace in flight is refused (one replace in flight)
+				int rest_remaining = 0;
+				uint32_t seq = 0;       // orders this rung has carried
+			};
+
+			MarketMakerConfig config;
+
+			LFQueue<UserOrder>* OrderQueue;
+			LFQueue<UserOrder>* CancelQueue;                // nullptr = cancels / replaces share OrderQueue
+			LFQueue<UserAcknowledgement>* AckQueue = nullptr;
+
+			short first_trader;
+			int trader_count;
+			int rungs_per_trader;
+			int rung_count;
+			uint32_t max_seq;
+
+			std::vector<Rung> rungs;
+			int live_quotes = 0;
+
+			std::mt19937_64 rng;
+			std::exponential_distribution<double> gap;   // in cycles
+			std::uniform_real_distribution<double> unit{0.0, 1.0};
+
+			// shared mid (same walk in every generator)
+			std::mt19937_64 mid_rng;
+			float mid;
+			uint64_t epoch_cycle = 0;
+			uint64_t drift_cycles;
+			uint64_t mid_steps = 0;
+
+			uint64_t next_event_cycle = 0;
+
+			// stats
+			uint64_t events = 0;
+			uint64_t creates = 0;
+			uint64_t cancels = 0;
+			uint64_t replaces = 0;
+			uint64_t fills = 0;
+			uint64_t filled_quantity = 0;
+			uint64_t rejects = 0;
+			uint64_t dropped = 0;            // lane full, event lost (state unchanged)
+			uint64_t max_lag_cycles = 0;     // worst delay of an event behind its schedule
+
+		public :
+
+			MarketMaker(const MarketMakerConfig& cfg,
+						short first_trader_id,
+						int traders,
+						LFQueue<UserOrder>* mmoq,
+						LFQueue<UserOrder>* mm_cancels,
+						double cycles_per_ns)
+						:
+						config(cfg),
+						OrderQueue(mmoq),
+						CancelQueue(mm_cancels),
+						first_trader(first_trader_id),
+						trader_count(traders < 1 ? 1 : traders),
+						rng(cfg.seed * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(first_trader_id)),
+						gap(cfg.arrival_rate / (cycles_per_ns * 1e9)),
+						mid_rng(cfg.mid_seed),
+						mid(cfg.start_mid)
+						{
+				if(config.ladder_levels < 1) config.ladder_levels = 1;
+				if(config.max_quantity < config.min_quantity) config.max_quantity = config.min_quantity;
+
+				rungs_per_trader = 2 * config.ladder_levels;
+				rung_count = trader_count * rungs_per_trader;
+				max_seq = static_cast<uint32_t>(INT_MAX / rung_count);
+				drift_cycles = static_cast<uint64_t>(static_cast<double>(config.drift_interval_ns) * cycles_per_ns);
+				if(drift_cycles == 0) drift_cycles = 1;
+
+				rungs.resize(rung_count);
+			}
+
+			MarketMaker(const MarketMaker&) = delete;
+			MarketMaker& operator=(const MarketMaker&) = delete;
+
+			// where this generator's fills come back (same queue for all its traders : one gateway writes, this thread reads)
+			void setAckQueue(LFQueue<UserAcknowledgement>* acks) noexcept { AckQueue = acks; }
+
+			// cycle at which the mid walk starts, must be the same for all generators
+			void setEpoch(uint64_t cycle) noexcept { epoch_cycle = cycle; }
+
+			short getFirstTrader() const noexcept { return first_trader; }
+			int getTraderCount() const noexcept { return trader_count; }
+
+			// starts the event schedule (and the mid walk, unless setEpoch() was called) at 'now'
+			void begin(uint64_t now) noexcept {
+				if(epoch_cycle == 0) epoch_cycle = now;
+				next_event_cycle = now;
+			}
+
+			// due events up to 'now' (open loop, at most max_events per call so acks keep flowing while catching up),
+			// returns how many were sent. begin() first
+			int poll(uint64_t now, int max_events = 64) noexcept {
+				if(AckQueue != nullptr) pollAcks();
+
+				int sent = 0;
+				while(now >= next_event_cycle && sent < max_events) {
+					uint64_t lag = now - next_event_cycle;
+					if(lag > max_lag_cycles) max_lag_cycles = lag;
+
+					advanceMid(next_event_cycle);
+					step();
+					next_event_cycle += static_cast<uint64_t>(gap(rng)) + 1;
+					sent++;
+				}
+				return sent;
+			}
+
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				uint64_t started = now_cycles();
+				begin(started);
+
+				while(!terminate.load(std::memory_order_acquire)) {
+					poll(now_cycles());
+				}
+
+				double cpns = get_cycles_per_ns();
+				printStats(static_cast<double>(now_cycles() - started) / cpns, cpns);
+			}
+
+			void printStats(double elapsed_ns, double cpns) const noexcept {
+				double n = (events > 0) ? static_cast<double>(events) : 1.0;
+				std::cout << "[MARKET MAKER " << first_trader << "-" << (first_trader + trader_count - 1) << "] events : " << events
+						  << " (" << static_cast<double>(events) / (elapsed_ns * 1e-9) << "/s, target " << config.arrival_rate << "/s)\n"
+						  << "  creates " << creates / n * 100 << "% , cancels " << cancels / n * 100 << "% , replaces " << replaces / n * 100
+						  << "% , dropped " << dropped << " , fills " << fills << " (" << filled_quantity << " lots) , rejects " << rejects
+						  << " , live quotes " << live_quotes << "/" << rung_count << " , worst lag " << max_lag_cycles / cpns << " ns\n";
+			}
+
+			uint64_t getEvents() const noexcept { return events; }
+			uint64_t getCreates() const noexcept { return creates; }
+			uint64_t getCancels() const noexcept { return cancels; }
+			uint64_t getReplaces() const noexcept { return replaces; }
+			uint64_t getFills() const noexcept { return fills; }
+			uint64_t getRejects() const noexcept { return rejects; }
+			uint64_t getDropped() const noexcept { return dropped; }
+			uint64_t getMaxLagCycles() const noexcept { return max_lag_cycles; }
+			uint64_t nextDue() const noexcept { return next_event_cycle; }
+			int getLiveQuotes() const noexcept { return live_quotes; }
+			float getMid() const noexcept { return mid; }
+
+		private :
+
+			// one event
+			inline void step() noexcept {
+				events++;
+				int r = static_cast<int>(rng() % static_cast<uint64_t>(rung_count));
+				Rung& rung = rungs[r];
+
+				if(rung.order_id == -1) {
+					uint32_t seq = (rung.seq + 1 >= max_seq) ? 0 : rung.seq + 1;
+					float price = rungPrice(r);
+					int quantity = drawQuantity();
+
+					rung.order_id = static_cast<int>(seq) * rung_count + r; // send() reads it
+					if(LIKELY(send(r, 'c', price, quantity))) {
+						rung.seq = seq;
+						rung.price = price;
+						rung.remaining = quantity;
+						live_quotes++;
+						creates++;
+					} else {
+						rung.order_id = -1;
+					}
+				} else if(unit(rng) < config.cancel_ratio) {
+					if(LIKELY(send(r, 'd', rung.price, 0))) {
+						setIdle(r);
+						cancels++;
+					}
+				} else {
+					float price = rungPrice(r);
+					int quantity = drawQuantity();
+					if(price == rung.price && quantity == rung.remaining) quantity = (quantity < config.max_quantity) ? quantity + 1 : quantity - 1;
+					if(LIKELY(send(r, 'u', price, quantity))) {
+						rung.rest_price = rung.price;
+						rung.rest_remaining = rung.remaining;
+						rung.price = price;
+						rung.remaining = quantity;
+						replaces++;
+					}
+				}
+			}
+
+			inline bool send(int r, char req_type, float price, int quantity) noexcept {
+				LFQueue<UserOrder>* lane = (req_type != 'c' && CancelQueue != nullptr) ? CancelQueue : OrderQueue;
+				UserOrder* o = lane->getNextWrite();
+				if(UNLIKELY(o == nullptr)) {
+					dropped++;
+					return false;
+				}
+
+				o->arrived_cycle_count = now_cycles();
+				o->order_id = rungs[r].order_id;
+				o->trader_id = static_cast<short>(first_trader + r / rungs_per_trader);
+				o->order_type = isBuyRung(r) ? 'b' : 's';
+				o->req_type = req_type;
+				o->price = price;
+				o->quantity = quantity;
+				o->out_cycle_count = o->arrived_cycle_count;
+				lane->updateWrite();
+				return true;
+			}
+
+			inline void pollAcks() noexcept {
+				UserAcknowledgement* ack;
+				while((ack = AckQueue->getNextRead()) != nullptr) {
+					if(LIKELY(ack->order_id >= 0)) {
+						int r = static_cast<int>(ack->order_id % rung_count);
+						Rung& rung = rungs[r];
+						if(rung.order_id == ack->order_id) {
+							if(ack->status == 'T') {
+								fills++;
+								filled_quantity += static_cast<uint64_t>(ack->quantity);
+								rung.remaining -= ack->quantity;
+								rung.rest_remaining -= ack->quantity;
+								if(rung.remaining <= 0) setIdle(r);
+							} else if(ack->status == 'K' || (ack->status == 'R' && ack->req_type == 'c')) {
+								rejects++;
+								setIdle(r);
+							} else if(ack->status == 'R') {
+								// refused replace : the quote rests untouched, next requote goes out as a 'u' again
+								rejects++;
+								rung.price = rung.rest_price;
+								rung.remaining = rung.rest_remaining;
+								if(rung.remaining <= 0) setIdle(r);
+							}
+						}
+					}
+					AckQueue->updateRead();
+				}
+			}
+
+			// rungs of a trader : [0, levels) bids, [levels, 2 * levels) asks, best first
+			inline bool isBuyRung(int r) const noexcept { return (r % rungs_per_trader) < config.ladder_levels; }
+
+			inline float rungPrice(int r) const noexcept {
+				int level = (r % rungs_per_trader) % config.ladder_levels;
+				float offset = config.half_spread + static_cast<float>(level) * config.ladder_step;
+				float price = isBuyRung(r) ? mid - offset : mid + offset;
+				return std::round(price * 10.0f) * 0.1f; // engine price quantum
+			}
+
+			inline int drawQuantity() noexcept {
+				return config.min_quantity + static_cast<int>(rng() % static_cast<uint64_t>(config.max_quantity - config.min_quantity + 1));
+			}
+
+			// walk the mid up to 'cycle', same steps in every generator
+			inline void advanceMid(uint64_t cycle) noexcept {
+				if(UNLIKELY(cycle < epoch_cycle)) return;
+				uint64_t target = (cycle - epoch_cycle) / drift_cycles;
+				float reach = config.half_spread + static_cast<float>(config.ladder_levels) * config.ladder_step;
+				while(mid_steps < target) {
+					float next = (mid_rng() & 1) ? mid + config.mid_tick : mid - config.mid_tick;
+					if(next - reach >= config.price_lo && next + reach <= config.price_hi) mid = next;
+					mid_steps++;
+				}
+			}
+
+			inline void setIdle(int r) noexcept {
+				rungs[r].order_id = -1;
+				rungs[r].remaining = 0;
+				live_quotes--;
+			}
+	};
+}
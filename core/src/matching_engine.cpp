@@ -2,6 +2,9 @@
 
 #include "lf_queue.h"
 #include "lob_structs.h"
+#include "conflated_book.h"
+#include "top_of_book.h"
+#include "logger.h"
 #include "benchmark_utility.h"
 
 
@@ -16,15 +19,29 @@ namespace internal_lib {
 
         private : 
 
-        internal_lib::LFQueue<internal_lib::LOBOrder>* LobOrderQueue; 
-        internal_lib::LFQueue<internal_lib::LOBAcknowledgement>* LobAckQueue; 
+        // one order/ack queue pair per order gateway. orders are fanned in round robin (like the logger does with its producers),
+        // acks are routed back to the gateway that owns the system id (top bits of the id slot, see system_id_allocator.h).
+        std::vector<internal_lib::LFQueue<internal_lib::LOBOrder>*> LobOrderQueues;
+        std::vector<internal_lib::LFQueue<internal_lib::LOBAcknowledgement>*> LobAckQueues;
+        size_t next_input = 0;
+        int partition_shift;
+
+        internal_lib::LFQueue<internal_lib::LOBOrder>* LobOrderQueue; // the input being served by the current readOrder()
 
         internal_lib::LFQueue<internal_lib::BroadcastElement>* BroadcastQueue; // we keep it only incremental, as snapshotting is cmplex logic.
         // need to create this structure in lob_structs.h
 
+        // conflated level feed (optional) : aggregate per price level overwritten in place for readers that can not keep up with
+        // the incremental stream. nullptr = off.
+        internal_lib::ConflatedBook* ConflatedLevels = nullptr;
+
+        // seqlock BBO + depth-10 page for in process readers (optional), fed from the same level changes. nullptr = off.
+        internal_lib::TopOfBook* TopBook = nullptr;
+
 
         internal_lib::LimitedOrderBook<true> BuyOrderBook; // it has it's Own LUT
         internal_lib::LimitedOrderBook<false> SellOrderBook; // it has it's own LUT
+        float price_limit; // max_price_ticks + 1 : price * 10 of a create / update must stay below it to land on a book row
 
 
         std::vector<uint64_t> Queue_Wait_Time;
@@ -33,6 +50,21 @@ namespace internal_lib {
         std::vector<uint64_t> Matching_Engine_Throughput; // time between 2 consecutive successful reads = true throughput
         uint64_t last_read_cycle = 0; // cycle stamp of previous successful read
 
+        // lookahead prefetch : while order i is processed, orders i+1..i+k are already sitting in LobOrderQueue.
+        // the order at distance k gets its LUT slot prefetched, the order at distance k/2 (whose LUT slot was pulled k/2 reads ago)
+        // gets its book row entry prefetched ---> by the time we dispatch them their cache misses are already paid. 0 disables it.
+        size_t prefetch_lookahead = 8;
+
+        // fused topology (fused_pipeline.cpp) : the gateway that empties the ack rings runs on this thread, inside processOrder.
+        // a full ring is then emptied through this hook instead of waiting for a drain that can never come. nullptr = split, wait
+        void (*ack_drain)(void*) noexcept = nullptr;
+        void* ack_drain_ctx = nullptr;
+        uint64_t broadcast_dropped = 0; // incremental changes lost to a full broadcast queue
+
+        // accept / fill / cancel / reject records into the logger's engine queue (optional, see attachLogger)
+        internal_lib::LogProducer Log{internal_lib::ComponentId::LOB_ENGINE};
+        uint64_t event_stamp = 0; // pickup stamp of the order being processed, the time stamp of its records
+
 
         public : 
 
@@ -44,13 +76,30 @@ namespace internal_lib {
             LFQueue<internal_lib::LOBOrder>* req_q,
             LFQueue<internal_lib::LOBAcknowledgement>* ack_q, // Corrected type to LOBAcknowledgement
             LFQueue<internal_lib::BroadcastElement>* brdcst_q // Corrected type to BroadcastElement
-        ) : LobOrderQueue(req_q),
-            LobAckQueue(ack_q),
+        ) : MatchingEngine(max_price_ticks, max_entries_per_price,
+                           std::vector<LFQueue<internal_lib::LOBOrder>*>{req_q},
+                           std::vector<LFQueue<internal_lib::LOBAcknowledgement>*>{ack_q},
+                           brdcst_q) {}
+
+        // multi gateway setup : req_qs[g] / ack_qs[g] belong to gateway g, gateway count must be a power of 2
+        MatchingEngine(
+            size_t max_price_ticks,
+            size_t max_entries_per_price,
+            std::vector<LFQueue<internal_lib::LOBOrder>*> req_qs,
+            std::vector<LFQueue<internal_lib::LOBAcknowledgement>*> ack_qs,
+            LFQueue<internal_lib::BroadcastElement>* brdcst_q
+        ) : LobOrderQueues(std::move(req_qs)),
+            LobAckQueues(std::move(ack_qs)),
+            partition_shift(systemIdPartitionShift(static_cast<int>(LobOrderQueues.size()))),
+            LobOrderQueue(LobOrderQueues[0]),
             BroadcastQueue(brdcst_q),
 
             BuyOrderBook(max_price_ticks, max_entries_per_price),
             SellOrderBook(max_price_ticks, max_entries_per_price)
             {
+                ASSERT(!LobOrderQueues.empty() && LobOrderQueues.size() == LobAckQueues.size(), " one order queue and one ack queue per gateway ");
+                ASSERT((LobOrderQueues.size() & (LobOrderQueues.size() - 1)) == 0, " gateway count must be a power of 2 ");
+                price_limit = static_cast<float>(max_price_ticks + 1);
 
                 Queue_Wait_Time.reserve(11000);
                 Matching_Engine_Processing_Time.reserve(11000);
@@ -95,6 +144,12 @@ namespace internal_lib {
 
         void readOrder() noexcept { // this will read from queue
             // step 1 
+            // pick the gateway input to serve this round (round robin, single gateway = always the same queue)
+            if(LobOrderQueues.size() > 1) {
+                LobOrderQueue = LobOrderQueues[next_input];
+                next_input = (next_input + 1) & (LobOrderQueues.size() - 1);
+            }
+
             // read from LobOrderQueue
 
             LOBOrder* order = LobOrderQueue->getNextRead(); // i would say I need to do somethign such that we only maintain a pointer and do not copy the order, since the read head wont move 
@@ -105,6 +160,8 @@ namespace internal_lib {
                 return ;
             } 
 
+            if(LIKELY(prefetch_lookahead != 0)) prefetchAhead();
+
             uint64_t arrived_at_lob = now_cycles(); // nanosecond timestamp when it got out of queue
 
             Queue_Wait_Time.push_back(arrived_at_lob - order->out_cycle_count); // time it got out of queue - time ewhen this was pushed into the queue
@@ -115,33 +172,98 @@ namespace internal_lib {
             }
             last_read_cycle = arrived_at_lob;
 
+            processOrder(*order);
+
+            // total time this order spent inside = order_processiung_complete - order->arrived_at ===> the meoment it got popped out at queue ---. the meoment it is done processing
+            // now update the read. 
+            LobOrderQueue->updateRead();
+
+        }
+
+        // one order, matched and acked. readOrder() calls it on the head of the LOB queue, a fused pipeline's gateway calls it
+        // directly on its own thread (DirectEngineSink, fused_pipeline.cpp) : no LOB queue, no queue wait
+        inline void processOrder(LOBOrder& order) noexcept {
             compiler_barrier();
             uint64_t order_arrived_at = now_cycles();
             compiler_barrier();
+            event_stamp = order_arrived_at;
 
             uint64_t order_processing_complete;
 
-            bool is_buy = ((order->order_type == 'b') ? true : false); // Assuming 'side' is the member based on previous context
-            if(order->req_type == 'c') {
+            bool is_buy = ((order.order_type == 'b') ? true : false); // Assuming 'side' is the member based on previous context
+            if(UNLIKELY(order.req_type == 'm')) {
+                // mass cancel carries no system id, order_type is the side to clear ('b', 's' or '*')
+                order_processing_complete = massCancelHandler(order);
+            } else if(UNLIKELY(order.system_id < 0)) {
+                // gateways reject unresolved ids themselves, this is only a guard so a bad id never indexes the book
+                compiler_barrier();
+                order_processing_complete = now_cycles();
+            } else if(UNLIKELY((order.req_type == 'c' || order.req_type == 'u') && !priceInBook(order.price))) {
+                // inf / nan or a price past the last tick would index past the book rows, whoever sent it (session, in process, udp)
+                order_processing_complete = priceRejectHandler(order, is_buy);
+            } else if(order.req_type == 'c') {
                 // call createOrderHandler
-                order_processing_complete = createOrderHandler(*order, is_buy); // pass by reference 
-            } else if(order->req_type == 'u') {
+                order_processing_complete = createOrderHandler(order, is_buy); // pass by reference 
+            } else if(order.req_type == 'u') {
                 // call updateOrderHandler
-                order_processing_complete = updateHandler(*order, is_buy);
+                order_processing_complete = updateHandler(order, is_buy);
             } else {
                 // call delete orderHandler
-                order_processing_complete = deleteHandler(*order, is_buy);
+                order_processing_complete = deleteHandler(order, is_buy);
             }
 
             Matching_Engine_Processing_Time.push_back(order_processing_complete - order_arrived_at);
-            Tick_To_Trade_Time.push_back(order_processing_complete - order->arrived_cycle_count);
+            Tick_To_Trade_Time.push_back(order_processing_complete - order.arrived_cycle_count);
+        }
 
-            // total time this order spent inside = order_processiung_complete - order->arrived_at ===> the meoment it got popped out at queue ---. the meoment it is done processing
-            // now update the read. 
-            LobOrderQueue->updateRead();
+        void prefetchAhead() noexcept {
+            LOBOrder* far_order = LobOrderQueue->getReadAhead(prefetch_lookahead);
+            if(far_order != nullptr) {
+                if(far_order->order_type == 'b') BuyOrderBook.prefetchLUT(far_order->system_id);
+                else SellOrderBook.prefetchLUT(far_order->system_id);
+            }
+
+            size_t near_distance = (prefetch_lookahead > 1) ? (prefetch_lookahead / 2) : 1;
+            LOBOrder* near_order = LobOrderQueue->getReadAhead(near_distance);
+            if(near_order != nullptr) {
+                if(near_order->order_type == 'b') BuyOrderBook.prefetchTarget(*near_order);
+                else SellOrderBook.prefetchTarget(*near_order);
+            }
+        }
 
+        void setPrefetchLookahead(size_t distance) noexcept { prefetch_lookahead = distance; }
+
+        // empty books and no samples, as if just constructed (the queues must be empty, attached feeds are not touched).
+        // the books keep their memory, so this is the cheap way to run the engine again (backtest sweeps)
+        void reset() noexcept {
+            BuyOrderBook.reset();
+            SellOrderBook.reset();
+            next_input = 0;
+            LobOrderQueue = LobOrderQueues[0];
+            last_read_cycle = 0;
+            Queue_Wait_Time.clear();
+            Matching_Engine_Processing_Time.clear();
+            Tick_To_Trade_Time.clear();
+            Matching_Engine_Throughput.clear();
         }
 
+        void setAckDrain(void (*drain)(void*) noexcept, void* ctx) noexcept {
+            ack_drain = drain;
+            ack_drain_ctx = ctx;
+        }
+
+        // the book must cover the same price ticks as the engine
+        void attachConflatedBook(internal_lib::ConflatedBook* book) noexcept { ConflatedLevels = book; }
+        void attachTopOfBook(internal_lib::TopOfBook* top) noexcept { TopBook = top; }
+
+        // the logger's engine queue, core_id tags the records. nullptr = no logging (the default)
+        void attachLogger(LFQueue<internal_lib::LogElement>* log_q, int core_id = -1) noexcept { Log.attach(log_q, core_id); }
+        uint64_t getLogDropped() const noexcept { return Log.getDropped(); }
+        uint64_t getBroadcastDropped() const noexcept { return broadcast_dropped; }
+
+        std::vector<uint64_t>& getProcessingTimes() noexcept { return Matching_Engine_Processing_Time; }
+        std::vector<uint64_t>& getTickToTradeTimes() noexcept { return Tick_To_Trade_Time; }
+
         uint64_t createOrderHandler(LOBOrder& order, bool is_buy) noexcept {
 
 
@@ -158,10 +280,12 @@ namespace internal_lib {
                 }
 
                 sendIncrementalChange(order.system_id, order.price, order.quantity, 'N', is_buy ? 'B' : 'S');
+                levelChange(is_buy, order.price, order.quantity, 1);
                 
-                if (order.trader_id == 1) {
-                    acknowledgeBackToOrderGateway(order.system_id, order.price, order.quantity, 'C', is_buy ? 'B' : 'S');
-                }
+                acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, order.quantity, 'C', is_buy ? 'B' : 'S');
+            } else {
+                // fully filled (or killed by wash trade check) on arrival, never rests ---> terminal
+                releaseSystemId(order.system_id);
             }
 
             compiler_barrier();
@@ -169,6 +293,26 @@ namespace internal_lib {
             return done_at;
         }
 
+        // tick index = price * 10 must land on a book row : 0 < price * 10 < max_price_ticks + 1 (nan fails both compares)
+        inline bool priceInBook(float price) const noexcept {
+            return price > 0.0f && price * 10 < price_limit;
+        }
+
+        // the book is not touched. a refused create never rested : killed ('K', like a wash trade kill) and its id is free again.
+        // a refused update is 'R' and leaves the resting order as it was (the id stays with it) ---> an engine 'R' is never terminal
+        uint64_t priceRejectHandler(LOBOrder& order, bool is_buy) noexcept {
+            if(order.req_type == 'c') {
+                acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, 0, 'K', is_buy ? 'B' : 'S');
+                releaseSystemId(order.system_id);
+            } else {
+                acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, 0, 'R', is_buy ? 'B' : 'S');
+            }
+
+            compiler_barrier();
+            uint64_t done_at = now_cycles();
+            return done_at;
+        }
+
         uint64_t updateHandler(LOBOrder& order, bool is_buy) noexcept {
 
             // if this makes a price updatethen we do delete and the call craetOrderhandler it Will automatically do aggressive checking fpor us no need to qrite separate code for that
@@ -193,7 +337,8 @@ namespace internal_lib {
             if(price_change) {
                 // price based difference, do delete and update
                 // since order_entry was a pointer we need to pass the reference in deleteHandler so use asterisk
-                uint64_t x = deleteHandler(*order_entry_in_lob, is_buy); // no need of x
+                // the id stays with the order (it is re-created right below) so it must not be released here
+                deleteHandler(*order_entry_in_lob, is_buy, false);
 
                 // by default we create new order so need not to update the orde separately
                 done_at = createOrderHandler(order,is_buy);
@@ -201,6 +346,8 @@ namespace internal_lib {
                 // won't send acknowledgement now, as delete and create form here would already have sent a succesfull one.
             } else if(quantity_change) {
                 // if only quantity changes 
+                levelChange(is_buy, order.price, order.quantity - order_entry_in_lob->quantity, 0);
+
                 if(is_buy) { 
                     BuyOrderBook.updateOrderQuantity(order);
                 } else {
@@ -210,10 +357,7 @@ namespace internal_lib {
                 // send incremental for quantity change
                 sendIncrementalChange(order.system_id, order.price, order.quantity, 'U', is_buy ? 'B' : 'S');
 
-                // acknowledge for Trader 1
-                if (order.trader_id == 1) {
-                    acknowledgeBackToOrderGateway(order.system_id, order.price, order.quantity, 'U', is_buy ? 'B' : 'S');
-                }
+                acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, order.quantity, 'U', is_buy ? 'B' : 'S');
                 compiler_barrier();
                 done_at = now_cycles();
             }
@@ -223,22 +367,33 @@ namespace internal_lib {
             // LOG
         }
 
-        uint64_t deleteHandler(LOBOrder& order, bool is_buy) noexcept {
+        uint64_t deleteHandler(LOBOrder& order, bool is_buy, bool release_id = true) noexcept {
             // call the LOB delete handler
+            bool removed;
+
+            if(ConflatedLevels != nullptr || TopBook != nullptr) {
+                // a cancel request carries no quantity, the level loses whatever the resting order still had
+                LOBOrder* resting = is_buy ? BuyOrderBook.peekLOBEntry(order.system_id) : SellOrderBook.peekLOBEntry(order.system_id);
+                if(resting != nullptr) levelChange(is_buy, resting->price, -resting->quantity, -1);
+            }
 
             if(is_buy) {
-                BuyOrderBook.deleteOrder(order.system_id);
+                removed = BuyOrderBook.deleteOrder(order.system_id);
 
             } else {
-                SellOrderBook.deleteOrder(order.system_id);
+                removed = SellOrderBook.deleteOrder(order.system_id);
             }
 
             // send incremental for deletion
             sendIncrementalChange(order.system_id, order.price, order.quantity, 'D', is_buy ? 'B' : 'S');
 
-            // acknowledge Deleted for trader 1
-            if (order.trader_id == 1) {
-                acknowledgeBackToOrderGateway(order.system_id, order.price, order.quantity, 'D', is_buy ? 'B' : 'S');
+            // acknowledge Deleted (before the release : the gateway still needs the id to translate this ack)
+            acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, order.quantity, 'D', is_buy ? 'B' : 'S');
+
+            // only the cancel that actually removed the order retires its id, a late cancel (order already filled/cancelled,
+            // or carrying a stale generation) must not free a slot that is already free or owned by someone else.
+            if (removed && release_id) {
+                releaseSystemId(order.system_id);
             }
 
             compiler_barrier();
@@ -247,6 +402,32 @@ namespace internal_lib {
             // LOG
         }
 
+        uint64_t massCancelHandler(LOBOrder& order) noexcept {
+            short trader_id = order.trader_id;
+
+            if(order.order_type != 's') {
+                BuyOrderBook.cancelAllForTrader(trader_id, [&](const LOBOrder& resting) {
+                    sendIncrementalChange(resting.system_id, resting.price, resting.quantity, 'D', 'B');
+                    levelChange(true, resting.price, -resting.quantity, -1);
+                    acknowledgeBackToOrderGateway(resting.system_id, trader_id, resting.price, resting.quantity, 'D', 'B');
+                    releaseSystemId(resting.system_id);
+                });
+            }
+
+            if(order.order_type != 'b') {
+                SellOrderBook.cancelAllForTrader(trader_id, [&](const LOBOrder& resting) {
+                    sendIncrementalChange(resting.system_id, resting.price, resting.quantity, 'D', 'S');
+                    levelChange(false, resting.price, -resting.quantity, -1);
+                    acknowledgeBackToOrderGateway(resting.system_id, trader_id, resting.price, resting.quantity, 'D', 'S');
+                    releaseSystemId(resting.system_id);
+                });
+            }
+
+            compiler_barrier();
+            uint64_t done_at = now_cycles();
+            return done_at;
+        }
+
         void aggressiveMatch(LOBOrder& order, bool is_buy) noexcept { 
 
             // if order of type sell
@@ -303,10 +484,7 @@ namespace internal_lib {
                             order.quantity = 0; 
                     
                             // send a specific 'cancelled' acknowledgement to the gateway as wash trade is detected
-                            // ack: only for rader 1
-                            if (order.trader_id == 1) {
-                                acknowledgeBackToOrderGateway(order.system_id, order.price, 0, 'K', 'B');
-                            }
+                            acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, 0, 'K', 'B');
                             break; 
                         }
                         
@@ -319,22 +497,20 @@ namespace internal_lib {
                         order.quantity -= trade_qty;
                         passive.quantity -= trade_qty;
 
-                        // broadcast change
-                        //  trades will be handles by user so he will upodated based on it and for the second passive order/ or the ordere which was not his he will get a increment request via delete function whic is below 
+                        // broadcast the fill : trade tape + it takes trade_qty off the resting order for book builders
+                        sendIncrementalChange(passive.system_id, trade_price, trade_qty, 'T', 'S');
 
-                        // acknowledge back for TRADER ID 1 only
-                        if (order.trader_id == 1) {
-                            acknowledgeBackToOrderGateway(order.system_id, trade_price, trade_qty, 'T', 'B'); // Aggressor
-                        }
-                        if (passive.trader_id == 1) {
-                            acknowledgeBackToOrderGateway(passive.system_id, trade_price, trade_qty, 'T', 'S'); // Passive
-                        }
+                        // acknowledge back to both sides, the gateway routes each ack to its trader's ring
+                        acknowledgeBackToOrderGateway(order.system_id, order.trader_id, trade_price, trade_qty, 'T', 'B'); // Aggressor
+                        acknowledgeBackToOrderGateway(passive.system_id, passive.trader_id, trade_price, trade_qty, 'T', 'S'); // Passive
+                        levelChange(false, passive.price, -trade_qty, (passive.quantity == 0) ? -1 : 0);
 
 
                         // if full ---> aggressive bid/ask quantity == passive optimal ask/bid quantity 
                         // remove the passive entry modify LOB using member functions from lob_structs
                         if (passive.quantity == 0) {
                              SellOrderBook.deleteOrder(passive.system_id);
+                             releaseSystemId(passive.system_id);
                         }
                     }
 
@@ -371,10 +547,7 @@ namespace internal_lib {
                             order.quantity = 0; 
                     
                             // send a specific 'cancelled' acknowledgement to the gateway as wash trade is detected
-                            // ack only for Trader 1
-                            if (order.trader_id == 1) {
-                                acknowledgeBackToOrderGateway(order.system_id, order.price, 0, 'K', 'S');
-                            }
+                            acknowledgeBackToOrderGateway(order.system_id, order.trader_id, order.price, 0, 'K', 'S');
                             break; 
                         }        
 
@@ -386,19 +559,17 @@ namespace internal_lib {
                         order.quantity -= trade_qty;
                         passive.quantity -= trade_qty;
 
-                        // whenerv matches send acknowledge to orderGateWay for Trader ID 1 only
-                        if (order.trader_id == 1) {
-                            acknowledgeBackToOrderGateway(order.system_id, trade_price, trade_qty, 'T', 'S');
-                        }
-                        if (passive.trader_id == 1) {
-                            acknowledgeBackToOrderGateway(passive.system_id, trade_price, trade_qty, 'T', 'B');
-                        }
-                        
-                        //  trades will be handles by user so he will upodated based on it and for the second passive order/ or the ordere which was not his he will get a increment request via delete function whic is below 
+                        sendIncrementalChange(passive.system_id, trade_price, trade_qty, 'T', 'B');
 
+                        // whenever it matches send an acknowledgement to both sides
+                        acknowledgeBackToOrderGateway(order.system_id, order.trader_id, trade_price, trade_qty, 'T', 'S');
+                        acknowledgeBackToOrderGateway(passive.system_id, passive.trader_id, trade_price, trade_qty, 'T', 'B');
+                        levelChange(true, passive.price, -trade_qty, (passive.quantity == 0) ? -1 : 0);
+                        
                         // remove the passive entry modify LOB
                         if (passive.quantity == 0) {
                              BuyOrderBook.deleteOrder(passive.system_id);
+                             releaseSystemId(passive.system_id);
                         }
                     }
 
@@ -412,28 +583,26 @@ namespace internal_lib {
         }
 
 
-        void acknowledgeBackToOrderGateway(int sys_id, double px, int qty, char status, char side) noexcept {
+        void acknowledgeBackToOrderGateway(int sys_id, short trader_id, double px, int qty, char status, char side) noexcept {
             // .. will receive soem ack object and send this to the ackonledge queue 
             internal_lib::LOBAcknowledgement ack;
             ack.system_id = sys_id;
+            ack.trader_id = trader_id; // origin, the gateway dispatches on it
             ack.price = px;
             ack.quantity = qty;
             ack.status = status;
             ack.side = side;
+
+            writeToLogger(sys_id, trader_id, px, qty, status, side); // every ack is an event of the audit trail
             
-            // write to AckQueue.
+            // write to the AckQueue of the gateway that owns this id.
+            LFQueue<LOBAcknowledgement>* LobAckQueue = ackQueueFor(sys_id);
             LOBAcknowledgement* write_obj = LobAckQueue->getNextWrite();
 
-            // I know this is risk we should keep somethign likea busy wait or a spin wait here
-            // but since our queues is large (5x the crash size) this is high probvablity that it will not block,
-            // also we doing testing so need to remove the busy wait to a simple check. 
-
-
-            /*
-             while(write_obj == nullptr) { 
-                write_obj = LobAckQueue->getNextWrite();
-            }*/
-            if(write_obj == nullptr) { 
+            // ring full : the gateway is behind, wait for it (backpressure) like releaseSystemId does. dropping the ack would
+            // leave the client without a fill / cancel confirmation
+            while(UNLIKELY(write_obj == nullptr)) {
+                waitForAckRoom();
                 write_obj = LobAckQueue->getNextWrite();
             }
 
@@ -444,9 +613,40 @@ namespace internal_lib {
             LobAckQueue->updateWrite(); // updates write position.
         }
 
+        // tells the gateway that this order is terminal so its system id can be recycled ( 'X' acks are consumed by the gateway, never forwarded).
+        // sent for every trader, unlike the user acks. unlike them we do not drop it when the ack queue is full, a lost release leaks an id slot for ever.
+        void releaseSystemId(int sys_id) noexcept {
+            LFQueue<LOBAcknowledgement>* LobAckQueue = ackQueueFor(sys_id);
+            LOBAcknowledgement* write_obj = LobAckQueue->getNextWrite();
+            while(UNLIKELY(write_obj == nullptr)) {
+                waitForAckRoom();
+                write_obj = LobAckQueue->getNextWrite();
+            }
+
+            write_obj->system_id = sys_id;
+            write_obj->trader_id = -1; // consumed by the gateway itself, never routed
+            write_obj->price = 0;
+            write_obj->quantity = 0;
+            write_obj->status = 'X';
+            write_obj->side = ' ';
+
+            LobAckQueue->updateWrite();
+        }
+
+        // split : the gateway drains on its own core, just spin. fused : drain it ourselves (a sweep or a mass cancel can
+        // produce more acks than the ring holds in one order)
+        inline void waitForAckRoom() noexcept {
+            if(ack_drain != nullptr) ack_drain(ack_drain_ctx);
+        }
+
+        inline LFQueue<LOBAcknowledgement>* ackQueueFor(int sys_id) noexcept {
+            return LobAckQueues[systemIdGateway(sys_id, partition_shift)];
+        }
+
         void sendIncrementalChange(int sys_id, double px, int qty, char type, char side) noexcept {
             // will get some incremental change and write it to market data puiblisher queue
             internal_lib::BroadcastElement be;
+            be.event_cycle = now_cycles();
             be.system_id = sys_id;
             be.price = px;
             be.quantity = qty;
@@ -457,30 +657,40 @@ namespace internal_lib {
 
             BroadcastElement* write_obj = BroadcastQueue->getNextWrite();
 
-           // I know this is risk we should keep somethign likea busy wait or a spoin wait here
-            // but since our queues is large (5x the crash size) this is high probvablity that it will not block,
-            // also we doing testing so need to remove the busy wait to a simple check. 
-
-
-            /*
-             while(write_obj == nullptr) { 
-                write_obj = LobAckQueue->getNextWrite();
-            }*/
-            if(write_obj == nullptr) { 
-                write_obj = BroadcastQueue->getNextWrite();
+            // ring full : the publisher is behind. the engine does not wait for market data (the publisher may share our thread
+            // in a stepped setup, and a slow feed must not stall matching), the change is dropped and counted instead.
+            // getBroadcastDropped() != 0 means the feed is no longer a complete picture of the book
+            if(UNLIKELY(write_obj == nullptr)) {
+                broadcast_dropped++;
+                return;
             }
 
-
             // can now write to this point 
             *write_obj = be;
 
             BroadcastQueue->updateWrite(); // update write index now 
+        }
 
-
+        inline void levelChange(bool is_buy, float price, int quantity_delta, int orders_delta) noexcept {
+            size_t tick = static_cast<size_t>(price * 10);
+            if(ConflatedLevels != nullptr) ConflatedLevels->apply(is_buy, tick, quantity_delta, orders_delta);
+            if(TopBook != nullptr) TopBook->apply(is_buy, tick, quantity_delta, orders_delta);
         }
 
-        void writeToLogger() noexcept {
-            // wil get some event and write it to logger.
+        // one record per ack, the level is per status : a wash trade kill or a price reject is a warning, the rest info
+        inline void writeToLogger(int sys_id, short trader_id, double px, int qty, char status, char side) noexcept {
+            auto fill = [&](LogElement& e) {
+                e.data_object.lob = {sys_id, qty, static_cast<float>(px), trader_id, side, status};
+            };
+            switch(status) {
+                case 'C' :
+                case 'U' : Log.write<LogLevel::INFO>(LOG_ENGINE_ACCEPT, event_stamp, fill); break;
+                case 'T' : Log.write<LogLevel::INFO>(LOG_ENGINE_FILL, event_stamp, fill); break;
+                case 'D' : Log.write<LogLevel::INFO>(LOG_ENGINE_CANCEL, event_stamp, fill); break;
+                case 'K' :
+                case 'R' : Log.write<LogLevel::WARN>(LOG_ENGINE_REJECT, event_stamp, fill); break;
+                default : break;
+            }
         }
 
     }; // End of Class
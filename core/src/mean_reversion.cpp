@@ -0,0 +1,83 @@
+// mean reversion strategy for the backtests ---> keeps its own book from the feed (book builder), every timer_ns of virtual
+// time it pulls what did not fill from the last round and takes the far side when the mid is more than band away from its
+// moving average (EMA, weight alpha). position is capped at max_position, fills / position / cash come from its own acks.
+// the parameters are a MeanReversionConfig so a sweep (sweep_runner.cpp) can run it over a grid of them.
+
+#pragma once
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "book_builder.h"
+
+#include "strategy.cpp"
+#include "backtest.cpp"
+
+namespace internal_lib {
+
+	struct MeanReversionConfig {
+		uint64_t timer_ns = 100000;
+		double alpha = 0.05;        // EMA weight of the newest mid
+		double band = 0.05;         // distance of the mid from its average before it trades
+		int lot = 5;
+		int max_position = 200;
+	};
+
+	class MeanReversion : public Strategy<MeanReversion> {
+
+		public :
+
+			// the builder is reset here : it is big (a node per system id), a sweep keeps one per worker next to its Backtest
+			MeanReversion(Backtest& bt, BookBuilder& builder, const MeanReversionConfig& cfg = MeanReversionConfig{})
+				: Strategy<MeanReversion>(bt.strategyOrders(), bt.strategyAcks(), bt.strategyFeed(), bt.strategyTrader()),
+				  config(cfg), book(builder) {
+				book.reset();
+				setTimer(config.timer_ns);
+			}
+
+			void onBookUpdate(const BroadcastElement& be) noexcept { book.apply(be); }
+			void onTrade(const BroadcastElement& be) noexcept { book.apply(be); }
+
+			void onAck(const UserAcknowledgement& ack) noexcept {
+				if(ack.status != 'T') return;
+				char side = getOrder(static_cast<int>(ack.order_id)).side;
+				int signed_qty = (side == 'b') ? ack.quantity : -ack.quantity;
+				position += signed_qty;
+				cash -= static_cast<double>(signed_qty) * ack.price;
+				fills++;
+			}
+
+			void onTimer(uint64_t) noexcept {
+				for(int k = 0; k < working_count; k++) cancelOrder(working[k]);
+				working_count = 0;
+
+				DepthLevel bid, ask;
+				if(!book.bestLevel(true, bid) || !book.bestLevel(false, ask)) return;
+				double mid = 0.5 * (bid.price + ask.price);
+				last_mid = mid;
+				average = (average == 0.0) ? mid : average + config.alpha * (mid - average);
+
+				int id = -1;
+				if(mid < average - config.band && position < config.max_position) id = sendOrder('b', ask.price, config.lot);
+				else if(mid > average + config.band && position > -config.max_position) id = sendOrder('s', bid.price, config.lot);
+				if(id >= 0) working[working_count++] = id;
+			}
+
+			double pnl() const noexcept { return cash + static_cast<double>(position) * last_mid; }
+			int getPosition() const noexcept { return position; }
+			uint64_t getFills() const noexcept { return fills; }
+
+		private :
+
+			MeanReversionConfig config;
+			BookBuilder& book;
+			double average = 0.0;
+			double last_mid = 0.0;
+			int working[4];
+			int working_count = 0;
+
+			int position = 0;
+			double cash = 0.0;
+			uint64_t fills = 0;
+	};
+}
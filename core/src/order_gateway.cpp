@@ -3,7 +3,11 @@
 #include "lf_queue.h"
 #include "simd_bplus_tree.h"
 #include "order_gateway_structs.h"
+#include "system_id_allocator.h"
+#include "order_entry_protocol.h"
+#include "pre_trade_risk.h"
 #include "mempool.h" 
+#include "logger.h"
 #include "benchmark_utility.h"
 
 #define LIKELY(x) __builtin_expect(!!(x), 1)
@@ -11,27 +15,100 @@
 
 namespace internal_lib {
 
-    class OrderGateway {
+    // where the gateway puts a translated order. it only ever asks for a slot to write the next LOBOrder into and commits it
+    // once it is filled, so the same gateway code runs in either pipeline topology (picked at compile time by the sink type) :
+    //   LobQueueSink     : the slot is the next entry of the LOB ring, commit publishes it to the engine on its own core (split)
+    //   DirectEngineSink : the engine is called on the slot inside commit, on the gateway's thread (fused, fused_pipeline.cpp)
+    // slot() may return nullptr (ring full), the order then stays in its user queue for the next round.
+    struct LobQueueSink {
+        static constexpr bool INLINE_ENGINE = false;
+
+        LFQueue<LOBOrder>* queue;
+
+        LobQueueSink(LFQueue<LOBOrder>* loq) noexcept : queue(loq) {} // implicit : OrderGateway(&laq, &soq, &mmoq, &loq)
+
+        inline LOBOrder* slot() noexcept { return queue->getNextWrite(); }
+        inline void commit() noexcept { queue->updateWrite(); }
+    };
+
+    template<typename OrderSink = LobQueueSink>
+    class BasicOrderGateway {
 
 		// we will use dependency injection here ====> the LF queues this order gateway is going to use will be defined in main thread only
 		// at startup and will be used here via a reference 
         private : 
             // LOB Communication
-            internal_lib::LFQueue<internal_lib::LOBOrder>* LobOrderQueue; 
+            OrderSink LobOrderSink; // LOB queue (split) or the engine itself (fused)
             internal_lib::LFQueue<internal_lib::LOBAcknowledgement>* LobAckQueue; 
 
             // sniper communication
             internal_lib::LFQueue<internal_lib::UserOrder>* SniperOrderQueue; 
-            internal_lib::LFQueue<internal_lib::UserAcknowledgement>* SniperAckQueue; 
 
             // Market Maker communication
             internal_lib::LFQueue<internal_lib::UserOrder>* MMOrderQueue; 
 
-            internal_lib::SIMDBPlusTree<long long, int, 256> BPTree; 
-            std::vector<long long> LUT; 
-            
-            int next_system_id = 0; // start from 0
+            // cancel lanes (optional, one per source) : cancels ('d') and replaces ('u') bypass the new orders queued in front of them,
+            // so a burst of new orders can not keep a stale quote in the book. drained first, but after cancel_streak_limit of them in
+            // a row the order lane of that source gets one turn ---> new orders are delayed by at most that many cancels.
+            internal_lib::LFQueue<internal_lib::UserOrder>* SniperCancelQueue = nullptr;
+            internal_lib::LFQueue<internal_lib::UserOrder>* MMCancelQueue = nullptr;
+            int cancel_streak_limit = 8;
+            int sniper_cancel_streak = 0;
+            int mm_cancel_streak = 0;
+
+            // a cancel lane head with an unknown id waits for the orders that were in its order lane when it first got looked at
+            // (its create can only be among them), no longer : a cancel of an order that is already gone is rejected once those passed
+            struct CancelWait {
+                bool waiting = false;
+                size_t from = 0;    // order lane read index when the wait started
+                size_t until = 0;   // order lane write index when the wait started
+            };
+            CancelWait sniper_cancel_wait;
+            CancelWait mm_cancel_wait;
+
+            // network lane (optional) : frames from / to the session server thread (session_server.cpp), nullptr when not attached
+            internal_lib::LFQueue<internal_lib::OEFrame>* SessionInbound = nullptr;
+            internal_lib::LFQueue<internal_lib::OEFrame>* SessionOutbound = nullptr;
+            std::vector<OrderEntrySession> NetSessions; // per trader sequence state, indexed by trader id
+            std::vector<uint64_t> Session_Ingress_Time; // recv() completed the message -> order is in the LOB queue
+
+            // ack routing table, direct indexed by LOBAcknowledgement::trader_id : every trader gets its own acks on its own ring.
+            // a trader with no route (nobody listening, e.g. the simulated market makers) has its acks counted and dropped.
+            struct AckRoute {
+                internal_lib::LFQueue<internal_lib::UserAcknowledgement>* queue = nullptr; // in process consumer (AlphaServer, tests ..)
+                bool network = false;                                                       // trades over the session lane ---> execution reports
+            };
+            std::vector<AckRoute> AckRoutes;
+            uint64_t unrouted_acks = 0;
+
+            // partitioned id space : with N gateways running side by side (each on its own core) gateway g only ever issues
+            // ids from slot range g, so translation state is private to the gateway (no sharing, no locks) and the engine
+            // can send every ack back to the gateway that owns the id.
+            int gateway_id;
+
+            internal_lib::SystemIdAllocator IdAllocator; // recycled ids, a slot is freed when the engine tells us the order is terminal ('X' ack)
 
+            internal_lib::SIMDBPlusTree<long long, int, 256> BPTree; 
+            // per system id, indexed by the position of the id inside our slot range (IdAllocator.localIndex) : the order key
+            // (trader, order id) and the order's open exposure for the risk stage. one 16 byte entry, so the risk check of a
+            // create and the fill / release of an ack touch the line the translation touches anyway
+            struct IdSlot {
+                long long order_key;
+                internal_lib::RiskOrder risk;
+            };
+            static_assert(sizeof(IdSlot) == 16, "4 id slots per cache line");
+            std::vector<IdSlot> LUT;
+
+
+            // pre trade risk : checked after translation (a replace needs the live order's exposure), a reject never reaches the engine
+            internal_lib::PreTradeRisk Risk;
+            bool risk_enabled = true;
+            uint64_t risk_rejects = 0;
+            uint64_t duplicate_order_ids = 0; // new orders refused because their client order id was still live
+            const uint64_t* risk_clock = nullptr; // external clock for the rate limits (backtest), nullptr = the TSC stamps
+
+            // forwarded orders (client order id -> system id) and rejects into the logger's gateway queue (optional, see attachLogger)
+            internal_lib::LogProducer Log{internal_lib::ComponentId::ORDER_GATEWAY};
 
             // 
             int orders_received = 0;
@@ -39,6 +116,18 @@ namespace internal_lib {
 
             std::vector<uint64_t> Order_Gateway_processing_Time;
 
+            // producer stamp (UserOrder::arrived_cycle_count / frame rx) -> forwarded to the LOB, queueing included. kept apart for
+            // new orders and cancels/replaces, the cancel lanes only pay off if the second one stays flat under a burst of the first.
+            // orders without a producer stamp (0) are not counted.
+            std::vector<uint64_t> New_Order_Latency;
+            std::vector<uint64_t> Cancel_Latency;
+
+            // burst mode : instead of translating one order at a time we peek up to burst_size pending orders/acks
+            // and interleave their lookups (group prefetching) so the DRAM misses of the tree descent and LUT reads overlap.
+            // burst_size <= 1 keeps the classic one-by-one path.
+            static constexpr int MAX_BURST = internal_lib::SIMDBPlusTree<long long, int, 256>::MAX_BATCH;
+            int burst_size = 1;
+
             // Throttle: busy-spin this many cycles after each order to match ME consumption rate.
             // Set to 0 to disable. Tune so that OGW effective rate ≈ ME throughput.
             // ME throughput ≈ 664 cycles, OGW processing ≈ 288 cycles → throttle ≈ 400 cycles.
@@ -56,48 +145,583 @@ namespace internal_lib {
 
         public :
 
-            OrderGateway(
+            BasicOrderGateway(
                      LFQueue<internal_lib::LOBAcknowledgement>* laq,  
                      LFQueue<internal_lib::UserOrder>* soq, 
-                     LFQueue<internal_lib::UserAcknowledgement>* saq, 
                      LFQueue<internal_lib::UserOrder>* mmoq, 
-                     LFQueue<internal_lib::LOBOrder>* loq) 
+                     OrderSink loq,
+                     int gateway_index = 0,
+                     int gateway_count = 1) 
                     : 
+                     LobOrderSink(loq),
                      LobAckQueue(laq),
                      SniperOrderQueue(soq),
-                     SniperAckQueue(saq),
                      MMOrderQueue(mmoq),
-                     LobOrderQueue(loq)
+                     gateway_id(gateway_index),
+                     IdAllocator(gateway_index << systemIdPartitionShift(gateway_count), 1 << systemIdPartitionShift(gateway_count)),
+                     BPTree(treePoolSize(1 << systemIdPartitionShift(gateway_count)))
                       {
                 // initialize B+ Tree
 
                 Order_Gateway_processing_Time.reserve(11000); //  so that resising does not occour
-                internal_lib::SIMDBPlusTree<long long, int, 256>::init(100000);
+                New_Order_Latency.reserve(11000);
+                Cancel_Latency.reserve(11000);
                 
                 // pre-allocate LUT
-                LUT.resize(1000000);
+                LUT.resize(IdAllocator.getCapacity());
+
+                AckRoutes.resize(OE_MAX_TRADERS);
+
+                if constexpr (OrderSink::INLINE_ENGINE) LobOrderSink.attachAckDrain(&drainFromEngine, this);
             }
 
-            long long SystemToOrderId(int sysId) noexcept {
-                if(LIKELY(sysId < LUT.size()))return LUT[sysId];
-                return -1; // sysId > size return -1;
+            // node budget for the translation tree : ids are recycled so live keys never exceed our slot count, and the tree
+            // keeps every node at least half full, so the worst case for slot_count keys is enough for a session of any length
+            static size_t treePoolSize(int slot_count) noexcept {
+                return decltype(BPTree)::worstCaseNodes(static_cast<size_t>(slot_count));
+            }
+
+            void setThrottleCycles(uint64_t cycles) noexcept { throttle_cycles = cycles; }
+
+            // where the acks (and gateway rejects) of trader_id go. nullptr = nobody listens, acks are dropped
+            void setAckRoute(short trader_id, LFQueue<UserAcknowledgement>* queue) noexcept {
+                if(trader_id >= 0 && trader_id < OE_MAX_TRADERS) AckRoutes[trader_id].queue = queue;
+            }
+
+            uint64_t getUnroutedAcks() const noexcept { return unrouted_acks; }
+
+            // limits can be changed from a control thread at any time (PreTradeRisk::setLimits), the gateway applies them between polls
+            PreTradeRisk& getRisk() noexcept { return Risk; }
+            void setPreTradeRisk(bool enabled) noexcept { risk_enabled = enabled; }
+            // rate limits on a virtual clock : the gateway reads *clock instead of the arrival stamp (the limits' cycles are its units)
+            void setRiskClock(const uint64_t* clock) noexcept { risk_clock = clock; }
+            uint64_t getRiskRejects() const noexcept { return risk_rejects; }
+            uint64_t getDuplicateOrderIds() const noexcept { return duplicate_order_ids; }
+
+            // the logger's gateway queue, core_id tags the records. nullptr = no logging (the default)
+            void attachLogger(LFQueue<LogElement>* log_q, int core_id = -1) noexcept { Log.attach(log_q, core_id); }
+            uint64_t getLogDropped() const noexcept { return Log.getDropped(); }
+
+            // hooks the gateway to a session server : inbound carries decoded-ready order entry messages, outbound carries
+            // execution reports (and rejects) back to it.
+            void attachSessionLane(LFQueue<OEFrame>* inbound, LFQueue<OEFrame>* outbound) noexcept {
+                SessionInbound = inbound;
+                SessionOutbound = outbound;
+
+                NetSessions.resize(OE_MAX_TRADERS);
+                for(int t = 0; t < OE_MAX_TRADERS; t++) NetSessions[t].trader_id = static_cast<short>(t);
+                Session_Ingress_Time.reserve(11000);
+            }
+
+            // either lane may be nullptr (that source keeps a single queue). producers put cancels / replaces on the cancel lane.
+            void attachCancelLanes(LFQueue<UserOrder>* sniper_cancels, LFQueue<UserOrder>* mm_cancels) noexcept {
+                SniperCancelQueue = sniper_cancels;
+                MMCancelQueue = mm_cancels;
+            }
+
+            void setCancelStreakLimit(int limit) noexcept { cancel_streak_limit = (limit < 1) ? 1 : limit; }
+
+            void setBurstSize(int burst) noexcept {
+                burst_size = (burst < 1) ? 1 : ((burst > MAX_BURST) ? MAX_BURST : burst);
+            }
+
+            long long SystemToOrderKey(int sysId) noexcept {
+                if(LIKELY(IdAllocator.isLive(sysId))) return LUT[IdAllocator.localIndex(sysId)].order_key;
+                return -1; // stale generation / never assigned id return -1;
                 
             }
 
-            // logic for getting system id
-            int GetOrAssignSystemId(long long orderId, char reqType) noexcept {
+            long long SystemToOrderId(int sysId) noexcept {
+                long long key = SystemToOrderKey(sysId);
+                return (LIKELY(key != -1)) ? orderKeyOrderId(key) : -1;
+            }
+
+            // logic for getting system id, orderKey = makeOrderKey(trader_id, order_id)
+            int GetOrAssignSystemId(long long orderKey, char reqType) noexcept {
                 if (reqType == 'c') {
                     // create new
-                    int sysId = next_system_id++;
-                    BPTree.insert(orderId, sysId);
-                    LUT[sysId] = orderId;
+                    int sysId = IdAllocator.allocate();
+                    if(UNLIKELY(sysId == -1)) return -1; // every slot is live, the engine rejects id -1
+
+                    // the client order id of a live order : the live order keeps its mapping (its acks and its release still
+                    // find it), the new one is rejected
+                    if(UNLIKELY(!BPTree.insert(orderKey, sysId))) {
+                        IdAllocator.release(sysId);
+                        duplicate_order_ids++;
+                        return -1;
+                    }
+                    // a recycled slot starts clean : nothing the last owner (or a stray write after its release) left in the risk half
+                    LUT[IdAllocator.localIndex(sysId)] = IdSlot{orderKey, internal_lib::RiskOrder{}};
                     return sysId;
                 } else {
                     // lookup existing
-                    return BPTree.find(orderId);
+                    return BPTree.find(orderKey);
+                }
+            }
+
+            // order is terminal in the book : forget its order id and recycle the slot (generation bump happens in the allocator)
+            void ReleaseSystemId(int sysId) noexcept {
+                if(UNLIKELY(!IdAllocator.isLive(sysId))) return;
+
+                int local = IdAllocator.localIndex(sysId);
+                Risk.onTerminal(orderKeyTraderId(LUT[local].order_key), LUT[local].risk);
+                BPTree.erase(LUT[local].order_key);
+                IdAllocator.release(sysId);
+            }
+
+            int liveSystemIds() const noexcept { return IdAllocator.liveCount(); }
+
+            // no live orders, fresh id generations, no exposure and no samples, as if just constructed. routes, lanes, limits
+            // and session state stay. the tree pool and the tables keep their memory (backtest sweeps reuse one gateway)
+            void reset() noexcept {
+                IdAllocator.reset();
+                BPTree.clear();
+                Risk.resetExposure();
+                for(IdSlot& slot : LUT) slot.risk = internal_lib::RiskOrder{};
+                sniper_cancel_streak = 0;
+                mm_cancel_streak = 0;
+                sniper_cancel_wait = CancelWait{};
+                mm_cancel_wait = CancelWait{};
+                unrouted_acks = 0;
+                risk_rejects = 0;
+                duplicate_order_ids = 0;
+                orders_received = 0;
+                LOB_orders_sent = 0;
+                Order_Gateway_processing_Time.clear();
+                New_Order_Latency.clear();
+                Cancel_Latency.clear();
+                Session_Ingress_Time.clear();
+            }
+
+            // one sniper order : translate + forward to the LOB
+            void pollSniperOrder() noexcept {
+                // take input from sniper
+                UserOrder* readOrder = SniperOrderQueue->getNextRead(); 
+
+                if(LIKELY(readOrder != nullptr)) {
+                    // grab the LOB slot before translating : an id assigned to an order we then fail to forward would leak
+                    LOBOrder* writeSlot = LobOrderSink.slot();
+                    if(UNLIKELY(writeSlot == nullptr)) return; // LOB queue full, retry next round
+
+                    // testing
+                    compiler_barrier();
+                    uint64_t arrived_cc = now_cycles(); // serialized timestamp when it arrived
+                    compiler_barrier();
+
+                    int sys_id = GetOrAssignSystemId(makeOrderKey(readOrder->trader_id, readOrder->order_id), readOrder->req_type);
+                    if(LIKELY(sys_id != -1) && UNLIKELY(!passRisk(readOrder, sys_id, arrived_cc))) sys_id = -1;
+
+                    compiler_barrier();
+                    uint64_t og_work_done = now_cycles(); // serialized timestamp when processing complete
+                    compiler_barrier();
+
+                    Order_Gateway_processing_Time.push_back(og_work_done - arrived_cc);
+
+                    if(UNLIKELY(sys_id == -1)) {
+                        // unknown order id / duplicate live order id / id range exhausted / risk reject : answer here, the engine could not route an ack for id -1 back to us anyway
+                        rejectToUser(readOrder);
+                        SniperOrderQueue->updateRead();
+                        return;
+                    }
+
+                    // zero copy write directly to buffer
+                    // write now
+                    writeLOBOrder(writeSlot, readOrder, sys_id, arrived_cc);
+                    recordIngressLatency(readOrder->req_type, readOrder->arrived_cycle_count, writeSlot->out_cycle_count);
+                    logForward(writeSlot, readOrder->order_id);
+                
+                    LobOrderSink.commit();
+                    SniperOrderQueue->updateRead();
+
+                    // throttle: slow down ogw to match me consumption rate
+                    busy_spin_throttle();
+                }
+            }
+
+            // burst of sniper orders : peek everything that is pending (upto burst_size), do the creates, then resolve all the
+            // lookups (update/delete) together through the prefetching batch find and finally forward them in arrival order.
+            void pollSniperOrderBurst() noexcept {
+                UserOrder* burst[MAX_BURST];
+                int sys_ids[MAX_BURST];
+
+                long long lookup_keys[MAX_BURST];
+                int lookup_ids[MAX_BURST];
+                int lookup_slot[MAX_BURST];
+
+                int n = 0;
+                while(n < burst_size) {
+                    UserOrder* o = SniperOrderQueue->getReadAhead(n);
+                    if(o == nullptr) break;
+                    burst[n++] = o;
+                }
+
+                if(n == 0) return;
+
+                compiler_barrier();
+                uint64_t arrived_cc = now_cycles();
+                compiler_barrier();
+
+                int lookups = 0;
+                for(int b = 0; b < n; b++) {
+                    if(burst[b]->req_type == 'c') {
+                        sys_ids[b] = GetOrAssignSystemId(makeOrderKey(burst[b]->trader_id, burst[b]->order_id), 'c');
+                    } else {
+                        lookup_keys[lookups] = makeOrderKey(burst[b]->trader_id, burst[b]->order_id);
+                        lookup_slot[lookups] = b;
+                        lookups++;
+                    }
+                }
+
+                if(lookups > 0) {
+                    BPTree.findBatch(lookup_keys, lookup_ids, lookups);
+                    for(int k = 0; k < lookups; k++) sys_ids[lookup_slot[k]] = lookup_ids[k];
+                }
+
+                // risk in arrival order, a rejected create hands its id back straight away. the lookups above ran before that, so a
+                // replace / cancel of the same key later in the burst can hold the id just released ---> re-checked, it is unknown now
+                for(int b = 0; b < n; b++) {
+                    if(LIKELY(sys_ids[b] != -1)) __builtin_prefetch(&LUT[IdAllocator.localIndex(sys_ids[b])], 1, 3);
+                }
+                for(int b = 0; b < n; b++) {
+                    if(UNLIKELY(sys_ids[b] != -1 && !IdAllocator.isLive(sys_ids[b]))) sys_ids[b] = -1;
+                    if(LIKELY(sys_ids[b] != -1) && UNLIKELY(!passRisk(burst[b], sys_ids[b], arrived_cc))) sys_ids[b] = -1;
+                }
+
+                compiler_barrier();
+                uint64_t og_work_done = now_cycles();
+                compiler_barrier();
+
+                // amortized per order cost so the numbers stay comparable with the one-by-one path
+                uint64_t per_order = (og_work_done - arrived_cc) / n;
+
+                for(int b = 0; b < n; b++) {
+                    if(UNLIKELY(sys_ids[b] == -1 || !IdAllocator.isLive(sys_ids[b]))) {
+                        rejectToUser(burst[b]);
+                        SniperOrderQueue->updateRead();
+                        continue;
+                    }
+
+                    LOBOrder* writeSlot = LobOrderSink.slot();
+                    if(UNLIKELY(writeSlot == nullptr)) {
+                        // LOB queue full, the rest stays in the sniper queue for the next round ---> hand back the ids we just gave them
+                        for(int r = b; r < n; r++) {
+                            if(burst[r]->req_type == 'c') ReleaseSystemId(sys_ids[r]);
+                        }
+                        break;
+                    }
+
+                    writeLOBOrder(writeSlot, burst[b], sys_ids[b], arrived_cc);
+                    recordIngressLatency(burst[b]->req_type, burst[b]->arrived_cycle_count, writeSlot->out_cycle_count);
+                    Order_Gateway_processing_Time.push_back(per_order);
+                    logForward(writeSlot, burst[b]->order_id);
+
+                    LobOrderSink.commit();
+                    SniperOrderQueue->updateRead();
+
+                    busy_spin_throttle();
+                }
+            }
+
+            void pollMarketMakerOrder() noexcept {
+                // take from market maker ---> we will only define a queue as of now for market maker but nothign will be there as of now 
+                UserOrder* readOrder = MMOrderQueue->getNextRead();
+                
+                if(LIKELY(readOrder != nullptr)) {
+                
+                LOBOrder* writeSlot = LobOrderSink.slot();
+                
+                if(LIKELY(writeSlot != nullptr)) {
+                    // zero copy write directly to buffer
+                    writeSlot->arrived_cycle_count = now_cycles();
+                    long long key = makeOrderKey(readOrder->trader_id, readOrder->order_id);
+                    char req_type = readOrder->req_type;
+
+                    if(req_type == 'q') {
+                        // quote (udp_quote_ingress.cpp) : the market maker does not track its quotes, a live quote id is replaced, an unknown one is created
+                        writeSlot->system_id = BPTree.find(key);
+                        req_type = (writeSlot->system_id != -1) ? 'u' : 'c';
+                        if(req_type == 'c') writeSlot->system_id = GetOrAssignSystemId(key, 'c');
+                    } else {
+                        writeSlot->system_id = GetOrAssignSystemId(key, req_type);
+                    }
+                    writeSlot->order_type = readOrder->order_type;
+                    writeSlot->quantity = readOrder->quantity;
+                    writeSlot->price = readOrder->price;
+                    writeSlot->req_type = req_type;
+                    writeSlot->trader_id = readOrder->trader_id;
+
+                    if(LIKELY(writeSlot->system_id != -1) && UNLIKELY(!passRisk(*writeSlot, writeSlot->arrived_cycle_count))) writeSlot->system_id = -1;
+                    
+                    // an order we could not translate (or risk rejected) is rejected to the market maker if it has an ack route, dropped otherwise
+                    if(LIKELY(writeSlot->system_id != -1)) {
+                        writeSlot->out_cycle_count = now_cycles();
+                        recordIngressLatency(req_type, readOrder->arrived_cycle_count, writeSlot->out_cycle_count);
+                        logForward(writeSlot, readOrder->order_id);
+                        LobOrderSink.commit();
+                    } else {
+                        rejectToUser(readOrder, req_type);
+                    }
+                    MMOrderQueue->updateRead();
+                }
+                }
+            }
+
+            // one cancel / replace from a cancel lane. a cancel can overtake the create of its own order (still in the order lane) :
+            // if the id is unknown the cancel waits at the head of its lane until the order lane got past everything that was
+            // published in it when the wait started, only then an unknown id is rejected (sniper) / dropped (market makers).
+            // a cancel of a filled / already cancelled order is answered after that many orders, not when the order lane runs dry.
+            // returns true if the lane head was consumed
+            bool pollCancelLane(LFQueue<UserOrder>* lane, LFQueue<UserOrder>* orders, CancelWait& wait) noexcept {
+                UserOrder* readOrder = lane->getNextRead();
+                if(readOrder == nullptr) return false;
+
+                LOBOrder* writeSlot = LobOrderSink.slot();
+                if(UNLIKELY(writeSlot == nullptr)) return false; // LOB queue full, retry next round
+
+                uint64_t arrived_cc = now_cycles();
+
+                int sys_id = BPTree.find(makeOrderKey(readOrder->trader_id, readOrder->order_id));
+                if(UNLIKELY(sys_id == -1)) {
+                    if(!wait.waiting) wait = CancelWait{true, orders->readIndex(), orders->writeIndex()};
+                    if(orders->entriesBetween(wait.from, orders->readIndex()) < orders->entriesBetween(wait.from, wait.until)) return false;
+                }
+                wait.waiting = false;
+                if(LIKELY(sys_id != -1) && UNLIKELY(!passRisk(readOrder, sys_id, arrived_cc))) sys_id = -1;
+
+                if(UNLIKELY(sys_id == -1)) {
+                    rejectToUser(readOrder);
+                    lane->updateRead();
+                    return true;
+                }
+
+                writeLOBOrder(writeSlot, readOrder, sys_id, arrived_cc);
+                recordIngressLatency(readOrder->req_type, readOrder->arrived_cycle_count, writeSlot->out_cycle_count);
+                Order_Gateway_processing_Time.push_back(writeSlot->out_cycle_count - arrived_cc);
+                logForward(writeSlot, readOrder->order_id);
+
+                LobOrderSink.commit();
+                lane->updateRead();
+                return true;
+            }
+
+            // one round of order ingress for both sources : cancel lane first (bounded streak), then the order lane
+            void pollOrders() noexcept {
+                if(SniperCancelQueue != nullptr && sniper_cancel_streak < cancel_streak_limit && pollCancelLane(SniperCancelQueue, SniperOrderQueue, sniper_cancel_wait)) {
+                    sniper_cancel_streak++;
+                } else {
+                    sniper_cancel_streak = 0;
+                    if(burst_size > 1) pollSniperOrderBurst();
+                    else pollSniperOrder();
+                }
+
+                if(MMCancelQueue != nullptr && mm_cancel_streak < cancel_streak_limit && pollCancelLane(MMCancelQueue, MMOrderQueue, mm_cancel_wait)) {
+                    mm_cancel_streak++;
+                } else {
+                    mm_cancel_streak = 0;
+                    pollMarketMakerOrder();
+                }
+            }
+
+            // one round of the gateway loop : orders, acks, session lane, risk limits
+            void poll() noexcept {
+                if constexpr (OrderSink::INLINE_ENGINE) {
+                    // the engine runs inside commit() on this thread, a full ack ring makes it call drainFromEngine() mid order :
+                    // the acks of the last round are out of the ring before new orders go in, so that stays the rare case
+                    if(drainAcknowledgements()) {
+                        pollOrders();
+                        if(SessionInbound != nullptr) pollSessionOrder();
+                    }
+                } else {
+                    pollOrders();
+
+                    // one order can come back as many acks (a fill per passive order), taking one per round falls behind
+                    if(burst_size > 1) pollAcknowledgementBurst();
+                    else drainAcknowledgements();
+
+                    if(SessionInbound != nullptr) pollSessionOrder();
+                }
+
+                Risk.refresh(); // hot reloaded limits
+            }
+
+            // fused : the engine calls this (on our thread, inside commit()) when our ack ring is full in the middle of an order
+            static void drainFromEngine(void* gateway) noexcept {
+                static_cast<BasicOrderGateway*>(gateway)->drainAcknowledgements();
+            }
+
+            // routes acks until the ring is empty (true) or a user queue is full (false, the rest waits for the next round)
+            bool drainAcknowledgements() noexcept {
+                LOBAcknowledgement* readAck;
+                while((readAck = LobAckQueue->getNextRead()) != nullptr) {
+                    if(UNLIKELY(!routeAck(readAck))) return false;
+                    LobAckQueue->updateRead();
+                }
+                return true;
+            }
+
+            void pollAcknowledgement() noexcept {
+                // process acknowledgements 
+                LOBAcknowledgement* readAck = LobAckQueue->getNextRead();
+            
+                if(LIKELY(readAck != nullptr)) {
+                    // the engine acks every trader, routeAck dispatches on the origin carried in the ack
+                    if(LIKELY(routeAck(readAck))) {
+                        // always a good practice to commit first and then only update read unless you have a strong durability mechanism.
+                        LobAckQueue->updateRead();
+                    }
+                }
+            }
+
+            // burst of acks : prefetch the LUT slot of every pending ack first, then translate them in order.
+            void pollAcknowledgementBurst() noexcept {
+                LOBAcknowledgement* burst[MAX_BURST];
+
+                int n = 0;
+                while(n < burst_size) {
+                    LOBAcknowledgement* a = LobAckQueue->getReadAhead(n);
+                    if(a == nullptr) break;
+                    if(LIKELY(IdAllocator.owns(a->system_id))) {
+                        __builtin_prefetch(&LUT[IdAllocator.localIndex(a->system_id)], 1, 3); // a fill writes the risk half
+                        IdAllocator.prefetchSlot(a->system_id); // the generation check reads it too
+                    }
+                    burst[n++] = a;
+                }
+
+                for(int b = 0; b < n; b++) {
+                    if(UNLIKELY(!routeAck(burst[b]))) break;
+                    LobAckQueue->updateRead();
                 }
             }
 
+            // one frame from the session server ---> LOB queue. rejects go straight back as execution reports.
+            // returns false if there was nothing to do or the LOB/outbound queue is full (the frame stays for the next round)
+            bool pollSessionOrder() noexcept {
+                OEFrame* frame = SessionInbound->getNextRead();
+                if(frame == nullptr) return false;
+
+                short trader_id = frame->trader_id;
+                if(UNLIKELY(reinterpret_cast<const OEHeader*>(frame->msg)->msg_type == 'O')) {
+                    // the session server lost the trader (logout / disconnect) : nobody takes its execution reports any more
+                    AckRoutes[trader_id].network = false;
+                    SessionInbound->updateRead();
+                    return true;
+                }
+
+                // reserve the reply slot first, a decoded message is consumed and its reject can not be deferred
+                OEFrame* reply = SessionOutbound->getNextWrite();
+                if(UNLIKELY(reply == nullptr)) return false;
+
+                uint64_t start = now_cycles();
+
+                DecodeResult result;
+                if(UNLIKELY(AckRoutes[trader_id].queue != nullptr)) {
+                    // in process trader (SessionServer::reserveTrader missed it) : the session must not take its acks over
+                    NetSessions[trader_id].next_in_seq++;
+                    result = {DecodeStatus::BAD_FIELD, frame->length};
+                } else {
+                    AckRoutes[trader_id].network = true;
+                    result = decodeOrderEntry(frame->msg, frame->length, NetSessions[trader_id]);
+                }
+                if(UNLIKELY(result.status == DecodeStatus::BACKPRESSURE)) return false;
+
+                if(UNLIKELY(result.status != DecodeStatus::OK)) {
+                    // only BAD_FIELD / UNKNOWN_ORDER / RISK_REJECT / DUPLICATE_ORDER_ID can get here, the session layer forwards complete in sequence messages only
+                    reply->trader_id = trader_id;
+                    reply->length = static_cast<uint16_t>(encodeReject(frame->msg, NetSessions[trader_id], reply->msg));
+                    SessionOutbound->updateWrite();
+                } else {
+                    LOB_orders_sent++;
+                }
+
+                uint64_t done = now_cycles();
+                Order_Gateway_processing_Time.push_back(done - start);
+                Session_Ingress_Time.push_back(done - frame->rx_cycle_count);
+                if(LIKELY(result.status == DecodeStatus::OK)) {
+                    recordIngressLatency((reinterpret_cast<const OEHeader*>(frame->msg)->msg_type == 'N') ? 'c' : 'd', frame->rx_cycle_count, done);
+                }
+
+                orders_received++;
+                SessionInbound->updateRead();
+                return true;
+            }
+
+            std::vector<uint64_t>& getSessionIngressTimes() noexcept { return Session_Ingress_Time; }
+            std::vector<uint64_t>& getNewOrderLatencies() noexcept { return New_Order_Latency; }
+            std::vector<uint64_t>& getCancelLatencies() noexcept { return Cancel_Latency; }
+
+            // ======================== binary order entry (order_entry_protocol.h) ========================
+
+            // decodes ONE message from the front of a receive buffer and maps it straight into the next LOBOrder slot
+            // (no UserOrder in between). the caller advances its buffer by result.consumed and calls again.
+            // a framing error (BAD_TYPE / BAD_LENGTH) consumes nothing ---> the session is broken and must be dropped by the caller.
+            // BAD_FIELD / UNKNOWN_ORDER / RISK_REJECT / DUPLICATE_ORDER_ID consume the message (it was sequenced), the caller answers it with encodeReject().
+            DecodeResult decodeOrderEntry(const char* buf, size_t len, OrderEntrySession& session) noexcept {
+                DecodeResult framed = oeFrame(buf, len, session.next_in_seq);
+                if(UNLIKELY(framed.status != DecodeStatus::OK)) return framed;
+
+                const OEHeader* header = reinterpret_cast<const OEHeader*>(buf);
+
+                LOBOrder* writeSlot = LobOrderSink.slot();
+                if(UNLIKELY(writeSlot == nullptr)) return {DecodeStatus::BACKPRESSURE, 0};
+
+                if(UNLIKELY(!oeValidFields(buf))) {
+                    session.next_in_seq++;
+                    return {DecodeStatus::BAD_FIELD, framed.consumed};
+                }
+
+                uint64_t arrived_cc = now_cycles();
+                DecodeStatus status;
+
+                switch(header->msg_type) {
+                    case 'N' : status = mapNewOrder(reinterpret_cast<const OENewOrder*>(buf), session.trader_id, writeSlot, arrived_cc); break;
+                    case 'C' : status = mapCancelOrder(reinterpret_cast<const OECancelOrder*>(buf), session.trader_id, writeSlot); break;
+                    case 'R' : status = mapReplaceOrder(reinterpret_cast<const OEReplaceOrder*>(buf), session.trader_id, writeSlot, arrived_cc); break;
+                    default  : status = mapMassCancel(reinterpret_cast<const OEMassCancel*>(buf), session.trader_id, writeSlot); break;
+                }
+
+                session.next_in_seq++;
+
+                if(LIKELY(status == DecodeStatus::OK)) {
+                    writeSlot->arrived_cycle_count = arrived_cc;
+                    writeSlot->trader_id = session.trader_id;
+                    writeSlot->out_cycle_count = now_cycles();
+                    logForward(writeSlot, oeClientOrderId(buf));
+                    LobOrderSink.commit();
+                }
+                return {status, framed.consumed};
+            }
+
+            // engine ack -> execution report written straight into the send buffer (needs OE_MAX_MESSAGE_SIZE bytes of room).
+            // returns bytes written, 0 for internal acks that are not for the client ('X' id release is consumed here).
+            size_t encodeExecutionReport(const LOBAcknowledgement& ack, OrderEntrySession& session, char* out) noexcept {
+                if(ack.status == 'X') {
+                    ReleaseSystemId(ack.system_id);
+                    return 0;
+                }
+
+                return oeEncodeExecutionReport(out, session.next_out_seq++, SystemToOrderId(ack.system_id), ack.price, ack.quantity, ack.side, ack.status);
+            }
+
+            // 'R' execution report for an inbound message the decoder refused (BAD_FIELD / UNKNOWN_ORDER / RISK_REJECT / DUPLICATE_ORDER_ID)
+            size_t encodeReject(const char* msg, OrderEntrySession& session, char* out) noexcept {
+                const OEHeader* header = reinterpret_cast<const OEHeader*>(msg);
+
+                int64_t client_order_id;
+                char side;
+
+                switch(header->msg_type) {
+                    case 'N' : client_order_id = reinterpret_cast<const OENewOrder*>(msg)->client_order_id; side = reinterpret_cast<const OENewOrder*>(msg)->side; break;
+                    case 'C' : client_order_id = reinterpret_cast<const OECancelOrder*>(msg)->client_order_id; side = reinterpret_cast<const OECancelOrder*>(msg)->side; break;
+                    case 'R' : client_order_id = reinterpret_cast<const OEReplaceOrder*>(msg)->client_order_id; side = reinterpret_cast<const OEReplaceOrder*>(msg)->side; break;
+                    default  : client_order_id = -1; side = reinterpret_cast<const OEMassCancel*>(msg)->side; break;
+                }
+
+                Log.write<LogLevel::WARN>(LOG_GATEWAY_REJECT, [&](LogElement& e) {
+                    e.data_object.ogw = {client_order_id, -1, 0.0f, 0, session.trader_id, side, header->msg_type, 0u};
+                });
+                return oeEncodeExecutionReport(out, session.next_out_seq++, client_order_id, 0.0f, 0, side, 'R');
+            }
+
             void run(
                      std::atomic<bool>& start_order_gateway,
                      std::atomic<bool>& terminate_order_gateway                    
@@ -114,110 +738,209 @@ namespace internal_lib {
 
                 // NOW !!!!!!!!!!!!
                 while(!terminate_order_gateway.load(std::memory_order_acquire)){
-                    
-                        // take input from sniper
-                        UserOrder* readOrder = SniperOrderQueue->getNextRead(); 
-
-                        if(LIKELY(readOrder != nullptr)) {
-                            // testing
-                            compiler_barrier();
-                            uint64_t arrived_cc = now_cycles(); // serialized timestamp when it arrived
-                            compiler_barrier();
-
-                            int sys_id = GetOrAssignSystemId(readOrder->order_id, readOrder->req_type);
-
-                            compiler_barrier();
-                            uint64_t og_work_done = now_cycles(); // serialized timestamp when processing complete
-                            compiler_barrier();
-
-                            Order_Gateway_processing_Time.push_back(og_work_done - arrived_cc);
-
-                            LOBOrder* writeSlot = LobOrderQueue->getNextWrite();
-                            if(LIKELY(writeSlot != nullptr)) {
-                            // zero copy write directly to buffer
-                                // write now
-
-                                writeSlot->arrived_cycle_count = arrived_cc; // cyce count when it got popped out at order gateway. // this will be used later.
-                                writeSlot->system_id = sys_id;
-                                writeSlot->order_type = readOrder->order_type;
-                                writeSlot->quantity = readOrder->quantity;
-                                writeSlot->price = readOrder->price;
-                                writeSlot->req_type = readOrder->req_type;
-                                writeSlot->trader_id = readOrder->trader_id; // sniper is 0
-                                writeSlot->out_cycle_count = now_cycles(); // the moment this was out from Order Gateway and pushed in LOBOrder queue
-                            
-                                LobOrderQueue->updateWrite();
-                                SniperOrderQueue->updateRead();
-
-                                // throttle: slow down ogw to match me consumption rate
-                                busy_spin_throttle();
-                            }
-                        }
-
-                        // take from market maker ---> we will only define a queue as of now for market maker but nothign will be there as of now 
-                        readOrder = MMOrderQueue->getNextRead();
-                        
-                        if(LIKELY(readOrder != nullptr)) {
-                        
-                        LOBOrder* writeSlot = LobOrderQueue->getNextWrite();
-                        
-                        if(LIKELY(writeSlot != nullptr)) {
-                            // zero copy write directly to buffer
-                            writeSlot->arrived_cycle_count = now_cycles();
-                            writeSlot->system_id = GetOrAssignSystemId(readOrder->order_id, readOrder->req_type);
-                            writeSlot->order_type = readOrder->order_type;
-                            writeSlot->quantity = readOrder->quantity;
-                            writeSlot->price = readOrder->price;
-                            writeSlot->req_type = readOrder->req_type;
-                            writeSlot->trader_id = readOrder->trader_id;
-                            
-                            LobOrderQueue->updateWrite();
-                            MMOrderQueue->updateRead();
-                        }
-                        }
-
-                        // process acknowledgements 
-                        LOBAcknowledgement* readAck = LobAckQueue->getNextRead();
-                    
-                        if(LIKELY(readAck != nullptr)) {
-                        
-                        // check who sent the order (sniper=0 or MM)
-                        // change in architecture -------> acknowledgements will only be created and sent for Sniper, market maker is just responsible for filling in market traffic.
-                        LFQueue<UserAcknowledgement>* targetQueue;
-
-                        // if(readAck->traderId == 1) { // we will publish for Alpha engine so we can copmment out this if 
-
-                            targetQueue = SniperAckQueue; 
-                        
-                            UserAcknowledgement* writeAck = targetQueue->getNextWrite();
-                        
-                            if(LIKELY(writeAck != nullptr)) {
-                                writeAck->order_id = SystemToOrderId(readAck->system_id);
-                                writeAck->quantity = readAck->quantity;
-                                writeAck->price = readAck->price;
-                                writeAck->status = readAck->status;
-                                writeAck->side = readAck->side;
-
-                                // always a good practice to commit first and then only update read unless you have a strong durability mechanism.
-                                targetQueue->updateWrite();
-                                LobAckQueue->updateRead();
-                            }
-                        // } 
-                        }
-                    
+                    poll();
                 }
 
                 std::this_thread::sleep_for(std::chrono::seconds(6)); // wait 6 seconds
 
-                std::string ogpt = "Order Gateway Processing Time";
+                std::string ogpt = "Order Gateway [" + std::to_string(gateway_id) + "] Processing Time";
 
                 double cpns = internal_lib::get_cycles_per_ns();
                 internal_lib::showBench(ogpt, Order_Gateway_processing_Time, cpns);
 
+                std::string nol = "Order Gateway [" + std::to_string(gateway_id) + "] New Order Latency (stamp -> LOB)";
+                internal_lib::showBench(nol, New_Order_Latency, cpns);
+                std::string cl = "Order Gateway [" + std::to_string(gateway_id) + "] Cancel/Replace Latency (stamp -> LOB)";
+                internal_lib::showBench(cl, Cancel_Latency, cpns);
+
                 return ;
 
                 
             }
+
+            std::vector<uint64_t>& getProcessingTimes() noexcept { return Order_Gateway_processing_Time; }
+
+        private :
+
+            inline void recordIngressLatency(char req_type, uint64_t stamp, uint64_t forwarded) noexcept {
+                if(stamp == 0) return;
+                if(req_type == 'c') New_Order_Latency.push_back(forwarded - stamp);
+                else Cancel_Latency.push_back(forwarded - stamp);
+            }
+
+            // the client order id -> system id mapping, an audit reads the engine's records (system ids only) through it
+            inline void logForward(const LOBOrder* order, long long order_id) noexcept {
+                Log.write<LogLevel::INFO>(LOG_GATEWAY_ORDER, order->arrived_cycle_count, [&](LogElement& e) {
+                    e.data_object.ogw = {order_id, order->system_id, order->price, order->quantity, order->trader_id, order->order_type, order->req_type, 0u};
+                });
+            }
+
+            inline void writeLOBOrder(LOBOrder* writeSlot, const UserOrder* readOrder, int sys_id, uint64_t arrived_cc) noexcept {
+                writeSlot->arrived_cycle_count = arrived_cc; // cyce count when it got popped out at order gateway. // this will be used later.
+                writeSlot->system_id = sys_id;
+                writeSlot->order_type = readOrder->order_type;
+                writeSlot->quantity = readOrder->quantity;
+                writeSlot->price = readOrder->price;
+                writeSlot->req_type = readOrder->req_type;
+                writeSlot->trader_id = readOrder->trader_id; // sniper is 0
+                writeSlot->out_cycle_count = now_cycles(); // the moment this was out from Order Gateway and pushed in LOBOrder queue
+            }
+
+            // translate + publish one engine ack. 'X' (id released) acks are consumed here and never reach the user.
+            // returns false if the user queue is full, the ack then stays in LobAckQueue for the next round.
+            inline bool routeAck(const LOBAcknowledgement* readAck) noexcept {
+                if(readAck->status == 'X') {
+                    ReleaseSystemId(readAck->system_id);
+                    return true;
+                }
+
+                short trader_id = readAck->trader_id;
+                if(UNLIKELY(static_cast<unsigned>(trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS))) {
+                    unrouted_acks++;
+                    return true;
+                }
+
+                if(readAck->status == 'T' && LIKELY(IdAllocator.isLive(readAck->system_id))) {
+                    Risk.onFill(trader_id, LUT[IdAllocator.localIndex(readAck->system_id)].risk, readAck->quantity);
+                }
+
+                const AckRoute& route = AckRoutes[trader_id];
+                if(route.network) return routeSessionAck(readAck, trader_id);
+
+                LFQueue<UserAcknowledgement>* targetQueue = route.queue;
+                if(UNLIKELY(targetQueue == nullptr)) {
+                    unrouted_acks++;
+                    return true;
+                }
+
+                UserAcknowledgement* writeAck = targetQueue->getNextWrite();
+                if(UNLIKELY(writeAck == nullptr)) return false;
+
+                writeUserAck(writeAck, readAck, SystemToOrderId(readAck->system_id));
+                targetQueue->updateWrite();
+                return true;
+            }
+
+            inline bool routeSessionAck(const LOBAcknowledgement* readAck, short trader_id) noexcept {
+                OEFrame* frame = SessionOutbound->getNextWrite();
+                if(UNLIKELY(frame == nullptr)) return false;
+
+                frame->trader_id = trader_id;
+                frame->length = static_cast<uint16_t>(encodeExecutionReport(*readAck, NetSessions[trader_id], frame->msg));
+                SessionOutbound->updateWrite();
+                return true;
+            }
+
+            // runs the pre trade checks for an order that already has its system id. a rejected create never reaches the engine,
+            // so its id goes straight back to the allocator.
+            inline bool passRisk(short trader_id, char req_type, int sys_id, char side, float price, int quantity, uint64_t now) noexcept {
+                if(UNLIKELY(!risk_enabled)) return true;
+                if(UNLIKELY(risk_clock != nullptr)) now = *risk_clock;
+
+                uint32_t reasons = Risk.check(req_type, trader_id, LUT[IdAllocator.localIndex(sys_id)].risk, side, price, quantity, now);
+                if(LIKELY(reasons == 0)) return true;
+
+                Log.write<LogLevel::WARN>(LOG_GATEWAY_RISK, [&](LogElement& e) {
+                    e.data_object.ogw = {SystemToOrderId(sys_id), sys_id, price, quantity, trader_id, side, req_type, reasons};
+                });
+
+                if(req_type == 'c') ReleaseSystemId(sys_id);
+                risk_rejects++;
+                return false;
+            }
+
+            inline bool passRisk(const UserOrder* order, int sys_id, uint64_t now) noexcept {
+                return passRisk(order->trader_id, order->req_type, sys_id, order->order_type, order->price, order->quantity, now);
+            }
+
+            inline bool passRisk(const LOBOrder& order, uint64_t now) noexcept {
+                return passRisk(order.trader_id, order.req_type, order.system_id, order.order_type, order.price, order.quantity, now);
+            }
+
+            inline DecodeStatus mapNewOrder(const OENewOrder* msg, short trader_id, LOBOrder* writeSlot, uint64_t arrived_cc) noexcept {
+                long long key = makeOrderKey(trader_id, msg->client_order_id);
+                int sys_id = GetOrAssignSystemId(key, 'c');
+                if(UNLIKELY(sys_id == -1)) return (BPTree.find(key) != -1) ? DecodeStatus::DUPLICATE_ORDER_ID : DecodeStatus::UNKNOWN_ORDER;
+
+                writeSlot->system_id = sys_id;
+                writeSlot->price = msg->price;
+                writeSlot->quantity = msg->quantity;
+                writeSlot->order_type = msg->side;
+                writeSlot->req_type = 'c';
+                writeSlot->trader_id = trader_id;
+                if(UNLIKELY(!passRisk(*writeSlot, arrived_cc))) return DecodeStatus::RISK_REJECT;
+                return DecodeStatus::OK;
+            }
+
+            inline DecodeStatus mapCancelOrder(const OECancelOrder* msg, short trader_id, LOBOrder* writeSlot) noexcept {
+                int sys_id = BPTree.find(makeOrderKey(trader_id, msg->client_order_id));
+                if(UNLIKELY(sys_id == -1)) return DecodeStatus::UNKNOWN_ORDER;
+
+                writeSlot->system_id = sys_id;
+                writeSlot->price = 0;
+                writeSlot->quantity = 0;
+                writeSlot->order_type = msg->side;
+                writeSlot->req_type = 'd';
+                return DecodeStatus::OK;
+            }
+
+            inline DecodeStatus mapReplaceOrder(const OEReplaceOrder* msg, short trader_id, LOBOrder* writeSlot, uint64_t arrived_cc) noexcept {
+                int sys_id = BPTree.find(makeOrderKey(trader_id, msg->client_order_id));
+                if(UNLIKELY(sys_id == -1)) return DecodeStatus::UNKNOWN_ORDER;
+
+                writeSlot->system_id = sys_id;
+                writeSlot->price = msg->price;
+                writeSlot->quantity = msg->quantity;
+                writeSlot->order_type = msg->side;
+                writeSlot->req_type = 'u';
+                writeSlot->trader_id = trader_id;
+                if(UNLIKELY(!passRisk(*writeSlot, arrived_cc))) return DecodeStatus::RISK_REJECT;
+                return DecodeStatus::OK;
+            }
+
+            inline DecodeStatus mapMassCancel(const OEMassCancel* msg, short /*trader_id*/, LOBOrder* writeSlot) noexcept {
+                // no single order behind it, the engine walks the book for the trader
+                writeSlot->system_id = -1;
+                writeSlot->price = 0;
+                writeSlot->quantity = 0;
+                writeSlot->order_type = msg->side;
+                writeSlot->req_type = 'm';
+                return DecodeStatus::OK;
+            }
+
+            // req_type : what was refused, a quote ('q') passes the create / replace it was resolved to
+            inline void rejectToUser(const UserOrder* readOrder, char req_type = 0) noexcept {
+                Log.write<LogLevel::WARN>(LOG_GATEWAY_REJECT, [&](LogElement& e) {
+                    e.data_object.ogw = {readOrder->order_id, -1, readOrder->price, readOrder->quantity, readOrder->trader_id, readOrder->order_type, readOrder->req_type, 0u};
+                });
+
+                if(UNLIKELY(static_cast<unsigned>(readOrder->trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS))) return;
+                LFQueue<UserAcknowledgement>* targetQueue = AckRoutes[readOrder->trader_id].queue;
+                if(UNLIKELY(targetQueue == nullptr)) return;
+
+                UserAcknowledgement* writeAck = targetQueue->getNextWrite();
+                if(UNLIKELY(writeAck == nullptr)) return;
+
+                writeAck->order_id = readOrder->order_id;
+                writeAck->price = readOrder->price;
+                writeAck->quantity = 0;
+                writeAck->system_id = -1;
+                writeAck->side = (readOrder->order_type == 'b') ? 'B' : 'S';
+                writeAck->status = 'R';
+                writeAck->req_type = (req_type != 0) ? req_type : readOrder->req_type;
+                targetQueue->updateWrite();
+            }
+
+            inline void writeUserAck(UserAcknowledgement* writeAck, const LOBAcknowledgement* readAck, long long order_id) noexcept {
+                writeAck->order_id = order_id;
+                writeAck->quantity = readAck->quantity;
+                writeAck->price = readAck->price;
+                writeAck->system_id = readAck->system_id;
+                writeAck->status = readAck->status;
+                writeAck->side = readAck->side;
+                writeAck->req_type = (readAck->status == 'R') ? 'u' : 0; // the engine only refuses replaces, a create it can not book is 'K'
+            }
     };
-}
 
+    using OrderGateway = BasicOrderGateway<>; // split pipeline : engine behind the LOB queue
+}
@@ -0,0 +1,233 @@
+// historical order flow replay ---> streams a recording (replay_format.h) into the gateway order queues.
+//
+// the file is mapped read only and pre-faulted (MAP_POPULATE), events are copied straight from the mapping into the
+// UserOrder slots of the queues, so the replay loop does no allocation, no syscalls and takes no page faults.
+// every trader id is routed through a direct indexed table to an order queue (and optionally the cancel lane of that source,
+// which then gets the cancels / replaces). traders without a route are skipped and counted.
+// the mapping itself is a ReplayMapping : a driver opens its own, or several drivers (a backtest sweep, one per worker thread)
+// attach to one shared read only mapping, each with its own read position.
+//
+// timing : speed 0 sends as fast as the queues take it, speed k > 0 keeps the recorded gaps scaled by 1 / k (1 = recorded
+// timing, 10 = ten times faster). a full queue never drops an event, the replay waits for it (counted as a stall) and the
+// events behind it are late, the worst lag behind the schedule is reported.
+
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include <atomic>
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "order_entry_protocol.h" // OE_MAX_TRADERS
+#include "replay_format.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	// read only mapping of a recording, safe to share between threads once open() returned
+	class ReplayMapping {
+
+		private :
+
+			void* map_base = nullptr;
+			size_t map_bytes = 0;
+			const ReplayFileHeader* header = nullptr;
+			const ReplayEvent* events = nullptr;
+
+		public :
+
+			ReplayMapping() = default;
+			ReplayMapping(const ReplayMapping&) = delete;
+			ReplayMapping& operator=(const ReplayMapping&) = delete;
+
+			~ReplayMapping() {
+				if(map_base != nullptr) ::munmap(map_base, map_bytes);
+			}
+
+			// false if the file can not be mapped or is not a (complete) v1 recording
+			bool open(const char* path) noexcept {
+				int fd = ::open(path, O_RDONLY);
+				if(fd == -1) return false;
+
+				struct stat st;
+				if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ReplayFileHeader)) {
+					::close(fd);
+					return false;
+				}
+
+				map_bytes = static_cast<size_t>(st.st_size);
+				void* mem = ::mmap(nullptr, map_bytes, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+				::close(fd);
+				if(mem == MAP_FAILED) return false;
+				::madvise(mem, map_bytes, MADV_SEQUENTIAL);
+				map_base = mem;
+
+				header = static_cast<const ReplayFileHeader*>(mem);
+				if(header->magic != REPLAY_MAGIC || header->version != REPLAY_VERSION || header->event_size != sizeof(ReplayEvent) ||
+				   header->event_count > (map_bytes - sizeof(ReplayFileHeader)) / sizeof(ReplayEvent)) {
+					::munmap(map_base, map_bytes);
+					map_base = nullptr;
+					header = nullptr;
+					return false;
+				}
+
+				events = reinterpret_cast<const ReplayEvent*>(static_cast<const char*>(mem) + sizeof(ReplayFileHeader));
+				return true;
+			}
+
+			bool isOpen() const noexcept { return header != nullptr; }
+			const ReplayFileHeader* getHeader() const noexcept { return header; }
+			const ReplayEvent* getEvents() const noexcept { return events; }
+			uint64_t getEventCount() const noexcept { return (header != nullptr) ? header->event_count : 0; }
+	};
+
+	class ReplayDriver {
+
+		private :
+
+			struct Route {
+				LFQueue<UserOrder>* orders = nullptr;
+				LFQueue<UserOrder>* cancels = nullptr;   // nullptr = cancels / replaces go to orders
+			};
+
+			std::vector<Route> Routes;
+
+			// recording : our own mapping (open) or a shared one (attach)
+			ReplayMapping own_mapping;
+			const ReplayFileHeader* header = nullptr;
+			const ReplayEvent* events = nullptr;
+			uint64_t event_count = 0;
+			uint64_t next_event = 0;
+
+			// timing
+			double cycles_per_ns;
+			double speed = 0.0;
+			double cycles_per_recorded_ns = 0.0;
+			uint64_t start_cycle = 0;
+
+			// stats
+			uint64_t sent = 0;
+			uint64_t unrouted = 0;
+			uint64_t stalls = 0;            // polls that found the target queue full
+			uint64_t max_lag_cycles = 0;    // worst send delay behind the (scaled) recorded time
+
+		public :
+
+			explicit ReplayDriver(double cpns) : Routes(OE_MAX_TRADERS), cycles_per_ns(cpns) {}
+
+			ReplayDriver(const ReplayDriver&) = delete;
+			ReplayDriver& operator=(const ReplayDriver&) = delete;
+
+			// false if the file can not be mapped or is not a (complete) v1 recording
+			bool open(const char* path) noexcept {
+				if(!own_mapping.open(path)) return false;
+				attach(own_mapping);
+				return true;
+			}
+
+			// replays from a mapping opened elsewhere (it must outlive the driver), from the first event
+			void attach(const ReplayMapping& mapping) noexcept {
+				header = mapping.getHeader();
+				events = mapping.getEvents();
+				event_count = mapping.getEventCount();
+				next_event = 0;
+			}
+
+			void setRoute(short trader_id, LFQueue<UserOrder>* orders, LFQueue<UserOrder>* cancels = nullptr) noexcept {
+				if(trader_id >= 0 && trader_id < OE_MAX_TRADERS) Routes[trader_id] = Route{orders, cancels};
+			}
+
+			// 0 = as fast as possible, k = recorded timing k times faster
+			void setSpeed(double k) noexcept { speed = (k < 0.0) ? 0.0 : k; }
+
+			// the first event is due at 'now'
+			void begin(uint64_t now) noexcept {
+				start_cycle = now;
+				cycles_per_recorded_ns = (speed > 0.0) ? cycles_per_ns / speed : 0.0;
+			}
+
+			// sends the events due by 'now' (at most max_events), returns how many were sent. begin() first
+			int poll(uint64_t now, int max_events = 64) noexcept {
+				int n = 0;
+				while(n < max_events && next_event < event_count) {
+					const ReplayEvent& ev = events[next_event];
+
+					uint64_t due = start_cycle;
+					if(speed > 0.0) {
+						due += static_cast<uint64_t>(static_cast<double>(ev.ts_ns - header->first_ts_ns) * cycles_per_recorded_ns);
+						if(now < due) break;
+					}
+
+					if(UNLIKELY(static_cast<unsigned>(ev.trader_id) >= static_cast<unsigned>(OE_MAX_TRADERS) || Routes[ev.trader_id].orders == nullptr)) {
+						unrouted++;
+						next_event++;
+						continue;
+					}
+
+					const Route& route = Routes[ev.trader_id];
+					LFQueue<UserOrder>* lane = (ev.req_type != 'c' && route.cancels != nullptr) ? route.cancels : route.orders;
+					UserOrder* o = lane->getNextWrite();
+					if(UNLIKELY(o == nullptr)) {
+						stalls++;
+						break;
+					}
+
+					if(speed > 0.0 && now - due > max_lag_cycles) max_lag_cycles = now - due;
+
+					o->arrived_cycle_count = now_cycles();
+					o->order_id = ev.order_id;
+					o->trader_id = ev.trader_id;
+					o->order_type = ev.order_type;
+					o->req_type = ev.req_type;
+					o->price = ev.price;
+					o->quantity = ev.quantity;
+					o->out_cycle_count = o->arrived_cycle_count;
+					lane->updateWrite();
+
+					next_event++;
+					sent++;
+					n++;
+				}
+				return n;
+			}
+
+			bool done() const noexcept { return next_event >= event_count; }
+
+			// cycle the next event is due at (begin() first), UINT64_MAX once done
+			uint64_t nextDue() const noexcept {
+				if(done()) return UINT64_MAX;
+				if(speed <= 0.0) return start_cycle;
+				return start_cycle + static_cast<uint64_t>(static_cast<double>(events[next_event].ts_ns - header->first_ts_ns) * cycles_per_recorded_ns);
+			}
+
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				begin(now_cycles());
+				while(!done() && !terminate.load(std::memory_order_acquire)) {
+					poll(now_cycles());
+				}
+
+				double elapsed_ns = static_cast<double>(now_cycles() - start_cycle) / cycles_per_ns;
+				std::cout << "[REPLAY] sent " << sent << "/" << event_count << " events in " << elapsed_ns * 1e-6 << " ms ("
+						  << static_cast<double>(sent) / (elapsed_ns * 1e-9) << "/s) , unrouted " << unrouted << " , stalls " << stalls
+						  << " , worst lag " << static_cast<double>(max_lag_cycles) / cycles_per_ns << " ns\n";
+			}
+
+			uint64_t getEventCount() const noexcept { return event_count; }
+			uint64_t getSent() const noexcept { return sent; }
+			uint64_t getUnrouted() const noexcept { return unrouted; }
+			uint64_t getStalls() const noexcept { return stalls; }
+			uint64_t getMaxLagCycles() const noexcept { return max_lag_cycles; }
+			uint64_t getRecordedSpanNs() const noexcept { return (header != nullptr) ? header->last_ts_ns - header->first_ts_ns : 0; }
+	};
+}
@@ -0,0 +1,239 @@
+// bundled order entry client for the session server (loopback testing, benchmarks, simple tools).
+// non blocking socket driven by poll() from the caller's own loop, no threads of its own.
+// keeps the last HISTORY_SIZE sent messages so it can resend whatever the server did not get before a disconnect.
+
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "order_entry_protocol.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	class OrderEntryClient {
+
+		private :
+
+			static constexpr size_t RX_BUFFER_SIZE = 64 * 1024;
+			static constexpr size_t TX_BUFFER_SIZE = 256 * 1024;
+			static constexpr uint32_t HISTORY_SIZE = 1 << 14; // sent messages kept for resend (power of 2)
+
+			int fd = -1;
+			short trader_id;
+			bool logged_on = false;
+			char logout_reason = 0;
+
+			uint32_t next_out_seq = 1;  // seq of the next order entry message we send
+			uint32_t next_in_seq = 1;   // seq of the next execution report we expect
+
+			std::vector<char> rx;
+			size_t rx_len = 0;
+			std::vector<char> tx;
+			size_t tx_len = 0;
+			std::vector<char> history;  // HISTORY_SIZE slots of OE_MAX_MESSAGE_SIZE, indexed by seq
+
+		public :
+
+			explicit OrderEntryClient(short trader) : trader_id(trader) {
+				rx.resize(RX_BUFFER_SIZE);
+				tx.resize(TX_BUFFER_SIZE);
+				history.resize(static_cast<size_t>(HISTORY_SIZE) * OE_MAX_MESSAGE_SIZE);
+			}
+
+			OrderEntryClient(const OrderEntryClient&) = delete;
+			OrderEntryClient& operator=(const OrderEntryClient&) = delete;
+
+			~OrderEntryClient() { disconnect(); }
+
+			// blocking connect, the socket is switched to non blocking afterwards
+			bool connect(const char* address, uint16_t port) noexcept {
+				fd = ::socket(AF_INET, SOCK_STREAM, 0);
+				if(fd == -1) return false;
+
+				sockaddr_in addr{};
+				addr.sin_family = AF_INET;
+				addr.sin_port = htons(port);
+				if(::inet_pton(AF_INET, address, &addr.sin_addr) != 1 ||
+				   ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+					disconnect();
+					return false;
+				}
+
+				int one = 1;
+				::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+				::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+				return true;
+			}
+
+			void disconnect() noexcept {
+				if(fd != -1) ::close(fd);
+				fd = -1;
+				logged_on = false;
+				rx_len = 0;
+				tx_len = 0;
+			}
+
+			// the accept arrives through poll(), wait for isLoggedOn()
+			void sendLogon(uint16_t heartbeat_ms = 0) noexcept {
+				OELogon logon{};
+				header(logon.header, 'L', sizeof(logon), 0);
+				logon.trader_id = trader_id;
+				logon.heartbeat_ms = heartbeat_ms;
+				logon.next_expected_seq = next_in_seq;
+				queue(reinterpret_cast<const char*>(&logon), sizeof(logon));
+				flush();
+			}
+
+			void sendLogout() noexcept {
+				OELogout logout{};
+				header(logout.header, 'O', sizeof(logout), 0);
+				logout.reason = 'U';
+				queue(reinterpret_cast<const char*>(&logout), sizeof(logout));
+				flush();
+			}
+
+			void sendHeartbeat() noexcept {
+				OEHeartbeat hb{};
+				header(hb.header, 'H', sizeof(hb), 0);
+				queue(reinterpret_cast<const char*>(&hb), sizeof(hb));
+			}
+
+			// order entry messages are only queued, flush() puts everything queued on the wire with one send()
+			uint32_t newOrder(int32_t client_order_id, float price, int32_t quantity, char side) noexcept {
+				OENewOrder m{};
+				header(m.header, 'N', sizeof(m), next_out_seq);
+				m.client_order_id = client_order_id;
+				m.price = price;
+				m.quantity = quantity;
+				m.side = side;
+				return sequenced(reinterpret_cast<const char*>(&m), sizeof(m));
+			}
+
+			uint32_t cancelOrder(int32_t client_order_id, char side) noexcept {
+				OECancelOrder m{};
+				header(m.header, 'C', sizeof(m), next_out_seq);
+				m.client_order_id = client_order_id;
+				m.side = side;
+				return sequenced(reinterpret_cast<const char*>(&m), sizeof(m));
+			}
+
+			uint32_t replaceOrder(int32_t client_order_id, float price, int32_t quantity, char side) noexcept {
+				OEReplaceOrder m{};
+				header(m.header, 'R', sizeof(m), next_out_seq);
+				m.client_order_id = client_order_id;
+				m.price = price;
+				m.quantity = quantity;
+				m.side = side;
+				return sequenced(reinterpret_cast<const char*>(&m), sizeof(m));
+			}
+
+			uint32_t massCancel(char side) noexcept {
+				OEMassCancel m{};
+				header(m.header, 'M', sizeof(m), next_out_seq);
+				m.side = side;
+				return sequenced(reinterpret_cast<const char*>(&m), sizeof(m));
+			}
+
+			bool flush() noexcept {
+				if(tx_len == 0 || fd == -1) return true;
+				ssize_t sent = ::send(fd, tx.data(), tx_len, MSG_NOSIGNAL);
+				if(sent < 0) return (errno == EAGAIN || errno == EWOULDBLOCK);
+
+				size_t left = tx_len - static_cast<size_t>(sent);
+				if(left != 0) std::memmove(tx.data(), tx.data() + sent, left);
+				tx_len = left;
+				return true;
+			}
+
+			// reads whatever arrived and calls on_report(const OEExecutionReport&) for every new execution report.
+			// returns the number of reports, -1 once the connection is gone (see getLogoutReason()).
+			template <typename OnReport>
+			int poll(OnReport&& on_report) noexcept {
+				if(UNLIKELY(fd == -1)) return -1;
+				flush();
+
+				ssize_t got = ::recv(fd, rx.data() + rx_len, RX_BUFFER_SIZE - rx_len, 0);
+				if(got == 0) { disconnect(); return -1; }
+				if(got < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : (disconnect(), -1);
+				rx_len += static_cast<size_t>(got);
+
+				int reports = 0;
+				size_t pos = 0;
+				while(rx_len - pos >= sizeof(OEHeader)) {
+					const OEHeader* h = reinterpret_cast<const OEHeader*>(rx.data() + pos);
+					if(rx_len - pos < h->length) break;
+
+					if(LIKELY(h->msg_type == 'E')) {
+						if(LIKELY(h->seq_num == next_in_seq)) { // lower = replay overlap, already seen
+							next_in_seq++;
+							on_report(*reinterpret_cast<const OEExecutionReport*>(h));
+							reports++;
+						}
+					} else if(h->msg_type == 'A') {
+						logged_on = true;
+						resendFrom(reinterpret_cast<const OELogonAccept*>(h)->next_expected_seq);
+					} else if(h->msg_type == 'O') {
+						logout_reason = reinterpret_cast<const OELogout*>(h)->reason;
+						disconnect();
+						return -1;
+					}
+					pos += h->length;
+				}
+
+				if(pos != 0) {
+					std::memmove(rx.data(), rx.data() + pos, rx_len - pos);
+					rx_len -= pos;
+				}
+				return reports;
+			}
+
+			bool isLoggedOn() const noexcept { return logged_on; }
+			bool isConnected() const noexcept { return fd != -1; }
+			char getLogoutReason() const noexcept { return logout_reason; }
+			uint32_t getNextOutSeq() const noexcept { return next_out_seq; }
+			uint32_t getNextInSeq() const noexcept { return next_in_seq; }
+
+		private :
+
+			uint32_t sequenced(const char* msg, size_t len) noexcept {
+				std::memcpy(history.data() + static_cast<size_t>(next_out_seq & (HISTORY_SIZE - 1)) * OE_MAX_MESSAGE_SIZE, msg, len);
+				queue(msg, len);
+				return next_out_seq++;
+			}
+
+			// the server has everything before 'from', resend the rest (we may have queued them into a dead connection)
+			void resendFrom(uint32_t from) noexcept {
+				for(uint32_t seq = from; seq != next_out_seq; seq++) {
+					const char* msg = history.data() + static_cast<size_t>(seq & (HISTORY_SIZE - 1)) * OE_MAX_MESSAGE_SIZE;
+					queue(msg, reinterpret_cast<const OEHeader*>(msg)->length);
+				}
+				flush();
+			}
+
+			inline void queue(const char* bytes, size_t len) noexcept {
+				if(UNLIKELY(tx_len + len > TX_BUFFER_SIZE)) flush();
+				if(UNLIKELY(tx_len + len > TX_BUFFER_SIZE)) return; // still full, the resend on the next logon recovers it
+				std::memcpy(tx.data() + tx_len, bytes, len);
+				tx_len += len;
+			}
+
+			static inline void header(OEHeader& h, char type, uint16_t length, uint32_t seq) noexcept {
+				h.length = length;
+				h.msg_type = type;
+				h.version = OE_PROTOCOL_VERSION;
+				h.seq_num = seq;
+			}
+	};
+}
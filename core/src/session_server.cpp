@@ -0,0 +1,512 @@
+// TCP session layer in front of the order gateway.
+//
+// one dedicated, busy polling network thread owns every client connection (non blocking sockets + epoll with a zero timeout,
+// so the thread never sleeps in the kernel). it does everything that is about the connection and nothing that is about the order :
+//   logon / logout, heartbeats, sequence numbers (duplicates dropped, gaps are a protocol error on TCP), replay of missed
+//   execution reports on re-logon, framing of the byte stream into messages.
+// complete in sequence application messages are handed to the gateway over one SPSC ring (OEFrame), the gateway decodes them
+// (decodeOrderEntry) and sends execution reports back over a second SPSC ring. the session layer then only copies bytes.
+// when a logged on trader goes away the gateway gets an 'O' frame on the same ring and stops routing its acks to the session.
+//
+// batched receive : every readable socket is drained with one big recv() into the connection's buffer and every complete
+// message in it is framed in the same pass, so at load one syscall carries hundreds of orders. outbound bytes are gathered per
+// connection and flushed with one send() per connection per poll.
+
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "lf_queue.h"
+#include "order_entry_protocol.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	class SessionServer {
+
+		private :
+
+			static constexpr size_t RX_BUFFER_SIZE = 64 * 1024;
+			static constexpr size_t TX_BUFFER_SIZE = 256 * 1024; // more than this pending towards one client = slow consumer, cut it
+			static constexpr int MAX_EVENTS = 64;
+			static constexpr uint32_t HISTORY_SIZE = 1 << 14; // execution reports kept per trader for replay (power of 2)
+			static constexpr uint16_t DEFAULT_HEARTBEAT_MS = 1000;
+			static constexpr uint32_t LISTENER = 0xFFFFFFFF; // epoll tag of the listening socket
+
+			struct Connection {
+				int fd = -1;
+				short trader_id = -1;          // -1 until logon
+				std::vector<char> rx;
+				size_t rx_len = 0;
+				std::vector<char> tx;
+				size_t tx_len = 0;
+				uint64_t last_rx_cycle = 0;
+				uint64_t last_tx_cycle = 0;
+				uint64_t heartbeat_cycles = 0;
+				bool dirty = false;            // has bytes in tx waiting for the flush of this poll
+			};
+
+			// sequence state belongs to the trader, a connection only borrows it while logged on
+			struct TraderState {
+				uint32_t next_in_seq = 1;      // next order entry seq we forward to the gateway
+				uint32_t next_out_seq = 1;     // seq of the next execution report (stamped by the gateway, tracked here)
+				int connection = -1;
+				bool in_process = false;       // its acks go to an in process consumer (reserveTrader), no logon
+				std::vector<char> history;     // HISTORY_SIZE slots of OE_MAX_MESSAGE_SIZE, indexed by seq
+			};
+
+			// gateway communication
+			LFQueue<OEFrame>* InboundQueue;    // session -> gateway
+			LFQueue<OEFrame>* OutboundQueue;   // gateway -> session
+
+			int listen_fd = -1;
+			int epoll_fd = -1;
+
+			std::vector<Connection> connections; // indexed by the epoll tag
+			std::vector<int> free_connections;
+			std::vector<int> dirty_connections;
+			std::vector<TraderState> traders;
+
+			double cycles_per_ns;
+			uint64_t timer_interval_cycles;
+			uint64_t next_timer_cycle = 0;
+			bool inbound_stalled = false;      // gateway ring was full, some rx buffers still hold complete messages
+			std::vector<short> pending_logouts; // traders whose logout notice did not fit in the gateway ring yet
+
+			// stats
+			uint64_t messages_in = 0;
+			uint64_t messages_out = 0;
+			uint64_t recv_calls = 0;
+
+		public :
+
+			SessionServer(LFQueue<OEFrame>* inbound, LFQueue<OEFrame>* outbound, int max_connections = 256)
+				:
+				InboundQueue(inbound),
+				OutboundQueue(outbound)
+				{
+				connections.resize(max_connections);
+				free_connections.reserve(max_connections);
+				for(int c = max_connections - 1; c >= 0; c--) free_connections.push_back(c);
+				dirty_connections.reserve(max_connections);
+
+				traders.resize(OE_MAX_TRADERS);
+				pending_logouts.reserve(max_connections);
+				cycles_per_ns = get_cycles_per_ns();
+				timer_interval_cycles = static_cast<uint64_t>(cycles_per_ns * 1000000.0); // timers are checked once per ms
+			}
+
+			SessionServer(const SessionServer&) = delete;
+			SessionServer& operator=(const SessionServer&) = delete;
+
+			~SessionServer() {
+				for(auto& conn : connections) if(conn.fd != -1) ::close(conn.fd);
+				if(listen_fd != -1) ::close(listen_fd);
+				if(epoll_fd != -1) ::close(epoll_fd);
+			}
+
+			// port 0 = any free port, returns the bound port (0 on failure)
+			uint16_t listen(uint16_t port, const char* address = "127.0.0.1") noexcept {
+				epoll_fd = ::epoll_create1(0);
+				listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+				if(epoll_fd == -1 || listen_fd == -1) return 0;
+
+				int one = 1;
+				::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+				sockaddr_in addr{};
+				addr.sin_family = AF_INET;
+				addr.sin_port = htons(port);
+				if(::inet_pton(AF_INET, address, &addr.sin_addr) != 1) return 0;
+				if(::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return 0;
+				if(::listen(listen_fd, 128) != 0) return 0;
+
+				epoll_event ev{};
+				ev.events = EPOLLIN;
+				ev.data.u32 = LISTENER;
+				if(::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) != 0) return 0;
+
+				socklen_t len = sizeof(addr);
+				::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+				return ntohs(addr.sin_port);
+			}
+
+			// one round of the network thread : socket events, gateway replies, flush, timers. returns the number of socket events
+			int poll() noexcept {
+				epoll_event events[MAX_EVENTS];
+				int n = ::epoll_wait(epoll_fd, events, MAX_EVENTS, 0);
+
+				if(UNLIKELY(!pending_logouts.empty())) flushLogouts();
+				if(UNLIKELY(inbound_stalled)) retryStalled();
+
+				for(int e = 0; e < n; e++) {
+					uint32_t tag = events[e].data.u32;
+					if(UNLIKELY(tag == LISTENER)) {
+						acceptAll();
+						continue;
+					}
+					Connection& conn = connections[tag];
+					if(UNLIKELY(conn.fd == -1)) continue; // closed earlier in this round
+
+					if(UNLIKELY(events[e].events & (EPOLLERR | EPOLLHUP))) {
+						closeConnection(static_cast<int>(tag));
+						continue;
+					}
+					if(events[e].events & EPOLLOUT) markDirty(static_cast<int>(tag)); // kernel buffer drained, retry the flush
+					if(events[e].events & EPOLLIN) readConnection(static_cast<int>(tag));
+				}
+
+				drainOutbound();
+				flushAll();
+
+				uint64_t now = now_cycles();
+				if(UNLIKELY(now >= next_timer_cycle)) {
+					checkTimers(now);
+					next_timer_cycle = now + timer_interval_cycles;
+				}
+				return n;
+			}
+
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				while(!terminate.load(std::memory_order_acquire)) {
+					poll();
+				}
+
+				std::cout << "[SESSION SERVER] messages in : " << messages_in << " , messages out : " << messages_out
+						  << " , recv calls : " << recv_calls << "\n";
+			}
+
+			// trader ids the gateway serves in process (setAckRoute) : their logons are refused ('I'), a session can not take their
+			// acks over. call before run()
+			void reserveTrader(short trader_id) noexcept {
+				if(trader_id >= 0 && trader_id < OE_MAX_TRADERS) traders[trader_id].in_process = true;
+			}
+
+			uint64_t getMessagesIn() const noexcept { return messages_in; }
+			uint64_t getMessagesOut() const noexcept { return messages_out; }
+			uint64_t getRecvCalls() const noexcept { return recv_calls; }
+
+		private :
+
+			void acceptAll() noexcept {
+				while(true) {
+					int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+					if(fd == -1) return; // EAGAIN : backlog empty
+
+					if(UNLIKELY(free_connections.empty())) {
+						::close(fd);
+						continue;
+					}
+
+					int one = 1;
+					::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+					int index = free_connections.back();
+					free_connections.pop_back();
+
+					Connection& conn = connections[index];
+					conn.fd = fd;
+					conn.trader_id = -1;
+					conn.rx.resize(RX_BUFFER_SIZE);
+					conn.tx.resize(TX_BUFFER_SIZE);
+					conn.rx_len = 0;
+					conn.tx_len = 0;
+					conn.dirty = false;
+					conn.last_rx_cycle = conn.last_tx_cycle = now_cycles();
+					conn.heartbeat_cycles = static_cast<uint64_t>(cycles_per_ns * 1e6 * DEFAULT_HEARTBEAT_MS);
+
+					epoll_event ev{};
+					ev.events = EPOLLIN;
+					ev.data.u32 = static_cast<uint32_t>(index);
+					::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+				}
+			}
+
+			void readConnection(int index) noexcept {
+				Connection& conn = connections[index];
+
+				if(LIKELY(conn.rx_len < RX_BUFFER_SIZE)) {
+					ssize_t got = ::recv(conn.fd, conn.rx.data() + conn.rx_len, RX_BUFFER_SIZE - conn.rx_len, 0);
+					recv_calls++;
+
+					if(got == 0) { closeConnection(index); return; }
+					if(got < 0) {
+						if(errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(index);
+						return;
+					}
+					conn.rx_len += static_cast<size_t>(got);
+					conn.last_rx_cycle = now_cycles();
+				}
+
+				frameMessages(index);
+			}
+
+			// cut the rx buffer into messages. stops early (and leaves the rest in the buffer) when the gateway ring is full
+			void frameMessages(int index) noexcept {
+				Connection& conn = connections[index];
+				size_t pos = 0;
+				uint64_t rx_cycle = conn.last_rx_cycle;
+
+				while(conn.rx_len - pos >= sizeof(OEHeader)) {
+					const char* msg = conn.rx.data() + pos;
+					const OEHeader* header = reinterpret_cast<const OEHeader*>(msg);
+
+					uint16_t app_length = oeInboundLength(header->msg_type);
+					uint16_t expected = (app_length != 0) ? app_length : oeSessionLength(header->msg_type);
+					if(UNLIKELY(expected == 0 || header->length != expected || header->version != OE_PROTOCOL_VERSION)) {
+						logoutAndClose(index, 'P');
+						return;
+					}
+					if(conn.rx_len - pos < expected) break; // partial message, wait for the rest
+
+					if(LIKELY(app_length != 0)) {
+						if(UNLIKELY(conn.trader_id == -1)) { logoutAndClose(index, 'P'); return; } // orders before logon
+
+						TraderState& trader = traders[conn.trader_id];
+						if(UNLIKELY(header->seq_num != trader.next_in_seq)) {
+							if(header->seq_num > trader.next_in_seq) { logoutAndClose(index, 'S'); return; } // TCP can not lose bytes
+							pos += expected; // duplicate of something we already forwarded (resend overlap), drop it
+							continue;
+						}
+
+						// a logout notice still waiting goes first, a re-logon's orders must not overtake it
+						OEFrame* frame = LIKELY(pending_logouts.empty()) ? InboundQueue->getNextWrite() : nullptr;
+						if(UNLIKELY(frame == nullptr)) {
+							inbound_stalled = true; // gateway is behind, keep the bytes and retry next poll
+							break;
+						}
+						frame->rx_cycle_count = rx_cycle;
+						frame->trader_id = conn.trader_id;
+						frame->length = expected;
+						std::memcpy(frame->msg, msg, expected);
+						InboundQueue->updateWrite();
+
+						trader.next_in_seq++;
+						messages_in++;
+					} else if(!handleSessionMessage(index, msg)) {
+						return; // connection closed
+					}
+					pos += expected;
+				}
+
+				// compact : keep the partial tail at the front of the buffer
+				if(pos != 0) {
+					std::memmove(conn.rx.data(), conn.rx.data() + pos, conn.rx_len - pos);
+					conn.rx_len -= pos;
+				}
+			}
+
+			void retryStalled() noexcept {
+				inbound_stalled = false;
+				for(size_t c = 0; c < connections.size(); c++) {
+					if(connections[c].fd != -1 && connections[c].rx_len >= sizeof(OEHeader)) frameMessages(static_cast<int>(c));
+					if(inbound_stalled) return; // still full
+				}
+			}
+
+			// returns false if the connection got closed
+			bool handleSessionMessage(int index, const char* msg) noexcept {
+				Connection& conn = connections[index];
+				char type = reinterpret_cast<const OEHeader*>(msg)->msg_type;
+
+				if(type == 'H') return true; // last_rx_cycle already refreshed
+				if(type == 'O') { logoutAndClose(index, 'U'); return false; }
+				if(UNLIKELY(type != 'L' || conn.trader_id != -1)) { logoutAndClose(index, 'P'); return false; }
+
+				const OELogon* logon = reinterpret_cast<const OELogon*>(msg);
+				if(UNLIKELY(logon->trader_id < 0 || logon->trader_id >= OE_MAX_TRADERS)) { logoutAndClose(index, 'I'); return false; }
+
+				TraderState& trader = traders[logon->trader_id];
+				if(UNLIKELY(trader.in_process)) { logoutAndClose(index, 'I'); return false; }
+				if(UNLIKELY(trader.connection != -1)) { logoutAndClose(index, 'B'); return false; }
+
+				// the client wants execution reports from next_expected_seq on, we must still hold all of them
+				uint32_t from = logon->next_expected_seq;
+				if(UNLIKELY(from == 0 || from > trader.next_out_seq || trader.next_out_seq - from > HISTORY_SIZE)) {
+					logoutAndClose(index, 'S');
+					return false;
+				}
+
+				if(trader.history.empty()) trader.history.resize(static_cast<size_t>(HISTORY_SIZE) * OE_MAX_MESSAGE_SIZE);
+				trader.connection = index;
+				conn.trader_id = logon->trader_id;
+				uint16_t heartbeat_ms = (logon->heartbeat_ms != 0) ? logon->heartbeat_ms : DEFAULT_HEARTBEAT_MS;
+				conn.heartbeat_cycles = static_cast<uint64_t>(cycles_per_ns * 1e6 * heartbeat_ms);
+
+				OELogonAccept accept{};
+				sessionHeader(accept.header, 'A', sizeof(accept));
+				accept.next_expected_seq = trader.next_in_seq;
+				queueBytes(index, reinterpret_cast<const char*>(&accept), sizeof(accept));
+
+				// replay what the client missed while it was away
+				for(uint32_t seq = from; seq != trader.next_out_seq; seq++) {
+					const char* report = historySlot(trader, seq);
+					if(!queueBytes(index, report, reinterpret_cast<const OEHeader*>(report)->length)) return false;
+				}
+				return true;
+			}
+
+			// gateway -> clients. every report goes to the trader's history, and to the socket if the trader is logged on
+			void drainOutbound() noexcept {
+				OEFrame* frame;
+				while((frame = OutboundQueue->getNextRead()) != nullptr) {
+					TraderState& trader = traders[frame->trader_id];
+					if(UNLIKELY(trader.history.empty())) trader.history.resize(static_cast<size_t>(HISTORY_SIZE) * OE_MAX_MESSAGE_SIZE);
+
+					uint32_t seq = reinterpret_cast<const OEHeader*>(frame->msg)->seq_num;
+					std::memcpy(historySlot(trader, seq), frame->msg, frame->length);
+					trader.next_out_seq = seq + 1;
+
+					if(trader.connection != -1) queueBytes(trader.connection, frame->msg, frame->length);
+					messages_out++;
+					OutboundQueue->updateRead();
+				}
+			}
+
+			inline char* historySlot(TraderState& trader, uint32_t seq) noexcept {
+				return trader.history.data() + static_cast<size_t>(seq & (HISTORY_SIZE - 1)) * OE_MAX_MESSAGE_SIZE;
+			}
+
+			// returns false (and drops the connection) if the client is not reading fast enough
+			bool queueBytes(int index, const char* bytes, size_t len) noexcept {
+				Connection& conn = connections[index];
+				if(UNLIKELY(conn.tx_len + len > TX_BUFFER_SIZE)) {
+					closeConnection(index); // no logout, it would not fit either. the history keeps the reports for the re-logon
+					return false;
+				}
+				std::memcpy(conn.tx.data() + conn.tx_len, bytes, len);
+				conn.tx_len += len;
+				markDirty(index);
+				return true;
+			}
+
+			inline void markDirty(int index) noexcept {
+				if(!connections[index].dirty) {
+					connections[index].dirty = true;
+					dirty_connections.push_back(index);
+				}
+			}
+
+			void flushAll() noexcept {
+				for(size_t d = 0; d < dirty_connections.size(); d++) {
+					int index = dirty_connections[d];
+					Connection& conn = connections[index];
+					conn.dirty = false;
+					if(conn.fd == -1 || conn.tx_len == 0) continue;
+					flush(index);
+				}
+				dirty_connections.clear();
+			}
+
+			void flush(int index) noexcept {
+				Connection& conn = connections[index];
+				ssize_t sent = ::send(conn.fd, conn.tx.data(), conn.tx_len, MSG_NOSIGNAL);
+				if(sent < 0) {
+					if(errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(index);
+					else armWrite(index, true);
+					return;
+				}
+
+				conn.last_tx_cycle = now_cycles();
+				size_t left = conn.tx_len - static_cast<size_t>(sent);
+				if(left != 0) std::memmove(conn.tx.data(), conn.tx.data() + sent, left);
+				conn.tx_len = left;
+				armWrite(index, left != 0); // socket buffer full : let epoll tell us when we can continue
+			}
+
+			void armWrite(int index, bool on) noexcept {
+				epoll_event ev{};
+				ev.events = on ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+				ev.data.u32 = static_cast<uint32_t>(index);
+				::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connections[index].fd, &ev);
+			}
+
+			void checkTimers(uint64_t now) noexcept {
+				for(size_t c = 0; c < connections.size(); c++) {
+					Connection& conn = connections[c];
+					if(conn.fd == -1) continue;
+
+					// nothing heard for 3 heartbeat intervals ---> peer is gone
+					if(UNLIKELY(now - conn.last_rx_cycle > 3 * conn.heartbeat_cycles)) {
+						logoutAndClose(static_cast<int>(c), 'T');
+						continue;
+					}
+					if(now - conn.last_tx_cycle > conn.heartbeat_cycles && conn.trader_id != -1) {
+						OEHeartbeat hb{};
+						sessionHeader(hb.header, 'H', sizeof(hb));
+						if(queueBytes(static_cast<int>(c), reinterpret_cast<const char*>(&hb), sizeof(hb))) conn.last_tx_cycle = now;
+					}
+				}
+			}
+
+			void logoutAndClose(int index, char reason) noexcept {
+				Connection& conn = connections[index];
+				OELogout logout{};
+				sessionHeader(logout.header, 'O', sizeof(logout));
+				logout.reason = reason;
+				// best effort, the connection goes away right after
+				::send(conn.fd, &logout, sizeof(logout), MSG_NOSIGNAL | MSG_DONTWAIT);
+				closeConnection(index);
+			}
+
+			void closeConnection(int index) noexcept {
+				Connection& conn = connections[index];
+				if(conn.fd == -1) return;
+
+				::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+				::close(conn.fd);
+				conn.fd = -1;
+				if(conn.trader_id != -1) {
+					traders[conn.trader_id].connection = -1; // sequences stay with the trader
+					pending_logouts.push_back(conn.trader_id);
+					flushLogouts();
+				}
+				conn.trader_id = -1;
+				conn.rx_len = 0;
+				conn.tx_len = 0;
+				free_connections.push_back(index);
+			}
+
+			// tells the gateway the trader is gone ('O' frame), it stops routing its acks to the session lane. reports produced
+			// while logged out are not kept, the replay covers what was sent before the connection went away
+			void flushLogouts() noexcept {
+				size_t sent = 0;
+				for(; sent < pending_logouts.size(); sent++) {
+					OEFrame* frame = InboundQueue->getNextWrite();
+					if(UNLIKELY(frame == nullptr)) break; // gateway is behind, next poll
+
+					OELogout* notice = reinterpret_cast<OELogout*>(frame->msg);
+					*notice = OELogout{};
+					sessionHeader(notice->header, 'O', sizeof(OELogout));
+					notice->reason = 'U';
+					frame->rx_cycle_count = now_cycles();
+					frame->trader_id = pending_logouts[sent];
+					frame->length = sizeof(OELogout);
+					InboundQueue->updateWrite();
+				}
+				pending_logouts.erase(pending_logouts.begin(), pending_logouts.begin() + sent);
+			}
+
+			static inline void sessionHeader(OEHeader& header, char type, uint16_t length) noexcept {
+				header.length = length;
+				header.msg_type = type;
+				header.version = OE_PROTOCOL_VERSION;
+				header.seq_num = 0;
+			}
+	};
+}
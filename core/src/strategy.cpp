@@ -0,0 +1,249 @@
+// strategy plugin interface ---> compile time (CRTP) base for strategies that trade through a gateway order queue.
+//
+// a strategy derives from Strategy<itself> and defines the hooks it cares about, the others fall back to the empty ones here :
+//   onBookUpdate(const BroadcastElement&)  incremental feed 'N' / 'U' / 'D'
+//   onTrade(const BroadcastElement&)       feed 'T' (one per fill)
+//   onAck(const UserAcknowledgement&)      its own acks, after the base updated the order table
+//   onTimer(uint64_t now)                  every setTimer() cycles (0 = off)
+// the hooks are called through static_cast<Derived*>(this), no virtual dispatch : the compiler sees the concrete strategy and
+// inlines the hook straight into the poll loop, an unused hook compiles to nothing.
+//
+// order helpers (sendOrder / replaceOrder / cancelOrder) write straight into the next slot of the order queue and keep a
+// preallocated table of the strategy's orders (order id = slot index, ids wrap at the table size and skip live orders), so a
+// cancel / replace only needs the id. nothing allocates after construction. a full queue is not retried here, the helper returns -1 / false and
+// the strategy decides (counted in getSendFailures).
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+
+#include "lf_queue.h"
+#include "lob_structs.h"
+#include "order_gateway_structs.h"
+#include "top_of_book.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	template<typename Derived>
+	class Strategy {
+
+		public :
+
+			struct StrategyOrder {
+				float price = 0.0f;
+				int quantity = 0;          // open quantity as far as the acks told us
+				char side = 0;             // 'b' / 's'
+				bool live = false;         // sent and not yet filled / cancelled / rejected
+			};
+
+		private :
+
+			LFQueue<UserOrder>* OrderQueue;
+			LFQueue<UserAcknowledgement>* AckQueue;
+			LFQueue<BroadcastElement>* BroadcastQueue;   // nullptr = no feed (ack / timer only strategy)
+			const TopOfBook* TopBook = nullptr;
+
+			short trader_id;
+			std::vector<StrategyOrder> Orders;
+			int next_order_id = 0;
+
+			uint64_t timer_interval = 0;
+			uint64_t next_timer = 0;
+
+			uint64_t send_failures = 0;
+
+		public :
+
+			Strategy(LFQueue<UserOrder>* oq, LFQueue<UserAcknowledgement>* aq, LFQueue<BroadcastElement>* bq, short trader, int max_orders = 1 << 16)
+				: OrderQueue(oq), AckQueue(aq), BroadcastQueue(bq), trader_id(trader), Orders((max_orders < 1) ? 1 : max_orders) {}
+
+			Strategy(const Strategy&) = delete;
+			Strategy& operator=(const Strategy&) = delete;
+
+			void setTopOfBook(const TopOfBook* top) noexcept { TopBook = top; }
+
+			// onTimer every 'cycles' (0 = off), the first one is due 'cycles' after the next poll
+			void setTimer(uint64_t cycles) noexcept {
+				timer_interval = cycles;
+				next_timer = 0;
+			}
+
+			// one pass of the event loop : feed, acks, timer. at most max_events of each queue so one busy queue can not starve
+			// the other. the clock is only read for the timer, after the queues (now_cycles serializes, the reaction to a feed
+			// event should not wait for it). returns the number of events handled
+			int poll(int max_events = 64) noexcept {
+				int handled = pollQueues(max_events);
+				if(timer_interval != 0) handled += pollTimer(now_cycles());
+				return handled;
+			}
+
+			// the same on an external (virtual) clock, the backtest drives strategies through this
+			int pollAt(uint64_t now, int max_events = 64) noexcept {
+				int handled = pollQueues(max_events);
+				if(timer_interval != 0) handled += pollTimer(now);
+				return handled;
+			}
+
+			// threaded use : spins on poll until terminate
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+				while(!terminate.load(std::memory_order_acquire)) poll();
+			}
+
+			// default hooks, hidden by the strategy's own
+			void onBookUpdate(const BroadcastElement&) noexcept {}
+			void onTrade(const BroadcastElement&) noexcept {}
+			void onAck(const UserAcknowledgement&) noexcept {}
+			void onTimer(uint64_t) noexcept {}
+
+			// when the timer fires next (0 = not armed yet, it arms on the next poll), UINT64_MAX = no timer
+			uint64_t nextTimer() const noexcept { return (timer_interval != 0) ? next_timer : UINT64_MAX; }
+
+			short getTraderId() const noexcept { return trader_id; }
+			uint64_t getSendFailures() const noexcept { return send_failures; }
+			const StrategyOrder& getOrder(int order_id) const noexcept { return Orders[order_id]; }
+
+		protected :
+
+			// new order, returns its order id or -1 if the queue is full or every id of the table is still live. the ids wrap, a
+			// slot whose order is still live is skipped (its id is still the gateway's key for that order)
+			inline int sendOrder(char side, float price, int quantity) noexcept {
+				int id = next_order_id;
+				int table = static_cast<int>(Orders.size());
+				for(int tried = 0; UNLIKELY(Orders[id].live); tried++) {
+					if(UNLIKELY(tried + 1 == table)) {
+						send_failures++;
+						return -1;
+					}
+					id = (id + 1 == table) ? 0 : id + 1;
+				}
+
+				UserOrder* o = OrderQueue->getNextWrite();
+				if(UNLIKELY(o == nullptr)) {
+					send_failures++;
+					return -1;
+				}
+				next_order_id = (id + 1 == table) ? 0 : id + 1;
+
+				writeOrder(o, id, 'c', side, price, quantity);
+				OrderQueue->updateWrite();
+				Orders[id] = StrategyOrder{price, quantity, side, true};
+				return id;
+			}
+
+			// re-price / re-size a live order, false if it is not live or the queue is full
+			inline bool replaceOrder(int order_id, float price, int quantity) noexcept {
+				StrategyOrder& so = Orders[order_id];
+				if(UNLIKELY(!so.live)) return false;
+				UserOrder* o = OrderQueue->getNextWrite();
+				if(UNLIKELY(o == nullptr)) {
+					send_failures++;
+					return false;
+				}
+				writeOrder(o, order_id, 'u', so.side, price, quantity);
+				OrderQueue->updateWrite();
+				so.price = price;
+				so.quantity = quantity;
+				return true;
+			}
+
+			// the order stays live until its cancel is acked (it may still fill)
+			inline bool cancelOrder(int order_id) noexcept {
+				const StrategyOrder& so = Orders[order_id];
+				if(UNLIKELY(!so.live)) return false;
+				UserOrder* o = OrderQueue->getNextWrite();
+				if(UNLIKELY(o == nullptr)) {
+					send_failures++;
+					return false;
+				}
+				writeOrder(o, order_id, 'd', so.side, so.price, 0);
+				OrderQueue->updateWrite();
+				return true;
+			}
+
+			// engine published BBO, false if no top of book is attached
+			inline bool readBBO(BBOView& out) const noexcept {
+				if(TopBook == nullptr) return false;
+				TopBook->readBBO(out);
+				return true;
+			}
+
+		private :
+
+			inline Derived& self() noexcept { return *static_cast<Derived*>(this); }
+
+			inline int pollQueues(int max_events) noexcept {
+				int handled = 0;
+
+				if(BroadcastQueue != nullptr) {
+					BroadcastElement* be;
+					for(int n = 0; n < max_events && (be = BroadcastQueue->getNextRead()) != nullptr; n++) {
+						if(be->type == 'T') self().onTrade(*be);
+						else self().onBookUpdate(*be);
+						BroadcastQueue->updateRead();
+						handled++;
+					}
+				}
+
+				UserAcknowledgement* ack;
+				for(int n = 0; n < max_events && (ack = AckQueue->getNextRead()) != nullptr; n++) {
+					trackAck(*ack);
+					self().onAck(*ack);
+					AckQueue->updateRead();
+					handled++;
+				}
+
+				return handled;
+			}
+
+			inline int pollTimer(uint64_t now) noexcept {
+				if(UNLIKELY(next_timer == 0)) {
+					next_timer = now + timer_interval;
+					return 0;
+				}
+				if(now < next_timer) return 0;
+				// a late timer fires once and re-arms from now, it does not burst to catch up
+				next_timer = (now - next_timer < timer_interval) ? next_timer + timer_interval : now + timer_interval;
+				self().onTimer(now);
+				return 1;
+			}
+
+			inline void writeOrder(UserOrder* o, int order_id, char req_type, char side, float price, int quantity) noexcept {
+				o->arrived_cycle_count = now_cycles();
+				o->order_id = order_id;
+				o->trader_id = trader_id;
+				o->order_type = side;
+				o->req_type = req_type;
+				o->price = price;
+				o->quantity = quantity;
+				o->out_cycle_count = o->arrived_cycle_count;
+			}
+
+			// 'C' (the order rests, also the second half of a re-priced replace : 'D' + 'C') and 'U' set what rests, 'T' reduces
+			// the open quantity. a full fill, a cancel ('D'), a kill ('K') or a refused create ends the order. a refused replace /
+			// cancel does not, the order still rests as it was (replaceOrder's price / size stay noted until the book says otherwise)
+			inline void trackAck(const UserAcknowledgement& ack) noexcept {
+				if(UNLIKELY(ack.order_id < 0 || ack.order_id >= static_cast<long long>(Orders.size()))) return;
+				StrategyOrder& so = Orders[ack.order_id];
+				if(ack.status == 'C') {
+					so.price = ack.price;
+					so.quantity = ack.quantity;
+					so.live = true;
+				} else if(ack.status == 'T') {
+					so.quantity -= ack.quantity;
+					if(so.quantity <= 0) so.live = false;
+				} else if(ack.status == 'U') {
+					so.quantity = ack.quantity;
+				} else if(ack.status == 'D' || ack.status == 'K' || (ack.status == 'R' && ack.req_type == 'c')) {
+					so.live = false;
+				}
+			}
+	};
+}
@@ -0,0 +1,155 @@
+// parallel parameter sweep ---> runs one job per parameter set on a pool of worker threads, one core each, and returns the
+// results in parameter order (the same vector whatever the number of workers).
+//
+// every worker builds its own WorkerState on its own thread (a Backtest with its engine / gateway / rings, a book builder ...),
+// so its memory is first touched, and stays, on the worker's core / node. nothing is shared between workers but the read only
+// inputs the job function captures (a ReplayMapping of the recording : one mmap, every worker reads the same pages) and the
+// result slots, each written by exactly one worker. a job gets the worker's state and must put it back to a clean state
+// itself (Backtest::reset keeps the pools and tables, building a new one per job would cost more than a short backtest).
+//
+// scheduling is work stealing over index ranges : the jobs are split into one contiguous range per worker, a worker takes
+// jobs from the front of its own range and, once it is empty, steals the back half of another worker's range. a range is
+// [begin, end) packed into one 64 bit atomic, so taking one job and stealing half are both a single CAS. jobs of very
+// different cost (short timers, long recordings) even out without a shared queue every worker would contend on.
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <string>
+
+#include "thread_utils.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	struct SweepStats {
+		uint64_t wall_ns = 0;
+		uint64_t jobs = 0;
+		uint64_t steals = 0;
+		std::vector<uint64_t> jobs_per_worker;
+	};
+
+	template<typename Params, typename Result>
+	class SweepRunner {
+
+		private :
+
+			// [begin, end) of a worker's remaining jobs : begin in the high half, end in the low half
+			struct alignas(64) Range {
+				std::atomic<uint64_t> bounds{0};
+			};
+
+			static constexpr uint64_t pack(uint32_t begin, uint32_t end) noexcept { return (static_cast<uint64_t>(begin) << 32) | end; }
+			static constexpr uint32_t first(uint64_t r) noexcept { return static_cast<uint32_t>(r >> 32); }
+			static constexpr uint32_t last(uint64_t r) noexcept { return static_cast<uint32_t>(r); }
+
+			int workers;
+			int first_core;                // worker w is pinned to first_core + w, -1 = not pinned
+			std::vector<Range> Ranges;
+			std::atomic<uint64_t> steals{0};
+			SweepStats stats;
+
+		public :
+
+			explicit SweepRunner(int worker_count, int core = -1)
+				: workers((worker_count < 1) ? 1 : worker_count), first_core(core), Ranges(workers) {}
+
+			SweepRunner(const SweepRunner&) = delete;
+			SweepRunner& operator=(const SweepRunner&) = delete;
+
+			// WorkerState : default constructible, built once per worker on the worker thread.
+			// job : Result(WorkerState&, const Params&), called once per parameter set
+			template<typename WorkerState, typename Job>
+			std::vector<Result> run(const std::vector<Params>& params, Job job) {
+				uint32_t count = static_cast<uint32_t>(params.size());
+				std::vector<Result> results(count);
+				stats = SweepStats{};
+				stats.jobs_per_worker.assign(workers, 0);
+				steals.store(0, std::memory_order_relaxed);
+
+				for(int w = 0; w < workers; w++) {
+					uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * w / workers);
+					uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (w + 1) / workers);
+					Ranges[w].bounds.store(pack(begin, end), std::memory_order_relaxed);
+				}
+
+				uint64_t wall_start = now_cycles();
+
+				std::vector<std::thread*> threads;
+				for(int w = 0; w < workers; w++) {
+					auto body = [this, w, &params, &results, &job]() {
+						WorkerState state;
+						uint32_t i;
+						uint64_t done = 0;
+						while(next(w, i)) {
+							results[i] = job(state, params[i]);
+							done++;
+						}
+						stats.jobs_per_worker[w] = done;
+					};
+					int core = (first_core >= 0) ? first_core + w : -1;
+					std::thread* t = createAndStartThread(core, "Sweep Worker " + std::to_string(w), body);
+					if(UNLIKELY(t == nullptr)) t = createAndStartThread(-1, "Sweep Worker " + std::to_string(w), body); // could not pin
+					threads.push_back(t);
+				}
+				for(std::thread* t : threads) {
+					t->join();
+					delete t;
+				}
+
+				stats.wall_ns = static_cast<uint64_t>(static_cast<double>(now_cycles() - wall_start) / get_cycles_per_ns());
+				stats.jobs = count;
+				stats.steals = steals.load(std::memory_order_relaxed);
+				return results;
+			}
+
+			const SweepStats& getStats() const noexcept { return stats; }
+			int getWorkers() const noexcept { return workers; }
+
+		private :
+
+			// next job for worker w : the front of its own range, else half of someone else's. false = no job left anywhere
+			// (work only moves between ranges, it never appears, so once every range was seen empty the sweep is done)
+			inline bool next(int w, uint32_t& job) noexcept {
+				if(LIKELY(popFront(w, job))) return true;
+				for(int k = 1; k < workers; k++) {
+					if(steal(w, (w + k) % workers, job)) return true;
+				}
+				return false;
+			}
+
+			inline bool popFront(int w, uint32_t& job) noexcept {
+				std::atomic<uint64_t>& bounds = Ranges[w].bounds;
+				uint64_t r = bounds.load(std::memory_order_acquire);
+				while(first(r) < last(r)) {
+					if(bounds.compare_exchange_weak(r, pack(first(r) + 1, last(r)), std::memory_order_acq_rel, std::memory_order_acquire)) {
+						job = first(r);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// takes the back half of the victim's range (at least one job) : runs its first job, the rest becomes the thief's
+			// own range. the thief's range is empty at this point, so nobody else is changing it
+			inline bool steal(int w, int victim, uint32_t& job) noexcept {
+				std::atomic<uint64_t>& bounds = Ranges[victim].bounds;
+				uint64_t r = bounds.load(std::memory_order_acquire);
+				while(first(r) < last(r)) {
+					uint32_t mid = first(r) + (last(r) - first(r)) / 2;
+					if(bounds.compare_exchange_weak(r, pack(first(r), mid), std::memory_order_acq_rel, std::memory_order_acquire)) {
+						job = mid;
+						Ranges[w].bounds.store(pack(mid + 1, last(r)), std::memory_order_release);
+						steals.fetch_add(1, std::memory_order_relaxed);
+						return true;
+					}
+				}
+				return false;
+			}
+	};
+}
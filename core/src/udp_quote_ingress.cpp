@@ -0,0 +1,234 @@
+// UDP ingress for market maker quote streams ---> feeds the gateway's MMOrderQueue.
+//
+// one recvmmsg() pulls up to batch_size datagrams (each up to QUOTE_MAX_PER_PACKET quotes) in a single syscall, all of them are
+// stamped with the cycle count of that return, decoded straight out of the receive buffers into UserOrder slots of the MM queue
+// and published to the gateway with ONE write index update per batch.
+//
+// with a cancel lane attached (OrderGateway::attachCancelLanes) quote cancels ('X') go there instead, so they are not stuck
+// behind the quotes of the same burst. the gateway drains the cancel lane first, so a cancel whose quote ('Q', a create or a
+// replace) is still waiting in the MM queue would overtake it and the quote would come back to life : such a cancel goes into
+// the MM queue behind its quote. the ingress remembers the MM queue position of the last 'Q' per quote (direct mapped on a
+// hash of trader + quote id, a collision only sends a cancel the ordered way) and compares it with how far the gateway read.
+//
+// latency over reliability : a datagram that is malformed, stale (packet_seq older than one we already took from that trader)
+// or does not fit in the MM queue is dropped and counted, never retried.
+
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+
+#include "lf_queue.h"
+#include "order_gateway_structs.h"
+#include "order_entry_protocol.h"
+#include "quote_protocol.h"
+#include "benchmark_utility.h"
+
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+
+namespace internal_lib {
+
+	class UdpQuoteIngress {
+
+		private :
+
+			static constexpr int MAX_BATCH = 64;
+
+			LFQueue<UserOrder>* MMOrderQueue;
+			LFQueue<UserOrder>* MMCancelQueue; // nullptr = cancels share MMOrderQueue
+
+			int fd = -1;
+			int batch_size = MAX_BATCH;
+
+			mmsghdr msgs[MAX_BATCH];
+			iovec iovs[MAX_BATCH];
+			std::vector<char> buffers; // MAX_BATCH datagrams of QUOTE_MAX_DATAGRAM
+
+			std::vector<uint32_t> next_packet_seq; // per trader
+
+			// MM queue position + 1 of the latest 'Q' per hash of (trader, quote id), 0 = none
+			static constexpr int QUOTE_SLOT_BITS = 12;
+			std::vector<uint64_t> last_quote_at;
+			uint64_t published = 0; // entries published to the MM queue so far
+
+			// stats
+			uint64_t recv_calls = 0;
+			uint64_t packets = 0;
+			uint64_t quotes = 0;
+			uint64_t lost_packets = 0;     // gaps in packet_seq
+			uint64_t stale_packets = 0;    // reordered / duplicated, dropped
+			uint64_t bad_packets = 0;      // malformed, dropped
+			uint64_t dropped_quotes = 0;   // MM queue full
+			uint64_t ordered_cancels = 0;  // cancels sent behind their still pending quote instead of on the cancel lane
+
+		public :
+
+			explicit UdpQuoteIngress(LFQueue<UserOrder>* mmoq, LFQueue<UserOrder>* mm_cancels = nullptr) : MMOrderQueue(mmoq), MMCancelQueue(mm_cancels) {
+				buffers.resize(static_cast<size_t>(MAX_BATCH) * QUOTE_MAX_DATAGRAM);
+				for(int i = 0; i < MAX_BATCH; i++) {
+					iovs[i].iov_base = buffers.data() + static_cast<size_t>(i) * QUOTE_MAX_DATAGRAM;
+					iovs[i].iov_len = QUOTE_MAX_DATAGRAM;
+					msgs[i].msg_hdr = msghdr{};
+					msgs[i].msg_hdr.msg_iov = &iovs[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+				}
+				next_packet_seq.assign(OE_MAX_TRADERS, 0);
+				last_quote_at.assign(size_t{1} << QUOTE_SLOT_BITS, 0);
+			}
+
+			UdpQuoteIngress(const UdpQuoteIngress&) = delete;
+			UdpQuoteIngress& operator=(const UdpQuoteIngress&) = delete;
+
+			~UdpQuoteIngress() {
+				if(fd != -1) ::close(fd);
+			}
+
+			// port 0 = any free port, returns the bound port (0 on failure).
+			// a big socket buffer absorbs the bursts between two polls instead of the kernel dropping them.
+			uint16_t bind(uint16_t port, const char* address = "127.0.0.1", int rcvbuf_bytes = 8 << 20) noexcept {
+				fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+				if(fd == -1) return 0;
+
+				::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf_bytes, sizeof(rcvbuf_bytes));
+
+				sockaddr_in addr{};
+				addr.sin_family = AF_INET;
+				addr.sin_port = htons(port);
+				if(::inet_pton(AF_INET, address, &addr.sin_addr) != 1) return 0;
+				if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return 0;
+
+				socklen_t len = sizeof(addr);
+				::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+				return ntohs(addr.sin_port);
+			}
+
+			// datagrams per recvmmsg, 1 behaves like a plain recvfrom() loop
+			void setBatchSize(int batch) noexcept {
+				batch_size = (batch < 1) ? 1 : ((batch > MAX_BATCH) ? MAX_BATCH : batch);
+			}
+
+			// one syscall worth of datagrams. returns the number of datagrams taken (0 if the socket was empty)
+			int poll() noexcept {
+				int n = ::recvmmsg(fd, msgs, static_cast<unsigned>(batch_size), MSG_DONTWAIT, nullptr);
+				recv_calls++;
+				if(n <= 0) return 0;
+
+				uint64_t rx_cycle = now_cycles(); // every datagram of the batch was already waiting in the socket at this point
+
+				size_t pending = 0;         // written but not yet published to the gateway
+				size_t pending_cancels = 0; // same for the cancel lane
+				for(int d = 0; d < n; d++) {
+					const char* datagram = buffers.data() + static_cast<size_t>(d) * QUOTE_MAX_DATAGRAM;
+					decodePacket(datagram, msgs[d].msg_len, pending, pending_cancels, rx_cycle);
+				}
+
+				if(LIKELY(pending != 0)) MMOrderQueue->updateWrite(pending);
+				published += pending;
+				if(pending_cancels != 0) MMCancelQueue->updateWrite(pending_cancels);
+				packets += static_cast<uint64_t>(n);
+				return n;
+			}
+
+			void run(std::atomic<bool>& start, std::atomic<bool>& terminate) noexcept {
+				while(!start.load(std::memory_order_acquire)) {
+					if(terminate.load(std::memory_order_acquire)) return;
+				}
+
+				while(!terminate.load(std::memory_order_acquire)) {
+					poll();
+				}
+
+				std::cout << "[UDP QUOTE INGRESS] packets : " << packets << " , quotes : " << quotes << " , lost : " << lost_packets
+						  << " , stale : " << stale_packets << " , bad : " << bad_packets << " , dropped quotes : " << dropped_quotes << "\n";
+			}
+
+			uint64_t getRecvCalls() const noexcept { return recv_calls; }
+			uint64_t getPackets() const noexcept { return packets; }
+			uint64_t getQuotes() const noexcept { return quotes; }
+			uint64_t getLostPackets() const noexcept { return lost_packets; }
+			uint64_t getBadPackets() const noexcept { return bad_packets; }
+			uint64_t getDroppedQuotes() const noexcept { return dropped_quotes; }
+			uint64_t getOrderedCancels() const noexcept { return ordered_cancels; }
+
+		private :
+
+			static inline size_t quoteSlot(short trader_id, int32_t quote_id) noexcept {
+				return static_cast<size_t>((static_cast<uint64_t>(makeOrderKey(trader_id, quote_id)) * 0x9E3779B97F4A7C15ull) >> (64 - QUOTE_SLOT_BITS));
+			}
+
+			// writes the quotes of one datagram into the MM queue (cancel lane) behind 'pending' ('pending_cancels') unpublished
+			// slots and advances both counters by what it wrote
+			void decodePacket(const char* datagram, size_t len, size_t& pending, size_t& pending_cancels, uint64_t rx_cycle) noexcept {
+				const QuotePacketHeader* header = reinterpret_cast<const QuotePacketHeader*>(datagram);
+
+				if(UNLIKELY(len < sizeof(QuotePacketHeader) || header->version != QUOTE_PROTOCOL_VERSION || header->length != len ||
+							len != sizeof(QuotePacketHeader) + static_cast<size_t>(header->count) * sizeof(QuoteMessage) ||
+							header->trader_id < 0 || header->trader_id >= OE_MAX_TRADERS)) {
+					bad_packets++;
+					return;
+				}
+
+				// first packet of a trader (expected 0) is taken as is, after that anything older than expected is stale
+				uint32_t& expected = next_packet_seq[header->trader_id];
+				if(UNLIKELY(expected != 0 && static_cast<int32_t>(header->packet_seq - expected) < 0)) {
+					stale_packets++;
+					return;
+				}
+				if(UNLIKELY(expected != 0 && header->packet_seq != expected)) lost_packets += header->packet_seq - expected;
+				expected = header->packet_seq + 1;
+
+				size_t count = header->count;
+				if(UNLIKELY(MMOrderQueue->getWriteSpace(pending + count) < pending + count ||
+							(MMCancelQueue != nullptr && MMCancelQueue->getWriteSpace(pending_cancels + count) < pending_cancels + count))) {
+					dropped_quotes += count; // whole packet or nothing, keeps a quote and its cancel together
+					return;
+				}
+
+				// everything before this position of the MM queue has been read by the gateway (a stale read index only errs on
+				// the ordered side)
+				uint64_t consumed = published - MMOrderQueue->entriesBetween(MMOrderQueue->readIndex(), MMOrderQueue->writeIndex());
+
+				const QuoteMessage* quote = reinterpret_cast<const QuoteMessage*>(datagram + sizeof(QuotePacketHeader));
+				size_t written = 0;
+				for(size_t q = 0; q < count; q++, quote++) {
+					if(UNLIKELY((quote->type != 'Q' && quote->type != 'X') || (quote->side != 'b' && quote->side != 's') ||
+								(quote->type == 'Q' && (quote->quantity <= 0 || !oeValidPrice(quote->price))))) {
+						bad_packets++;
+						continue;
+					}
+
+					UserOrder* order;
+					if(MMCancelQueue == nullptr) {
+						order = MMOrderQueue->getWriteAhead(pending++);
+					} else {
+						uint64_t& last_quote = last_quote_at[quoteSlot(header->trader_id, quote->quote_id)];
+						if(quote->type == 'Q') {
+							last_quote = published + pending + 1;
+							order = MMOrderQueue->getWriteAhead(pending++);
+						} else if(LIKELY(last_quote <= consumed)) {
+							order = MMCancelQueue->getWriteAhead(pending_cancels++);
+						} else {
+							ordered_cancels++; // its quote is still in the MM queue
+							order = MMOrderQueue->getWriteAhead(pending++);
+						}
+					}
+
+					order->arrived_cycle_count = rx_cycle;
+					order->order_id = quote->quote_id;
+					order->trader_id = header->trader_id;
+					order->order_type = quote->side;
+					order->req_type = (quote->type == 'Q') ? 'q' : 'd';
+					order->price = quote->price;
+					order->quantity = quote->quantity;
+					order->out_cycle_count = rx_cycle;
+					written++;
+				}
+
+				quotes += written;
+			}
+	};
+}